@@ -29,8 +29,8 @@ MainWindow::MainWindow(QWidget* parent)
         m_view->SetLayerTarget(i, KIGFX::TARGET_NONCACHED);
 
 
-    GAL_DISPLAY_OPTIONS option;
-    m_gal = new OPENGL_GAL(option, nullptr);
+    // The GAL keeps a reference to its options
+    m_gal = new OPENGL_GAL(m_options, nullptr);
     m_view->SetGAL(m_gal);
 
     m_painter = new DATA_PAINTER(m_gal);
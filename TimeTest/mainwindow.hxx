@@ -33,6 +33,7 @@ public:
     std::vector<DATA_Circle> circles1;
     std::vector<DATA_Triangle> triangles1;
     std::vector<DATA_Rectangle> rectangles1;
+    GAL_DISPLAY_OPTIONS m_options;
     OPENGL_GAL* m_gal;
     QWidget* m_rWidget;
     VIEW* m_view;
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <utility>
+
+/**
+ * Epoch based reclamation: delays freeing objects until no reader can see them anymore.
+ *
+ * Readers pin the current epoch with a GUARD for as long as they use the objects. The writer
+ * unlinks an object, then retires it: the object is tagged with the current epoch, which
+ * advances. Collect() frees the objects retired before the oldest epoch still pinned.
+ *
+ * Pinning is lock-free and may happen on any thread. Retire() and Collect() belong to a single
+ * writer thread.
+ */
+class EPOCH_RECLAIMER
+{
+public:
+    /// Maximum number of readers at once. Additional readers wait for a free slot.
+    static constexpr size_t MAX_READERS = 64;
+
+    /**
+     * Pins the current epoch while it exists.
+     */
+    class GUARD
+    {
+    public:
+        explicit GUARD( EPOCH_RECLAIMER& aReclaimer ) :
+                m_slot( aReclaimer.pin() )
+        {
+        }
+
+        ~GUARD()
+        {
+            if( m_slot )
+                m_slot->store( 0, std::memory_order_release );
+        }
+
+        GUARD( GUARD&& aOther ) noexcept :
+                m_slot( std::exchange( aOther.m_slot, nullptr ) )
+        {
+        }
+
+        GUARD( const GUARD& ) = delete;
+        GUARD& operator=( const GUARD& ) = delete;
+
+    private:
+        std::atomic<uint64_t>* m_slot;
+    };
+
+    EPOCH_RECLAIMER() :
+            m_epoch( 1 )
+    {
+        for( std::atomic<uint64_t>& slot : m_readers )
+            slot.store( 0, std::memory_order_relaxed );
+    }
+
+    /**
+     * Free everything left. No reader may be running anymore.
+     */
+    ~EPOCH_RECLAIMER()
+    {
+        for( auto& [epoch, deleter] : m_retired )
+            deleter();
+    }
+
+    EPOCH_RECLAIMER( const EPOCH_RECLAIMER& ) = delete;
+    EPOCH_RECLAIMER& operator=( const EPOCH_RECLAIMER& ) = delete;
+
+    /**
+     * Schedule \a aDeleter to run once the readers running now are done. The objects it frees
+     * must already be unreachable for new readers.
+     */
+    void Retire( std::function<void()> aDeleter )
+    {
+        m_retired.emplace_back( m_epoch.fetch_add( 1, std::memory_order_seq_cst ),
+                                std::move( aDeleter ) );
+    }
+
+    /**
+     * Run the deleters of the objects no reader can see anymore.
+     *
+     * @return the number of deleters run.
+     */
+    size_t Collect()
+    {
+        uint64_t oldest = UINT64_MAX;
+
+        for( const std::atomic<uint64_t>& slot : m_readers )
+        {
+            const uint64_t epoch = slot.load( std::memory_order_seq_cst );
+
+            if( epoch != 0 && epoch < oldest )
+                oldest = epoch;
+        }
+
+        size_t count = 0;
+
+        // Retired in epoch order, so the collectable ones are at the front
+        while( !m_retired.empty() && m_retired.front().first < oldest )
+        {
+            std::function<void()> deleter = std::move( m_retired.front().second );
+            m_retired.pop_front();
+            deleter();
+            count++;
+        }
+
+        return count;
+    }
+
+    /**
+     * @return the number of retired deleters not run yet.
+     */
+    size_t GetPendingCount() const
+    {
+        return m_retired.size();
+    }
+
+private:
+    std::atomic<uint64_t>* pin()
+    {
+        while( true )
+        {
+            for( std::atomic<uint64_t>& slot : m_readers )
+            {
+                uint64_t free = 0;
+                uint64_t epoch = m_epoch.load( std::memory_order_seq_cst );
+
+                // If the epoch advances before the slot is published, the objects retired
+                // meanwhile were unreachable before this reader starts: pinning late is fine
+                if( slot.compare_exchange_strong( free, epoch, std::memory_order_seq_cst ) )
+                    return &slot;
+            }
+
+            std::this_thread::yield();
+        }
+    }
+
+    std::atomic<uint64_t>                              m_epoch;
+    std::array<std::atomic<uint64_t>, MAX_READERS>     m_readers;    ///< Pinned epochs, 0 if free.
+    std::deque<std::pair<uint64_t, std::function<void()>>> m_retired;
+};
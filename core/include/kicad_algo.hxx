@@ -26,6 +26,8 @@
 #define INCLUDE_CORE_KICAD_ALGO_H_
 
 #include <algorithm>
+#include <array>
+#include <cstdint>
 #include <functional> // std::function
 #include <utility>    // std::pair
 #include <vector>
@@ -255,6 +257,67 @@ int lexicographical_compare_three_way( Container1Iter aC1_first, Container1Iter
 }
 
 
+/**
+ * @brief Stable sort of key/value pairs by their key, with a least significant byte first
+ * radix sort.
+ *
+ * Runs in linear time and only streams through the pairs, so it is much faster than a
+ * comparison sort for large arrays. Bytes that are the same in all keys are skipped.
+ *
+ *  @param  __entries  The pairs to sort.
+ *  @param  __scratch  A buffer of the same type, kept by the caller to save allocations.
+ */
+template <typename _Value>
+void radix_sort_by_key( std::vector<std::pair<uint32_t, _Value>>& __entries,
+                        std::vector<std::pair<uint32_t, _Value>>& __scratch )
+{
+    const size_t __size = __entries.size();
+
+    if( __size < 64 )
+    {
+        std::stable_sort( __entries.begin(), __entries.end(),
+                          []( const auto& a, const auto& b )
+                          {
+                              return a.first < b.first;
+                          } );
+        return;
+    }
+
+    // Histograms of all the passes are gathered in a single read of the keys
+    std::array<std::array<size_t, 256>, 4> __counts{};
+
+    for( const auto& __entry : __entries )
+    {
+        for( int __pass = 0; __pass < 4; ++__pass )
+            __counts[__pass][( __entry.first >> ( 8 * __pass ) ) & 0xff]++;
+    }
+
+    __scratch.resize( __size );
+
+    for( int __pass = 0; __pass < 4; ++__pass )
+    {
+        std::array<size_t, 256>& __count = __counts[__pass];
+        const int                __shift = 8 * __pass;
+
+        if( __count[( __entries[0].first >> __shift ) & 0xff] == __size )
+            continue;
+
+        size_t __offset = 0;
+
+        for( size_t& __bucket : __count )
+        {
+            const size_t __n = __bucket;
+            __bucket = __offset;
+            __offset += __n;
+        }
+
+        for( const auto& __entry : __entries )
+            __scratch[__count[( __entry.first >> __shift ) & 0xff]++] = __entry;
+
+        __entries.swap( __scratch );
+    }
+}
+
 } // namespace alg
 
 #endif /* INCLUDE_CORE_KICAD_ALGO_H_ */
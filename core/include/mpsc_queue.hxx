@@ -0,0 +1,134 @@
+#pragma once
+
+#include <atomic>
+#include <optional>
+#include <utility>
+
+/**
+ * An unbounded queue with multiple producers and a single consumer.
+ *
+ * Push() is lock-free and may be called from any thread. Pop() must only be called by one
+ * thread at a time. This is the intrusive queue of Dmitry Vyukov: producers exchange the head
+ * pointer and link the previous head to their node, the consumer follows the links from the
+ * tail. A producer preempted between both steps briefly hides the nodes pushed after its own,
+ * Pop() then reports the queue as empty until it completes.
+ */
+template <typename T>
+class MPSC_QUEUE
+{
+public:
+    MPSC_QUEUE() :
+            m_head( &m_stub ),
+            m_tail( &m_stub )
+    {
+    }
+
+    ~MPSC_QUEUE()
+    {
+        NODE* node = m_tail;
+
+        while( node )
+        {
+            NODE* next = node->next.load( std::memory_order_relaxed );
+
+            if( node != &m_stub )
+                delete node;
+
+            node = next;
+        }
+    }
+
+    MPSC_QUEUE( const MPSC_QUEUE& ) = delete;
+    MPSC_QUEUE& operator=( const MPSC_QUEUE& ) = delete;
+
+    /**
+     * Append \a aValue to the queue. Can be called from any thread.
+     */
+    void Push( T aValue )
+    {
+        push( new NODE( std::move( aValue ) ) );
+    }
+
+    /**
+     * Move the oldest value of the queue to \a aValue. Consumer thread only.
+     *
+     * @return false if the queue is empty (or the next value is not completely pushed yet).
+     */
+    bool Pop( T& aValue )
+    {
+        NODE* tail = m_tail;
+        NODE* next = tail->next.load( std::memory_order_acquire );
+
+        if( tail == &m_stub )
+        {
+            if( !next )
+                return false;
+
+            // Skip the stub
+            m_tail = next;
+            tail = next;
+            next = next->next.load( std::memory_order_acquire );
+        }
+
+        if( !next )
+        {
+            // The tail is the last node. It cannot be taken while it is the head, producers
+            // link to it: put the stub behind it first.
+            if( tail != m_head.load( std::memory_order_acquire ) )
+                return false;
+
+            push( &m_stub );
+            next = tail->next.load( std::memory_order_acquire );
+
+            if( !next )
+                return false;
+        }
+
+        m_tail = next;
+        aValue = std::move( *tail->value );
+        delete tail;
+        return true;
+    }
+
+    /**
+     * @return true if there is nothing to pop. Consumer thread only.
+     */
+    bool IsEmpty() const
+    {
+        const NODE* tail = m_tail;
+
+        if( tail == &m_stub )
+            return !tail->next.load( std::memory_order_acquire );
+
+        return false;
+    }
+
+private:
+    struct NODE
+    {
+        NODE() :
+                next( nullptr )
+        {
+        }
+
+        explicit NODE( T&& aValue ) :
+                next( nullptr ),
+                value( std::move( aValue ) )
+        {
+        }
+
+        std::atomic<NODE*> next;
+        std::optional<T>   value;    ///< Empty for the stub.
+    };
+
+    void push( NODE* aNode )
+    {
+        aNode->next.store( nullptr, std::memory_order_relaxed );
+        NODE* prev = m_head.exchange( aNode, std::memory_order_acq_rel );
+        prev->next.store( aNode, std::memory_order_release );
+    }
+
+    std::atomic<NODE*> m_head;      ///< Last pushed node, shared by the producers.
+    NODE*              m_tail;      ///< Next node to pop, owned by the consumer.
+    NODE               m_stub;      ///< Keeps the queue non-empty, so producers never touch m_tail.
+};
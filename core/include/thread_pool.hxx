@@ -0,0 +1,142 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * A fixed size pool of worker threads running queued tasks.
+ *
+ * Tasks must not wait for other tasks of the same pool, as all the workers could end up
+ * waiting. ParallelFor() is meant to be called from outside of the pool.
+ */
+class THREAD_POOL
+{
+public:
+    /**
+     * @param aThreadCount is the number of worker threads, 0 for one per hardware thread.
+     */
+    explicit THREAD_POOL( unsigned aThreadCount = 0 );
+
+    ~THREAD_POOL();
+
+    THREAD_POOL( const THREAD_POOL& ) = delete;
+    THREAD_POOL& operator=( const THREAD_POOL& ) = delete;
+
+    unsigned GetThreadCount() const { return static_cast<unsigned>( m_workers.size() ); }
+
+    /**
+     * Queue a task.
+     *
+     * @return a future holding the task result, or the exception it threw.
+     */
+    template <typename F>
+    std::future<std::invoke_result_t<F>> Submit( F&& aTask )
+    {
+        using RESULT = std::invoke_result_t<F>;
+
+        auto task = std::make_shared<std::packaged_task<RESULT()>>( std::forward<F>( aTask ) );
+        std::future<RESULT> result = task->get_future();
+
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            m_tasks.emplace( [task]() { ( *task )(); } );
+        }
+
+        m_condition.notify_one();
+        return result;
+    }
+
+    /**
+     * Call \a aFunc( i ) for every i in [0, aCount) on the pool and the calling thread, and wait
+     * until all calls are done.
+     *
+     * Indices are handed out dynamically in chunks of \a aChunk, so uneven work per index is
+     * balanced between the threads. The first exception thrown by \a aFunc is rethrown.
+     */
+    template <typename F>
+    void ParallelFor( size_t aCount, F&& aFunc, size_t aChunk = 1 )
+    {
+        if( aCount == 0 )
+            return;
+
+        aChunk = std::max<size_t>( aChunk, 1 );
+
+        const size_t chunks = ( aCount + aChunk - 1 ) / aChunk;
+        const size_t helpers = std::min<size_t>( GetThreadCount(), chunks - 1 );
+
+        std::atomic<size_t> next( 0 );
+
+        auto run =
+                [&]()
+                {
+                    for( size_t begin = next.fetch_add( aChunk ); begin < aCount;
+                         begin = next.fetch_add( aChunk ) )
+                    {
+                        const size_t end = std::min( begin + aChunk, aCount );
+
+                        for( size_t i = begin; i < end; ++i )
+                            aFunc( i );
+                    }
+                };
+
+        std::vector<std::future<void>> futures;
+        futures.reserve( helpers );
+
+        for( size_t i = 0; i < helpers; ++i )
+            futures.push_back( Submit( run ) );
+
+        std::exception_ptr error;
+
+        try
+        {
+            run();
+        }
+        catch( ... )
+        {
+            error = std::current_exception();
+            next = aCount;      // make the helpers stop early
+        }
+
+        // Always wait for the helpers, they reference local state
+        for( std::future<void>& future : futures )
+        {
+            try
+            {
+                future.get();
+            }
+            catch( ... )
+            {
+                if( !error )
+                    error = std::current_exception();
+            }
+        }
+
+        if( error )
+            std::rethrow_exception( error );
+    }
+
+private:
+    void workerLoop();
+
+    std::vector<std::thread>          m_workers;
+    std::queue<std::function<void()>> m_tasks;
+    std::mutex                        m_mutex;
+    std::condition_variable           m_condition;
+    bool                              m_stopping;
+};
+
+
+/**
+ * Return the thread pool shared by the application.
+ */
+THREAD_POOL& GetKiCadThreadPool();
@@ -0,0 +1,58 @@
+#include <thread_pool.hxx>
+
+
+THREAD_POOL::THREAD_POOL( unsigned aThreadCount ) :
+        m_stopping( false )
+{
+    if( aThreadCount == 0 )
+        aThreadCount = std::max( 1u, std::thread::hardware_concurrency() );
+
+    m_workers.reserve( aThreadCount );
+
+    for( unsigned i = 0; i < aThreadCount; ++i )
+        m_workers.emplace_back( &THREAD_POOL::workerLoop, this );
+}
+
+
+THREAD_POOL::~THREAD_POOL()
+{
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_stopping = true;
+    }
+
+    m_condition.notify_all();
+
+    for( std::thread& worker : m_workers )
+        worker.join();
+}
+
+
+void THREAD_POOL::workerLoop()
+{
+    while( true )
+    {
+        std::function<void()> task;
+
+        {
+            std::unique_lock<std::mutex> lock( m_mutex );
+            m_condition.wait( lock, [this]() { return m_stopping || !m_tasks.empty(); } );
+
+            // Finish the queued tasks before stopping, somebody may be waiting for them
+            if( m_tasks.empty() )
+                return;
+
+            task = std::move( m_tasks.front() );
+            m_tasks.pop();
+        }
+
+        task();
+    }
+}
+
+
+THREAD_POOL& GetKiCadThreadPool()
+{
+    static THREAD_POOL pool;
+    return pool;
+}
@@ -23,7 +23,9 @@ public:
 		m_layer(F_Cu) {}
 	inline ITEM_TYPE Type() const { return m_structType; }
 	virtual const BOX2I ViewBBox() const override;
-	virtual const BOX2I GetBoundingBox() const;
+	virtual const BOX2D ViewBBoxD() const override;
+	const BOX2I GetBoundingBox() const;
+	virtual const BOX2D GetBoundingBoxD() const;
 
 	virtual std::vector<int> ViewGetLayers() const override;
 
@@ -9,7 +9,10 @@ public:
 	DATA_Circle() = default;
 	DATA_Circle(VECTOR2I, double);
 
-	virtual const BOX2I GetBoundingBox() const override;
+	virtual const BOX2D GetBoundingBoxD() const override;
+	virtual double ViewHitDistance(const VECTOR2D& aPoint) const override;
+	virtual bool ViewHitTest(const SHAPE_LINE_CHAIN& aArea, bool aContained) const override;
+	virtual void ViewGetAnchors(std::vector<VIEW_ANCHOR>& aAnchors) const override;
 	std::string GetClass() const override {
 		return "Circle";
 	}
@@ -1,4 +1,5 @@
 #pragma once
+#include <hash_128.hxx>
 #include "data_circle.hxx"
 #include "data_line.hxx"
 #include "data_rectangle.hxx"
@@ -9,6 +10,22 @@ class DataManager {
 public:
 	DataManager() = default;
 	void GenerateData();
+
+	/**
+	 * Sort the items of each kind along a Hilbert curve of their bbox centers, so that items
+	 * close on the board are close in memory as well and drawing them walks memory mostly
+	 * sequentially.
+	 *
+	 * The items move, so this must be done before they are added to a view.
+	 */
+	void SortSpatially();
+
+	/**
+	 * @return a hash of the geometry of all the items, in their order. Equal hashes mean the
+	 * same items in the same order, so an index snapshot saved for them can be used again
+	 * (see KIGFX::VIEW::LoadIndexSnapshot()).
+	 */
+	HASH_128 GetContentHash() const;
 	std::vector<KIGFX::DATA_Circle>		m_circles;
 	std::vector<KIGFX::DATA_Line>		m_lines;
 	std::vector<KIGFX::DATA_Rectangle>	m_rectangles;
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <vector>
+
 #include "gal/include/painter.hxx"
 #include "data_render_settings.hxx"
 
@@ -20,6 +22,13 @@ public:
 		return &m_dataSettings;
 	}
 	virtual bool Draw(const VIEW_ITEM* aItem, int aLayer) override;
+
+	/**
+	 * Group the items by type and draw the circles, rectangles and lines with one batch
+	 * call each. Large layers are grouped in ranges on the shared thread pool, keeping the
+	 * order of the items within each type.
+	 */
+	virtual bool DrawItems(std::span<VIEW_ITEM* const> aItems, int aLayer) override;
 protected:
 	void draw(const DATA_Triangle* aTriangle, int aLayer);
 	void draw(const DATA_Rectangle* a_Rectangle, int aLayer);
@@ -27,6 +36,27 @@ protected:
 	void draw(const DATA_Circle* aCircle, int aLayer);
 protected:
 	DATA_RENDER_SETTINGS m_dataSettings;
+
+	// Items of the layer drawn by DrawItems(), grouped by type. Kept to reuse the memory.
+	std::vector<VECTOR2D> m_circleCenters;
+	std::vector<double> m_circleRadii;
+	std::vector<VECTOR2D> m_rectangleCorners;
+	std::vector<VECTOR2D> m_linePoints;
+	std::vector<const DATA_Triangle*> m_triangles;
+
+	// Items of each type in a range of the layer, then the index of the first one in the arrays
+	struct RANGE_COUNTS {
+		size_t circles = 0;
+		size_t rectangles = 0;
+		size_t lines = 0;
+		size_t triangles = 0;
+		bool handled = true;
+	};
+
+	std::vector<RANGE_COUNTS> m_ranges;
+
+	// Smallest number of items grouped by a thread
+	static constexpr size_t MIN_RANGE = 16384;
 };
 
 }
\ No newline at end of file
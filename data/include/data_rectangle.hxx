@@ -9,7 +9,9 @@ public:
 	DATA_Rectangle() = default;
 	DATA_Rectangle(VECTOR2I, VECTOR2I);
 
-	virtual const BOX2I GetBoundingBox() const override;
+	virtual const BOX2D GetBoundingBoxD() const override;
+	virtual void ViewGetAnchors(std::vector<VIEW_ANCHOR>& aAnchors) const override;
+	virtual void ViewGetEdges(std::vector<SEG>& aEdges) const override;
 	std::string GetClass() const override {
 		return "Rectangle";
 	}
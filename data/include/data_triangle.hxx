@@ -8,7 +8,11 @@ class DATA_Triangle : public BOARD_ITEM
 public:
 	DATA_Triangle(VECTOR2I, VECTOR2I, VECTOR2I);
 
-	virtual const BOX2I GetBoundingBox() const override;
+	virtual const BOX2D GetBoundingBoxD() const override;
+	virtual double ViewHitDistance(const VECTOR2D& aPoint) const override;
+	virtual bool ViewHitTest(const SHAPE_LINE_CHAIN& aArea, bool aContained) const override;
+	virtual void ViewGetAnchors(std::vector<VIEW_ANCHOR>& aAnchors) const override;
+	virtual void ViewGetEdges(std::vector<SEG>& aEdges) const override;
 	std::string GetClass() const override {
 		return "Triangle";
 	}
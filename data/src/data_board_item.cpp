@@ -8,11 +8,21 @@ const BOX2I BOARD_ITEM::ViewBBox() const
     return GetBoundingBox();
 }
 
+const BOX2D BOARD_ITEM::ViewBBoxD() const
+{
+    return GetBoundingBoxD();
+}
+
 const BOX2I BOARD_ITEM::GetBoundingBox() const
+{
+    return BOX2ISafe(GetBoundingBoxD());
+}
+
+const BOX2D BOARD_ITEM::GetBoundingBoxD() const
 {
     // return a zero-sized box per default. derived classes should override
     // this
-    return BOX2I(VECTOR2I(0, 0), VECTOR2I(0, 0));
+    return BOX2D(VECTOR2D(0, 0), VECTOR2D(0, 0));
 }
 
 std::vector<int> BOARD_ITEM::ViewGetLayers() const
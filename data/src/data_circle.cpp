@@ -1,5 +1,7 @@
 #include "data_circle.hxx"
 
+#include <shape_line_chain.hxx>
+
 using namespace KIGFX;
 
 DATA_Circle::DATA_Circle(VECTOR2I aCenterPoint, double aRadius)
@@ -7,9 +9,31 @@ DATA_Circle::DATA_Circle(VECTOR2I aCenterPoint, double aRadius)
 	  m_centerPoint(aCenterPoint),
 	  m_radius(aRadius) { }
 
-const BOX2I DATA_Circle::GetBoundingBox() const
+const BOX2D DATA_Circle::GetBoundingBoxD() const
+{
+	VECTOR2D pos = m_centerPoint - VECTOR2D(m_radius, m_radius);
+	return BOX2D(pos, VECTOR2D(2 * m_radius, 2 * m_radius));
+}
+
+double DATA_Circle::ViewHitDistance(const VECTOR2D& aPoint) const
 {
-	VECTOR2I pos = m_centerPoint - VECTOR2I(m_radius / 2, m_radius / 2);
-	return BOX2I(pos, VECTOR2I(m_radius, m_radius));
+	// Same as SHAPE_CIRCLE::Collide(), without rounding the center and radius to integers
+	return std::max(0.0, (aPoint - m_centerPoint).EuclideanNorm() - m_radius);
 }
 
+bool DATA_Circle::ViewHitTest(const SHAPE_LINE_CHAIN& aArea, bool aContained) const
+{
+	const VECTOR2I center = KiROUND(m_centerPoint);
+	const bool     centerInside = aArea.PointInside(center);
+	const double   outlineDistance = std::sqrt(static_cast<double>(aArea.SquaredDistance(center, true)));
+
+	if (aContained)
+		return centerInside && outlineDistance >= m_radius;
+
+	return centerInside || outlineDistance <= m_radius;
+}
+
+void DATA_Circle::ViewGetAnchors(std::vector<VIEW_ANCHOR>& aAnchors) const
+{
+	aAnchors.push_back({ m_centerPoint, VIEW_ANCHOR_TYPE::CENTER });
+}
@@ -1,5 +1,7 @@
 #include "data_line.hxx"
 
+#include <seg.hxx>
+
 using namespace KIGFX;
 
 DATA_Line::DATA_Line(VECTOR2I aStartPoint, VECTOR2I aEndPoint) 
@@ -7,11 +9,33 @@ DATA_Line::DATA_Line(VECTOR2I aStartPoint, VECTOR2I aEndPoint)
 	  m_startPoint(aStartPoint),
 	  m_endPoint(aEndPoint) {}
 
-const BOX2I DATA_Line::GetBoundingBox() const
+const BOX2D DATA_Line::GetBoundingBoxD() const
+{
+	double dx = abs(m_endPoint.x - m_startPoint.x);
+	double dy = abs(m_endPoint.y - m_startPoint.y);
+	VECTOR2D pos = { std::min(m_startPoint.x, m_endPoint.x), std::min(m_startPoint.y, m_endPoint.y) };
+	VECTOR2D dis = { dx, dy };
+	return BOX2D(pos, dis);
+}
+
+double DATA_Line::ViewHitDistance(const VECTOR2D& aPoint) const
+{
+	return SEG(m_startPoint, m_endPoint).Distance(KiROUND(aPoint));
+}
+
+bool DATA_Line::ViewHitTest(const SHAPE_LINE_CHAIN& aArea, bool aContained) const
+{
+	return hitTestPolyline(aArea, aContained, { m_startPoint, m_endPoint }, false);
+}
+
+void DATA_Line::ViewGetAnchors(std::vector<VIEW_ANCHOR>& aAnchors) const
+{
+	aAnchors.push_back({ m_startPoint, VIEW_ANCHOR_TYPE::ENDPOINT });
+	aAnchors.push_back({ m_endPoint, VIEW_ANCHOR_TYPE::ENDPOINT });
+	aAnchors.push_back({ (VECTOR2D(m_startPoint) + VECTOR2D(m_endPoint)) / 2, VIEW_ANCHOR_TYPE::MIDPOINT });
+}
+
+void DATA_Line::ViewGetEdges(std::vector<SEG>& aEdges) const
 {
-	int dx = abs(m_endPoint.x - m_startPoint.x);
-	int dy = abs(m_endPoint.y - m_startPoint.y);
-	VECTOR2I pos = { std::min(m_startPoint.x, m_endPoint.x), std::min(m_startPoint.y, m_endPoint.y) };
-	VECTOR2I dis = { dx, dy };
-	return BOX2I(pos, dis);
+	aEdges.emplace_back(m_startPoint, m_endPoint);
 }
@@ -1,6 +1,10 @@
+#include <algorithm>
+#include <cstring>
 #include <random>
 
 #include "data_manager.hxx"
+#include "hilbert_curve.hxx"
+#include "mmh3_hash.hxx"
 
 void DataManager::GenerateData()
 {
@@ -36,4 +40,106 @@ void DataManager::GenerateData()
         double r = distR(gen);
         m_circles.push_back({ VECTOR2D(cx, cy), r });
     }
-}
\ No newline at end of file
+}
+
+template <class T>
+static void sortByHilbertIndex(std::vector<T>& aItems, const BOX2D& aExtents)
+{
+    std::vector<std::pair<uint64_t, size_t>> keys;
+    keys.reserve(aItems.size());
+
+    for (size_t i = 0; i < aItems.size(); ++i)
+        keys.emplace_back(HilbertIndex(aItems[i].ViewBBoxD().Centre(), aExtents), i);
+
+    std::sort(keys.begin(), keys.end());
+
+    std::vector<T> sorted;
+    sorted.reserve(aItems.size());
+
+    for (const auto& [key, index] : keys)
+        sorted.push_back(std::move(aItems[index]));
+
+    aItems = std::move(sorted);
+}
+
+void DataManager::SortSpatially()
+{
+    // One curve over all the items, so that the order of each kind is consistent
+    BOX2D extents;
+    bool  first = true;
+
+    auto merge = [&](const auto& aItems) {
+        for (const auto& item : aItems) {
+            BOX2D bbox = item.ViewBBoxD();
+            bbox.Normalize();
+
+            if (first)
+                extents = bbox;
+            else
+                extents.Merge(bbox);
+
+            first = false;
+        }
+    };
+
+    merge(m_circles);
+    merge(m_lines);
+    merge(m_rectangles);
+    merge(m_triangles);
+
+    sortByHilbertIndex(m_circles, extents);
+    sortByHilbertIndex(m_lines, extents);
+    sortByHilbertIndex(m_rectangles, extents);
+    sortByHilbertIndex(m_triangles, extents);
+}
+
+HASH_128 DataManager::GetContentHash() const
+{
+    MMH3_HASH hash;
+
+    // The hash is fed 32 bits at a time
+    auto add = [&](const auto& aValue) {
+        int32_t words[sizeof(aValue) / sizeof(int32_t)];
+        std::memcpy(words, &aValue, sizeof(aValue));
+
+        for (int32_t word : words)
+            hash.add(word);
+    };
+
+    add(static_cast<int32_t>(m_circles.size()));
+
+    for (const KIGFX::DATA_Circle& circle : m_circles) {
+        add(circle.m_centerPoint.x);
+        add(circle.m_centerPoint.y);
+        add(circle.m_radius);
+    }
+
+    add(static_cast<int32_t>(m_lines.size()));
+
+    for (const KIGFX::DATA_Line& line : m_lines) {
+        add(line.m_startPoint.x);
+        add(line.m_startPoint.y);
+        add(line.m_endPoint.x);
+        add(line.m_endPoint.y);
+    }
+
+    add(static_cast<int32_t>(m_rectangles.size()));
+
+    for (const KIGFX::DATA_Rectangle& rectangle : m_rectangles) {
+        add(rectangle.m_startPoint.x);
+        add(rectangle.m_startPoint.y);
+        add(rectangle.m_endPoint.x);
+        add(rectangle.m_endPoint.y);
+    }
+
+    add(static_cast<int32_t>(m_triangles.size()));
+
+    for (const KIGFX::DATA_Triangle& triangle : m_triangles) {
+        for (const VECTOR2I& point : { triangle.m_point1, triangle.m_point2, triangle.m_point3 }) {
+            add(point.x);
+            add(point.y);
+        }
+    }
+
+    return hash.digest();
+}
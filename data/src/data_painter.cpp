@@ -5,6 +5,9 @@
 #include "data_triangle.hxx"
 #include "data_rectangle.hxx"
 
+#include <algorithm>
+#include <thread_pool.hxx>
+
 KIGFX::DATA_PAINTER::DATA_PAINTER(GAL* aGal)
 	: PAINTER(aGal) { }
 
@@ -33,8 +36,112 @@ bool KIGFX::DATA_PAINTER::Draw(const VIEW_ITEM* aItem, int aLayer) {
 		draw(static_cast<const DATA_Rectangle*>(item), aLayer);
 		break;
 	default:
-		break;
+		return false;
 	}
+
+	return true;
+}
+
+bool KIGFX::DATA_PAINTER::DrawItems(std::span<VIEW_ITEM* const> aItems, int aLayer) {
+	THREAD_POOL& pool = GetKiCadThreadPool();
+	const size_t ranges = std::clamp<size_t>(aItems.size() / MIN_RANGE, 1, pool.GetThreadCount());
+
+	auto range = [&](size_t aRange) {
+		const size_t begin = aItems.size() * aRange / ranges;
+		return aItems.subspan(begin, aItems.size() * (aRange + 1) / ranges - begin);
+	};
+
+	// First count the items of each type in every range, so the ranges can then be grouped
+	// concurrently, each into its own part of the arrays
+	m_ranges.assign(ranges, RANGE_COUNTS());
+
+	pool.ParallelFor(ranges, [&](size_t aRange) {
+		RANGE_COUNTS& counts = m_ranges[aRange];
+
+		for (const VIEW_ITEM* viewItem : range(aRange)) {
+			if (!viewItem->IsBOARD_ITEM()) {
+				counts.handled = false;
+				return;
+			}
+
+			switch (static_cast<const BOARD_ITEM*>(viewItem)->Type())
+			{
+			case ITEM_TYPE::LINE: ++counts.lines; break;
+			case ITEM_TYPE::CIRCLE: ++counts.circles; break;
+			case ITEM_TYPE::TRIANGLE: ++counts.triangles; break;
+			case ITEM_TYPE::RECTANGLE: ++counts.rectangles; break;
+			default:
+				counts.handled = false;
+				return;
+			}
+		}
+	});
+
+	// Nothing is drawn before all the items are known to be handled here
+	RANGE_COUNTS total;
+
+	for (RANGE_COUNTS& counts : m_ranges) {
+		if (!counts.handled)
+			return false;
+
+		const RANGE_COUNTS first = total;
+
+		total.circles += counts.circles;
+		total.rectangles += counts.rectangles;
+		total.lines += counts.lines;
+		total.triangles += counts.triangles;
+		counts = first;
+	}
+
+	m_circleCenters.resize(total.circles);
+	m_circleRadii.resize(total.circles);
+	m_rectangleCorners.resize(2 * total.rectangles);
+	m_linePoints.resize(2 * total.lines);
+	m_triangles.resize(total.triangles);
+
+	pool.ParallelFor(ranges, [&](size_t aRange) {
+		RANGE_COUNTS next = m_ranges[aRange];
+
+		for (const VIEW_ITEM* viewItem : range(aRange)) {
+			const BOARD_ITEM* item = static_cast<const BOARD_ITEM*>(viewItem);
+
+			switch (item->Type())
+			{
+			case ITEM_TYPE::LINE: {
+				const DATA_Line* line = static_cast<const DATA_Line*>(item);
+				m_linePoints[2 * next.lines] = line->m_startPoint;
+				m_linePoints[2 * next.lines++ + 1] = line->m_endPoint;
+				break;
+			}
+			case ITEM_TYPE::CIRCLE: {
+				const DATA_Circle* circle = static_cast<const DATA_Circle*>(item);
+				m_circleCenters[next.circles] = circle->m_centerPoint;
+				m_circleRadii[next.circles++] = circle->m_radius;
+				break;
+			}
+			case ITEM_TYPE::TRIANGLE:
+				m_triangles[next.triangles++] = static_cast<const DATA_Triangle*>(item);
+				break;
+			case ITEM_TYPE::RECTANGLE: {
+				const DATA_Rectangle* rectangle = static_cast<const DATA_Rectangle*>(item);
+				m_rectangleCorners[2 * next.rectangles] = rectangle->m_startPoint;
+				m_rectangleCorners[2 * next.rectangles++ + 1] = rectangle->m_endPoint;
+				break;
+			}
+			default:
+				break;
+			}
+		}
+	});
+
+	m_gal->DrawRectangles(m_rectangleCorners);
+	m_gal->DrawLines(m_linePoints);
+	m_gal->DrawCircles(m_circleCenters, m_circleRadii);
+
+	for (const DATA_Triangle* triangle : m_triangles)
+		draw(triangle, aLayer);
+
+	return true;
 }
 
 void KIGFX::DATA_PAINTER::draw(const DATA_Triangle* aTriangle, int aLayer) {
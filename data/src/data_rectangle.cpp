@@ -7,11 +7,36 @@ DATA_Rectangle::DATA_Rectangle(VECTOR2I aStartPoint, VECTOR2I aEndPoint)
 	  m_startPoint(aStartPoint),
 	  m_endPoint(aEndPoint) { }
 
-const BOX2I DATA_Rectangle::GetBoundingBox() const
+const BOX2D DATA_Rectangle::GetBoundingBoxD() const
 {
 	double dx = abs(m_endPoint.x - m_startPoint.x);
 	double dy = abs(m_endPoint.y - m_startPoint.y);
 	VECTOR2D pos = { std::min(m_startPoint.x, m_endPoint.x), std::min(m_startPoint.y, m_endPoint.y) };
 	VECTOR2D dis = { dx, dy };
-	return BOX2I(pos, dis);
+	return BOX2D(pos, dis);
+}
+
+void DATA_Rectangle::ViewGetAnchors(std::vector<VIEW_ANCHOR>& aAnchors) const
+{
+	const VECTOR2D corners[] = { m_startPoint, VECTOR2D(m_endPoint.x, m_startPoint.y), m_endPoint,
+								 VECTOR2D(m_startPoint.x, m_endPoint.y) };
+
+	for (int i = 0; i < 4; ++i)
+	{
+		aAnchors.push_back({ corners[i], VIEW_ANCHOR_TYPE::CORNER });
+		aAnchors.push_back({ (corners[i] + corners[(i + 1) % 4]) / 2, VIEW_ANCHOR_TYPE::MIDPOINT });
+	}
+
+	aAnchors.push_back({ (m_startPoint + m_endPoint) / 2, VIEW_ANCHOR_TYPE::CENTER });
+}
+
+void DATA_Rectangle::ViewGetEdges(std::vector<SEG>& aEdges) const
+{
+	const VECTOR2I start = KiROUND(m_startPoint);
+	const VECTOR2I end = KiROUND(m_endPoint);
+
+	aEdges.emplace_back(start, VECTOR2I(end.x, start.y));
+	aEdges.emplace_back(VECTOR2I(end.x, start.y), end);
+	aEdges.emplace_back(end, VECTOR2I(start.x, end.y));
+	aEdges.emplace_back(VECTOR2I(start.x, end.y), start);
 }
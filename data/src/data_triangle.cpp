@@ -1,5 +1,7 @@
 #include "data_triangle.hxx"
 
+#include <seg.hxx>
+
 using namespace KIGFX;
 
 DATA_Triangle::DATA_Triangle(VECTOR2I aPoint1, VECTOR2I aPoint2, VECTOR2I aPoint3)
@@ -8,10 +10,38 @@ DATA_Triangle::DATA_Triangle(VECTOR2I aPoint1, VECTOR2I aPoint2, VECTOR2I aPoint
 	  m_point2(aPoint2),
 	  m_point3(aPoint3) {}
 
-const BOX2I DATA_Triangle::GetBoundingBox() const
+const BOX2D DATA_Triangle::GetBoundingBoxD() const
+{
+	VECTOR2D startPoint = { std::min({m_point1.x, m_point2.x, m_point3.x}), std::min({m_point1.y, m_point2.y, m_point3.y}) };
+	VECTOR2D endPoint = { std::max({m_point1.x, m_point2.x, m_point3.x}), std::max({m_point1.y, m_point2.y, m_point3.y}) };
+	VECTOR2D dis = { endPoint.x - startPoint.x, endPoint.y - startPoint.y };
+	return BOX2D(startPoint, dis);
+}
+
+double DATA_Triangle::ViewHitDistance(const VECTOR2D& aPoint) const
+{
+	// Drawn as an open polyline, see DATA_PAINTER
+	const VECTOR2I point = KiROUND(aPoint);
+
+	return std::min(SEG(m_point1, m_point2).Distance(point), SEG(m_point2, m_point3).Distance(point));
+}
+
+bool DATA_Triangle::ViewHitTest(const SHAPE_LINE_CHAIN& aArea, bool aContained) const
+{
+	return hitTestPolyline(aArea, aContained, { m_point1, m_point2, m_point3 }, false);
+}
+
+void DATA_Triangle::ViewGetAnchors(std::vector<VIEW_ANCHOR>& aAnchors) const
+{
+	aAnchors.push_back({ m_point1, VIEW_ANCHOR_TYPE::ENDPOINT });
+	aAnchors.push_back({ m_point2, VIEW_ANCHOR_TYPE::CORNER });
+	aAnchors.push_back({ m_point3, VIEW_ANCHOR_TYPE::ENDPOINT });
+	aAnchors.push_back({ (VECTOR2D(m_point1) + VECTOR2D(m_point2)) / 2, VIEW_ANCHOR_TYPE::MIDPOINT });
+	aAnchors.push_back({ (VECTOR2D(m_point2) + VECTOR2D(m_point3)) / 2, VIEW_ANCHOR_TYPE::MIDPOINT });
+}
+
+void DATA_Triangle::ViewGetEdges(std::vector<SEG>& aEdges) const
 {
-	VECTOR2I startPoint = { std::min({m_point1.x, m_point2.x, m_point3.x}), std::min({m_point1.x, m_point2.x, m_point3.x}) };
-	VECTOR2I endPoint = { std::max({m_point1.x, m_point2.x, m_point3.x}), std::max({m_point1.x, m_point2.x, m_point3.x}) };
-	VECTOR2I dis = { endPoint.x - startPoint.x, endPoint.y - startPoint.y };
-	return BOX2I(startPoint, dis);
-}
\ No newline at end of file
+	aEdges.emplace_back(m_point1, m_point2);
+	aEdges.emplace_back(m_point2, m_point3);
+}
@@ -1,11 +1,13 @@
 #ifndef CACHED_CONTAINER_H_
 #define CACHED_CONTAINER_H_
 
-#include <map>
+#include <cstdint>
 #include <set>
+#include <vector>
 #include <QOpenGLBuffer>
 
 #include "vertex_container.hxx"
+#include "tlsf_allocator.hxx"
 
 namespace KIGFX
 {
@@ -73,18 +75,76 @@ public:
 
     virtual unsigned int AllItemsSize() const { return 0; }
 
-protected:
-    ///< Maps size of free memory chunks to their offsets
-    typedef std::pair<unsigned int, unsigned int> CHUNK;
-    typedef std::multimap<unsigned int, unsigned int> FREE_CHUNK_MAP;
+    ///< Fragmentation of the free space in the container
+    struct FRAGMENTATION
+    {
+        unsigned int freeSpace;         ///< Free vertices in all the free chunks
+        unsigned int freeChunks;        ///< Number of free chunks
+        unsigned int largestFreeChunk;  ///< Size of the largest free chunk
+        unsigned int defragmentations;  ///< Full defragmentations since the container creation
+
+        ///< 0 when the free space is a single chunk, close to 1 when it is scattered
+        double Ratio() const
+        {
+            return freeSpace ? 1.0 - double( largestFreeChunk ) / freeSpace : 0.0;
+        }
+    };
+
+    /**
+     * Return the current fragmentation of the container.
+     */
+    FRAGMENTATION GetFragmentation() const;
+
+    ///< Progress of the incremental compaction
+    struct COMPACTION
+    {
+        unsigned int itemsMoved;        ///< Items moved by the last compaction step
+        unsigned int bytesMoved;        ///< Bytes moved by the last compaction step
+        uint64_t     totalBytesMoved;   ///< Bytes moved since the container creation
+        bool         active;            ///< Whether a compaction pass is in progress
+    };
+
+    /**
+     * Return the progress of the incremental compaction, the remaining fragmentation is given
+     * by GetFragmentation().
+     */
+    const COMPACTION& GetCompaction() const
+    {
+        return m_compaction;
+    }
+
+    /**
+     * Set the amount of data moved at most by a compaction step, run once per Map().
+     *
+     * @param aBytes is the step budget, 0 disables the incremental compaction.
+     */
+    void SetCompactionBudget( unsigned int aBytes )
+    {
+        m_compactionBudget = aBytes;
+    }
+
+    ///< Fragmentation ratio starting a compaction pass
+    static constexpr double COMPACTION_START = 0.25;
 
+    ///< Default compaction step budget, in bytes
+    static constexpr unsigned int DEFAULT_COMPACTION_BUDGET = 4 * 1024 * 1024;
+
+protected:
     /// List of all the stored items
     typedef std::set<VERTEX_ITEM*> ITEMS;
 
+    ///< Chunk of vertices moved by the compaction, the ranges never overlap
+    struct CHUNK_MOVE
+    {
+        unsigned int from;
+        unsigned int to;
+        unsigned int size;
+    };
+
     /**
-     * Resize the chunk that stores the current item to the given size. The current item has
-     * its offset adjusted after the call, and the new chunk parameters are stored
-     * in m_chunkOffset and m_chunkSize.
+     * Resize the chunk that stores the current item to the given size, in place if possible.
+     * Otherwise the item is moved, having its offset adjusted after the call, and the new chunk
+     * parameters are stored in m_chunkOffset and m_chunkSize.
      *
      * @param aSize is the requested chunk size.
      * @return true in case of success, false otherwise.
@@ -111,38 +171,57 @@ protected:
     void defragment( VERTEX* aTarget );
 
     /**
-     * Look for consecutive free memory chunks and merges them, decreasing fragmentation of
-     * memory.
+     * Set up the chunks after the items have been moved one after another to the beginning of
+     * a container of m_currentSize vertices, e.g. by defragmentResize().
      */
-    void mergeFreeChunks();
+    void resetChunks();
 
     /**
-     * Return the size of a chunk.
+     * Run a step of the incremental compaction, when the free space is fragmented enough.
      *
-     * @param aChunk is the chunk.
+     * The items at the end of the container are moved to the lowest free chunks they fit in,
+     * within the step budget, so the free space gathers at the end over a few frames instead of
+     * stopping a frame for defragmentResize(). Nothing is moved while an item is edited.
      */
-    inline int getChunkSize( const CHUNK& aChunk ) const
-    {
-        return aChunk.first;
-    }
+    void compact();
 
     /**
-     * Return the offset of a chunk.
-     *
-     * @param aChunk is the chunk.
+     * Move the vertices of chunks within the container, in the given order. The default
+     * implementation copies the mapped vertices.
      */
-    inline unsigned int getChunkOffset( const CHUNK& aChunk ) const
-    {
-        return aChunk.second;
-    }
+    virtual void moveChunks( const std::vector<CHUNK_MOVE>& aMoves );
 
-    /**
-     * Add a chunk marked as a free space.
-     */
-    void addFreeChunk( unsigned int aOffset, unsigned int aSize );
+    ///< Return the index of the lowest compaction hole of at least aSize, or -1 if none
+    int findHole( unsigned int aSize ) const;
+
+    ///< Update the size of a compaction hole in the search tree
+    void updateHole( unsigned int aIndex, unsigned int aSize );
+
+    ///< Allocator of the chunks, free chunks are merged as soon as they are freed
+    TLSF_ALLOCATOR m_allocator;
+
+    ///< Number of full defragmentations so far
+    unsigned int m_defragmentations;
+
+    ///< Items left to move in the current compaction pass with their offsets, a max-heap once
+    ///< gathered, and the last item gathered
+    std::vector<std::pair<unsigned int, VERTEX_ITEM*>> m_compactionQueue;
+    VERTEX_ITEM*                                       m_compactionScan;
+
+    ///< Free chunks when the items are gathered as (offset, size), in offset order, and a tree of
+    ///< their maximal sizes (leaves from m_compactionTree.size() / 2) for first fit queries,
+    ///< empty while the items are being gathered
+    std::vector<std::pair<unsigned int, unsigned int>> m_compactionHoles;
+    std::vector<unsigned int>                          m_compactionTree;
+
+    unsigned int m_compactionBudget;
+    COMPACTION   m_compaction;
+
+    ///< Bytes moved before the current pass
+    uint64_t m_compactionPassStart;
 
-    ///< Store size & offset of free chunks.
-    FREE_CHUNK_MAP  m_freeChunks;
+    ///< Fragmentation ratio starting the next pass, raised after a pass that moved nothing
+    double m_compactionResume;
 
     ///< Stored VERTEX_ITEMs
     ITEMS m_items;
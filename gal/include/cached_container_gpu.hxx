@@ -77,6 +77,9 @@ protected:
     bool defragmentResize( unsigned int aNewSize ) override;
     bool defragmentResizeMemcpy( unsigned int aNewSize );
 
+    ///< Move the chunks with glCopyBufferSubData() when the buffer is not mapped
+    void moveChunks( const std::vector<CHUNK_MOVE>& aMoves ) override;
+
     ///< Flag saying if vertex buffer is currently mapped
     bool m_isMapped;
 
@@ -48,8 +48,11 @@ public:
     CACHED_CONTAINER_RAM( unsigned int aSize = DEFAULT_SIZE );
     ~CACHED_CONTAINER_RAM();
 
-    ///< @copydoc VERTEX_CONTAINER::Unmap()
-    void Map() override {}
+    ///< @copydoc VERTEX_CONTAINER::Map()
+    void Map() override
+    {
+        compact();
+    }
 
     ///< @copydoc VERTEX_CONTAINER::Unmap()
     void Unmap() override;
@@ -86,6 +86,11 @@ namespace KIGFX
         ///< The pixel scale factor (>1 for hi-DPI scaled displays)
         double m_scaleFactor;
 
+        ///< Draw circles, rectangles and segments of non-cached targets as GPU instances. They
+        ///< are drawn interleaved with the other primitives in submission order, so overlaps
+        ///< at the same depth look the same as without instancing
+        bool m_glInstancing;
+
         void NotifyChanged();
     };
 
@@ -40,6 +40,7 @@ class VERTEX_CONTAINER;
 class VERTEX_ITEM;
 class CACHED_CONTAINER;
 class NONCACHED_CONTAINER;
+class INSTANCE_CONTAINER;
 
 /**
  * Class to handle uploading vertices and indices to GPU in drawing purposes.
@@ -99,6 +100,15 @@ protected:
     ///< true: enable Z test when drawing
     bool m_enableDepthTest;
 
+    /**
+     * Bind the vertex array and the vertex buffer, creating them on first use.
+     *
+     * They are kept until the manager is destroyed, so flushing several times per frame (e.g.
+     * when the clip area changes) does not allocate new GL objects.
+     */
+    void bindVertexArray();
+
+    ///< Vertex array and vertex buffer of the manager, created by bindVertexArray()
     GLuint vao = 0, vbo = 0;
 };  
 
@@ -177,6 +187,7 @@ class GPU_NONCACHED_MANAGER : public GPU_MANAGER
 {
 public:
     GPU_NONCACHED_MANAGER( VERTEX_CONTAINER* aContainer );
+    ~GPU_NONCACHED_MANAGER();
 
     ///< @copydoc GPU_MANAGER::BeginDrawing()
     virtual void BeginDrawing() override;
@@ -186,6 +197,33 @@ public:
 
     ///< @copydoc GPU_MANAGER::EndDrawing()
     virtual void EndDrawing() override;
+
+    /**
+     * Set the container of primitives drawn as instances, interleaved with the vertices in
+     * submission order.
+     */
+    void SetInstances( INSTANCE_CONTAINER* aInstances )
+    {
+        m_instances = aInstances;
+    }
+
+protected:
+    /**
+     * Draw the stored instances and the uploaded vertices in submission order, with an
+     * instanced draw call per run of primitives of the same type.
+     *
+     * @param aVertexCount is the number of vertices uploaded to the vertex array.
+     */
+    void drawInstances( unsigned int aVertexCount );
+
+    ///< Draw the uploaded vertices in [aFirst, aEnd)
+    void drawVertices( unsigned int aFirst, unsigned int aEnd );
+
+    ///< Primitives drawn as instances, cleared after drawing
+    INSTANCE_CONTAINER* m_instances;
+
+    ///< Vertex array, unit quad and per-instance buffers for instanced drawing
+    GLuint m_instanceVao, m_quadVbo, m_instanceVbo;
 };
 
 } // namespace KIGFX
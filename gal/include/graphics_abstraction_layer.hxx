@@ -4,6 +4,7 @@
 #include <deque>
 #include <stack>
 #include <limits>
+#include <span>
 
 #include "matrix3x3.hxx"
 
@@ -91,6 +92,17 @@ public:
      */
     virtual void DrawLine( const VECTOR2D& aStartPoint, const VECTOR2D& aEndPoint ) {};
 
+    /**
+     * Draw a batch of lines, like DrawLine() for each of them.
+     *
+     * @param aPoints are the start and end points of the lines, in pairs.
+     */
+    virtual void DrawLines( std::span<const VECTOR2D> aPoints )
+    {
+        for( size_t i = 0; i + 1 < aPoints.size(); i += 2 )
+            DrawLine( aPoints[i], aPoints[i + 1] );
+    }
+
     /**
      * Draw a rounded segment.
      *
@@ -137,6 +149,19 @@ public:
      */
     virtual void DrawCircle( const VECTOR2D& aCenterPoint, double aRadius ) {};
 
+    /**
+     * Draw a batch of circles, like DrawCircle() for each of them.
+     *
+     * @param aCenterPoints are the center points of the circles.
+     * @param aRadii are the radii of the circles, one per center point.
+     */
+    virtual void DrawCircles( std::span<const VECTOR2D> aCenterPoints,
+                              std::span<const double> aRadii )
+    {
+        for( size_t i = 0; i < aCenterPoints.size(); ++i )
+            DrawCircle( aCenterPoints[i], aRadii[i] );
+    }
+
     /**
      * Draw an arc.
      *
@@ -185,6 +210,17 @@ public:
         DrawRectangle( aRect.GetOrigin(), aRect.GetEnd() );
     }
 
+    /**
+     * Draw a batch of rectangles, like DrawRectangle() for each of them.
+     *
+     * @param aCorners are the start and end points of the rectangles, in pairs.
+     */
+    virtual void DrawRectangles( std::span<const VECTOR2D> aCorners )
+    {
+        for( size_t i = 0; i + 1 < aCorners.size(); i += 2 )
+            DrawRectangle( aCorners[i], aCorners[i + 1] );
+    }
+
     /**
      * Draw a polygon representing a font glyph.
      */
@@ -684,6 +720,29 @@ public:
      */
     virtual void ClearTarget( RENDER_TARGET aTarget ) {};
 
+    /**
+     * Restrict clearing and drawing to an area of the screen, until the current drawing ends
+     * (see EndDrawing()).
+     *
+     * Used to redraw only the parts of the targets that changed, the rest of their contents is
+     * kept from the previous frame. It may be called several times during a drawing; what was
+     * drawn before stays clipped to the previous area.
+     *
+     * @param aArea is the area in screen pixels.
+     */
+    virtual void SetClipArea( const BOX2I& aArea ) {};
+
+    /**
+     * Shift the contents the render targets kept from the previous frame, e.g. to reuse them
+     * when the view is panned.
+     *
+     * The uncovered parts of the targets are left with stale contents and have to be redrawn.
+     *
+     * @param aDelta is the shift in screen pixels.
+     * @return false if the targets cannot be scrolled, they have to be redrawn whole then.
+     */
+    virtual bool ScrollTargets( const VECTOR2I& aDelta ) { return false; };
+
     /**
      * Return true if the target exists.
      *
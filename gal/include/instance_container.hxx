@@ -0,0 +1,123 @@
+/**
+ * @file instance_container.hxx
+ * @brief Class to store primitives drawn by instancing, without caching. Like the
+ * NONCACHED_CONTAINER, it is filled for one frame and cleared once drawn.
+ */
+
+#ifndef INSTANCE_CONTAINER_H_
+#define INSTANCE_CONTAINER_H_
+
+#include "gal/include/vertex_common.hxx"
+
+#include <array>
+#include <vector>
+
+namespace KIGFX
+{
+class INSTANCE_CONTAINER
+{
+public:
+    ///< Primitives of one type submitted one after another, with no vertices in between
+    struct RUN
+    {
+        SHADER_MODE  type;
+        size_t       first;     ///< Index of the first primitive in Get( type )
+        size_t       count;
+        unsigned int vertices;  ///< Number of vertices submitted before the run
+    };
+
+    /**
+     * Add a primitive.
+     *
+     * @param aType is the primitive type, one of SHADER_INSTANCED_*.
+     * @param aInstance is the primitive data.
+     * @param aVertices is the number of vertices submitted so far in the frame.
+     */
+    void Add( SHADER_MODE aType, const INSTANCE& aInstance, unsigned int aVertices )
+    {
+        std::vector<INSTANCE>& instances = m_instances[aType - SHADER_INSTANCED_CIRCLE];
+
+        addRun( aType, instances.size(), 1, aVertices );
+        instances.push_back( aInstance );
+        ++m_count;
+    }
+
+    /**
+     * Add primitives to be filled by the caller.
+     *
+     * @param aType is the primitive type, one of SHADER_INSTANCED_*.
+     * @param aCount is the number of primitives to add.
+     * @param aVertices is the number of vertices submitted so far in the frame.
+     * @return the first of the added primitives, valid until the next call to Add().
+     */
+    INSTANCE* Add( SHADER_MODE aType, size_t aCount, unsigned int aVertices )
+    {
+        std::vector<INSTANCE>& instances = m_instances[aType - SHADER_INSTANCED_CIRCLE];
+        const size_t           first = instances.size();
+
+        addRun( aType, first, aCount, aVertices );
+        instances.resize( first + aCount );
+        m_count += aCount;
+
+        return instances.data() + first;
+    }
+
+    /**
+     * Return the primitives of the given type, one of SHADER_INSTANCED_*.
+     */
+    const std::vector<INSTANCE>& Get( SHADER_MODE aType ) const
+    {
+        return m_instances[aType - SHADER_INSTANCED_CIRCLE];
+    }
+
+    /**
+     * Return the runs of primitives in submission order. Drawing them interleaved with the
+     * vertices keeps the visibility of overlapping primitives at the same depth.
+     */
+    const std::vector<RUN>& GetRuns() const
+    {
+        return m_runs;
+    }
+
+    /**
+     * Return the number of primitives stored, of all types.
+     */
+    size_t GetSize() const
+    {
+        return m_count;
+    }
+
+    /**
+     * Remove all the primitives, keeping the memory for the next frame.
+     */
+    void Clear()
+    {
+        for( std::vector<INSTANCE>& instances : m_instances )
+            instances.clear();
+
+        m_runs.clear();
+        m_count = 0;
+    }
+
+private:
+    ///< Extend the last run if it has the same type and no vertices were submitted since
+    void addRun( SHADER_MODE aType, size_t aFirst, size_t aCount, unsigned int aVertices )
+    {
+        if( !m_runs.empty() && m_runs.back().type == aType && m_runs.back().vertices == aVertices )
+            m_runs.back().count += aCount;
+        else
+            m_runs.push_back( { aType, aFirst, aCount, aVertices } );
+    }
+
+    ///< Primitives of each type
+    std::array<std::vector<INSTANCE>, INSTANCE_TYPE_COUNT> m_instances;
+
+    ///< Submission order of the primitives
+    std::vector<RUN> m_runs;
+
+    ///< Number of primitives of all types
+    size_t m_count = 0;
+};
+} // namespace KIGFX
+
+#endif /* INSTANCE_CONTAINER_H_ */
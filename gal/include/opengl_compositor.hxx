@@ -62,6 +62,26 @@ public:
     void     DrawBuffer( unsigned int aSourceHandle, unsigned int aDestHandle );
     unsigned int CreateBuffer( VECTOR2I aDimensions );
 
+    /**
+     * Create the scratch buffer used by ScrollBuffer() if needed and check that it can be used
+     * for a buffer, so that several buffers can be checked before any of them is scrolled.
+     *
+     * @param aBufferHandle is the handle of the buffer, as returned by CreateBuffer().
+     * @return false if ScrollBuffer() would fail for the buffer.
+     */
+    bool PrepareScroll( unsigned int aBufferHandle );
+
+    /**
+     * Shift the contents of a buffer, e.g. to reuse the previous frame when the view is panned.
+     *
+     * The uncovered part of the buffer keeps stale contents.
+     *
+     * @param aBufferHandle is the handle of the buffer, as returned by CreateBuffer().
+     * @param aDelta is the shift in buffer pixels, y pointing down as on the screen.
+     * @return false if the buffer could not be scrolled.
+     */
+    bool ScrollBuffer( unsigned int aBufferHandle, const VECTOR2I& aDelta );
+
     void SetAntialiasingMode( GAL_ANTIALIASING_MODE aMode ); // clears all buffers
     GAL_ANTIALIASING_MODE GetAntialiasingMode() const;
 
@@ -107,6 +127,9 @@ protected:
     GLuint          m_curFbo;
 
     GAL_ANTIALIASING_MODE m_currentAntialiasingMode;
+
+    /// Scratch buffer for ScrollBuffer(), created on first use (0 if none)
+    unsigned int    m_scrollBuffer;
     std::unique_ptr<OPENGL_PRESENTOR> m_antialiasing;
 };
 } // namespace KIGFX
@@ -95,6 +95,9 @@ public:
     /// @copydoc GAL::DrawLine()
     void DrawLine( const VECTOR2D& aStartPoint, const VECTOR2D& aEndPoint ) override;
 
+    /// @copydoc GAL::DrawLines()
+    void DrawLines( std::span<const VECTOR2D> aPoints ) override;
+
     /// @copydoc GAL::DrawSegment()
     void DrawSegment( const VECTOR2D& aStartPoint, const VECTOR2D& aEndPoint,
                               double aWidth ) override;
@@ -106,6 +109,10 @@ public:
     /// @copydoc GAL::DrawCircle()
     void DrawCircle( const VECTOR2D& aCenterPoint, double aRadius ) override;
 
+    /// @copydoc GAL::DrawCircles()
+    void DrawCircles( std::span<const VECTOR2D> aCenterPoints,
+                      std::span<const double> aRadii ) override;
+
     /// @copydoc GAL::DrawArc()
     void DrawArc( const VECTOR2D& aCenterPoint, double aRadius, const EDA_ANGLE& aStartAngle,
                   const EDA_ANGLE& aAngle ) override;
@@ -117,6 +124,9 @@ public:
     /// @copydoc GAL::DrawRectangle()
     void DrawRectangle( const VECTOR2D& aStartPoint, const VECTOR2D& aEndPoint ) override;
 
+    /// @copydoc GAL::DrawRectangles()
+    void DrawRectangles( std::span<const VECTOR2D> aCorners ) override;
+
     /// @copydoc GAL::DrawPolyline()
     void DrawPolyline( const std::deque<VECTOR2D>& aPointList ) override;
     void DrawPolyline( const std::vector<VECTOR2D>& aPointList ) override;
@@ -232,6 +242,12 @@ public:
     /// @copydoc GAL::ClearTarget()
     void ClearTarget( RENDER_TARGET aTarget ) override;
 
+    /// @copydoc GAL::SetClipArea()
+    void SetClipArea( const BOX2I& aArea ) override;
+
+    /// @copydoc GAL::ScrollTargets()
+    bool ScrollTargets( const VECTOR2I& aDelta ) override;
+
     /// @copydoc GAL::HasTarget()
     virtual bool HasTarget( RENDER_TARGET aTarget ) override;
 
@@ -285,6 +301,12 @@ public:
 
     void UnlockContext( int aClientCookie ) override;
 
+    /**
+     * Return the number of bytes of vertex and instance data the non-cached target will
+     * upload at the next EndDrawing().
+     */
+    size_t GetNonCachedDataSize() const;
+
     /// @copydoc GAL::BeginDrawing()
     void BeginDrawing() override;
 
@@ -333,6 +355,12 @@ private:
     /// Container for storing temp (diff mode) VERTEX_ITEMs
     VERTEX_MANAGER*         m_tempManager;
 
+    /// Outline lines of the rectangles drawn by DrawRectangles(), reused between calls
+    std::vector<VECTOR2D>   m_batchLines;
+
+    /// Vertex coordinates of the triangle fans drawn by DrawArc(), reused between calls
+    std::vector<GLfloat>    m_batchXY;
+
     // Framebuffer & compositing
     OPENGL_COMPOSITOR*      m_compositor;       ///< Handles multiple rendering targets
     unsigned int            m_mainBuffer;       ///< Main rendering target
@@ -352,6 +380,7 @@ private:
                                                         ///< done when the window is visible
     bool                    m_isGrouping;               ///< Was a group started?
     bool                    m_isContextLocked;          ///< Used for assertion checking
+    bool                    m_isClipAreaSet;            ///< Is the scissor test enabled?
     int                     m_lockClientCookie;
     GLint                   ufm_worldPixelSize;
     GLint                   ufm_screenPixelSize;
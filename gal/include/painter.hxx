@@ -1,4 +1,5 @@
 #pragma once
+#include <span>
 
 #include "gal/include/opengl_gal.hxx"
 #include "render_settings.hxx"
@@ -30,6 +31,32 @@ public:
         */
     virtual bool Draw(const VIEW_ITEM* aItem, int aLayer) = 0;
 
+    /**
+     * Draw at once the items of a layer drawn in immediate mode, e.g. to group them by type
+     * and draw each group with the batch primitives of the GAL (DrawCircles() etc.).
+     *
+     * The items may be drawn in any order. The default implementation draws nothing, so
+     * the items are drawn one by one with Draw().
+     *
+     * @param aItems are the visible items of the layer.
+     * @param aLayer is the layer being drawn.
+     * @return true if the items were drawn, false if none was.
+     */
+    virtual bool DrawItems(std::span<VIEW_ITEM* const> aItems, int aLayer);
+
+    /**
+     * Draw a group of items too small to be seen one by one at the current zoom.
+     *
+     * The default implementation fills \a aArea with the current stroke color, made more
+     * transparent the less of the area is covered by the items. Painters that color items by
+     * layer should override it.
+     *
+     * @param aArea is the bounding box of the items.
+     * @param aCoverage is the fraction of \a aArea covered by the items, between 0 and 1.
+     * @param aLayer is the layer of the items.
+     */
+    virtual void DrawAggregate(const BOX2D& aArea, double aCoverage, int aLayer);
+
     /**
      * Changes Graphics Abstraction Layer used for drawing items for a new one.
      *
@@ -0,0 +1,166 @@
+/**
+ * @file tlsf_allocator.hxx
+ * @brief Two-level segregated fit allocator of ranges of vertex indices, used by the cached
+ * containers to manage their vertex buffers.
+ */
+
+#ifndef TLSF_ALLOCATOR_H_
+#define TLSF_ALLOCATOR_H_
+
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace KIGFX
+{
+/**
+ * Allocator of ranges in [0, size), with constant time allocation and freeing.
+ *
+ * Free blocks are kept in lists segregated by size: a first level for each power of two,
+ * split in SL_COUNT linear second level classes. Bitmaps of the non-empty lists give the
+ * smallest class fitting a request in a couple of bit scans. Freed blocks are merged with
+ * their free neighbors right away, so two free blocks are never adjacent.
+ *
+ * The block data is kept apart from the managed range, as it is usually a vertex buffer that
+ * may live in video memory.
+ */
+class TLSF_ALLOCATOR
+{
+public:
+    ///< Returned when a request cannot be satisfied
+    static constexpr unsigned int NONE = std::numeric_limits<unsigned int>::max();
+
+    /**
+     * @param aSize is the size of the managed range, all free at first.
+     */
+    TLSF_ALLOCATOR( unsigned int aSize = 0 );
+
+    /**
+     * Free everything and set the size of the managed range.
+     */
+    void Reset( unsigned int aSize );
+
+    /**
+     * Allocate a block.
+     *
+     * @param aSize is the block size, greater than 0.
+     * @return the block offset or NONE if there is no free block large enough.
+     */
+    unsigned int Allocate( unsigned int aSize );
+
+    /**
+     * Allocate a block at a given offset, which has to be the start of a free block. Blocks
+     * claimed one after another from the start of a reset allocator rebuild a compacted
+     * layout.
+     *
+     * @return false if there is no free block large enough at \a aOffset.
+     */
+    bool Claim( unsigned int aOffset, unsigned int aSize );
+
+    /**
+     * Free a block returned by Allocate() or Claim().
+     */
+    void Free( unsigned int aOffset );
+
+    /**
+     * Shrink a block, or grow it in place if the block after it is free and large enough.
+     *
+     * @return false if the block cannot grow in place, it is unchanged then.
+     */
+    bool Resize( unsigned int aOffset, unsigned int aSize );
+
+    /**
+     * Return the size of an allocated block.
+     */
+    unsigned int GetBlockSize( unsigned int aOffset ) const;
+
+    /**
+     * Return the total size of the free blocks.
+     */
+    unsigned int GetFreeSpace() const
+    {
+        return m_freeSpace;
+    }
+
+    /**
+     * Return the number of free blocks.
+     */
+    unsigned int GetFreeBlockCount() const
+    {
+        return m_freeBlocks;
+    }
+
+    /**
+     * Return the size of the largest free block.
+     */
+    unsigned int GetLargestFreeBlock() const;
+
+    /**
+     * Return the free blocks as (offset, size) pairs, in offset order.
+     */
+    std::vector<std::pair<unsigned int, unsigned int>> GetFreeBlocks() const;
+
+private:
+    ///< Second level classes per power of two (log2)
+    static constexpr unsigned int SL_LOG2 = 4;
+    static constexpr unsigned int SL_COUNT = 1 << SL_LOG2;
+
+    ///< First level classes: sizes below SL_COUNT share the first one, then a power of two each
+    static constexpr unsigned int FL_COUNT = 32 - SL_LOG2 + 1;
+
+    ///< Index of the missing block
+    static constexpr unsigned int NIL = std::numeric_limits<unsigned int>::max();
+
+    struct BLOCK
+    {
+        unsigned int offset;
+        unsigned int size;
+        bool         free;
+
+        ///< Neighbors in the managed range
+        unsigned int prevPhys;
+        unsigned int nextPhys;
+
+        ///< Neighbors in the list of free blocks of the same class
+        unsigned int prevFree;
+        unsigned int nextFree;
+    };
+
+    ///< Return the first and second level class of a size
+    static void mapping( unsigned int aSize, unsigned int& aFl, unsigned int& aSl );
+
+    ///< Return a free block of at least aSize in the smallest class that fits, or NIL
+    unsigned int findFree( unsigned int aSize ) const;
+
+    unsigned int newBlock( unsigned int aOffset, unsigned int aSize );
+    void         deleteBlock( unsigned int aBlock );
+
+    void insertFree( unsigned int aBlock );
+    void removeFree( unsigned int aBlock );
+
+    ///< Turn the end of a block into a new free block, merged with the following free block
+    void splitFree( unsigned int aBlock, unsigned int aSize );
+
+    ///< Take aSize from the start of a free block for an allocation, freeing the rest
+    unsigned int use( unsigned int aBlock, unsigned int aSize );
+
+    ///< Block data, with the unused entries chained in m_unused by nextPhys
+    std::vector<BLOCK> m_blocks;
+    unsigned int       m_unused;
+
+    ///< Blocks by offset
+    std::unordered_map<unsigned int, unsigned int> m_blockAt;
+
+    ///< Heads of the free lists and bitmaps of the non-empty ones
+    unsigned int  m_heads[FL_COUNT][SL_COUNT];
+    uint32_t      m_flBitmap;
+    uint32_t      m_slBitmap[FL_COUNT];
+
+    unsigned int m_freeSpace;
+    unsigned int m_freeBlocks;
+};
+} // namespace KIGFX
+
+#endif /* TLSF_ALLOCATOR_H_ */
@@ -27,19 +27,30 @@ enum SHADER_MODE
     SHADER_LINE_C = 7,
     SHADER_LINE_D = 8,
     SHADER_LINE_E = 9,
-    SHADER_LINE_F = 10
+    SHADER_LINE_F = 10,
+    SHADER_INSTANCED_CIRCLE = 12,
+    SHADER_INSTANCED_RECT = 13,
+    SHADER_INSTANCED_SEGMENT = 14
 };
 
-///< Data structure for vertices {X,Y,Z,R,G,B,A,shader&param}
+///< Number of primitive types that can be drawn as instances (SHADER_INSTANCED_*)
+static constexpr int INSTANCE_TYPE_COUNT = SHADER_INSTANCED_SEGMENT - SHADER_INSTANCED_CIRCLE + 1;
+
+///< Data structure for vertices {X,Y,Z,R,G,B,A,shader params,shader type}, packed in 32 bytes
+///< The color is normalized by the vertex attribute setup and the shader type is converted to
+///< float. Coordinates and shader parameters stay in floats as they are in world units.
 struct VERTEX
 {
-    GLfloat x, y, z;        // Coordinates
-    GLfloat r, g, b, a;     // Color
-    GLfloat shader[4];      // Shader type & params
+    GLfloat  x, y, z;       // Coordinates
+    GLubyte  r, g, b, a;    // Color
+    GLfloat  shader[3];     // Shader params
+    GLushort mode;          // Shader type
+    GLushort reserved;      // Padding to keep the vertices 4-byte aligned
 };
 
+static_assert( sizeof( VERTEX ) == 32, "VERTEX has to be packed" );
+
 static constexpr size_t VERTEX_SIZE   = sizeof( VERTEX );
-static constexpr size_t VERTEX_STRIDE = VERTEX_SIZE / sizeof( GLfloat );
 
 static constexpr size_t COORD_OFFSET  = offsetof( VERTEX, x );
 static constexpr size_t COORD_SIZE    = sizeof( VERTEX::x ) + sizeof( VERTEX::y ) +
@@ -56,8 +67,26 @@ static constexpr size_t SHADER_OFFSET = offsetof( VERTEX, shader );
 static constexpr size_t SHADER_SIZE = sizeof( VERTEX::shader );
 static constexpr size_t SHADER_STRIDE = SHADER_SIZE / sizeof( GLfloat );
 
+static constexpr size_t MODE_OFFSET = offsetof( VERTEX, mode );
+
 static constexpr size_t INDEX_SIZE = sizeof( GLuint );
 
+///< Data structure for primitives drawn by instancing a unit quad, which the vertex shader
+///< expands according to the SHADER_INSTANCED_* mode of the draw call
+struct INSTANCE
+{
+    GLfloat geometry[4];    // Circle: center & radius, rectangle & segment: start & end points
+    GLfloat width;          // Circle: stroke width (0 if filled), segment: line width
+    GLfloat depth;
+    GLubyte color[4];
+};
+
+static constexpr size_t INSTANCE_SIZE = sizeof( INSTANCE );
+
+static constexpr size_t INSTANCE_GEOMETRY_OFFSET = offsetof( INSTANCE, geometry );
+static constexpr size_t INSTANCE_PARAMS_OFFSET   = offsetof( INSTANCE, width );
+static constexpr size_t INSTANCE_COLOR_OFFSET    = offsetof( INSTANCE, color );
+
 } // namespace KIGFX
 
 #endif /* VERTEX_COMMON_H_ */
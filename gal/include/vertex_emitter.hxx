@@ -0,0 +1,58 @@
+/**
+ * @file vertex_emitter.hxx
+ * @brief Functions writing batches of vertices straight into container memory, with SIMD
+ * implementations selected at runtime for the CPU in use.
+ */
+
+#ifndef VERTEX_EMITTER_H_
+#define VERTEX_EMITTER_H_
+
+#include "gal/include/vertex_common.hxx"
+
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+
+namespace KIGFX
+{
+///< Instruction sets of the EmitVertices() implementations
+enum class VERTEX_ISA
+{
+    SCALAR,
+    SSE2,
+    AVX2
+};
+
+/**
+ * Write vertices whose X and Y coordinates are given as pairs, all the other fields being
+ * copied from a base vertex.
+ *
+ * @param aTarget is the memory to write aCount vertices to.
+ * @param aXY are the X and Y coordinates of the vertices (2 * aCount values).
+ * @param aCount is the number of vertices.
+ * @param aZ is the Z coordinate of all the vertices.
+ * @param aTransform is the transformation applied to the coordinates, nullptr for none.
+ * @param aBase holds the color and shader of the vertices, its coordinates are ignored.
+ */
+void EmitVertices( VERTEX* aTarget, const GLfloat aXY[], size_t aCount, GLfloat aZ,
+                   const glm::mat4* aTransform, const VERTEX& aBase );
+
+/**
+ * Return the instruction set used by EmitVertices().
+ */
+VERTEX_ISA GetVertexIsa();
+
+/**
+ * Force the instruction set used by EmitVertices(), e.g. to compare them in benchmarks.
+ *
+ * @return false if the CPU does not support \a aIsa, which is not changed then.
+ */
+bool SetVertexIsa( VERTEX_ISA aIsa );
+
+/**
+ * Return the name of an instruction set.
+ */
+const char* GetVertexIsaName( VERTEX_ISA aIsa );
+
+} // namespace KIGFX
+
+#endif /* VERTEX_EMITTER_H_ */
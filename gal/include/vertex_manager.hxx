@@ -38,12 +38,14 @@
 #include "color4d.hxx"
 #include <stack>
 #include <memory>
+#include <functional>
 
 namespace KIGFX
 {
 class SHADER;
 class VERTEX_ITEM;
 class VERTEX_CONTAINER;
+class INSTANCE_CONTAINER;
 class GPU_MANAGER;
 
 /**
@@ -132,6 +134,116 @@ public:
      */
     bool Vertices( const VERTEX aVertices[], unsigned int aSize );
 
+    /**
+     * Add vertices whose X and Y coordinates are given as pairs, sharing the same Z coordinate.
+     *
+     * The currently set color, shader and transformation matrix are applied with SIMD
+     * instructions when the CPU has them (see EmitVertices()), writing straight into the
+     * reserved space if it is large enough, or into newly allocated space otherwise.
+     *
+     * @param aXY are the X and Y coordinates of the vertices (2 * aSize values).
+     * @param aSize is the number of vertices to be added.
+     * @param aZ is the Z coordinate of the vertices.
+     * @return True if successful, false otherwise.
+     */
+    bool Vertices( const GLfloat aXY[], unsigned int aSize, GLfloat aZ );
+
+    /**
+     * Add a primitive drawn by instancing a unit quad, expanded by the vertex shader.
+     *
+     * The currently set color is used. Instances are only available for non-cached managers
+     * with instancing enabled, while no transformation is applied and no reserved vertices
+     * are pending; otherwise the caller has to draw the primitive with vertices.
+     *
+     * @param aType is the primitive type, one of SHADER_INSTANCED_*.
+     * @param aGeometry are the primitive coordinates (see INSTANCE::geometry).
+     * @param aWidth is the stroke or line width (see INSTANCE::width).
+     * @param aDepth is the depth of the primitive.
+     * @return True if the primitive was added, false if it has to be drawn with vertices.
+     */
+    bool Instance( SHADER_MODE aType, const GLfloat aGeometry[4], GLfloat aWidth,
+                   GLfloat aDepth );
+
+    /**
+     * Add a batch of circles in the currently used color.
+     *
+     * The circles are added as instances when possible, or as a triangle of 3 vertices each
+     * otherwise. Either way the memory is allocated once for the whole batch, so it is faster
+     * than adding the circles one by one. The current transformation matrix is applied.
+     *
+     * @param aMode is either SHADER_FILLED_CIRCLE or SHADER_STROKED_CIRCLE.
+     * @param aCenters are the circle centers.
+     * @param aRadii are the circle radii, one per center.
+     * @param aCount is the number of circles.
+     * @param aWidth is the stroke width of SHADER_STROKED_CIRCLE.
+     * @param aDepth is the depth of the circles.
+     * @return True if successful, false otherwise.
+     */
+    bool Circles( SHADER_MODE aMode, const VECTOR2D aCenters[], const double aRadii[],
+                  size_t aCount, GLfloat aWidth, GLfloat aDepth );
+
+    /**
+     * Add a batch of filled axis-aligned rectangles in the currently used color.
+     *
+     * @see Circles() for the allocation and transformation.
+     *
+     * @param aCorners are the start and end points of each rectangle (2 * aCount points).
+     * @param aCount is the number of rectangles.
+     * @param aDepth is the depth of the rectangles.
+     * @return True if successful, false otherwise.
+     */
+    bool Rectangles( const VECTOR2D aCorners[], size_t aCount, GLfloat aDepth );
+
+    /**
+     * Add a batch of lines in the currently used color, with the line width maintained by the
+     * vertex shader (see SHADER_LINE_A).
+     *
+     * @see Circles() for the allocation and transformation.
+     *
+     * @param aPoints are the start and end points of each line (2 * aCount points).
+     * @param aCount is the number of lines.
+     * @param aWidth is the line width.
+     * @param aDepth is the depth of the lines.
+     * @return True if successful, false otherwise.
+     */
+    bool Lines( const VECTOR2D aPoints[], size_t aCount, GLfloat aWidth, GLfloat aDepth );
+
+    /**
+     * Return true if Instance() can currently be used.
+     */
+    bool IsInstancingAvailable() const
+    {
+        return m_instances && m_instancingEnabled && m_noTransform && m_reservedSpace == 0;
+    }
+
+    /**
+     * Enable/disable drawing primitives as instances (non-cached managers only).
+     */
+    void EnableInstancing( bool aEnabled )
+    {
+        m_instancingEnabled = aEnabled;
+    }
+
+    /**
+     * Set the number of threads generating the vertices and instances of large batches
+     * (Circles(), Rectangles(), Lines() and Vertices()), the calling thread included.
+     *
+     * The memory of a batch is allocated up front and every thread fills its own range of it,
+     * so the output is the same whatever the number of threads.
+     *
+     * @param aThreads is the number of threads, 0 for as many as the shared pool has.
+     */
+    void SetGenerationThreads( unsigned int aThreads )
+    {
+        m_generationThreads = aThreads;
+    }
+
+    /**
+     * Return the number of bytes of vertex and instance data stored for the next EndDrawing()
+     * of a non-cached manager.
+     */
+    size_t GetPendingDataSize() const;
+
     /**
      * Change currently used color that will be applied to newly added vertices.
      *
@@ -179,10 +291,10 @@ public:
     inline void Shader( GLfloat aShaderType, GLfloat aParam1 = 0.0f, GLfloat aParam2 = 0.0f,
                         GLfloat aParam3 = 0.0f )
     {
-        m_shader[0] = aShaderType;
-        m_shader[1] = aParam1;
-        m_shader[2] = aParam2;
-        m_shader[3] = aParam3;
+        m_shaderMode = static_cast<GLushort>( aShaderType );
+        m_shader[0] = aParam1;
+        m_shader[1] = aParam2;
+        m_shader[2] = aParam3;
     }
 
     /**
@@ -359,12 +471,51 @@ protected:
      */
     void putVertex( VERTEX& aTarget, GLfloat aX, GLfloat aY, GLfloat aZ ) const;
 
+    /**
+     * Allocate vertices for a batch of primitives, reporting allocation errors.
+     */
+    VERTEX* allocateBatch( size_t aSize );
+
+    /**
+     * Return a vertex with the currently used color and the given shader type, to be
+     * completed by the batch functions.
+     */
+    VERTEX batchVertex( SHADER_MODE aMode ) const;
+
+    /**
+     * Apply the current transformation matrix to the coordinates of a batch of vertices.
+     */
+    void transformBatch( VERTEX* aVertices, size_t aSize ) const;
+
+    /**
+     * Call \a aGenerate( begin, end ) for ranges covering the [0, aCount) primitives of a batch,
+     * on the shared thread pool when the batch is large enough.
+     *
+     * \a aGenerate runs concurrently, so it may only write the range of the batch it is given
+     * and read the manager state (color, shader, transformation), which does not change
+     * meanwhile.
+     */
+    void generateBatch( size_t aCount,
+                        const std::function<void( size_t, size_t )>& aGenerate ) const;
+
     /// Container for vertices, may be cached or noncached
     std::shared_ptr<VERTEX_CONTAINER> m_container;
 
     /// GPU manager for data transfers and drawing operations
     std::shared_ptr<GPU_MANAGER>      m_gpu;
 
+    /// Container for primitives drawn as instances, only for non-cached managers
+    std::shared_ptr<INSTANCE_CONTAINER> m_instances;
+
+    /// Should primitives be drawn as instances when possible
+    bool                    m_instancingEnabled;
+
+    /// Number of threads generating large batches, 0 for as many as the shared pool has
+    unsigned int            m_generationThreads;
+
+    /// Smallest number of primitives generated by a thread
+    static constexpr size_t MIN_GENERATION_RANGE = 4096;
+
     /// State machine variables
     /// True in case there is no need to transform vertices
     bool                    m_noTransform;
@@ -378,7 +529,10 @@ protected:
     /// Currently used color
     GLubyte                 m_color[COLOR_STRIDE];
 
-    /// Currently used shader and its parameters
+    /// Currently used shader
+    GLushort                m_shaderMode;
+
+    /// Currently used shader parameters
     GLfloat                 m_shader[SHADER_STRIDE];
 
     /// Currently reserved chunk to store vertices
@@ -11,13 +11,22 @@ const float SHADER_LINE_D         = 8.0;
 const float SHADER_LINE_E         = 9.0;
 const float SHADER_LINE_F         = 10.0;
 const float SHADER_HOLE_WALL      = 11.0;
+const float SHADER_INSTANCED_CIRCLE  = 12.0;
+const float SHADER_INSTANCED_RECT    = 13.0;
+const float SHADER_INSTANCED_SEGMENT = 14.0;
 
 const float MIN_WIDTH = 1.0;
 
 // --- 顶点输入 ---
 layout(location = 0) in vec3 a_position;
 layout(location = 1) in vec4 a_color;
-layout(location = 2) in vec4 a_shaderParams;
+layout(location = 2) in vec3 a_shaderParams;
+layout(location = 6) in float a_shaderMode;
+
+// Instanced primitives: a_position is a corner of the [-1, 1] unit quad
+layout(location = 3) in vec4 a_instanceGeometry;    // circle: center, radius; others: start, end
+layout(location = 4) in vec2 a_instanceParams;      // width, depth
+layout(location = 5) in vec4 a_instanceColor;
 
 // --- 输出到片段着色器 ---
 out vec4 v_color;
@@ -188,19 +197,81 @@ void computeHoleWallCoords(float vertexIndex, float radius, float lineWidth)
 }
 
 
+// Square around the circle, shaded by the filled/stroked circle modes of the fragment shader
+void computeInstancedCircle()
+{
+    float width = a_instanceParams.x;
+    float pixelR = roundr(a_instanceGeometry.z / u_worldPixelSize, 1.0);
+    float pixelWidth = roundr(width / u_worldPixelSize, 1.0);
+
+    if (pixelWidth < u_minLinePixelWidth)
+        pixelWidth = u_minLinePixelWidth;
+
+    if (width > 0.0)
+        pixelR += pixelWidth / 2.0;
+
+    vec4 center = roundv(u_mvp * vec4(a_instanceGeometry.xy, a_instanceParams.y, 1.0)
+                         + vec4(1, 1, 0, 0), u_screenPixelSize);
+
+    gl_Position = center + vec4(a_position.xy * pixelR * u_screenPixelSize, 0, 0)
+                  + vec4(-1, -1, 0, 0);
+    v_circleCoords = a_position.xy;
+    v_shaderParams = vec4(width > 0.0 ? SHADER_STROKED_CIRCLE : SHADER_FILLED_CIRCLE, 0.0,
+                          pixelR, pixelWidth);
+}
+
+void computeInstancedRect()
+{
+    vec2 pos = mix(a_instanceGeometry.xy, a_instanceGeometry.zw, a_position.xy * 0.5 + 0.5);
+
+    gl_Position = u_mvp * vec4(pos, a_instanceParams.y, 1.0);
+    v_shaderParams = vec4(0.0);
+}
+
+// Quad around the segment and its round caps, shaded by the line mode of the fragment shader
+void computeInstancedSegment()
+{
+    vec2 vs = a_instanceGeometry.zw - a_instanceGeometry.xy;
+    float lineLength = length(vs);
+    float w = max(a_instanceParams.x, u_minLinePixelWidth * u_worldPixelSize);
+    vec2 dir = lineLength > 0.0 ? vs / lineLength : vec2(1.0, 0.0);
+    vec2 normal = vec2(-dir.y, dir.x);
+    vec2 middle = (a_instanceGeometry.xy + a_instanceGeometry.zw) * 0.5;
+    float aspect = (lineLength + w) / w;
+
+    vec2 pos = middle + dir * (lineLength + w) * 0.5 * a_position.x
+               + normal * w * 0.5 * a_position.y;
+
+    gl_Position = u_mvp * vec4(pos, a_instanceParams.y, 1.0);
+    v_shaderParams = vec4(SHADER_LINE_A, aspect, 0.0, 0.0);
+    v_texCoord = vec2(aspect * a_position.x, a_position.y);
+}
+
+
 void main()
 {
-    float mode = a_shaderParams[0];
+    float mode = a_shaderMode;
 
     // Pass attributes to the fragment shader
-    v_shaderParams = a_shaderParams;
+    v_shaderParams = vec4(a_shaderMode, a_shaderParams);
 
     float lineWidth = v_shaderParams.y;
     vec2 vs = v_shaderParams.zw;
     vec2 vp = vec2(-vs.y, vs.x);
     bool posture = abs( vs.x ) < abs(vs.y);
 
-    if( mode == SHADER_LINE_A )
+    if( mode >= SHADER_INSTANCED_CIRCLE )
+    {
+        if( mode == SHADER_INSTANCED_CIRCLE )
+            computeInstancedCircle();
+        else if( mode == SHADER_INSTANCED_RECT )
+            computeInstancedRect();
+        else
+            computeInstancedSegment();
+
+        v_color = a_instanceColor;
+    }
+    else if( mode == SHADER_LINE_A )
         computeLineCoords( posture,  -vs, vp,  vec2( -1, -1 ), vec2( -1, 0 ), lineWidth, false );
     else if( mode == SHADER_LINE_B )
         computeLineCoords( posture,  -vs, -vp, vec2( -1,  1 ), vec2(  1, 0 ), lineWidth, false );
@@ -17,7 +17,8 @@ const float MIN_WIDTH = 1.0;
 // --- 顶点输入 ---
 layout(location = 0) in vec3 a_position;
 layout(location = 1) in vec4 a_color;
-layout(location = 2) in vec4 a_shaderParams;
+layout(location = 2) in vec3 a_shaderParams;
+layout(location = 6) in float a_shaderMode;
 
 // --- 输出到片段着色器 ---
 out vec4 v_color;
@@ -53,7 +54,7 @@ void main()
     vec2(u_antialiasingOffset);
     gl_Position = u_mvp * vec4(a_position, 1.0);
     v_color = a_color;
-    v_shaderParams = a_shaderParams;
+    v_shaderParams = vec4(a_shaderMode, a_shaderParams);
     v_circleCoords = a_position.xy;
     v_texCoord = a_position.xy;
 }
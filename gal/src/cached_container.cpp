@@ -36,7 +36,7 @@
 #include "gal/include/vertex_item.hxx"
 #include "gal/include/utils.hxx"
 
-#include <list>
+#include <vector>
 #include <algorithm>
 #include <cassert>
 
@@ -53,13 +53,18 @@ using namespace KIGFX;
 
 CACHED_CONTAINER::CACHED_CONTAINER( unsigned int aSize ) :
         VERTEX_CONTAINER( aSize ),
+        m_allocator( aSize ),       // in the beginning there is only free space
+        m_defragmentations( 0 ),
+        m_compactionScan( nullptr ),
+        m_compactionBudget( DEFAULT_COMPACTION_BUDGET ),
+        m_compaction{ 0, 0, 0, false },
+        m_compactionPassStart( 0 ),
+        m_compactionResume( COMPACTION_START ),
         m_item( nullptr ),
         m_chunkSize( 0 ),
         m_chunkOffset( 0 ),
         m_maxIndex( 0 )
 {
-    // In the beginning there is only free space
-    m_freeChunks.insert( std::make_pair( aSize, 0 ) );
 }
 
 
@@ -85,19 +90,21 @@ void CACHED_CONTAINER::FinishItem()
     // Finishing the previously edited item
     if( itemSize < m_chunkSize )
     {
-        // There is some not used but reserved memory left, so we should return it to the pool
-        int itemOffset = m_item->GetOffset();
-
-        // Add the not used memory back to the pool
-        addFreeChunk( itemOffset + itemSize, m_chunkSize - itemSize );
-
-        // mergeFreeChunks();   // veery slow and buggy
+        // There is some not used but reserved memory left, so we should return it to the pool,
+        // merged with the free space that follows
+        if( itemSize > 0 )
+            m_allocator.Resize( m_chunkOffset, itemSize );
+        else
+            m_allocator.Free( m_chunkOffset );
 
-        m_maxIndex = std::max( itemOffset + itemSize, m_maxIndex );
+        m_freeSpace = m_allocator.GetFreeSpace();
     }
 
     if( itemSize > 0 )
+    {
         m_items.insert( m_item );
+        m_maxIndex = std::max( m_item->GetOffset() + itemSize, m_maxIndex );
+    }
 
     m_item = nullptr;
     m_chunkSize = 0;
@@ -160,10 +167,9 @@ void CACHED_CONTAINER::Delete( VERTEX_ITEM* aItem )
     if( size == 0 )
         return; // Item is not stored here
 
-    int offset = aItem->GetOffset();
-
-    // Insert a free memory chunk entry in the place where item was stored
-    addFreeChunk( offset, size );
+    // Free the chunk where the item was stored, merged with the free space around it
+    m_allocator.Free( aItem->GetOffset() );
+    m_freeSpace = m_allocator.GetFreeSpace();
 
     // Indicate that the item is not stored in the container anymore
     aItem->setSize( 0 );
@@ -205,8 +211,13 @@ void CACHED_CONTAINER::Clear()
     m_items.clear();
 
     // Now there is only free space left
-    m_freeChunks.clear();
-    m_freeChunks.insert( std::make_pair( m_freeSpace, 0 ) );
+    m_allocator.Reset( m_currentSize );
+
+    m_compactionQueue.clear();
+    m_compactionHoles.clear();
+    m_compactionTree.clear();
+    m_compaction.active = false;
+    m_compactionResume = COMPACTION_START;
 }
 
 
@@ -217,11 +228,28 @@ bool CACHED_CONTAINER::reallocate( unsigned int aSize )
 
     unsigned int itemSize = m_item->GetSize();
 
-    // Find a free space chunk >= aSize
-    FREE_CHUNK_MAP::iterator newChunk = m_freeChunks.lower_bound( aSize );
+    // Grow in place when the space after the chunk is free, as it is for items being added
+    // at the end of the used space
+    if( m_chunkSize > 0 && m_allocator.Resize( m_chunkOffset, aSize ) )
+    {
+        m_chunkSize = aSize;
+        m_freeSpace = m_allocator.GetFreeSpace();
+        return true;
+    }
+
+    // Otherwise the item moves, with room to keep growing; the unused part is returned by
+    // FinishItem()
+    unsigned int newChunkSize = std::max( aSize, 2 * m_chunkSize );
+    unsigned int newChunkOffset = m_allocator.Allocate( newChunkSize );
+
+    if( newChunkOffset == TLSF_ALLOCATOR::NONE && newChunkSize > aSize )
+    {
+        newChunkSize = aSize;
+        newChunkOffset = m_allocator.Allocate( newChunkSize );
+    }
 
     // Is there enough space to store vertices?
-    if( newChunk == m_freeChunks.end() )
+    if( newChunkOffset == TLSF_ALLOCATOR::NONE )
     {
         bool result;
 
@@ -240,30 +268,42 @@ bool CACHED_CONTAINER::reallocate( unsigned int aSize )
         if( !result )
             return false;
 
-        newChunk = m_freeChunks.lower_bound( aSize );
-        assert( newChunk != m_freeChunks.end() );
-    }
+        ++m_defragmentations;
+
+        // The current chunk is now the last one, followed by all the free space
+        if( m_chunkSize > 0 )
+        {
+            bool grown = m_allocator.Resize( m_chunkOffset, aSize );
+            assert( grown );
+            ( void ) grown;
 
-    // Parameters of the allocated chunk
-    unsigned int newChunkSize = getChunkSize( *newChunk );
-    unsigned int newChunkOffset = getChunkOffset( *newChunk );
+            m_chunkSize = aSize;
+            m_freeSpace = m_allocator.GetFreeSpace();
+            return true;
+        }
+
+        newChunkSize = aSize;
+        newChunkOffset = m_allocator.Allocate( newChunkSize );
+        assert( newChunkOffset != TLSF_ALLOCATOR::NONE );
+    }
 
-    assert( newChunkSize >= aSize );
     assert( newChunkOffset < m_currentSize );
 
     // Check if the item was previously stored in the container
-    if( itemSize > 0 )
+    if( m_chunkSize > 0 )
     {
         // The item was reallocated, so we have to copy all the old data to the new place
-        memcpy( &m_vertices[newChunkOffset], &m_vertices[m_chunkOffset], itemSize * VERTEX_SIZE );
+        if( itemSize > 0 )
+        {
+            memcpy( &m_vertices[newChunkOffset], &m_vertices[m_chunkOffset],
+                    itemSize * VERTEX_SIZE );
+        }
 
         // Free the space used by the previous chunk
-        addFreeChunk( m_chunkOffset, m_chunkSize );
+        m_allocator.Free( m_chunkOffset );
     }
 
-    // Remove the new allocated chunk from the free space pool
-    m_freeChunks.erase( newChunk );
-    m_freeSpace -= newChunkSize;
+    m_freeSpace = m_allocator.GetFreeSpace();
 
     m_chunkSize = newChunkSize;
     m_chunkOffset = newChunkOffset;
@@ -335,54 +375,194 @@ void CACHED_CONTAINER::defragment( VERTEX* aTarget )
 }
 
 
-void CACHED_CONTAINER::mergeFreeChunks()
+void CACHED_CONTAINER::resetChunks()
 {
-    if( m_freeChunks.size() <= 1 ) // There are no chunks that can be merged
-        return;
+    m_allocator.Reset( m_currentSize );
 
-#ifdef KICAD_GAL_PROFILE
-    PROF_TIMER totalTime;
-#endif /* KICAD_GAL_PROFILE */
+    // The items are stored one after another, followed by the chunk of the current item
+    std::vector<VERTEX_ITEM*> items;
+
+    for( VERTEX_ITEM* item : m_items )
+    {
+        if( item != m_item )
+            items.push_back( item );
+    }
 
-    // Reversed free chunks map - this one stores chunk size with its offset as the key
-    std::list<CHUNK> freeChunks;
+    std::sort( items.begin(), items.end(),
+               []( const VERTEX_ITEM* aA, const VERTEX_ITEM* aB )
+               {
+                   return aA->GetOffset() < aB->GetOffset();
+               } );
 
-    FREE_CHUNK_MAP::const_iterator it, it_end;
+    for( VERTEX_ITEM* item : items )
+    {
+        bool claimed = m_allocator.Claim( item->GetOffset(), item->GetSize() );
+        assert( claimed );
+        ( void ) claimed;
+    }
 
-    for( it = m_freeChunks.begin(), it_end = m_freeChunks.end(); it != it_end; ++it )
+    if( m_chunkSize > 0 )
     {
-        freeChunks.emplace_back( it->second, it->first );
+        bool claimed = m_allocator.Claim( m_chunkOffset, m_chunkSize );
+        assert( claimed );
+        ( void ) claimed;
     }
 
-    m_freeChunks.clear();
-    freeChunks.sort();
+    m_freeSpace = m_allocator.GetFreeSpace();
+
+    // The items have moved, a compaction pass in progress is over
+    m_compactionQueue.clear();
+    m_compactionHoles.clear();
+    m_compactionTree.clear();
+    m_compaction.active = false;
+    m_compactionResume = COMPACTION_START;
+}
+
+
+void CACHED_CONTAINER::compact()
+{
+    m_compaction.itemsMoved = 0;
+    m_compaction.bytesMoved = 0;
+
+    // Not while an item is edited, e.g. when remapped by defragmentResize()
+    if( m_compactionBudget == 0 || m_item )
+        return;
+
+    if( !m_compaction.active )
+    {
+        if( GetFragmentation().Ratio() < m_compactionResume )
+            return;
+
+        m_compactionQueue.clear();
+        m_compactionQueue.reserve( m_items.size() );
+        m_compactionScan = nullptr;
 
-    std::list<CHUNK>::const_iterator itf, itf_end;
-    unsigned int                     offset = freeChunks.front().first;
-    unsigned int                     size = freeChunks.front().second;
-    freeChunks.pop_front();
+        m_compaction.active = true;
+        m_compactionPassStart = m_compaction.totalBytesMoved;
+    }
 
-    for( itf = freeChunks.begin(), itf_end = freeChunks.end(); itf != itf_end; ++itf )
+    if( m_compactionTree.empty() )
     {
-        if( itf->first == offset + size )
+        // The items are gathered over a few steps, the ones deleted or moved meanwhile are
+        // skipped later and the ones added are left for the next pass
+        const unsigned int maxGathered = 16384;
+        ITEMS::iterator    it = m_compactionScan ? m_items.upper_bound( m_compactionScan )
+                                                 : m_items.begin();
+
+        for( unsigned int i = 0; it != m_items.end() && i < maxGathered; ++it, ++i )
+            m_compactionQueue.emplace_back( ( *it )->GetOffset(), *it );
+
+        if( it != m_items.end() )
         {
-            // These chunks can be merged, so just increase the current chunk size and go on
-            size += itf->second;
+            m_compactionScan = std::prev( it ) == m_items.end() ? nullptr : *std::prev( it );
+            return;
         }
-        else
+
+        std::make_heap( m_compactionQueue.begin(), m_compactionQueue.end() );
+
+        m_compactionHoles = m_allocator.GetFreeBlocks();
+
+        size_t leaves = 1;
+
+        while( leaves < m_compactionHoles.size() )
+            leaves *= 2;
+
+        m_compactionTree.assign( 2 * leaves, 0 );
+
+        for( size_t i = 0; i < m_compactionHoles.size(); ++i )
+            m_compactionTree[leaves + i] = m_compactionHoles[i].second;
+
+        for( size_t i = leaves - 1; i > 0; --i )
+        {
+            m_compactionTree[i] = std::max( m_compactionTree[2 * i],
+                                            m_compactionTree[2 * i + 1] );
+        }
+    }
+
+    // Items that cannot move cost a few tree lookups, but there may be many of them
+    const unsigned int      maxVisits = 2048;
+    const unsigned int      budget = std::max<unsigned int>( m_compactionBudget / VERTEX_SIZE, 1 );
+    unsigned int            moved = 0;
+    unsigned int            visits = 0;
+    std::vector<CHUNK_MOVE> moves;
+
+    while( !m_compactionQueue.empty() && visits < maxVisits )
+    {
+        const auto [offset, item] = m_compactionQueue.front();
+        const int  lowest = findHole( 1 );
+
+        // The remaining items are all below the free chunks
+        if( lowest < 0 || m_compactionHoles[lowest].first > offset )
         {
-            // These chunks cannot be merged
-            // So store the previous one
-            m_freeChunks.insert( std::make_pair( size, offset ) );
+            m_compactionQueue.clear();
+            break;
+        }
 
-            // and let's check the next chunk
-            offset = itf->first;
-            size = itf->second;
+        const bool stored = m_items.find( item ) != m_items.end() && item->GetOffset() == offset;
+        const unsigned int size = stored ? item->GetSize() : 0;
+
+        // At least one item per step, however large
+        if( moved > 0 && moved + size > budget )
+            break;
+
+        std::pop_heap( m_compactionQueue.begin(), m_compactionQueue.end() );
+        m_compactionQueue.pop_back();
+        ++visits;
+
+        if( !stored )
+            continue;
+
+        int hole = findHole( size );
+
+        // The holes taken or changed since the pass started are dropped
+        while( hole >= 0 && m_compactionHoles[hole].first < offset
+               && !m_allocator.Claim( m_compactionHoles[hole].first, size ) )
+        {
+            updateHole( hole, 0 );
+            hole = findHole( size );
         }
+
+        if( hole < 0 || m_compactionHoles[hole].first > offset )
+            continue;
+
+        const unsigned int newOffset = m_compactionHoles[hole].first;
+
+        // The rest of the hole stays free right after the item
+        m_compactionHoles[hole].first += size;
+        updateHole( hole, m_compactionHoles[hole].second - size );
+
+        m_allocator.Free( offset );
+        item->setOffset( newOffset );
+        moves.push_back( { offset, newOffset, size } );
+        moved += size;
     }
 
-    // Add the last one
-    m_freeChunks.insert( std::make_pair( size, offset ) );
+    if( !moves.empty() )
+    {
+        moveChunks( moves );
+
+        m_freeSpace = m_allocator.GetFreeSpace();
+        m_dirty = true;
+
+        m_compaction.itemsMoved = moves.size();
+        m_compaction.bytesMoved = moved * VERTEX_SIZE;
+        m_compaction.totalBytesMoved += m_compaction.bytesMoved;
+    }
+
+    if( m_compactionQueue.empty() )
+    {
+        const double ratio = GetFragmentation().Ratio();
+
+        // After a pass that could not move anything, wait for the fragmentation to grow
+        if( m_compaction.totalBytesMoved == m_compactionPassStart )
+            m_compactionResume = std::max( COMPACTION_START, ratio + 0.05 );
+        else
+            m_compactionResume = COMPACTION_START;
+
+        m_compactionHoles.clear();
+        m_compactionTree.clear();
+        m_compaction.active = false;
+    }
 
 #if CACHED_CONTAINER_TEST > 0
     test();
@@ -390,13 +570,56 @@ void CACHED_CONTAINER::mergeFreeChunks()
 }
 
 
-void CACHED_CONTAINER::addFreeChunk( unsigned int aOffset, unsigned int aSize )
+void CACHED_CONTAINER::moveChunks( const std::vector<CHUNK_MOVE>& aMoves )
 {
-    assert( aOffset + aSize <= m_currentSize );
-    assert( aSize > 0 );
+    assert( IsMapped() );
+
+    for( const CHUNK_MOVE& move : aMoves )
+        memcpy( &m_vertices[move.to], &m_vertices[move.from], move.size * VERTEX_SIZE );
+}
+
+
+int CACHED_CONTAINER::findHole( unsigned int aSize ) const
+{
+    if( m_compactionTree.empty() || m_compactionTree[1] < aSize )
+        return -1;
+
+    const size_t leaves = m_compactionTree.size() / 2;
+    size_t       node = 1;
+
+    // Descend to the leftmost leaf large enough
+    while( node < leaves )
+        node = m_compactionTree[2 * node] >= aSize ? 2 * node : 2 * node + 1;
+
+    return node - leaves;
+}
+
 
-    m_freeChunks.insert( std::make_pair( aSize, aOffset ) );
-    m_freeSpace += aSize;
+void CACHED_CONTAINER::updateHole( unsigned int aIndex, unsigned int aSize )
+{
+    size_t node = m_compactionTree.size() / 2 + aIndex;
+
+    m_compactionHoles[aIndex].second = aSize;
+    m_compactionTree[node] = aSize;
+
+    for( node /= 2; node > 0; node /= 2 )
+    {
+        m_compactionTree[node] = std::max( m_compactionTree[2 * node],
+                                           m_compactionTree[2 * node + 1] );
+    }
+}
+
+
+CACHED_CONTAINER::FRAGMENTATION CACHED_CONTAINER::GetFragmentation() const
+{
+    FRAGMENTATION fragmentation;
+
+    fragmentation.freeSpace = m_allocator.GetFreeSpace();
+    fragmentation.freeChunks = m_allocator.GetFreeBlockCount();
+    fragmentation.largestFreeChunk = m_allocator.GetLargestFreeBlock();
+    fragmentation.defragmentations = m_defragmentations;
+
+    return fragmentation;
 }
 
 
@@ -414,13 +637,7 @@ void CACHED_CONTAINER::test()
 {
 #ifdef KICAD_GAL_PROFILE
     // Free space check
-    unsigned int             freeSpace = 0;
-    FREE_CHUNK_MAP::iterator itf;
-
-    for( itf = m_freeChunks.begin(); itf != m_freeChunks.end(); ++itf )
-        freeSpace += getChunkSize( *itf );
-
-    assert( freeSpace == m_freeSpace );
+    assert( m_allocator.GetFreeSpace() == m_freeSpace );
 
     // Used space check
     unsigned int    used_space = 0;
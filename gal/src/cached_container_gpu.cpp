@@ -68,10 +68,26 @@ void CACHED_CONTAINER_GPU::Map()
         throw std::runtime_error( "OpenGL no longer available!" );
 
     m_buffer.bind();
+
+    // The compaction copies the data on the GPU side when possible, with the buffer unmapped,
+    // otherwise through the mapped memory
+    if( m_useCopyBuffer )
+        compact();
+
     m_vertices = static_cast<VERTEX*>( m_buffer.map(QOpenGLBuffer::ReadWrite) );
 
     if( checkGlError( "mapping vertices buffer", __FILE__, __LINE__ ) == GL_NO_ERROR )
         m_isMapped = true;
+
+    if( !m_useCopyBuffer && m_isMapped )
+        compact();
+
+    if( m_compaction.bytesMoved > 0 )
+    {
+        spdlog::trace( "{} Compacted {} items / {} bytes, fragmentation {:.3f}",
+                       traceGalCachedContainerGpu, m_compaction.itemsMoved,
+                       m_compaction.bytesMoved, GetFragmentation().Ratio() );
+    }
 }
 
 
@@ -98,6 +114,27 @@ void CACHED_CONTAINER_GPU::Unmap()
 }
 
 
+void CACHED_CONTAINER_GPU::moveChunks( const std::vector<CHUNK_MOVE>& aMoves )
+{
+    if( m_isMapped )
+    {
+        CACHED_CONTAINER::moveChunks( aMoves );
+        return;
+    }
+
+    QOpenGLFunctions_3_3_Core* function = QOpenGLVersionFunctionsFactory::get<QOpenGLFunctions_3_3_Core>(QOpenGLContext::currentContext());
+
+    // The source and target ranges never overlap, so the bound buffer can be both
+    for( const CHUNK_MOVE& move : aMoves )
+    {
+        function->glCopyBufferSubData( GL_ARRAY_BUFFER, GL_ARRAY_BUFFER, move.from * VERTEX_SIZE,
+                                       move.to * VERTEX_SIZE, move.size * VERTEX_SIZE );
+    }
+
+    checkGlError( "moving chunks during compaction", __FILE__, __LINE__ );
+}
+
+
 bool CACHED_CONTAINER_GPU::defragmentResize( unsigned int aNewSize )
 {
     if( !m_useCopyBuffer )
@@ -203,8 +240,7 @@ bool CACHED_CONTAINER_GPU::defragmentResize( unsigned int aNewSize )
     spdlog::trace("[{}] VBO size {} used {}\n", traceGalProfile.data(), m_currentSize, AllItemsSize());
 
     // Now there is only one big chunk of free memory
-    m_freeChunks.clear();
-    m_freeChunks.insert( std::make_pair( m_freeSpace, m_currentSize - m_freeSpace ) );
+    resetChunks();
 
     return true;
 }
@@ -269,8 +305,7 @@ bool CACHED_CONTAINER_GPU::defragmentResizeMemcpy( unsigned int aNewSize )
     spdlog::trace("[{}] VBO size {} used: {} \n", traceGalProfile.data(), m_currentSize, AllItemsSize());
 
     // Now there is only one big chunk of free memory
-    m_freeChunks.clear();
-    m_freeChunks.insert( std::make_pair( m_freeSpace, m_currentSize - m_freeSpace ) );
+    resetChunks();
 
     return true;
 }
@@ -25,7 +25,8 @@ GAL_DISPLAY_OPTIONS::GAL_DISPLAY_OPTIONS()
       m_axesEnabled( false ),
       m_fullscreenCursor( false ),
       m_forceDisplayCursor( false ),
-      m_scaleFactor( DPI_SCALING::GetDefaultScaleFactor() )
+      m_scaleFactor( DPI_SCALING::GetDefaultScaleFactor() ),
+      m_glInstancing( true )
 {
 }
 
@@ -2,6 +2,7 @@
 #include "gal/include/cached_container_gpu.hxx"
 #include "gal/include/cached_container_ram.hxx"
 #include "gal/include/noncached_container.hxx"
+#include "gal/include/instance_container.hxx"
 #include "gal/include/shader.hxx"
 #include "gal/include/utils.hxx"
 #include "gal/include/vertex_item.hxx"
@@ -22,6 +23,31 @@
 
 using namespace KIGFX;
 
+/**
+ * Describe the #VERTEX layout to the vertex array object that is currently bound.
+ *
+ * Colors are stored as bytes and normalized to [0, 1], the shader type is converted to float.
+ */
+static void setVertexAttributes( QOpenGLFunctions_3_3_Core* aFunctions )
+{
+    // a_position
+    aFunctions->glVertexAttribPointer( 0, COORD_STRIDE, GL_FLOAT, GL_FALSE, VERTEX_SIZE,
+                                       (void*) COORD_OFFSET );
+    aFunctions->glEnableVertexAttribArray( 0 );
+    // a_color
+    aFunctions->glVertexAttribPointer( 1, COLOR_STRIDE, GL_UNSIGNED_BYTE, GL_TRUE, VERTEX_SIZE,
+                                       (void*) COLOR_OFFSET );
+    aFunctions->glEnableVertexAttribArray( 1 );
+    // a_shaderParams
+    aFunctions->glVertexAttribPointer( 2, SHADER_STRIDE, GL_FLOAT, GL_FALSE, VERTEX_SIZE,
+                                       (void*) SHADER_OFFSET );
+    aFunctions->glEnableVertexAttribArray( 2 );
+    // a_shaderMode
+    aFunctions->glVertexAttribPointer( 6, 1, GL_UNSIGNED_SHORT, GL_FALSE, VERTEX_SIZE,
+                                       (void*) MODE_OFFSET );
+    aFunctions->glEnableVertexAttribArray( 6 );
+}
+
 GPU_MANAGER* GPU_MANAGER::MakeManager( VERTEX_CONTAINER* aContainer )
 {
     if( aContainer->IsCached() )
@@ -43,6 +69,29 @@ GPU_MANAGER::GPU_MANAGER( VERTEX_CONTAINER* aContainer ) :
 
 GPU_MANAGER::~GPU_MANAGER()
 {
+    // Managers are destroyed with the GAL context current
+    if( vao == 0 || !QOpenGLContext::currentContext() )
+        return;
+
+    QOpenGLFunctions_3_3_Core* function = QOpenGLVersionFunctionsFactory::get<QOpenGLFunctions_3_3_Core>(QOpenGLContext::currentContext());
+
+    function->glDeleteBuffers( 1, &vbo );
+    function->glDeleteVertexArrays( 1, &vao );
+}
+
+
+void GPU_MANAGER::bindVertexArray()
+{
+    QOpenGLFunctions_3_3_Core* function = QOpenGLVersionFunctionsFactory::get<QOpenGLFunctions_3_3_Core>(QOpenGLContext::currentContext());
+
+    if( vao == 0 )
+    {
+        function->glGenVertexArrays( 1, &vao );
+        function->glGenBuffers( 1, &vbo );
+    }
+
+    function->glBindVertexArray( vao );
+    function->glBindBuffer( GL_ARRAY_BUFFER, vbo );
 }
 
 
@@ -124,11 +173,8 @@ void GPU_CACHED_MANAGER::EndDrawing()
 
     CACHED_CONTAINER* cached = static_cast<CACHED_CONTAINER*>( m_container );
 
+    bindVertexArray();
 
-    function->glGenVertexArrays(1, &vao);
-    function->glGenBuffers(1, &vbo);
-    function->glBindVertexArray(vao);
-    function->glBindBuffer(GL_ARRAY_BUFFER, vbo);
     if( cached->IsMapped() )
         cached->Unmap();
 
@@ -143,15 +189,7 @@ void GPU_CACHED_MANAGER::EndDrawing()
         function->glDisable( GL_DEPTH_TEST );
 
 
-    // a_position
-    function->glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (void*)0);
-    function->glEnableVertexAttribArray(0);
-    // a_color
-    function->glVertexAttribPointer(1, 4, GL_FLOAT, GL_TRUE, 11 * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
-    function->glEnableVertexAttribArray(1);
-    // a_shaderParams
-    function->glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (void*)(7 * sizeof(GLfloat)));
-    function->glEnableVertexAttribArray(2);
+    setVertexAttributes( function );
 
     PROF_TIMER cntDraw( "gl-draw-elements" );
 
@@ -244,11 +282,28 @@ void GPU_CACHED_MANAGER::resizeIndices( unsigned int aNewSize )
 
 // Noncached manager
 GPU_NONCACHED_MANAGER::GPU_NONCACHED_MANAGER( VERTEX_CONTAINER* aContainer ) :
-        GPU_MANAGER( aContainer )
+        GPU_MANAGER( aContainer ),
+        m_instances( nullptr ),
+        m_instanceVao( 0 ),
+        m_quadVbo( 0 ),
+        m_instanceVbo( 0 )
 {
 }
 
 
+GPU_NONCACHED_MANAGER::~GPU_NONCACHED_MANAGER()
+{
+    if( m_instanceVao == 0 || !QOpenGLContext::currentContext() )
+        return;
+
+    QOpenGLFunctions_3_3_Core* function = QOpenGLVersionFunctionsFactory::get<QOpenGLFunctions_3_3_Core>(QOpenGLContext::currentContext());
+
+    function->glDeleteBuffers( 1, &m_instanceVbo );
+    function->glDeleteBuffers( 1, &m_quadVbo );
+    function->glDeleteVertexArrays( 1, &m_instanceVao );
+}
+
+
 void GPU_NONCACHED_MANAGER::BeginDrawing()
 {
     // Nothing has to be prepared
@@ -265,8 +320,13 @@ void GPU_NONCACHED_MANAGER::EndDrawing()
 {
     QOpenGLFunctions_3_3_Core* function = QOpenGLVersionFunctionsFactory::get<QOpenGLFunctions_3_3_Core>(QOpenGLContext::currentContext());
 
-    if( m_container->GetSize() == 0)
+    const unsigned int vertexCount = m_container->GetSize();
+
+    if( vertexCount == 0 )
+    {
+        drawInstances( 0 );
         return;
+    }
 
     VERTEX *vertices = m_container->GetAllVertices();
     function->glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
@@ -276,42 +336,22 @@ void GPU_NONCACHED_MANAGER::EndDrawing()
     else
         function->glDisable( GL_DEPTH_TEST );
 
-    // Prepare buffers
-    function->glGenVertexArrays(1, &vao);
-    function->glGenBuffers(1, &vbo);
-    function->glBindVertexArray(vao);
-    function->glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    function->glBufferData(GL_ARRAY_BUFFER, m_container->GetSize() * VERTEX_SIZE, vertices, GL_STATIC_DRAW);
+    // Upload into the buffer of the previous flushes, orphaning its old storage
+    bindVertexArray();
+    function->glBufferData(GL_ARRAY_BUFFER, vertexCount * VERTEX_SIZE, vertices, GL_STREAM_DRAW);
 
-    // a_position
-    function->glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (void*)0);
-    function->glEnableVertexAttribArray(0);
-    // a_color
-    function->glVertexAttribPointer(1, 4, GL_FLOAT, GL_TRUE, 11 * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
-    function->glEnableVertexAttribArray(1);
-    // a_shaderParams
-    function->glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (void*)(7 * sizeof(GLfloat)));
-    function->glEnableVertexAttribArray(2);
+    setVertexAttributes( function );
 
     function->glBindVertexArray(0);
     //function->glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
     
-    m_shader->Use();
-    function->glBindVertexArray(vao);
-    function->glDrawArrays(GL_TRIANGLES, 0, m_container->GetSize());
-    function->glBindVertexArray(0);
-    m_shader->Deactivate();
+    drawInstances( vertexCount );
 
     GLenum err; 
     while ((err = glGetError()) != GL_NO_ERROR) {
         qDebug() << "GL error:" << err;
     }
 
-    
-    while ((err = glGetError()) != GL_NO_ERROR) {
-        qDebug() << "GL error:" << err;
-    }
-
 
     // Deactivate vertex array
     if( m_shader != nullptr )
@@ -319,11 +359,136 @@ void GPU_NONCACHED_MANAGER::EndDrawing()
         function->glDisableVertexAttribArray(0);
         function->glDisableVertexAttribArray(1);
         function->glDisableVertexAttribArray(2);
+        function->glDisableVertexAttribArray(6);
         m_shader->Deactivate();
     }
 
     m_container->Clear();
+}
+
+
+void GPU_NONCACHED_MANAGER::drawVertices( unsigned int aFirst, unsigned int aEnd )
+{
+    if( aFirst >= aEnd )
+        return;
+
+    QOpenGLFunctions_3_3_Core* function = QOpenGLVersionFunctionsFactory::get<QOpenGLFunctions_3_3_Core>(QOpenGLContext::currentContext());
+
+    function->glBindVertexArray( vao );
+    function->glDrawArrays( GL_TRIANGLES, aFirst, aEnd - aFirst );
+    function->glBindVertexArray( 0 );
+}
+
+
+void GPU_NONCACHED_MANAGER::drawInstances( unsigned int aVertexCount )
+{
+    QOpenGLFunctions_3_3_Core* function = QOpenGLVersionFunctionsFactory::get<QOpenGLFunctions_3_3_Core>(QOpenGLContext::currentContext());
+
+    if( !m_instances || m_instances->GetSize() == 0 )
+    {
+        if( aVertexCount > 0 )
+        {
+            m_shader->Use();
+            drawVertices( 0, aVertexCount );
+            m_shader->Deactivate();
+        }
+
+        return;
+    }
+
+    if( m_instanceVao == 0 )
+    {
+        // Two triangles covering [-1, 1]^2, the vertex shader scales them to each primitive
+        static const GLfloat quad[] = { -1.0f, -1.0f, 0.0f,   1.0f, -1.0f, 0.0f,
+                                         1.0f,  1.0f, 0.0f,  -1.0f, -1.0f, 0.0f,
+                                         1.0f,  1.0f, 0.0f,  -1.0f,  1.0f, 0.0f };
+
+        function->glGenVertexArrays( 1, &m_instanceVao );
+        function->glGenBuffers( 1, &m_quadVbo );
+        function->glGenBuffers( 1, &m_instanceVbo );
+        function->glBindVertexArray( m_instanceVao );
+
+        // a_position: corner of the unit quad
+        function->glBindBuffer( GL_ARRAY_BUFFER, m_quadVbo );
+        function->glBufferData( GL_ARRAY_BUFFER, sizeof( quad ), quad, GL_STATIC_DRAW );
+        function->glVertexAttribPointer( 0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof( GLfloat ), (void*) 0 );
+        function->glEnableVertexAttribArray( 0 );
+
+        // a_instanceGeometry, a_instanceParams and a_instanceColor advance once per instance,
+        // their pointers are set for each run
+        for( GLuint attrib = 3; attrib <= 5; ++attrib )
+        {
+            function->glEnableVertexAttribArray( attrib );
+            function->glVertexAttribDivisor( attrib, 1 );
+        }
+
+        function->glBindVertexArray( 0 );
+    }
+
+    if( m_enableDepthTest )
+        function->glEnable( GL_DEPTH_TEST );
+    else
+        function->glDisable( GL_DEPTH_TEST );
+
+    // All the types in one buffer, orphaned as instances are regenerated every frame
+    size_t typeBase[INSTANCE_TYPE_COUNT];
+    size_t total = 0;
+
+    for( int type = 0; type < INSTANCE_TYPE_COUNT; ++type )
+    {
+        typeBase[type] = total;
+        total += m_instances->Get( SHADER_MODE( SHADER_INSTANCED_CIRCLE + type ) ).size();
+    }
+
+    function->glBindBuffer( GL_ARRAY_BUFFER, m_instanceVbo );
+    function->glBufferData( GL_ARRAY_BUFFER, total * INSTANCE_SIZE, nullptr, GL_STREAM_DRAW );
+
+    for( int type = 0; type < INSTANCE_TYPE_COUNT; ++type )
+    {
+        const std::vector<INSTANCE>& instances =
+                m_instances->Get( SHADER_MODE( SHADER_INSTANCED_CIRCLE + type ) );
+
+        if( !instances.empty() )
+        {
+            function->glBufferSubData( GL_ARRAY_BUFFER, typeBase[type] * INSTANCE_SIZE,
+                                       instances.size() * INSTANCE_SIZE, instances.data() );
+        }
+    }
+
+    // Runs of instances are drawn between the vertices submitted before and after them, in
+    // submission order, so overlapping primitives at the same depth keep their visibility
+    unsigned int drawnVertices = 0;
+
+    m_shader->Use();
+
+    for( const INSTANCE_CONTAINER::RUN& run : m_instances->GetRuns() )
+    {
+        drawVertices( drawnVertices, run.vertices );
+        drawnVertices = std::max( drawnVertices, run.vertices );
+
+        const size_t base = ( typeBase[run.type - SHADER_INSTANCED_CIRCLE] + run.first )
+                            * INSTANCE_SIZE;
+
+        function->glBindVertexArray( m_instanceVao );
+        function->glBindBuffer( GL_ARRAY_BUFFER, m_instanceVbo );
+        function->glVertexAttribPointer( 3, 4, GL_FLOAT, GL_FALSE, INSTANCE_SIZE,
+                                         (void*) ( base + INSTANCE_GEOMETRY_OFFSET ) );
+        function->glVertexAttribPointer( 4, 2, GL_FLOAT, GL_FALSE, INSTANCE_SIZE,
+                                         (void*) ( base + INSTANCE_PARAMS_OFFSET ) );
+        function->glVertexAttribPointer( 5, 4, GL_UNSIGNED_BYTE, GL_TRUE, INSTANCE_SIZE,
+                                         (void*) ( base + INSTANCE_COLOR_OFFSET ) );
+
+        // a_shaderMode is not an array here, its constant value selects the shader mode
+        function->glVertexAttrib1f( 6, (GLfloat) run.type );
+        function->glDrawArraysInstanced( GL_TRIANGLES, 0, 6, run.count );
+        function->glBindVertexArray( 0 );
+    }
+
+    drawVertices( drawnVertices, aVertexCount );
+
+    m_shader->Deactivate();
 
+    m_instances->Clear();
 }
 
 void GPU_MANAGER::EnableDepthTest( bool aEnabled )
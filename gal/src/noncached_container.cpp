@@ -67,9 +67,9 @@ void NONCACHED_CONTAINER::SetItem( VERTEX_ITEM* aItem )
 
 VERTEX* NONCACHED_CONTAINER::Allocate( unsigned int aSize )
 {
-    if( m_freeSpace < aSize )
+    // Double the space, as many times as needed by large batches
+    while( m_freeSpace < aSize )
     {
-        // Double the space
         VERTEX* newVertices =
                 static_cast<VERTEX*>( realloc( m_vertices, m_currentSize * 2 * sizeof( VERTEX ) ) );
 
@@ -22,7 +22,8 @@ OPENGL_COMPOSITOR::OPENGL_COMPOSITOR() :
         m_mainFbo( 0 ),
         m_depthBuffer( 0 ),
         m_curFbo( DIRECT_RENDERING ),
-        m_currentAntialiasingMode( GAL_ANTIALIASING_MODE::AA_NONE )
+        m_currentAntialiasingMode( GAL_ANTIALIASING_MODE::AA_NONE ),
+        m_scrollBuffer( 0 )
 {
     m_antialiasing = std::make_unique<ANTIALIASING_NONE>( this );
 }
@@ -361,6 +362,61 @@ void OPENGL_COMPOSITOR::DrawBuffer( unsigned int aSourceHandle, unsigned int aDe
 }
 
 
+bool OPENGL_COMPOSITOR::PrepareScroll( unsigned int aBufferHandle )
+{
+    if( !m_initialized || aBufferHandle == 0 || aBufferHandle > usedBuffers() )
+        return false;
+
+    if( m_scrollBuffer == 0 )
+    {
+        try
+        {
+            m_scrollBuffer = CreateBuffer( m_buffers[aBufferHandle - 1].dimensions );
+        }
+        catch( const std::runtime_error& )
+        {
+            spdlog::trace( "Could not create a framebuffer for scrolling.\n" );
+            return false;
+        }
+    }
+
+    return m_buffers[m_scrollBuffer - 1].dimensions == m_buffers[aBufferHandle - 1].dimensions;
+}
+
+
+bool OPENGL_COMPOSITOR::ScrollBuffer( unsigned int aBufferHandle, const VECTOR2I& aDelta )
+{
+    if( !PrepareScroll( aBufferHandle ) )
+        return false;
+
+    const OPENGL_BUFFER& buffer = m_buffers[aBufferHandle - 1];
+    const OPENGL_BUFFER& scratch = m_buffers[m_scrollBuffer - 1];
+    const VECTOR2I&      size = buffer.dimensions;
+
+    QOpenGLFunctions_3_3_Core* function = QOpenGLVersionFunctionsFactory::get<QOpenGLFunctions_3_3_Core>(QOpenGLContext::currentContext());
+    unsigned int oldBuffer = GetBuffer();
+
+    bindFb( m_mainFbo );
+
+    // Blitting within a single texture is undefined when source and destination overlap, so
+    // the shifted image goes through the scratch buffer. GL counts rows from the bottom.
+    function->glReadBuffer( buffer.attachmentPoint );
+    function->glDrawBuffer( scratch.attachmentPoint );
+    function->glBlitFramebuffer( 0, 0, size.x, size.y, aDelta.x, -aDelta.y, size.x + aDelta.x,
+                                 size.y - aDelta.y, GL_COLOR_BUFFER_BIT, GL_NEAREST );
+
+    function->glReadBuffer( scratch.attachmentPoint );
+    function->glDrawBuffer( buffer.attachmentPoint );
+    function->glBlitFramebuffer( 0, 0, size.x, size.y, 0, 0, size.x, size.y, GL_COLOR_BUFFER_BIT,
+                                 GL_NEAREST );
+    checkGlError( "scrolling framebuffer", __FILE__, __LINE__ );
+
+    SetBuffer( oldBuffer == DIRECT_RENDERING ? DIRECT_RENDERING : DIRECT_RENDERING + oldBuffer );
+
+    return true;
+}
+
+
 void OPENGL_COMPOSITOR::Present()
 {
     m_antialiasing->Present();
@@ -398,6 +454,7 @@ void OPENGL_COMPOSITOR::clean()
         function->glDeleteTextures( 1, &buffer.textureTarget );
 
     m_buffers.clear();
+    m_scrollBuffer = 0;
 
     function->glDeleteFramebuffers( 1, &m_mainFbo );
 
@@ -306,6 +306,7 @@ OPENGL_GAL::OPENGL_GAL(GAL_DISPLAY_OPTIONS& aDisplayOptions,
 
     // Initialize the flags
     m_isFramebufferInitialized = false;
+    m_isClipAreaSet = false;
     m_isBitmapFontInitialized = false;
     m_isInitialized = false;
     m_isGrouping = false;
@@ -433,6 +434,13 @@ bool OPENGL_GAL::updatedGalDisplayOptions( const GAL_DISPLAY_OPTIONS& aOptions )
 
     bool refresh = false;
 
+    if( m_isInitialized )
+    {
+        m_nonCachedManager->EnableInstancing( m_options.m_glInstancing );
+        m_overlayManager->EnableInstancing( m_options.m_glInstancing );
+        m_tempManager->EnableInstancing( m_options.m_glInstancing );
+    }
+
     if( m_options.antialiasing_mode != m_compositor->GetAntialiasingMode() )
     {
         m_compositor->SetAntialiasingMode( m_options.antialiasing_mode );
@@ -465,6 +473,12 @@ VECTOR2D OPENGL_GAL::getScreenPixelSize() const
 }
 
 
+size_t OPENGL_GAL::GetNonCachedDataSize() const
+{
+    return m_nonCachedManager ? m_nonCachedManager->GetPendingDataSize() : 0;
+}
+
+
 void OPENGL_GAL::BeginDrawing()
 {
 #ifdef KICAD_GAL_PROFILE
@@ -659,6 +673,10 @@ void OPENGL_GAL::EndDrawing()
         m_overlayManager->EndDrawing();
         cntEndOverlay.Stop();
     }
+
+    // A clip area set during drawing applies to the targets only, they are composited whole
+    this->glDisable( GL_SCISSOR_TEST );
+    m_isClipAreaSet = false;
         
     cntComposite.Start();
     
@@ -747,6 +765,13 @@ void OPENGL_GAL::DrawLine( const VECTOR2D& aStartPoint, const VECTOR2D& aEndPoin
 }
 
 
+void OPENGL_GAL::DrawLines( std::span<const VECTOR2D> aPoints )
+{
+    m_currentManager->Color( m_strokeColor.r, m_strokeColor.g, m_strokeColor.b, m_strokeColor.a );
+    m_currentManager->Lines( aPoints.data(), aPoints.size() / 2, m_lineWidth, m_layerDepth );
+}
+
+
 void OPENGL_GAL::DrawSegment( const VECTOR2D& aStartPoint, const VECTOR2D& aEndPoint,
                               double aWidth )
 {
@@ -819,64 +844,99 @@ void OPENGL_GAL::DrawCircle( const VECTOR2D& aCenterPoint, double aRadius )
 }
 
 
-void OPENGL_GAL::drawCircle( const VECTOR2D& aCenterPoint, double aRadius, bool aReserve )
+void OPENGL_GAL::DrawCircles( std::span<const VECTOR2D> aCenterPoints,
+                              std::span<const double> aRadii )
 {
+    const size_t count = std::min( aCenterPoints.size(), aRadii.size() );
+
     if( m_isFillEnabled )
     {
-        if( aReserve )
-            m_currentManager->Reserve( 3 );
-
         m_currentManager->Color( m_fillColor.r, m_fillColor.g, m_fillColor.b, m_fillColor.a );
+        m_currentManager->Circles( SHADER_FILLED_CIRCLE, aCenterPoints.data(), aRadii.data(),
+                                   count, 0.0f, m_layerDepth );
+    }
+
+    if( m_isStrokeEnabled )
+    {
+        m_currentManager->Color( m_strokeColor.r, m_strokeColor.g, m_strokeColor.b,
+                                 m_strokeColor.a );
+        m_currentManager->Circles( SHADER_STROKED_CIRCLE, aCenterPoints.data(), aRadii.data(),
+                                   count, m_lineWidth, m_layerDepth );
+    }
+}
 
-        /* Draw a triangle that contains the circle, then shade it leaving only the circle.
-         *  Parameters given to Shader() are indices of the triangle's vertices
-         *  (if you want to understand more, check the vertex shader source [shader.vert]).
-         *  Shader uses this coordinates to determine if fragments are inside the circle or not.
-         *  Does the calculations in the vertex shader now (pixel alignment)
-         *       v2
-         *       /\
-         *      //\\
-         *  v0 /_\/_\ v1
-         */
-        m_currentManager->Shader( SHADER_FILLED_CIRCLE, 1.0, aRadius );
-        m_currentManager->Vertex( aCenterPoint.x, aCenterPoint.y, m_layerDepth );
 
-        m_currentManager->Shader( SHADER_FILLED_CIRCLE, 2.0, aRadius );
-        m_currentManager->Vertex( aCenterPoint.x, aCenterPoint.y, m_layerDepth );
+void OPENGL_GAL::drawCircle( const VECTOR2D& aCenterPoint, double aRadius, bool aReserve )
+{
+    // Instanced circles are a square expanded by the vertex shader, see SHADER_INSTANCED_CIRCLE
+    const GLfloat instance[4] = { (GLfloat) aCenterPoint.x, (GLfloat) aCenterPoint.y,
+                                  (GLfloat) aRadius, 0.0f };
 
-        m_currentManager->Shader( SHADER_FILLED_CIRCLE, 3.0, aRadius );
-        m_currentManager->Vertex( aCenterPoint.x, aCenterPoint.y, m_layerDepth );
+    if( m_isFillEnabled )
+    {
+        m_currentManager->Color( m_fillColor.r, m_fillColor.g, m_fillColor.b, m_fillColor.a );
+
+        if( !m_currentManager->Instance( SHADER_INSTANCED_CIRCLE, instance, 0.0f, m_layerDepth ) )
+        {
+            if( aReserve )
+                m_currentManager->Reserve( 3 );
+
+            /* Draw a triangle that contains the circle, then shade it leaving only the circle.
+             *  Parameters given to Shader() are indices of the triangle's vertices
+             *  (if you want to understand more, check the vertex shader source [shader.vert]).
+             *  Shader uses this coordinates to determine if fragments are inside the circle or not.
+             *  Does the calculations in the vertex shader now (pixel alignment)
+             *       v2
+             *       /\
+             *      //\\
+             *  v0 /_\/_\ v1
+             */
+            m_currentManager->Shader( SHADER_FILLED_CIRCLE, 1.0, aRadius );
+            m_currentManager->Vertex( aCenterPoint.x, aCenterPoint.y, m_layerDepth );
+
+            m_currentManager->Shader( SHADER_FILLED_CIRCLE, 2.0, aRadius );
+            m_currentManager->Vertex( aCenterPoint.x, aCenterPoint.y, m_layerDepth );
+
+            m_currentManager->Shader( SHADER_FILLED_CIRCLE, 3.0, aRadius );
+            m_currentManager->Vertex( aCenterPoint.x, aCenterPoint.y, m_layerDepth );
+        }
     }
 
     if( m_isStrokeEnabled )
     {
-        if( aReserve )
-            m_currentManager->Reserve( 3 );
-
         m_currentManager->Color( m_strokeColor.r, m_strokeColor.g, m_strokeColor.b,
                                  m_strokeColor.a );
 
-        /* Draw a triangle that contains the circle, then shade it leaving only the circle.
-         *  Parameters given to Shader() are indices of the triangle's vertices
-         *  (if you want to understand more, check the vertex shader source [shader.vert]).
-         *  and the line width. Shader uses this coordinates to determine if fragments are
-         *  inside the circle or not.
-         *       v2
-         *       /\
-         *      //\\
-         *  v0 /_\/_\ v1
-         */
-        m_currentManager->Shader( SHADER_STROKED_CIRCLE, 1.0, aRadius, m_lineWidth );
-        m_currentManager->Vertex( aCenterPoint.x, // v0
-                                  aCenterPoint.y, m_layerDepth );
-
-        m_currentManager->Shader( SHADER_STROKED_CIRCLE, 2.0, aRadius, m_lineWidth );
-        m_currentManager->Vertex( aCenterPoint.x, // v1
-                                  aCenterPoint.y, m_layerDepth );
-
-        m_currentManager->Shader( SHADER_STROKED_CIRCLE, 3.0, aRadius, m_lineWidth );
-        m_currentManager->Vertex( aCenterPoint.x, aCenterPoint.y, // v2
-                                  m_layerDepth );
+        // A zero width instance is a filled circle, so those go through vertices
+        if( m_lineWidth <= 0.0
+            || !m_currentManager->Instance( SHADER_INSTANCED_CIRCLE, instance, m_lineWidth,
+                                            m_layerDepth ) )
+        {
+            if( aReserve )
+                m_currentManager->Reserve( 3 );
+
+            /* Draw a triangle that contains the circle, then shade it leaving only the circle.
+             *  Parameters given to Shader() are indices of the triangle's vertices
+             *  (if you want to understand more, check the vertex shader source [shader.vert]).
+             *  and the line width. Shader uses this coordinates to determine if fragments are
+             *  inside the circle or not.
+             *       v2
+             *       /\
+             *      //\\
+             *  v0 /_\/_\ v1
+             */
+            m_currentManager->Shader( SHADER_STROKED_CIRCLE, 1.0, aRadius, m_lineWidth );
+            m_currentManager->Vertex( aCenterPoint.x, // v0
+                                      aCenterPoint.y, m_layerDepth );
+
+            m_currentManager->Shader( SHADER_STROKED_CIRCLE, 2.0, aRadius, m_lineWidth );
+            m_currentManager->Vertex( aCenterPoint.x, // v1
+                                      aCenterPoint.y, m_layerDepth );
+
+            m_currentManager->Shader( SHADER_STROKED_CIRCLE, 3.0, aRadius, m_lineWidth );
+            m_currentManager->Vertex( aCenterPoint.x, aCenterPoint.y, // v2
+                                      m_layerDepth );
+        }
     }
 }
 
@@ -904,25 +964,25 @@ void OPENGL_GAL::DrawArc( const VECTOR2D& aCenterPoint, double aRadius,
         m_currentManager->Color( m_fillColor.r, m_fillColor.g, m_fillColor.b, m_fillColor.a );
         m_currentManager->Shader( SHADER_NONE );
 
-        // Triangle fan
+        // Triangle fan, transformed and written at once by Vertices()
+        m_batchXY.clear();
+
         for( alpha = startAngle; ( alpha + alphaIncrement ) < endAngle; )
         {
-            m_currentManager->Reserve( 3 );
-            m_currentManager->Vertex( 0.0, 0.0, m_layerDepth );
-            m_currentManager->Vertex( cos( alpha ) * aRadius, sin( alpha ) * aRadius,
-                                      m_layerDepth );
+            m_batchXY.insert( m_batchXY.end(), { 0.0f, 0.0f, GLfloat( cos( alpha ) * aRadius ),
+                                                 GLfloat( sin( alpha ) * aRadius ) } );
             alpha += alphaIncrement;
-            m_currentManager->Vertex( cos( alpha ) * aRadius, sin( alpha ) * aRadius,
-                                      m_layerDepth );
+            m_batchXY.insert( m_batchXY.end(), { GLfloat( cos( alpha ) * aRadius ),
+                                                 GLfloat( sin( alpha ) * aRadius ) } );
         }
 
         // The last missing triangle
-        const VECTOR2D endPoint( cos( endAngle ) * aRadius, sin( endAngle ) * aRadius );
+        m_batchXY.insert( m_batchXY.end(), { 0.0f, 0.0f, GLfloat( cos( alpha ) * aRadius ),
+                                             GLfloat( sin( alpha ) * aRadius ),
+                                             GLfloat( cos( endAngle ) * aRadius ),
+                                             GLfloat( sin( endAngle ) * aRadius ) } );
 
-        m_currentManager->Reserve( 3 );
-        m_currentManager->Vertex( 0.0, 0.0, m_layerDepth );
-        m_currentManager->Vertex( cos( alpha ) * aRadius, sin( alpha ) * aRadius, m_layerDepth );
-        m_currentManager->Vertex( endPoint.x, endPoint.y, m_layerDepth );
+        m_currentManager->Vertices( m_batchXY.data(), m_batchXY.size() / 2, m_layerDepth );
     }
 
     if( m_isStrokeEnabled )
@@ -1112,17 +1172,24 @@ void OPENGL_GAL::DrawRectangle( const VECTOR2D& aStartPoint, const VECTOR2D& aEn
     // Fill the rectangle
     if( m_isFillEnabled )
     {
-        m_currentManager->Reserve( 6 );
-        m_currentManager->Shader( SHADER_NONE );
         m_currentManager->Color( m_fillColor.r, m_fillColor.g, m_fillColor.b, m_fillColor.a );
 
-        m_currentManager->Vertex( aStartPoint.x, aStartPoint.y, m_layerDepth );
-        m_currentManager->Vertex( diagonalPointA.x, diagonalPointA.y, m_layerDepth );
-        m_currentManager->Vertex( aEndPoint.x, aEndPoint.y, m_layerDepth );
+        const GLfloat instance[4] = { (GLfloat) aStartPoint.x, (GLfloat) aStartPoint.y,
+                                      (GLfloat) aEndPoint.x, (GLfloat) aEndPoint.y };
+
+        if( !m_currentManager->Instance( SHADER_INSTANCED_RECT, instance, 0.0f, m_layerDepth ) )
+        {
+            m_currentManager->Reserve( 6 );
+            m_currentManager->Shader( SHADER_NONE );
+
+            m_currentManager->Vertex( aStartPoint.x, aStartPoint.y, m_layerDepth );
+            m_currentManager->Vertex( diagonalPointA.x, diagonalPointA.y, m_layerDepth );
+            m_currentManager->Vertex( aEndPoint.x, aEndPoint.y, m_layerDepth );
 
-        m_currentManager->Vertex( aStartPoint.x, aStartPoint.y, m_layerDepth );
-        m_currentManager->Vertex( aEndPoint.x, aEndPoint.y, m_layerDepth );
-        m_currentManager->Vertex( diagonalPointB.x, diagonalPointB.y, m_layerDepth );
+            m_currentManager->Vertex( aStartPoint.x, aStartPoint.y, m_layerDepth );
+            m_currentManager->Vertex( aEndPoint.x, aEndPoint.y, m_layerDepth );
+            m_currentManager->Vertex( diagonalPointB.x, diagonalPointB.y, m_layerDepth );
+        }
     }
 
     // Stroke the outline
@@ -1137,6 +1204,14 @@ void OPENGL_GAL::DrawRectangle( const VECTOR2D& aStartPoint, const VECTOR2D& aEn
         {
             DrawLine( aStartPoint + VECTOR2D( 1.0, 0.0 ), aEndPoint );
         }
+        else if( m_currentManager->IsInstancingAvailable() )
+        {
+            // Four segment instances, without building a polyline
+            drawLineQuad( aStartPoint, diagonalPointA );
+            drawLineQuad( diagonalPointA, aEndPoint );
+            drawLineQuad( aEndPoint, diagonalPointB );
+            drawLineQuad( diagonalPointB, aStartPoint );
+        }
         else
         {
             std::deque<VECTOR2D> pointList;
@@ -1152,6 +1227,51 @@ void OPENGL_GAL::DrawRectangle( const VECTOR2D& aStartPoint, const VECTOR2D& aEn
 }
 
 
+void OPENGL_GAL::DrawRectangles( std::span<const VECTOR2D> aCorners )
+{
+    const size_t count = aCorners.size() / 2;
+
+    if( m_isFillEnabled )
+    {
+        m_currentManager->Color( m_fillColor.r, m_fillColor.g, m_fillColor.b, m_fillColor.a );
+        m_currentManager->Rectangles( aCorners.data(), count, m_layerDepth );
+    }
+
+    // The outlines are drawn as line quads, like DrawRectangle() does
+    if( m_isStrokeEnabled )
+    {
+        m_batchLines.clear();
+        m_batchLines.reserve( count * 8 );
+
+        for( size_t i = 0; i < count; ++i )
+        {
+            const VECTOR2D& start = aCorners[2 * i];
+            const VECTOR2D& end = aCorners[2 * i + 1];
+
+            // Zero length lines are not drawn, so enforce a minimum
+            if( start == end )
+            {
+                m_batchLines.push_back( start + VECTOR2D( 1.0, 0.0 ) );
+                m_batchLines.push_back( end );
+                continue;
+            }
+
+            const VECTOR2D diagonalPointA( end.x, start.y );
+            const VECTOR2D diagonalPointB( start.x, end.y );
+
+            m_batchLines.insert( m_batchLines.end(), { start, diagonalPointA, diagonalPointA, end,
+                                                       end, diagonalPointB, diagonalPointB,
+                                                       start } );
+        }
+
+        m_currentManager->Color( m_strokeColor.r, m_strokeColor.g, m_strokeColor.b,
+                                 m_strokeColor.a );
+        m_currentManager->Lines( m_batchLines.data(), m_batchLines.size() / 2, m_lineWidth,
+                                 m_layerDepth );
+    }
+}
+
+
 void OPENGL_GAL::DrawSegmentChain( const std::vector<VECTOR2D>& aPointList, double aWidth )
 {
     drawSegmentChain(
@@ -2024,6 +2144,82 @@ void OPENGL_GAL::ClearTarget( RENDER_TARGET aTarget )
 }
 
 
+void OPENGL_GAL::SetClipArea( const BOX2I& aArea )
+{
+    BOX2I area = aArea;
+    area.Normalize();
+
+    // glScissor() works in framebuffer pixels, counted from the bottom left corner
+    const VECTOR2I bufferSize = m_compositor->GetScreenSize();
+    const double   scaleX = (double) bufferSize.x / std::max( 1, m_screenSize.x );
+    const double   scaleY = (double) bufferSize.y / std::max( 1, m_screenSize.y );
+
+    const int left = KiROUND( std::floor( area.GetLeft() * scaleX ) );
+    const int right = KiROUND( std::ceil( area.GetRight() * scaleX ) );
+    const int top = KiROUND( std::floor( area.GetTop() * scaleY ) );
+    const int bottom = KiROUND( std::ceil( area.GetBottom() * scaleY ) );
+
+    // Items are only rendered when the managers are flushed, so the ones drawn under the
+    // previous clip area have to be rendered before the scissor changes
+    if( m_isClipAreaSet )
+    {
+        unsigned int oldTarget = m_compositor->GetBuffer();
+
+        m_compositor->SetBuffer( OPENGL_COMPOSITOR::DIRECT_RENDERING + m_mainBuffer );
+        m_nonCachedManager->EndDrawing();
+        m_cachedManager->EndDrawing();
+        m_cachedManager->BeginDrawing();
+
+        if( m_overlayBuffer )
+            m_compositor->SetBuffer( OPENGL_COMPOSITOR::DIRECT_RENDERING + m_overlayBuffer );
+
+        m_overlayManager->EndDrawing();
+
+        if( oldTarget == OPENGL_COMPOSITOR::DIRECT_RENDERING )
+            m_compositor->SetBuffer( OPENGL_COMPOSITOR::DIRECT_RENDERING );
+        else
+            m_compositor->SetBuffer( OPENGL_COMPOSITOR::DIRECT_RENDERING + oldTarget );
+    }
+
+    this->glEnable( GL_SCISSOR_TEST );
+    this->glScissor( left, bufferSize.y - bottom, right - left, bottom - top );
+    m_isClipAreaSet = true;
+}
+
+
+bool OPENGL_GAL::ScrollTargets( const VECTOR2I& aDelta )
+{
+    if( !m_isFramebufferInitialized || m_isClipAreaSet )
+        return false;
+
+    // The buffers may be larger than the screen (HiDPI, supersampling)
+    const VECTOR2I bufferSize = m_compositor->GetScreenSize();
+    const double   scaleX = (double) bufferSize.x / std::max( 1, m_screenSize.x );
+    const double   scaleY = (double) bufferSize.y / std::max( 1, m_screenSize.y );
+    const VECTOR2D bufferDelta( aDelta.x * scaleX, aDelta.y * scaleY );
+
+    // A fractional shift would resample the image, it has to be redrawn instead
+    if( bufferDelta.x != std::round( bufferDelta.x ) || bufferDelta.y != std::round( bufferDelta.y ) )
+        return false;
+
+    const VECTOR2I delta( KiROUND( bufferDelta.x ), KiROUND( bufferDelta.y ) );
+
+    // Check both targets first, a failure must leave them both unchanged
+    if( !m_compositor->PrepareScroll( m_mainBuffer )
+        || ( m_overlayBuffer && !m_compositor->PrepareScroll( m_overlayBuffer ) ) )
+    {
+        return false;
+    }
+
+    m_compositor->ScrollBuffer( m_mainBuffer, delta );
+
+    if( m_overlayBuffer )
+        m_compositor->ScrollBuffer( m_overlayBuffer, delta );
+
+    return true;
+}
+
+
 bool OPENGL_GAL::HasTarget( RENDER_TARGET aTarget )
 {
     switch( aTarget )
@@ -2117,6 +2313,16 @@ void OPENGL_GAL::drawLineQuad( const VECTOR2D& aStartPoint, const VECTOR2D& aEnd
      * dots mark triangles' hypotenuses
      */
 
+    const GLfloat instance[4] = { (GLfloat) aStartPoint.x, (GLfloat) aStartPoint.y,
+                                  (GLfloat) aEndPoint.x, (GLfloat) aEndPoint.y };
+
+    // A segment instance is expanded from a unit quad by the vertex shader
+    if( m_currentManager->Instance( SHADER_INSTANCED_SEGMENT, instance, m_lineWidth,
+                                    m_layerDepth ) )
+    {
+        return;
+    }
+
     auto v1 = m_currentManager->GetTransformation()
               * glm::vec4( aStartPoint.x, aStartPoint.y, 0.0, 0.0 );
     auto v2 = m_currentManager->GetTransformation()
@@ -2780,6 +2986,10 @@ void OPENGL_GAL::init()
     m_overlayManager = new VERTEX_MANAGER( false );
     m_tempManager = new VERTEX_MANAGER( false );
 
+    m_nonCachedManager->EnableInstancing( m_options.m_glInstancing );
+    m_overlayManager->EnableInstancing( m_options.m_glInstancing );
+    m_tempManager->EnableInstancing( m_options.m_glInstancing );
+
     // Make VBOs use shaders
     m_cachedManager->SetShader( *m_shader );
     m_nonCachedManager->SetShader( *m_shader );
@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "gal/include/painter.hxx"
 
 using namespace KIGFX;
@@ -10,4 +12,22 @@ PAINTER::~PAINTER() {}
 
 void PAINTER::DrawLine(const VECTOR2D& aStartPoint, const VECTOR2D& aEndPoint) {
 	m_gal->DrawLine(aStartPoint, aEndPoint);
-}
\ No newline at end of file
+}
+
+bool PAINTER::DrawItems(std::span<VIEW_ITEM* const> aItems, int aLayer) {
+	return false;
+}
+
+void PAINTER::DrawAggregate(const BOX2D& aArea, double aCoverage, int aLayer) {
+	// Sparse areas stay visible, as their items would be drawn at least one pixel wide
+	const double MIN_ALPHA = 0.25;
+	COLOR4D color = m_gal->GetStrokeColor();
+
+	color.a *= std::clamp(aCoverage, MIN_ALPHA, 1.0);
+
+	GAL_SCOPED_ATTRS scopedAttrs(*m_gal, GAL_SCOPED_ATTRS::STROKE_FILL);
+	m_gal->SetIsStroke(false);
+	m_gal->SetIsFill(true);
+	m_gal->SetFillColor(color);
+	m_gal->DrawRectangle(aArea.GetOrigin(), aArea.GetEnd());
+}
@@ -0,0 +1,395 @@
+/**
+ * @file tlsf_allocator.cpp
+ * @brief Two-level segregated fit allocator of ranges of vertex indices, used by the cached
+ * containers to manage their vertex buffers.
+ */
+
+#include "gal/include/tlsf_allocator.hxx"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+
+using namespace KIGFX;
+
+TLSF_ALLOCATOR::TLSF_ALLOCATOR( unsigned int aSize )
+{
+    Reset( aSize );
+}
+
+
+void TLSF_ALLOCATOR::Reset( unsigned int aSize )
+{
+    m_blocks.clear();
+    m_unused = NIL;
+    m_blockAt.clear();
+
+    for( unsigned int fl = 0; fl < FL_COUNT; ++fl )
+    {
+        std::fill( m_heads[fl], m_heads[fl] + SL_COUNT, NIL );
+        m_slBitmap[fl] = 0;
+    }
+
+    m_flBitmap = 0;
+    m_freeSpace = 0;
+    m_freeBlocks = 0;
+
+    if( aSize > 0 )
+        insertFree( newBlock( 0, aSize ) );
+}
+
+
+unsigned int TLSF_ALLOCATOR::Allocate( unsigned int aSize )
+{
+    assert( aSize > 0 );
+
+    unsigned int block = findFree( aSize );
+
+    if( block == NIL )
+        return NONE;
+
+    return use( block, aSize );
+}
+
+
+bool TLSF_ALLOCATOR::Claim( unsigned int aOffset, unsigned int aSize )
+{
+    assert( aSize > 0 );
+
+    auto it = m_blockAt.find( aOffset );
+
+    if( it == m_blockAt.end() || !m_blocks[it->second].free || m_blocks[it->second].size < aSize )
+        return false;
+
+    use( it->second, aSize );
+
+    return true;
+}
+
+
+void TLSF_ALLOCATOR::Free( unsigned int aOffset )
+{
+    unsigned int block = m_blockAt.at( aOffset );
+    unsigned int prev = m_blocks[block].prevPhys;
+    unsigned int next = m_blocks[block].nextPhys;
+
+    assert( !m_blocks[block].free );
+
+    // Merge with the free neighbors, there can be at most one on each side
+    if( prev != NIL && m_blocks[prev].free )
+    {
+        removeFree( prev );
+        m_blocks[prev].size += m_blocks[block].size;
+        m_blocks[prev].nextPhys = next;
+
+        if( next != NIL )
+            m_blocks[next].prevPhys = prev;
+
+        deleteBlock( block );
+        block = prev;
+    }
+
+    if( next != NIL && m_blocks[next].free )
+    {
+        removeFree( next );
+        m_blocks[block].size += m_blocks[next].size;
+        m_blocks[block].nextPhys = m_blocks[next].nextPhys;
+
+        if( m_blocks[block].nextPhys != NIL )
+            m_blocks[m_blocks[block].nextPhys].prevPhys = block;
+
+        deleteBlock( next );
+    }
+
+    insertFree( block );
+}
+
+
+bool TLSF_ALLOCATOR::Resize( unsigned int aOffset, unsigned int aSize )
+{
+    assert( aSize > 0 );
+
+    unsigned int block = m_blockAt.at( aOffset );
+    unsigned int size = m_blocks[block].size;
+
+    assert( !m_blocks[block].free );
+
+    if( aSize <= size )
+    {
+        if( aSize < size )
+            splitFree( block, aSize );
+
+        return true;
+    }
+
+    unsigned int next = m_blocks[block].nextPhys;
+
+    if( next == NIL || !m_blocks[next].free || m_blocks[next].size < aSize - size )
+        return false;
+
+    // Take the beginning of the following free block
+    const unsigned int extra = aSize - size;
+
+    removeFree( next );
+    m_blocks[block].size = aSize;
+
+    if( m_blocks[next].size == extra )
+    {
+        m_blocks[block].nextPhys = m_blocks[next].nextPhys;
+
+        if( m_blocks[block].nextPhys != NIL )
+            m_blocks[m_blocks[block].nextPhys].prevPhys = block;
+
+        deleteBlock( next );
+    }
+    else
+    {
+        m_blockAt.erase( m_blocks[next].offset );
+        m_blocks[next].offset += extra;
+        m_blocks[next].size -= extra;
+        m_blockAt[m_blocks[next].offset] = next;
+        insertFree( next );
+    }
+
+    return true;
+}
+
+
+unsigned int TLSF_ALLOCATOR::GetBlockSize( unsigned int aOffset ) const
+{
+    return m_blocks[m_blockAt.at( aOffset )].size;
+}
+
+
+unsigned int TLSF_ALLOCATOR::GetLargestFreeBlock() const
+{
+    if( !m_flBitmap )
+        return 0;
+
+    // The largest block is in the highest non-empty class, which may hold smaller ones as well
+    const unsigned int fl = std::bit_width( m_flBitmap ) - 1;
+    const unsigned int sl = std::bit_width( m_slBitmap[fl] ) - 1;
+    unsigned int       largest = 0;
+
+    for( unsigned int block = m_heads[fl][sl]; block != NIL; block = m_blocks[block].nextFree )
+        largest = std::max( largest, m_blocks[block].size );
+
+    return largest;
+}
+
+
+std::vector<std::pair<unsigned int, unsigned int>> TLSF_ALLOCATOR::GetFreeBlocks() const
+{
+    std::vector<std::pair<unsigned int, unsigned int>> blocks;
+
+    blocks.reserve( m_freeBlocks );
+
+    for( unsigned int fl = 0; fl < FL_COUNT; ++fl )
+    {
+        for( unsigned int sl = 0; sl < SL_COUNT; ++sl )
+        {
+            for( unsigned int block = m_heads[fl][sl]; block != NIL;
+                 block = m_blocks[block].nextFree )
+            {
+                blocks.emplace_back( m_blocks[block].offset, m_blocks[block].size );
+            }
+        }
+    }
+
+    std::sort( blocks.begin(), blocks.end() );
+
+    return blocks;
+}
+
+
+void TLSF_ALLOCATOR::mapping( unsigned int aSize, unsigned int& aFl, unsigned int& aSl )
+{
+    if( aSize < SL_COUNT )
+    {
+        aFl = 0;
+        aSl = aSize;
+    }
+    else
+    {
+        const unsigned int msb = std::bit_width( aSize ) - 1;
+
+        aFl = msb - SL_LOG2 + 1;
+        aSl = ( aSize >> ( msb - SL_LOG2 ) ) - SL_COUNT;
+    }
+}
+
+
+unsigned int TLSF_ALLOCATOR::findFree( unsigned int aSize ) const
+{
+    unsigned int fl, sl;
+    mapping( aSize, fl, sl );
+
+    const unsigned int requestFl = fl;
+    const unsigned int requestSl = sl;
+
+    // Round up to the next class unless aSize is the smallest size of its class, so that any
+    // block found is large enough
+    if( aSize >= SL_COUNT )
+    {
+        const uint64_t rounded =
+                aSize + ( uint64_t( 1 ) << ( std::bit_width( aSize ) - 1 - SL_LOG2 ) ) - 1;
+
+        if( rounded > std::numeric_limits<unsigned int>::max() )
+            fl = FL_COUNT;
+        else
+            mapping( rounded, fl, sl );
+    }
+
+    uint32_t slMap = fl < FL_COUNT ? m_slBitmap[fl] & ( ~0u << sl ) : 0;
+
+    if( !slMap )
+    {
+        const uint32_t flMap = fl + 1 < FL_COUNT ? m_flBitmap & ( ~0u << ( fl + 1 ) ) : 0;
+
+        if( flMap )
+        {
+            fl = std::countr_zero( flMap );
+            slMap = m_slBitmap[fl];
+        }
+    }
+
+    if( slMap )
+        return m_heads[fl][std::countr_zero( slMap )];
+
+    // Last resort before failing, a first fit in the class of aSize
+    for( unsigned int block = m_heads[requestFl][requestSl]; block != NIL;
+         block = m_blocks[block].nextFree )
+    {
+        if( m_blocks[block].size >= aSize )
+            return block;
+    }
+
+    return NIL;
+}
+
+
+unsigned int TLSF_ALLOCATOR::newBlock( unsigned int aOffset, unsigned int aSize )
+{
+    unsigned int block = m_unused;
+
+    if( block != NIL )
+    {
+        m_unused = m_blocks[block].nextPhys;
+    }
+    else
+    {
+        block = m_blocks.size();
+        m_blocks.emplace_back();
+    }
+
+    m_blocks[block] = { aOffset, aSize, false, NIL, NIL, NIL, NIL };
+    m_blockAt[aOffset] = block;
+
+    return block;
+}
+
+
+void TLSF_ALLOCATOR::deleteBlock( unsigned int aBlock )
+{
+    m_blockAt.erase( m_blocks[aBlock].offset );
+    m_blocks[aBlock].nextPhys = m_unused;
+    m_unused = aBlock;
+}
+
+
+void TLSF_ALLOCATOR::insertFree( unsigned int aBlock )
+{
+    BLOCK& block = m_blocks[aBlock];
+    unsigned int fl, sl;
+
+    mapping( block.size, fl, sl );
+
+    block.free = true;
+    block.prevFree = NIL;
+    block.nextFree = m_heads[fl][sl];
+
+    if( block.nextFree != NIL )
+        m_blocks[block.nextFree].prevFree = aBlock;
+
+    m_heads[fl][sl] = aBlock;
+    m_flBitmap |= 1u << fl;
+    m_slBitmap[fl] |= 1u << sl;
+
+    m_freeSpace += block.size;
+    ++m_freeBlocks;
+}
+
+
+void TLSF_ALLOCATOR::removeFree( unsigned int aBlock )
+{
+    BLOCK& block = m_blocks[aBlock];
+    unsigned int fl, sl;
+
+    mapping( block.size, fl, sl );
+
+    if( block.prevFree != NIL )
+        m_blocks[block.prevFree].nextFree = block.nextFree;
+    else
+        m_heads[fl][sl] = block.nextFree;
+
+    if( block.nextFree != NIL )
+        m_blocks[block.nextFree].prevFree = block.prevFree;
+
+    if( m_heads[fl][sl] == NIL )
+    {
+        m_slBitmap[fl] &= ~( 1u << sl );
+
+        if( !m_slBitmap[fl] )
+            m_flBitmap &= ~( 1u << fl );
+    }
+
+    block.free = false;
+
+    m_freeSpace -= block.size;
+    --m_freeBlocks;
+}
+
+
+void TLSF_ALLOCATOR::splitFree( unsigned int aBlock, unsigned int aSize )
+{
+    const unsigned int restOffset = m_blocks[aBlock].offset + aSize;
+    const unsigned int restSize = m_blocks[aBlock].size - aSize;
+    const unsigned int next = m_blocks[aBlock].nextPhys;
+
+    m_blocks[aBlock].size = aSize;
+
+    if( next != NIL && m_blocks[next].free )
+    {
+        // Extend the following free block backwards
+        removeFree( next );
+        m_blockAt.erase( m_blocks[next].offset );
+        m_blocks[next].offset = restOffset;
+        m_blocks[next].size += restSize;
+        m_blockAt[restOffset] = next;
+        insertFree( next );
+        return;
+    }
+
+    const unsigned int rest = newBlock( restOffset, restSize );
+
+    m_blocks[rest].prevPhys = aBlock;
+    m_blocks[rest].nextPhys = next;
+    m_blocks[aBlock].nextPhys = rest;
+
+    if( next != NIL )
+        m_blocks[next].prevPhys = rest;
+
+    insertFree( rest );
+}
+
+
+unsigned int TLSF_ALLOCATOR::use( unsigned int aBlock, unsigned int aSize )
+{
+    removeFree( aBlock );
+
+    // The block after a free one is always used, so the rest does not need merging
+    if( m_blocks[aBlock].size > aSize )
+        splitFree( aBlock, aSize );
+
+    return m_blocks[aBlock].offset;
+}
@@ -0,0 +1,280 @@
+#include "gal/include/vertex_emitter.hxx"
+
+#include <cstring>
+
+#if defined( __x86_64__ ) || defined( _M_X64 )
+#define VERTEX_EMITTER_X86
+#include <immintrin.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#define VERTEX_TARGET_AVX2
+#else
+#define VERTEX_TARGET_AVX2 __attribute__( ( target( "avx2" ) ) )
+#endif
+#endif
+
+using namespace KIGFX;
+
+// The SIMD implementations write a vertex as two 16 byte halves: coordinates and color, then
+// shader parameters and type
+static_assert( VERTEX_SIZE == 8 * sizeof( GLfloat ) && COLOR_OFFSET == 3 * sizeof( GLfloat ),
+               "EmitVertices() expects 32 byte vertices with the color after the coordinates" );
+
+
+/**
+ * Return the 4 color bytes of a vertex as a float lane, moved around without arithmetic.
+ */
+static GLfloat colorBits( const VERTEX& aVertex )
+{
+    GLfloat bits;
+    memcpy( &bits, &aVertex.r, sizeof( bits ) );
+
+    return bits;
+}
+
+
+static void emitScalar( VERTEX* aTarget, const GLfloat aXY[], size_t aCount, GLfloat aZ,
+                        const glm::mat4* aTransform, const VERTEX& aBase )
+{
+    for( size_t i = 0; i < aCount; ++i )
+    {
+        VERTEX& vertex = aTarget[i];
+
+        vertex = aBase;
+
+        if( aTransform )
+        {
+            const glm::vec4 transVertex = *aTransform * glm::vec4( aXY[2 * i], aXY[2 * i + 1],
+                                                                  aZ, 1.0f );
+
+            vertex.x = transVertex.x;
+            vertex.y = transVertex.y;
+            vertex.z = transVertex.z;
+        }
+        else
+        {
+            vertex.x = aXY[2 * i];
+            vertex.y = aXY[2 * i + 1];
+            vertex.z = aZ;
+        }
+    }
+}
+
+
+#ifdef VERTEX_EMITTER_X86
+
+// One vertex per iteration: (x, y, z, color) is computed, (shader params, type) is constant
+static void emitSse2( VERTEX* aTarget, const GLfloat aXY[], size_t aCount, GLfloat aZ,
+                      const glm::mat4* aTransform, const VERTEX& aBase )
+{
+    const GLfloat* base = reinterpret_cast<const GLfloat*>( &aBase );
+    const __m128   color = _mm_set_ps( colorBits( aBase ), 0.0f, 0.0f, 0.0f );
+    const __m128   shader = _mm_loadu_ps( base + 4 );
+    GLfloat*       target = reinterpret_cast<GLfloat*>( aTarget );
+
+    if( aTransform )
+    {
+        // glm matrices are column major
+        const GLfloat* m = &( *aTransform )[0][0];
+        const __m128   c0 = _mm_loadu_ps( m );
+        const __m128   c1 = _mm_loadu_ps( m + 4 );
+        const __m128   zc = _mm_add_ps( _mm_mul_ps( _mm_loadu_ps( m + 8 ), _mm_set1_ps( aZ ) ),
+                                        _mm_loadu_ps( m + 12 ) );
+        const __m128   xyzMask = _mm_castsi128_ps( _mm_set_epi32( 0, -1, -1, -1 ) );
+
+        for( size_t i = 0; i < aCount; ++i, target += 8 )
+        {
+            __m128 xyz = _mm_add_ps( _mm_add_ps( _mm_mul_ps( c0, _mm_set1_ps( aXY[2 * i] ) ),
+                                                 _mm_mul_ps( c1, _mm_set1_ps( aXY[2 * i + 1] ) ) ),
+                                     zc );
+
+            _mm_storeu_ps( target, _mm_or_ps( _mm_and_ps( xyz, xyzMask ), color ) );
+            _mm_storeu_ps( target + 4, shader );
+        }
+    }
+    else
+    {
+        const __m128 zColor = _mm_set_ps( colorBits( aBase ), aZ, 0.0f, 0.0f );
+
+        for( size_t i = 0; i < aCount; ++i, target += 8 )
+        {
+            const __m128 xy = _mm_castpd_ps(
+                    _mm_load_sd( reinterpret_cast<const double*>( aXY + 2 * i ) ) );
+
+            _mm_storeu_ps( target, _mm_or_ps( xy, zColor ) );
+            _mm_storeu_ps( target + 4, shader );
+        }
+    }
+}
+
+
+// Two vertices per iteration, each written with a single 32 byte store
+VERTEX_TARGET_AVX2
+static void emitAvx2( VERTEX* aTarget, const GLfloat aXY[], size_t aCount, GLfloat aZ,
+                      const glm::mat4* aTransform, const VERTEX& aBase )
+{
+    const GLfloat* base = reinterpret_cast<const GLfloat*>( &aBase );
+    const __m256   shader = _mm256_broadcast_ps( reinterpret_cast<const __m128*>( base + 4 ) );
+    const size_t   pairs = aCount / 2;
+    GLfloat*       target = reinterpret_cast<GLfloat*>( aTarget );
+
+    // x0 y0 x1 y1 spread to the lanes of the two vertices
+    const __m256i xIndex = _mm256_setr_epi32( 0, 0, 0, 0, 2, 2, 2, 2 );
+    const __m256i yIndex = _mm256_setr_epi32( 1, 1, 1, 1, 3, 3, 3, 3 );
+    const __m256i xyIndex = _mm256_setr_epi32( 0, 1, 0, 0, 2, 3, 0, 0 );
+
+    __m256 xyz;
+
+    if( aTransform )
+    {
+        const GLfloat* m = &( *aTransform )[0][0];
+        const __m256   c0 = _mm256_broadcast_ps( reinterpret_cast<const __m128*>( m ) );
+        const __m256   c1 = _mm256_broadcast_ps( reinterpret_cast<const __m128*>( m + 4 ) );
+        const __m256   zc = _mm256_add_ps(
+                _mm256_mul_ps( _mm256_broadcast_ps( reinterpret_cast<const __m128*>( m + 8 ) ),
+                               _mm256_set1_ps( aZ ) ),
+                _mm256_broadcast_ps( reinterpret_cast<const __m128*>( m + 12 ) ) );
+        const __m256   color = _mm256_setr_ps( 0.0f, 0.0f, 0.0f, colorBits( aBase ),
+                                               0.0f, 0.0f, 0.0f, colorBits( aBase ) );
+
+        for( size_t i = 0; i < pairs; ++i, target += 16 )
+        {
+            const __m256 xy = _mm256_castps128_ps256( _mm_loadu_ps( aXY + 4 * i ) );
+
+            xyz = _mm256_add_ps(
+                    _mm256_add_ps( _mm256_mul_ps( c0, _mm256_permutevar8x32_ps( xy, xIndex ) ),
+                                   _mm256_mul_ps( c1, _mm256_permutevar8x32_ps( xy, yIndex ) ) ),
+                    zc );
+            xyz = _mm256_blend_ps( xyz, color, 0x88 );
+
+            _mm256_storeu_ps( target, _mm256_permute2f128_ps( xyz, shader, 0x20 ) );
+            _mm256_storeu_ps( target + 8, _mm256_permute2f128_ps( xyz, shader, 0x21 ) );
+        }
+    }
+    else
+    {
+        const __m256 zColor = _mm256_setr_ps( 0.0f, 0.0f, aZ, colorBits( aBase ),
+                                              0.0f, 0.0f, aZ, colorBits( aBase ) );
+
+        for( size_t i = 0; i < pairs; ++i, target += 16 )
+        {
+            const __m256 xy = _mm256_castps128_ps256( _mm_loadu_ps( aXY + 4 * i ) );
+
+            xyz = _mm256_blend_ps( _mm256_permutevar8x32_ps( xy, xyIndex ), zColor, 0xCC );
+
+            _mm256_storeu_ps( target, _mm256_permute2f128_ps( xyz, shader, 0x20 ) );
+            _mm256_storeu_ps( target + 8, _mm256_permute2f128_ps( xyz, shader, 0x21 ) );
+        }
+    }
+
+    // The last vertex of an odd count
+    if( aCount % 2 )
+        emitSse2( aTarget + 2 * pairs, aXY + 4 * pairs, 1, aZ, aTransform, aBase );
+}
+
+
+static bool isSupported( VERTEX_ISA aIsa )
+{
+    if( aIsa != VERTEX_ISA::AVX2 )
+        return true;    // SSE2 is part of x86-64
+
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid( info, 0 );
+
+    if( info[0] < 7 )
+        return false;
+
+    // The OS has to save the AVX registers (OSXSAVE and XCR0 bits 1-2)
+    __cpuid( info, 1 );
+
+    if( !( info[2] & ( 1 << 27 ) ) || ( _xgetbv( 0 ) & 0x6 ) != 0x6 )
+        return false;
+
+    __cpuidex( info, 7, 0 );
+    return info[1] & ( 1 << 5 );
+#else
+    // Needed when called before the constructors of libgcc, as for static initialization
+    __builtin_cpu_init();
+    return __builtin_cpu_supports( "avx2" );
+#endif
+}
+
+#else
+
+static bool isSupported( VERTEX_ISA aIsa )
+{
+    return aIsa == VERTEX_ISA::SCALAR;
+}
+
+#endif
+
+
+typedef void ( *EMIT_FUNC )( VERTEX*, const GLfloat[], size_t, GLfloat, const glm::mat4*,
+                             const VERTEX& );
+
+
+static EMIT_FUNC emitFunction( VERTEX_ISA aIsa )
+{
+#ifdef VERTEX_EMITTER_X86
+    if( aIsa == VERTEX_ISA::AVX2 )
+        return emitAvx2;
+    else if( aIsa == VERTEX_ISA::SSE2 )
+        return emitSse2;
+#endif
+
+    return emitScalar;
+}
+
+
+static VERTEX_ISA bestIsa()
+{
+    for( VERTEX_ISA isa : { VERTEX_ISA::AVX2, VERTEX_ISA::SSE2 } )
+    {
+        if( isSupported( isa ) )
+            return isa;
+    }
+
+    return VERTEX_ISA::SCALAR;
+}
+
+
+static VERTEX_ISA s_isa = bestIsa();
+static EMIT_FUNC  s_emit = emitFunction( s_isa );
+
+
+void KIGFX::EmitVertices( VERTEX* aTarget, const GLfloat aXY[], size_t aCount, GLfloat aZ,
+                          const glm::mat4* aTransform, const VERTEX& aBase )
+{
+    s_emit( aTarget, aXY, aCount, aZ, aTransform, aBase );
+}
+
+
+VERTEX_ISA KIGFX::GetVertexIsa()
+{
+    return s_isa;
+}
+
+
+bool KIGFX::SetVertexIsa( VERTEX_ISA aIsa )
+{
+    if( !isSupported( aIsa ) )
+        return false;
+
+    s_isa = aIsa;
+    s_emit = emitFunction( aIsa );
+
+    return true;
+}
+
+
+const char* KIGFX::GetVertexIsaName( VERTEX_ISA aIsa )
+{
+    switch( aIsa )
+    {
+    case VERTEX_ISA::AVX2: return "AVX2";
+    case VERTEX_ISA::SSE2: return "SSE2";
+    default:               return "scalar";
+    }
+}
@@ -3,8 +3,11 @@
 #include "gal/include/vertex_item.hxx"
 #include "gal/include/cached_container.hxx"
 #include "gal/include/noncached_container.hxx"
+#include "gal/include/instance_container.hxx"
+#include "gal/include/vertex_emitter.hxx"
 #include "gal/include/gpu_manager.hxx"
 #include "confirm.hxx"
+#include <thread_pool.hxx>
 
 
 /**
@@ -18,14 +21,24 @@ static const std::string traceVertexManager = "KICAD_VERTEX_MANAGER";
 using namespace KIGFX;
 
 VERTEX_MANAGER::VERTEX_MANAGER( bool aCached ) :
+        m_instancingEnabled( true ),
+        m_generationThreads( 0 ),
         m_noTransform( true ),
         m_transform( 1.0f ),
+        m_shaderMode( SHADER_NONE ),
         m_reserved( nullptr ),
         m_reservedSpace( 0 )
 {
     m_container.reset( VERTEX_CONTAINER::MakeContainer( aCached ) );
     m_gpu.reset( GPU_MANAGER::MakeManager( m_container.get() ) );
 
+    // Instances are regenerated every frame, like non-cached vertices
+    if( !aCached )
+    {
+        m_instances = std::make_shared<INSTANCE_CONTAINER>();
+        static_cast<GPU_NONCACHED_MANAGER*>( m_gpu.get() )->SetInstances( m_instances.get() );
+    }
+
     // There is no shader used by default
     for( unsigned int i = 0; i < SHADER_STRIDE; ++i )
         m_shader[i] = 0.0f;
@@ -148,6 +161,303 @@ bool VERTEX_MANAGER::Vertices( const VERTEX aVertices[], unsigned int aSize )
 }
 
 
+bool VERTEX_MANAGER::Vertices( const GLfloat aXY[], unsigned int aSize, GLfloat aZ )
+{
+    VERTEX* newVertex;
+
+    if( aSize == 0 )
+        return true;
+
+    if( m_reservedSpace >= aSize )
+    {
+        newVertex = m_reserved;
+        m_reserved += aSize;
+        m_reservedSpace -= aSize;
+
+        if( m_reservedSpace == 0 )
+            m_reserved = nullptr;
+    }
+    else
+    {
+        newVertex = allocateBatch( aSize );
+
+        if( newVertex == nullptr )
+            return false;
+    }
+
+    VERTEX base = batchVertex( static_cast<SHADER_MODE>( m_shaderMode ) );
+
+    for( unsigned int i = 0; i < SHADER_STRIDE; ++i )
+        base.shader[i] = m_shader[i];
+
+    const glm::mat4* transform = m_noTransform ? nullptr : &m_transform;
+
+    generateBatch( aSize,
+            [&]( size_t aBegin, size_t aEnd )
+            {
+                EmitVertices( newVertex + aBegin, aXY + 2 * aBegin, aEnd - aBegin, aZ, transform,
+                              base );
+            } );
+
+    return true;
+}
+
+
+bool VERTEX_MANAGER::Instance( SHADER_MODE aType, const GLfloat aGeometry[4], GLfloat aWidth,
+                               GLfloat aDepth )
+{
+    if( !IsInstancingAvailable() )
+        return false;
+
+    INSTANCE instance;
+
+    for( unsigned int i = 0; i < 4; ++i )
+    {
+        instance.geometry[i] = aGeometry[i];
+        instance.color[i] = m_color[i];
+    }
+
+    instance.width = aWidth;
+    instance.depth = aDepth;
+
+    m_instances->Add( aType, instance, m_container->GetSize() );
+
+    return true;
+}
+
+
+bool VERTEX_MANAGER::Circles( SHADER_MODE aMode, const VECTOR2D aCenters[],
+                              const double aRadii[], size_t aCount, GLfloat aWidth,
+                              GLfloat aDepth )
+{
+    if( aCount == 0 )
+        return true;
+
+    const bool stroked = aMode == SHADER_STROKED_CIRCLE;
+
+    // A zero width instance is a filled circle, so zero width strokes go through vertices
+    if( IsInstancingAvailable() && ( !stroked || aWidth > 0.0f ) )
+    {
+        INSTANCE* instances = m_instances->Add( SHADER_INSTANCED_CIRCLE, aCount,
+                                                 m_container->GetSize() );
+
+        generateBatch( aCount,
+                [&]( size_t aBegin, size_t aEnd )
+                {
+                    for( INSTANCE* instance = instances + aBegin; aBegin < aEnd;
+                         ++aBegin, ++instance )
+                    {
+                        instance->geometry[0] = aCenters[aBegin].x;
+                        instance->geometry[1] = aCenters[aBegin].y;
+                        instance->geometry[2] = aRadii[aBegin];
+                        instance->geometry[3] = 0.0f;
+                        instance->width = stroked ? aWidth : 0.0f;
+                        instance->depth = aDepth;
+
+                        for( unsigned int j = 0; j < COLOR_STRIDE; ++j )
+                            instance->color[j] = m_color[j];
+                    }
+                } );
+
+        return true;
+    }
+
+    VERTEX* vertices = allocateBatch( aCount * 3 );
+
+    if( vertices == nullptr )
+        return false;
+
+    // The vertex shader expands each triangle around its circle, see OPENGL_GAL::drawCircle()
+    const VERTEX base = batchVertex( aMode );
+
+    generateBatch( aCount,
+            [&]( size_t aBegin, size_t aEnd )
+            {
+                VERTEX* vertex = vertices + aBegin * 3;
+
+                for( size_t i = aBegin; i < aEnd; ++i )
+                {
+                    for( int j = 1; j <= 3; ++j, ++vertex )
+                    {
+                        *vertex = base;
+                        vertex->x = aCenters[i].x;
+                        vertex->y = aCenters[i].y;
+                        vertex->z = aDepth;
+                        vertex->shader[0] = j;
+                        vertex->shader[1] = aRadii[i];
+                        vertex->shader[2] = stroked ? aWidth : 0.0f;
+                    }
+                }
+
+                transformBatch( vertices + aBegin * 3, ( aEnd - aBegin ) * 3 );
+            } );
+
+    return true;
+}
+
+
+bool VERTEX_MANAGER::Rectangles( const VECTOR2D aCorners[], size_t aCount, GLfloat aDepth )
+{
+    if( aCount == 0 )
+        return true;
+
+    if( IsInstancingAvailable() )
+    {
+        INSTANCE* instances = m_instances->Add( SHADER_INSTANCED_RECT, aCount,
+                                                 m_container->GetSize() );
+
+        generateBatch( aCount,
+                [&]( size_t aBegin, size_t aEnd )
+                {
+                    for( INSTANCE* instance = instances + aBegin; aBegin < aEnd;
+                         ++aBegin, ++instance )
+                    {
+                        instance->geometry[0] = aCorners[2 * aBegin].x;
+                        instance->geometry[1] = aCorners[2 * aBegin].y;
+                        instance->geometry[2] = aCorners[2 * aBegin + 1].x;
+                        instance->geometry[3] = aCorners[2 * aBegin + 1].y;
+                        instance->width = 0.0f;
+                        instance->depth = aDepth;
+
+                        for( unsigned int j = 0; j < COLOR_STRIDE; ++j )
+                            instance->color[j] = m_color[j];
+                    }
+                } );
+
+        return true;
+    }
+
+    VERTEX* vertices = allocateBatch( aCount * 6 );
+
+    if( vertices == nullptr )
+        return false;
+
+    const VERTEX base = batchVertex( SHADER_NONE );
+
+    generateBatch( aCount,
+            [&]( size_t aBegin, size_t aEnd )
+            {
+                VERTEX* vertex = vertices + aBegin * 6;
+
+                for( size_t i = aBegin; i < aEnd; ++i )
+                {
+                    const VECTOR2D& start = aCorners[2 * i];
+                    const VECTOR2D& end = aCorners[2 * i + 1];
+
+                    // Two triangles: start, (end.x, start.y), end and start, end, (start.x, end.y)
+                    const GLfloat xs[6] = { (GLfloat) start.x, (GLfloat) end.x, (GLfloat) end.x,
+                                            (GLfloat) start.x, (GLfloat) end.x, (GLfloat) start.x };
+                    const GLfloat ys[6] = { (GLfloat) start.y, (GLfloat) start.y, (GLfloat) end.y,
+                                            (GLfloat) start.y, (GLfloat) end.y, (GLfloat) end.y };
+
+                    for( int j = 0; j < 6; ++j, ++vertex )
+                    {
+                        *vertex = base;
+                        vertex->x = xs[j];
+                        vertex->y = ys[j];
+                        vertex->z = aDepth;
+                    }
+                }
+
+                transformBatch( vertices + aBegin * 6, ( aEnd - aBegin ) * 6 );
+            } );
+
+    return true;
+}
+
+
+bool VERTEX_MANAGER::Lines( const VECTOR2D aPoints[], size_t aCount, GLfloat aWidth,
+                            GLfloat aDepth )
+{
+    if( aCount == 0 )
+        return true;
+
+    if( IsInstancingAvailable() )
+    {
+        INSTANCE* instances = m_instances->Add( SHADER_INSTANCED_SEGMENT, aCount,
+                                                 m_container->GetSize() );
+
+        generateBatch( aCount,
+                [&]( size_t aBegin, size_t aEnd )
+                {
+                    for( INSTANCE* instance = instances + aBegin; aBegin < aEnd;
+                         ++aBegin, ++instance )
+                    {
+                        instance->geometry[0] = aPoints[2 * aBegin].x;
+                        instance->geometry[1] = aPoints[2 * aBegin].y;
+                        instance->geometry[2] = aPoints[2 * aBegin + 1].x;
+                        instance->geometry[3] = aPoints[2 * aBegin + 1].y;
+                        instance->width = aWidth;
+                        instance->depth = aDepth;
+
+                        for( unsigned int j = 0; j < COLOR_STRIDE; ++j )
+                            instance->color[j] = m_color[j];
+                    }
+                } );
+
+        return true;
+    }
+
+    VERTEX* vertices = allocateBatch( aCount * 6 );
+
+    if( vertices == nullptr )
+        return false;
+
+    // Line quads as in OPENGL_GAL::drawLineQuad(), the shader offsets the vertices by the
+    // (transformed) line vector
+    static const GLushort modes[6] = { SHADER_LINE_A, SHADER_LINE_B, SHADER_LINE_C,
+                                       SHADER_LINE_D, SHADER_LINE_E, SHADER_LINE_F };
+    static const bool     atEnd[6] = { false, false, true, true, true, false };
+
+    const VERTEX base = batchVertex( SHADER_NONE );
+
+    generateBatch( aCount,
+            [&]( size_t aBegin, size_t aEnd )
+            {
+                VERTEX* vertex = vertices + aBegin * 6;
+
+                for( size_t i = aBegin; i < aEnd; ++i )
+                {
+                    const VECTOR2D& start = aPoints[2 * i];
+                    const VECTOR2D& end = aPoints[2 * i + 1];
+                    glm::vec4       vs( end.x - start.x, end.y - start.y, 0.0f, 0.0f );
+
+                    if( !m_noTransform )
+                        vs = m_transform * vs;
+
+                    for( int j = 0; j < 6; ++j, ++vertex )
+                    {
+                        const VECTOR2D& point = atEnd[j] ? end : start;
+
+                        *vertex = base;
+                        vertex->x = point.x;
+                        vertex->y = point.y;
+                        vertex->z = aDepth;
+                        vertex->mode = modes[j];
+                        vertex->shader[0] = aWidth;
+                        vertex->shader[1] = vs.x;
+                        vertex->shader[2] = vs.y;
+                    }
+                }
+
+                transformBatch( vertices + aBegin * 6, ( aEnd - aBegin ) * 6 );
+            } );
+
+    return true;
+}
+
+
+size_t VERTEX_MANAGER::GetPendingDataSize() const
+{
+    size_t size = m_container->GetSize() * VERTEX_SIZE;
+
+    if( m_instances )
+        size += m_instances->GetSize() * INSTANCE_SIZE;
+
+    return size;
+}
+
+
 void VERTEX_MANAGER::SetItem( VERTEX_ITEM& aItem ) const
 {
     m_container->SetItem( &aItem );
@@ -224,6 +534,9 @@ void VERTEX_MANAGER::SetShader( SHADER& aShader ) const
 void VERTEX_MANAGER::Clear() const
 {
     m_container->Clear();
+
+    if( m_instances )
+        m_instances->Clear();
 }
 
 
@@ -273,6 +586,8 @@ void VERTEX_MANAGER::putVertex( VERTEX& aTarget, GLfloat aX, GLfloat aY, GLfloat
     aTarget.a = m_color[3];
 
     // Apply currently used shader
+    aTarget.mode = m_shaderMode;
+
     for( unsigned int j = 0; j < SHADER_STRIDE; ++j )
     {
         aTarget.shader[j] = m_shader[j];
@@ -280,6 +595,79 @@ void VERTEX_MANAGER::putVertex( VERTEX& aTarget, GLfloat aX, GLfloat aY, GLfloat
 }
 
 
+VERTEX* VERTEX_MANAGER::allocateBatch( size_t aSize )
+{
+    // flag to avoid hanging by calling DisplayError too many times:
+    static bool show_err = true;
+
+    VERTEX* vertices = m_container->Allocate( aSize );
+
+    if( vertices == nullptr && show_err )
+    {
+        DisplayError( nullptr, "VERTEX_MANAGER: Vertex allocation error" );
+        show_err = false;
+    }
+
+    return vertices;
+}
+
+
+VERTEX VERTEX_MANAGER::batchVertex( SHADER_MODE aMode ) const
+{
+    VERTEX vertex = {};
+
+    vertex.r = m_color[0];
+    vertex.g = m_color[1];
+    vertex.b = m_color[2];
+    vertex.a = m_color[3];
+    vertex.mode = aMode;
+
+    return vertex;
+}
+
+
+void VERTEX_MANAGER::transformBatch( VERTEX* aVertices, size_t aSize ) const
+{
+    if( m_noTransform )
+        return;
+
+    for( size_t i = 0; i < aSize; ++i )
+    {
+        glm::vec4 transVertex( aVertices[i].x, aVertices[i].y, aVertices[i].z, 1.0f );
+        transVertex = m_transform * transVertex;
+
+        aVertices[i].x = transVertex.x;
+        aVertices[i].y = transVertex.y;
+        aVertices[i].z = transVertex.z;
+    }
+}
+
+
+void VERTEX_MANAGER::generateBatch( size_t aCount,
+                                    const std::function<void( size_t, size_t )>& aGenerate ) const
+{
+    THREAD_POOL& pool = GetKiCadThreadPool();
+    // By default one thread per core, the calling thread included
+    const size_t threads = m_generationThreads ? m_generationThreads : pool.GetThreadCount();
+
+    // Small batches are not worth waking up the workers
+    const size_t ranges = std::min( threads, aCount / MIN_GENERATION_RANGE );
+
+    if( ranges <= 1 )
+    {
+        aGenerate( 0, aCount );
+        return;
+    }
+
+    // Fixed ranges, so each primitive ends up at the same place whichever thread generates it
+    pool.ParallelFor( ranges,
+            [&]( size_t aRange )
+            {
+                aGenerate( aCount * aRange / ranges, aCount * ( aRange + 1 ) / ranges );
+            } );
+}
+
+
 void VERTEX_MANAGER::EnableDepthTest( bool aEnabled )
 {
     m_gpu->EnableDepthTest( aEnabled );
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+#include "box2.hxx"
+
+/**
+ * Number of bits per axis of the grid the Hilbert curve goes through.
+ */
+constexpr int HILBERT_ORDER = 16;
+
+/**
+ * Return the distance along a Hilbert curve covering a 2^HILBERT_ORDER square grid of the
+ * cell ( \a aX, \a aY ).
+ *
+ * Cells close along the curve are close in the plane, so sorting objects by this distance
+ * keeps spatially adjacent objects close in memory.
+ */
+inline uint64_t HilbertIndex( uint32_t aX, uint32_t aY )
+{
+    uint64_t index = 0;
+
+    for( uint32_t s = 1u << ( HILBERT_ORDER - 1 ); s > 0; s >>= 1 )
+    {
+        const uint32_t rx = ( aX & s ) > 0;
+        const uint32_t ry = ( aY & s ) > 0;
+
+        index += static_cast<uint64_t>( s ) * s * ( ( 3 * rx ) ^ ry );
+
+        // Rotate the quadrant so that the curve stays continuous
+        if( ry == 0 )
+        {
+            if( rx == 1 )
+            {
+                aX = s - 1 - ( aX & ( s - 1 ) );
+                aY = s - 1 - ( aY & ( s - 1 ) );
+            }
+
+            std::swap( aX, aY );
+        }
+    }
+
+    return index;
+}
+
+
+/**
+ * Return the Hilbert curve distance of the point \a aPoint, the grid being stretched over
+ * \a aExtents. Points outside of \a aExtents are clamped to its border.
+ */
+inline uint64_t HilbertIndex( const VECTOR2D& aPoint, const BOX2D& aExtents )
+{
+    constexpr double cells = ( 1u << HILBERT_ORDER ) - 1;
+
+    auto cell = []( double aValue, double aOrigin, double aSize ) -> uint32_t
+                {
+                    if( aSize <= 0.0 )
+                        return 0;
+
+                    return static_cast<uint32_t>(
+                            std::clamp( ( aValue - aOrigin ) / aSize, 0.0, 1.0 ) * cells );
+                };
+
+    return HilbertIndex( cell( aPoint.x, aExtents.GetX(), aExtents.GetWidth() ),
+                         cell( aPoint.y, aExtents.GetY(), aExtents.GetHeight() ) );
+}
@@ -0,0 +1,2164 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include <QGuiApplication>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include "data_line.hxx"
+#include "data_manager.hxx"
+#include "data_rectangle.hxx"
+#include "gal/include/cached_container.hxx"
+#include "gal/include/graphics_abstraction_layer.hxx"
+#include "gal/include/instance_container.hxx"
+#include "gal/include/painter.hxx"
+#include "gal/include/vertex_container.hxx"
+#include "gal/include/vertex_emitter.hxx"
+#include "gal/include/vertex_item.hxx"
+#include "gal/include/vertex_manager.hxx"
+#include "view.hxx"
+#include "view_index.hxx"
+#include "shape_line_chain.hxx"
+#include "kicad_algo.hxx"
+#include "profile.hxx"
+
+using namespace KIGFX;
+
+// Synthetic board: random rectangles scattered over a 1m x 1m area (in nm)
+static std::vector<DATA_Rectangle> makeRectangles(size_t aCount)
+{
+	constexpr int EXTENT = 1000000000;
+	constexpr int MAX_SIZE = 200000;
+
+	std::mt19937 gen(12345);
+	std::uniform_int_distribution<int> distPos(0, EXTENT - MAX_SIZE);
+	std::uniform_int_distribution<int> distSize(1000, MAX_SIZE);
+
+	std::vector<DATA_Rectangle> rectangles;
+	rectangles.reserve(aCount);
+
+	for (size_t i = 0; i < aCount; ++i) {
+		VECTOR2I start(distPos(gen), distPos(gen));
+		VECTOR2I end = start + VECTOR2I(distSize(gen), distSize(gen));
+		rectangles.emplace_back(start, end);
+	}
+
+	return rectangles;
+}
+
+static std::vector<VIEW_ITEM*> itemPointers(std::vector<DATA_Rectangle>& aItems)
+{
+	std::vector<VIEW_ITEM*> items;
+	items.reserve(aItems.size());
+
+	for (DATA_Rectangle& item : aItems)
+		items.push_back(&item);
+
+	return items;
+}
+
+// VIEW::Add() per item vs VIEW::AddItems() bulk load
+static void benchLoad(size_t aCount)
+{
+	std::vector<DATA_Rectangle> rectangles = makeRectangles(aCount);
+	std::vector<VIEW_ITEM*> items = itemPointers(rectangles);
+	double perItemMs, bulkMs;
+
+	{
+		VIEW view;
+		PROF_TIMER timer;
+
+		for (VIEW_ITEM* item : items)
+			view.Add(item);
+
+		timer.Stop();
+		perItemMs = timer.msecs();
+		view.Clear();
+	}
+
+	{
+		VIEW view;
+		PROF_TIMER timer;
+
+		view.AddItems(items);
+
+		timer.Stop();
+		bulkMs = timer.msecs();
+		view.Clear();
+	}
+
+	printf("load %10zu items: Add() %10.1f ms, AddItems() %10.1f ms, speedup %.1fx\n",
+		aCount, perItemMs, bulkMs, perItemMs / bulkMs);
+}
+
+// Per-frame query cost: one VIEW::Query() over all layers per frame, for several viewport sizes
+static void benchQuery(size_t aCount)
+{
+	constexpr int EXTENT = 1000000000;
+	constexpr int FRAMES = 50;
+
+	std::vector<DATA_Rectangle> rectangles = makeRectangles(aCount);
+	std::vector<VIEW_ITEM*> items = itemPointers(rectangles);
+
+	VIEW view;
+	view.AddItems(items);
+
+	std::vector<VIEW::LAYER_ITEM_PAIR> scratch;
+
+	for (double fraction : { 0.001, 0.01, 0.1, 0.5, 1.0 }) {
+		const int size = static_cast<int>(EXTENT * std::sqrt(fraction));
+		const BOX2I viewport(VECTOR2I((EXTENT - size) / 2, (EXTENT - size) / 2), VECTOR2I(size, size));
+		size_t hits = 0;
+		size_t visited = 0;
+
+		// Materialize into a fresh vector every frame (the previous VIEW_RTREE::Query behaviour)
+		PROF_TIMER copyTimer;
+
+		for (int frame = 0; frame < FRAMES; ++frame) {
+			std::vector<VIEW_ITEM*> result;
+			view.Query(viewport, [&](VIEW_ITEM* aItem) { result.push_back(aItem); return true; });
+			hits = result.size();
+		}
+
+		copyTimer.Stop();
+
+		// Stream hits straight to the visitor
+		PROF_TIMER streamTimer;
+
+		for (int frame = 0; frame < FRAMES; ++frame) {
+			visited = 0;
+			view.Query(viewport, [&](VIEW_ITEM* aItem) { visited++; return true; });
+		}
+
+		streamTimer.Stop();
+
+		// Reusable scratch buffer
+		PROF_TIMER scratchTimer;
+
+		for (int frame = 0; frame < FRAMES; ++frame) {
+			scratch.clear();
+			view.Query(viewport, scratch);
+		}
+
+		scratchTimer.Stop();
+
+		if (visited != hits || scratch.size() != hits)
+			printf("query: result mismatch\n");
+
+		printf("query %5.1f%% of board, %9zu hits: fresh vector %8.3f ms, streaming %8.3f ms, "
+			"scratch %8.3f ms per frame\n",
+			fraction * 100.0, hits, copyTimer.msecs() / FRAMES, streamTimer.msecs() / FRAMES,
+			scratchTimer.msecs() / FRAMES);
+	}
+
+	view.Clear();
+}
+
+// Interactive drag: a random subset of items moves every frame. VIEW::Remove() + VIEW::Add()
+// per moved item vs VIEW::UpdateBBox(), each frame followed by a viewport query
+static void benchMove(size_t aCount, size_t aMoved)
+{
+	constexpr int EXTENT = 1000000000;
+	constexpr int FRAMES = 20;
+	constexpr int STEP = 20000;
+
+	std::vector<DATA_Rectangle> rectangles = makeRectangles(aCount);
+	std::vector<VIEW_ITEM*> items = itemPointers(rectangles);
+	const BOX2I viewport(VECTOR2I(EXTENT / 4, EXTENT / 4), VECTOR2I(EXTENT / 2, EXTENT / 2));
+
+	std::mt19937 gen(4321);
+	std::uniform_int_distribution<size_t> distItem(0, aCount - 1);
+	std::vector<size_t> moved(aCount < aMoved ? aCount : aMoved);
+
+	auto run = [&](bool aUpdateInPlace, size_t& aHits) {
+		VIEW view;
+		view.AddItems(items);
+		gen.seed(4321);
+
+		PROF_TIMER timer;
+
+		for (int frame = 0; frame < FRAMES; ++frame) {
+			// Move the same selection a bit further every frame, like a drag does
+			if (frame % 5 == 0) {
+				for (size_t& index : moved)
+					index = distItem(gen);
+			}
+
+			for (size_t index : moved) {
+				DATA_Rectangle& rect = rectangles[index];
+
+				if (!aUpdateInPlace)
+					view.Remove(&rect);
+
+				rect.m_startPoint.x += STEP;
+				rect.m_endPoint.x += STEP;
+
+				if (aUpdateInPlace)
+					view.UpdateBBox(&rect);
+				else
+					view.Add(&rect);
+			}
+
+			aHits = 0;
+			view.Query(viewport, [&](VIEW_ITEM*) { aHits++; return true; });
+		}
+
+		timer.Stop();
+		view.Clear();
+
+		return timer.msecs() / FRAMES;
+	};
+
+	// Both runs start from the same positions; the item addresses stay the same
+	const std::vector<DATA_Rectangle> original = rectangles;
+	size_t removeAddHits = 0, updateHits = 0;
+	const double removeAddMs = run(false, removeAddHits);
+	std::copy(original.begin(), original.end(), rectangles.begin());
+	const double updateMs = run(true, updateHits);
+
+	if (removeAddHits != updateHits)
+		printf("move: result mismatch (%zu vs %zu)\n", removeAddHits, updateHits);
+
+	printf("move %zu of %zu items per frame: Remove()+Add() %8.1f ms, UpdateBBox() %8.1f ms per frame, "
+		"speedup %.1fx\n",
+		moved.size(), aCount, removeAddMs, updateMs, removeAddMs / updateMs);
+}
+
+// GAL drawing nothing, so the redraw benchmark measures the VIEW side of a frame only
+class NULL_GAL : public GAL
+{
+public:
+	NULL_GAL(GAL_DISPLAY_OPTIONS& aOptions) : GAL(aOptions) {}
+
+	bool ScrollTargets(const VECTOR2I& aDelta) override { return true; }
+};
+
+class COUNTING_PAINTER : public PAINTER
+{
+public:
+	COUNTING_PAINTER(GAL* aGal) : PAINTER(aGal), m_draws(0), m_aggregates(0) {}
+
+	RENDER_SETTINGS* GetSettings() override { return nullptr; }
+
+	bool Draw(const VIEW_ITEM* aItem, int aLayer) override
+	{
+		m_draws++;
+		return true;
+	}
+
+	void DrawAggregate(const BOX2D& aArea, double aCoverage, int aLayer) override
+	{
+		m_aggregates++;
+	}
+
+	size_t m_draws;
+	size_t m_aggregates;
+};
+
+// Show the whole board on a full HD screen
+static void setupView(VIEW& aView, GAL& aGal, PAINTER& aPainter, int aExtent)
+{
+	aGal.SetScreenSize(VECTOR2I(1920, 1080));
+	aView.SetGAL(&aGal);
+	aView.SetPainter(&aPainter);
+	aView.SetScaleLimits(1e9, 1e-9);
+	aView.SetViewport(BOX2D(VECTOR2D(0, 0), VECTOR2D(aExtent, aExtent)));
+
+	for (int i = 0; i < VIEW::VIEW_MAX_LAYERS; i++)
+		aView.SetLayerTarget(i, TARGET_NONCACHED);
+}
+
+// One item is dragged per frame on a board shown whole, then the view is redrawn: full
+// viewport repaint vs repaint of the damaged area only
+static void benchRedraw(size_t aCount)
+{
+	constexpr int EXTENT = 1000000000;
+	constexpr int FRAMES = 50;
+	constexpr int STEP = 20000;
+
+	std::vector<DATA_Rectangle> rectangles = makeRectangles(aCount);
+	std::vector<VIEW_ITEM*> items = itemPointers(rectangles);
+	const std::vector<DATA_Rectangle> original = rectangles;
+
+	auto run = [&](bool aDamageRedraw, size_t& aDraws) {
+		GAL_DISPLAY_OPTIONS options;
+		NULL_GAL gal(options);
+		COUNTING_PAINTER painter(&gal);
+		VIEW view;
+
+		setupView(view, gal, painter, EXTENT);
+		view.UseDamageRedraw(aDamageRedraw);
+
+		std::copy(original.begin(), original.end(), rectangles.begin());
+		view.AddItems(items);
+		view.Redraw();
+
+		std::mt19937 gen(4321);
+		std::uniform_int_distribution<size_t> distItem(0, aCount - 1);
+		double cullMs = 0.0, submitMs = 0.0;
+
+		painter.m_draws = 0;
+		PROF_TIMER timer;
+
+		for (int frame = 0; frame < FRAMES; ++frame) {
+			DATA_Rectangle& rect = rectangles[distItem(gen)];
+
+			rect.m_startPoint.x += STEP;
+			rect.m_endPoint.x += STEP;
+			view.UpdateBBox(&rect);
+			view.Redraw();
+
+			cullMs += view.GetLastCullTime();
+			submitMs += view.GetLastSubmitTime();
+		}
+
+		timer.Stop();
+		view.Clear();
+
+		aDraws = painter.m_draws / FRAMES;
+		printf("redraw %-7s %zu items: %8.2f ms per frame (cull %8.2f ms, submit %8.2f ms), "
+			"%zu draws per frame\n",
+			aDamageRedraw ? "damage" : "full", aCount, timer.msecs() / FRAMES, cullMs / FRAMES,
+			submitMs / FRAMES, aDraws);
+
+		return timer.msecs() / FRAMES;
+	};
+
+	size_t fullDraws = 0, damageDraws = 0;
+	const double fullMs = run(false, fullDraws);
+	const double damageMs = run(true, damageDraws);
+
+	printf("redraw speedup %.1fx\n", fullMs / damageMs);
+}
+
+// Continuous panning over a board shown whole, like scrolling with the mouse wheel: full
+// redraw vs scrolling the previous frame and redrawing the uncovered strip only
+static void benchPan(size_t aCount)
+{
+	constexpr int EXTENT = 1000000000;
+	constexpr int FRAMES = 50;
+	constexpr double STEP = 24.0;       // pixels per frame
+
+	std::vector<DATA_Rectangle> rectangles = makeRectangles(aCount);
+	std::vector<VIEW_ITEM*> items = itemPointers(rectangles);
+
+	auto run = [&](bool aScrollBlit) {
+		GAL_DISPLAY_OPTIONS options;
+		NULL_GAL gal(options);
+		COUNTING_PAINTER painter(&gal);
+		VIEW view;
+
+		setupView(view, gal, painter, EXTENT);
+		view.UseScrollBlit(aScrollBlit);
+		view.AddItems(items);
+		view.Redraw();
+
+		double cullMs = 0.0, submitMs = 0.0;
+
+		painter.m_draws = 0;
+		PROF_TIMER timer;
+
+		for (int frame = 0; frame < FRAMES; ++frame) {
+			// Alternate the direction, so the view stays over the board
+			const double step = (frame / 10) % 2 ? -STEP : STEP;
+
+			view.SetCenter(view.GetCenter() + view.ToWorld(VECTOR2D(step / 2, step), false));
+			view.Redraw();
+
+			cullMs += view.GetLastCullTime();
+			submitMs += view.GetLastSubmitTime();
+		}
+
+		timer.Stop();
+		view.Clear();
+
+		printf("pan %-7s %zu items: %8.2f ms per frame (cull %8.2f ms, submit %8.2f ms), "
+			"%zu draws per frame\n",
+			aScrollBlit ? "scroll" : "full", aCount, timer.msecs() / FRAMES, cullMs / FRAMES,
+			submitMs / FRAMES, painter.m_draws / FRAMES);
+
+		return timer.msecs() / FRAMES;
+	};
+
+	const double fullMs = run(false);
+	const double scrollMs = run(true);
+
+	printf("pan speedup %.1fx\n", fullMs / scrollMs);
+}
+
+// The whole board is redrawn at full zoom out: every item drawn vs small items aggregated
+// into one quad per couple of pixels
+static void benchLod(size_t aCount)
+{
+	constexpr int EXTENT = 1000000000;
+	constexpr int FRAMES = 20;
+
+	std::vector<DATA_Rectangle> rectangles = makeRectangles(aCount);
+	std::vector<VIEW_ITEM*> items = itemPointers(rectangles);
+
+	auto run = [&](double aThreshold) {
+		GAL_DISPLAY_OPTIONS options;
+		NULL_GAL gal(options);
+		COUNTING_PAINTER painter(&gal);
+		VIEW view;
+
+		setupView(view, gal, painter, EXTENT);
+		view.SetAggregateThreshold(aThreshold);
+		view.AddItems(items);
+
+		// The first frame fills the aggregate caches
+		PROF_TIMER firstTimer;
+		view.Redraw();
+		firstTimer.Stop();
+
+		painter.m_draws = 0;
+		painter.m_aggregates = 0;
+		PROF_TIMER timer;
+
+		for (int frame = 0; frame < FRAMES; ++frame) {
+			view.MarkDirty();
+			view.Redraw();
+		}
+
+		timer.Stop();
+
+		const size_t draws = painter.m_draws / FRAMES;
+		const size_t aggregates = painter.m_aggregates / FRAMES;
+
+		// Dragging an item only refills the cells it leaves and enters
+		std::mt19937 gen(4321);
+		std::uniform_int_distribution<size_t> distItem(0, aCount - 1);
+
+		view.UseDamageRedraw(true);
+		PROF_TIMER dragTimer;
+
+		for (int frame = 0; frame < FRAMES; ++frame) {
+			DATA_Rectangle& rect = rectangles[distItem(gen)];
+
+			rect.m_startPoint.x += 20000000;
+			rect.m_endPoint.x += 20000000;
+			view.UpdateBBox(&rect);
+			view.Redraw();
+		}
+
+		dragTimer.Stop();
+		view.Clear();
+
+		printf("lod %-10s %zu items: first frame %8.2f ms, %8.2f ms per frame, "
+			"%zu items + %zu aggregates drawn per frame, drag %6.2f ms per frame\n",
+			aThreshold > 0.0 ? "aggregated" : "off", aCount, firstTimer.msecs(),
+			timer.msecs() / FRAMES, draws, aggregates, dragTimer.msecs() / FRAMES);
+
+		return timer.msecs() / FRAMES;
+	};
+
+	const std::vector<DATA_Rectangle> original = rectangles;
+	const double offMs = run(0.0);
+	std::copy(original.begin(), original.end(), rectangles.begin());
+	const double lodMs = run(2.0);
+
+	printf("lod speedup %.1fx\n", offMs / lodMs);
+}
+
+// Draw priority ordering of the items culled on a board shown whole. First the sorts alone:
+// a comparison sort reading the priority through each item's separately allocated data (like
+// VIEW_ITEM_DATA) vs a radix sort of priority/item pairs gathered during the cull. Then whole
+// VIEW redraws with and without draw priority.
+static void benchPriority(size_t aCount)
+{
+	constexpr int EXTENT = 1000000000;
+	constexpr int FRAMES = 10;
+
+	struct PRIORITY_DATA
+	{
+		int priority;
+	};
+
+	struct ITEM
+	{
+		std::unique_ptr<PRIORITY_DATA> data;
+	};
+
+	std::mt19937 gen(2468);
+	std::vector<ITEM> sortItems(aCount);
+
+	for (size_t i = 0; i < aCount; ++i)
+		sortItems[i].data = std::make_unique<PRIORITY_DATA>(PRIORITY_DATA{ static_cast<int>(i) });
+
+	// Items come out of the index in spatial order, unrelated to the order they were added in
+	std::vector<ITEM*> culled;
+
+	for (ITEM& item : sortItems)
+		culled.push_back(&item);
+
+	std::shuffle(culled.begin(), culled.end(), gen);
+
+	std::vector<ITEM*> compareSorted = culled;
+	PROF_TIMER compareTimer;
+	std::sort(compareSorted.begin(), compareSorted.end(), [](ITEM* a, ITEM* b) {
+		return a->data->priority < b->data->priority;
+	});
+	compareTimer.Stop();
+
+	std::vector<std::pair<uint32_t, ITEM*>> keys, scratch;
+	std::vector<ITEM*> radixSorted;
+	PROF_TIMER radixTimer;
+
+	keys.reserve(culled.size());
+
+	for (ITEM* item : culled)
+		keys.emplace_back(static_cast<uint32_t>(item->data->priority) ^ 0x80000000u, item);
+
+	alg::radix_sort_by_key(keys, scratch);
+	radixSorted.reserve(keys.size());
+
+	for (const auto& [key, item] : keys)
+		radixSorted.push_back(item);
+
+	radixTimer.Stop();
+
+	if (radixSorted != compareSorted)
+		printf("priority: result mismatch\n");
+
+	printf("priority sort %zu items: std::sort %8.2f ms, gather + radix sort %8.2f ms, speedup %.1fx\n",
+		aCount, compareTimer.msecs(), radixTimer.msecs(), compareTimer.msecs() / radixTimer.msecs());
+
+	std::vector<DATA_Rectangle> rectangles = makeRectangles(aCount);
+	std::vector<VIEW_ITEM*> items = itemPointers(rectangles);
+
+	auto run = [&](bool aDrawPriority) {
+		GAL_DISPLAY_OPTIONS options;
+		NULL_GAL gal(options);
+		COUNTING_PAINTER painter(&gal);
+		VIEW view;
+
+		setupView(view, gal, painter, EXTENT);
+		view.UseDrawPriority(aDrawPriority);
+		view.AddItems(items);
+		view.Redraw();
+
+		double cullMs = 0.0;
+
+		for (int frame = 0; frame < FRAMES; ++frame) {
+			view.MarkDirty();
+			view.Redraw();
+			cullMs += view.GetLastCullTime();
+		}
+
+		view.Clear();
+
+		printf("priority %-3s %zu items: cull %8.2f ms per frame\n", aDrawPriority ? "on" : "off",
+			aCount, cullMs / FRAMES);
+	};
+
+	run(false);
+	run(true);
+}
+
+// Board items on 1 to 6 layers, like tracks, SMD pads and through-hole pads
+class LAYERED_RECTANGLE : public DATA_Rectangle
+{
+public:
+	LAYERED_RECTANGLE(const DATA_Rectangle& aRect, int aLayerCount) :
+		DATA_Rectangle(aRect), m_layerCount(aLayerCount) {}
+
+	std::vector<int> ViewGetLayers() const override
+	{
+		std::vector<int> layers(m_layerCount);
+		std::iota(layers.begin(), layers.end(), 0);
+		return layers;
+	}
+
+	int m_layerCount;
+};
+
+// Synthetic board: 70% of the items on one layer, 20% on three and 10% on six
+static std::vector<LAYERED_RECTANGLE> makeLayeredRectangles(size_t aCount)
+{
+	std::vector<DATA_Rectangle> plain = makeRectangles(aCount);
+	std::vector<LAYERED_RECTANGLE> rectangles;
+	rectangles.reserve(aCount);
+
+	for (size_t i = 0; i < aCount; ++i)
+		rectangles.emplace_back(plain[i], i % 10 < 7 ? 1 : i % 10 < 9 ? 3 : 6);
+
+	return rectangles;
+}
+
+static double residentMb()
+{
+	long pages = 0;
+
+	if (FILE* f = fopen("/proc/self/statm", "r")) {
+		if (fscanf(f, "%*ld %ld", &pages) != 1)
+			pages = 0;
+
+		fclose(f);
+	}
+
+	return pages * (sysconf(_SC_PAGESIZE) / 1048576.0);
+}
+
+// Memory held by the VIEW for its items (VIEW_ITEM_DATA, cached group ids and indexes), and
+// the time to add, cache and clear them
+static void benchMemory(size_t aCount)
+{
+	std::vector<LAYERED_RECTANGLE> rectangles = makeLayeredRectangles(aCount);
+	std::vector<VIEW_ITEM*> items;
+	items.reserve(aCount);
+
+	for (LAYERED_RECTANGLE& rect : rectangles)
+		items.push_back(&rect);
+
+	GAL_DISPLAY_OPTIONS options;
+	NULL_GAL gal(options);
+	COUNTING_PAINTER painter(&gal);
+	VIEW view;
+
+	view.SetGAL(&gal);
+	view.SetPainter(&painter);
+
+	// AddItems() first, while the RSS growth is not hidden by memory freed by a previous pass
+	for (bool bulk : { true, false }) {
+		const double baseMb = residentMb();
+		PROF_TIMER addTimer;
+
+		if (bulk)
+			view.AddItems(items);
+		else {
+			for (VIEW_ITEM* item : items)
+				view.Add(item);
+		}
+
+		addTimer.Stop();
+		PROF_TIMER cacheTimer;
+		view.UpdateItems();
+		cacheTimer.Stop();
+
+		const double viewMb = residentMb() - baseMb;
+		PROF_TIMER clearTimer;
+		view.Clear();
+		clearTimer.Stop();
+
+		printf("memory %zu items: RSS +%7.1f MB, %-10s %8.1f ms, UpdateItems() %8.1f ms, "
+			"Clear() %8.1f ms\n", aCount, viewMb, bulk ? "AddItems()" : "Add()",
+			addTimer.msecs(), cacheTimer.msecs(), clearTimer.msecs());
+	}
+}
+
+// Board-wide edit: every item moves, so VIEW::UpdateItems() rebuilds the layer indexes from
+// scratch instead of updating the items one by one
+static void benchRebuild(size_t aCount)
+{
+	constexpr int EXTENT = 1000000000;
+	constexpr int FRAMES = 5;
+	constexpr int STEP = 20000;
+
+	std::vector<LAYERED_RECTANGLE> rectangles = makeLayeredRectangles(aCount);
+	std::vector<VIEW_ITEM*> items;
+	items.reserve(aCount);
+
+	for (LAYERED_RECTANGLE& rect : rectangles)
+		items.push_back(&rect);
+
+	GAL_DISPLAY_OPTIONS options;
+	NULL_GAL gal(options);
+	COUNTING_PAINTER painter(&gal);
+	VIEW view;
+
+	setupView(view, gal, painter, EXTENT);
+	view.AddItems(items);
+	view.UpdateItems();
+
+	const BOX2I viewport(VECTOR2I(EXTENT / 4, EXTENT / 4), VECTOR2I(EXTENT / 2, EXTENT / 2));
+	double updateMs = 0.0;
+	size_t hits = 0;
+
+	for (int frame = 0; frame < FRAMES; ++frame) {
+		for (LAYERED_RECTANGLE& rect : rectangles) {
+			rect.m_startPoint.x += STEP;
+			rect.m_endPoint.x += STEP;
+			view.Update(&rect, GEOMETRY);
+		}
+
+		PROF_TIMER timer;
+		view.UpdateItems();
+		timer.Stop();
+		updateMs += timer.msecs();
+	}
+
+	view.Query(viewport, [&](VIEW_ITEM*) { hits++; return true; });
+	view.Clear();
+
+	printf("rebuild %zu items: UpdateItems() %8.1f ms, %zu items in viewport\n", aCount,
+		updateMs / FRAMES, hits);
+}
+
+// Progressive load: a loader thread queues the items in batches (and then removes every tenth
+// one) while frames keep being drawn, each frame applying a bounded number of queued items. Vs
+// a single AddItems() blocking the first frame.
+static void benchIngest(size_t aCount)
+{
+	constexpr int EXTENT = 1000000000;
+	constexpr size_t BATCH = 10000;
+	constexpr size_t ITEMS_PER_FRAME = 50000;
+
+	std::vector<DATA_Rectangle> rectangles = makeRectangles(aCount);
+	std::vector<VIEW_ITEM*> items = itemPointers(rectangles);
+	GAL_DISPLAY_OPTIONS options;
+	NULL_GAL gal(options);
+	COUNTING_PAINTER painter(&gal);
+	double blockingMs;
+
+	{
+		VIEW view;
+		setupView(view, gal, painter, EXTENT);
+
+		PROF_TIMER timer;
+		view.AddItems(items);
+		view.Redraw();
+		timer.Stop();
+		blockingMs = timer.msecs();
+		view.Clear();
+	}
+
+	VIEW view;
+	setupView(view, gal, painter, EXTENT);
+
+	std::atomic<bool> loaded(false);
+	std::atomic<size_t> disposed(0);
+
+	PROF_TIMER totalTimer;
+
+	std::thread loader([&]() {
+		for (size_t i = 0; i < aCount; i += BATCH) {
+			const size_t end = std::min(aCount, i + BATCH);
+			view.QueueAdd(std::vector<VIEW_ITEM*>(items.begin() + i, items.begin() + end));
+		}
+
+		std::vector<VIEW_ITEM*> removed;
+
+		for (size_t i = 0; i < aCount; i += 10)
+			removed.push_back(items[i]);
+
+		view.QueueRemove(std::move(removed), [&](VIEW_ITEM*) { disposed++; });
+		loaded = true;
+	});
+
+	size_t frames = 0;
+	double maxFrameMs = 0.0;
+
+	while (true) {
+		const bool done = loaded;
+		PROF_TIMER frameTimer;
+		const bool pending = view.ApplyQueuedChanges(ITEMS_PER_FRAME);
+		view.Redraw();
+		frameTimer.Stop();
+
+		frames++;
+		maxFrameMs = std::max(maxFrameMs, frameTimer.msecs());
+
+		if (done && !pending)
+			break;
+	}
+
+	totalTimer.Stop();
+	loader.join();
+
+	size_t hits = 0;
+	view.Query(BOX2I(VECTOR2I(0, 0), VECTOR2I(EXTENT, EXTENT)), [&](VIEW_ITEM*) { hits++; return true; });
+	view.Clear();
+
+	printf("ingest %zu items: AddItems() + first frame %8.1f ms; queued: %zu frames, "
+		"%6.1f ms max per frame, %8.1f ms total, %zu items in view, %zu disposed\n", aCount,
+		blockingMs, frames, maxFrameMs, totalTimer.msecs(), hits, disposed.load());
+}
+
+// Item distributions for the index benchmark
+// Picking under the cursor: VIEW::HitTest() with a few pixels of tolerance and VIEW::Nearest()
+// for hover/snap, at random points of a board of diagonal lines. The bbox Query() of the same
+// area shows how many candidates the exact shape test rejects.
+static void benchPick(size_t aCount)
+{
+	constexpr int EXTENT = 1000000000;
+	constexpr int MAX_SIZE = 200000;
+	constexpr int TOLERANCE = 20000;
+	constexpr int PICKS = 10000;
+
+	std::mt19937 gen(12345);
+	std::uniform_int_distribution<int> distPos(0, EXTENT - MAX_SIZE);
+	std::uniform_int_distribution<int> distSize(1000, MAX_SIZE);
+
+	std::vector<DATA_Line> lines;
+	lines.reserve(aCount);
+
+	for (size_t i = 0; i < aCount; ++i) {
+		VECTOR2I start(distPos(gen), distPos(gen));
+		lines.emplace_back(start, start + VECTOR2I(distSize(gen), distSize(gen)));
+	}
+
+	std::vector<VIEW_ITEM*> items;
+	items.reserve(aCount);
+
+	for (DATA_Line& line : lines)
+		items.push_back(&line);
+
+	VIEW view;
+	view.AddItems(items);
+
+	std::vector<VECTOR2D> points;
+
+	for (int i = 0; i < PICKS; ++i)
+		points.emplace_back(distPos(gen), distPos(gen));
+
+	std::vector<VIEW::LAYER_ITEM_PAIR> hits;
+	std::vector<VIEW::ITEM_DISTANCE_PAIR> nearest;
+	size_t candidates = 0, hitCount = 0;
+
+	PROF_TIMER queryTimer;
+
+	for (const VECTOR2D& point : points) {
+		hits.clear();
+		candidates += view.Query(BOX2D(point - VECTOR2D(TOLERANCE, TOLERANCE),
+			VECTOR2D(2 * TOLERANCE, 2 * TOLERANCE)), hits);
+	}
+
+	queryTimer.Stop();
+
+	PROF_TIMER hitTimer;
+
+	for (const VECTOR2D& point : points) {
+		hits.clear();
+		hitCount += view.HitTest(point, TOLERANCE, hits);
+	}
+
+	hitTimer.Stop();
+
+	printf("pick %zu items: bbox Query() %7.2f us (%zu candidates), HitTest() %7.2f us (%zu hits)\n",
+		aCount, queryTimer.msecs() * 1000.0 / PICKS, candidates, hitTimer.msecs() * 1000.0 / PICKS,
+		hitCount);
+
+	for (int k : { 1, 10 }) {
+		double sum = 0.0;
+		PROF_TIMER nearestTimer;
+
+		for (const VECTOR2D& point : points) {
+			nearest.clear();
+			view.Nearest(point, k, nearest);
+			sum += nearest.back().second;
+		}
+
+		nearestTimer.Stop();
+
+		// Check against a scan of all items for the first points
+		for (int i = 0; i < 3; ++i) {
+			double best = std::numeric_limits<double>::max();
+
+			for (const DATA_Line& line : lines)
+				best = std::min(best, line.ViewHitDistance(points[i]));
+
+			nearest.clear();
+			view.Nearest(points[i], k, nearest);
+
+			if (nearest.front().second != best)
+				printf("pick: Nearest() mismatch\n");
+		}
+
+		printf("pick %zu items: Nearest(k=%d) %7.2f us, mean distance %.0f\n", aCount, k,
+			nearestTimer.msecs() * 1000.0 / PICKS, sum / PICKS);
+	}
+
+	view.Clear();
+}
+
+// Lasso selection of about half of the board, fully inside and touching: VIEW::Query() of the
+// lasso bbox plus an exact test of every candidate on the caller thread, vs VIEW::Select()
+static void benchSelect(size_t aCount)
+{
+	constexpr int EXTENT = 1000000000;
+	constexpr int POINTS = 200;
+
+	std::vector<DATA_Rectangle> rectangles = makeRectangles(aCount);
+	std::vector<VIEW_ITEM*> items = itemPointers(rectangles);
+
+	VIEW view;
+	view.AddItems(items);
+
+	// Wobbly circle around the board center
+	SHAPE_LINE_CHAIN lasso;
+
+	for (int i = 0; i < POINTS; ++i) {
+		const double angle = 2.0 * M_PI * i / POINTS;
+		const double radius = EXTENT * (0.38 + 0.04 * std::sin(7.0 * angle));
+		lasso.Append(VECTOR2I(EXTENT / 2 + radius * std::cos(angle), EXTENT / 2 + radius * std::sin(angle)));
+	}
+
+	lasso.SetClosed(true);
+
+	for (bool contained : { true, false }) {
+		std::vector<VIEW::LAYER_ITEM_PAIR> candidates, selected;
+		size_t naiveCount = 0;
+
+		PROF_TIMER naiveTimer;
+		const BOX2I bbox = lasso.BBox();
+		view.Query(BOX2D(bbox.GetOrigin(), bbox.GetSize()), candidates);
+
+		for (const VIEW::LAYER_ITEM_PAIR& candidate : candidates) {
+			if (candidate.first->ViewHitTest(lasso, contained))
+				naiveCount++;
+		}
+
+		naiveTimer.Stop();
+
+		PROF_TIMER selectTimer;
+		view.Select(lasso, contained, selected);
+		selectTimer.Stop();
+
+		if (selected.size() != naiveCount)
+			printf("select: result mismatch %zu vs %zu\n", selected.size(), naiveCount);
+
+		printf("select %zu items, %s: Query() + tests %8.1f ms, Select() %8.1f ms, %zu selected\n",
+			aCount, contained ? "inside" : "touching", naiveTimer.msecs(), selectTimer.msecs(),
+			selected.size());
+	}
+
+	view.Clear();
+}
+
+// Cursor snapping on a board shown whole: VIEW::GetSnapAnchor() per cursor position,
+// and the cost of keeping the snap index up to date while items are dragged
+static void benchSnap(size_t aCount)
+{
+	constexpr int EXTENT = 1000000000;
+	constexpr int MAX_SIZE = 200000;
+	constexpr int CURSORS = 10000;
+	constexpr int MOVED = 10000;
+	constexpr int STEP = 20000;
+	constexpr double SNAP_PIXELS = 8.0;
+
+	std::vector<DATA_Rectangle> rectangles = makeRectangles(aCount);
+	std::vector<VIEW_ITEM*> items = itemPointers(rectangles);
+
+	GAL_DISPLAY_OPTIONS options;
+	NULL_GAL gal(options);
+	COUNTING_PAINTER painter(&gal);
+	VIEW view;
+	setupView(view, gal, painter, EXTENT);
+	view.AddItems(items);
+
+	PROF_TIMER enableTimer;
+	view.EnableSnapIndex(true);
+	enableTimer.Stop();
+
+	// Cursors near item corners, so that most of them snap at a closer zoom
+	std::mt19937 gen(12345);
+	std::uniform_int_distribution<size_t> distItem(0, aCount - 1);
+	std::uniform_int_distribution<int> distJitter(-MAX_SIZE / 4, MAX_SIZE / 4);
+	std::vector<VECTOR2D> cursors;
+
+	for (int i = 0; i < CURSORS; ++i) {
+		const DATA_Rectangle& rect = rectangles[distItem(gen)];
+		cursors.emplace_back(rect.m_startPoint.x + distJitter(gen), rect.m_startPoint.y + distJitter(gen));
+	}
+
+	for (double scale : { view.GetScale(), view.GetScale() * 1000.0 }) {
+		view.SetScale(scale);
+
+		size_t snapped = 0, intersections = 0;
+		PROF_TIMER snapTimer;
+
+		for (const VECTOR2D& cursor : cursors) {
+			if (std::optional<VIEW_ANCHOR> anchor = view.GetSnapAnchor(cursor, SNAP_PIXELS)) {
+				snapped++;
+				intersections += anchor->type == VIEW_ANCHOR_TYPE::INTERSECTION;
+			}
+		}
+
+		snapTimer.Stop();
+
+		printf("snap %zu items, %.0f nm/pixel: GetSnapAnchor() %6.2f us, %zu snapped (%zu intersections)\n",
+			aCount, view.ToWorld(1.0), snapTimer.msecs() * 1000.0 / CURSORS, snapped, intersections);
+	}
+
+	// Drag: UpdateBBox() of moved items with and without the snap index
+	for (bool enabled : { false, true }) {
+		view.EnableSnapIndex(enabled);
+
+		PROF_TIMER moveTimer;
+
+		for (int i = 0; i < MOVED; ++i) {
+			DATA_Rectangle& rect = rectangles[distItem(gen)];
+			rect.m_startPoint.x += STEP;
+			rect.m_endPoint.x += STEP;
+			view.UpdateBBox(&rect);
+		}
+
+		moveTimer.Stop();
+
+		printf("snap %zu items: EnableSnapIndex() %8.1f ms, UpdateBBox() %s snap index %6.2f us\n",
+			aCount, enableTimer.msecs(), enabled ? "with" : "without", moveTimer.msecs() * 1000.0 / MOVED);
+	}
+
+	view.Clear();
+}
+
+// Painter reading the geometry of the items it is given, like a real painter does
+class GEOMETRY_PAINTER : public COUNTING_PAINTER
+{
+public:
+	GEOMETRY_PAINTER(GAL* aGal) : COUNTING_PAINTER(aGal), m_sum(0.0) {}
+
+	bool Draw(const VIEW_ITEM* aItem, int aLayer) override
+	{
+		const DATA_Rectangle* rect = static_cast<const DATA_Rectangle*>(aItem);
+
+		m_sum += rect->m_startPoint.x + rect->m_endPoint.y;
+		return COUNTING_PAINTER::Draw(aItem, aLayer);
+	}
+
+	double m_sum;
+};
+
+// Items in random order in memory vs sorted along a Hilbert curve: VIEW_ITEM_DATA only
+// (VIEW::SortItemsSpatially()), and the items as well (DataManager::SortSpatially()).
+// Redraw of the whole board and of zoomed in windows, and UpdateItems() of all the items
+static void benchOrder(size_t aCount)
+{
+	constexpr int EXTENT = 1000000000;
+	constexpr int FRAMES = 10;
+	constexpr int WINDOWS = 200;
+
+	enum class ORDER { INSERTION, VIEW_DATA, STORAGE };
+
+	auto run = [&](ORDER aOrder) {
+		DataManager data;
+		data.m_rectangles = makeRectangles(aCount);
+
+		PROF_TIMER loadTimer;
+
+		if (aOrder == ORDER::STORAGE)
+			data.SortSpatially();
+
+		std::vector<VIEW_ITEM*> items = itemPointers(data.m_rectangles);
+
+		GAL_DISPLAY_OPTIONS options;
+		NULL_GAL gal(options);
+		GEOMETRY_PAINTER painter(&gal);
+		VIEW view;
+
+		setupView(view, gal, painter, EXTENT);
+
+		// Items added in random order, as a board edited for a while ends up
+		std::shuffle(items.begin(), items.end(), std::mt19937(4321));
+		view.AddItems(items);
+
+		if (aOrder != ORDER::INSERTION)
+			view.SortItemsSpatially();
+
+		loadTimer.Stop();
+		view.Redraw();
+
+		PROF_TIMER fullTimer;
+
+		for (int frame = 0; frame < FRAMES; ++frame) {
+			view.MarkDirty();
+			view.Redraw();
+		}
+
+		fullTimer.Stop();
+
+		std::mt19937 gen(12345);
+		std::uniform_int_distribution<int> distPos(EXTENT / 64, EXTENT - EXTENT / 64);
+		view.SetScale(view.GetScale() * 32.0);
+
+		PROF_TIMER windowTimer;
+
+		for (int frame = 0; frame < WINDOWS; ++frame) {
+			view.SetCenter(VECTOR2D(distPos(gen), distPos(gen)));
+			view.Redraw();
+		}
+
+		windowTimer.Stop();
+
+		PROF_TIMER updateTimer;
+
+		for (int frame = 0; frame < FRAMES; ++frame) {
+			view.UpdateAllItems(REPAINT);
+			view.UpdateItems();
+		}
+
+		updateTimer.Stop();
+		view.Clear();
+
+		const char* names[] = { "insertion", "view data", "storage" };
+
+		printf("order %-9s %zu items: load %7.1f ms, full redraw %7.2f ms, window redraw %6.3f ms, "
+			"UpdateItems() %6.2f ms\n",
+			names[static_cast<int>(aOrder)], aCount, loadTimer.msecs(), fullTimer.msecs() / FRAMES,
+			windowTimer.msecs() / WINDOWS, updateTimer.msecs() / FRAMES);
+	};
+
+	run(ORDER::INSERTION);
+	run(ORDER::VIEW_DATA);
+	run(ORDER::STORAGE);
+}
+
+// Opening a design: AddItems() vs LoadIndexSnapshot() of a snapshot saved by the first view,
+// with the query results of both checked against a scan of all the items
+static void benchSnapshot(size_t aCount)
+{
+	constexpr int EXTENT = 1000000000;
+	constexpr int QUERIES = 1000;
+
+	const std::string path = (std::filesystem::temp_directory_path() / "benchview.vidx").string();
+
+	DataManager data;
+	data.m_rectangles = makeRectangles(aCount);
+	std::vector<VIEW_ITEM*> items = itemPointers(data.m_rectangles);
+
+	PROF_TIMER hashTimer;
+	const HASH_128 hash = data.GetContentHash();
+	hashTimer.Stop();
+
+	std::mt19937 gen(99);
+	std::uniform_int_distribution<int> distPos(0, EXTENT - EXTENT / 100);
+	std::vector<BOX2D> windows;
+
+	for (int i = 0; i < QUERIES; ++i)
+		windows.emplace_back(VECTOR2D(distPos(gen), distPos(gen)), VECTOR2D(EXTENT / 100, EXTENT / 100));
+
+	std::vector<size_t> expected;
+
+	for (const BOX2D& window : windows) {
+		size_t hits = 0;
+
+		for (const DATA_Rectangle& rect : data.m_rectangles)
+			hits += window.Intersects(rect.GetBoundingBoxD());
+
+		expected.push_back(hits);
+	}
+
+	auto queries = [&](VIEW& aView, const char* aName) {
+		std::vector<VIEW::LAYER_ITEM_PAIR> hits;
+		size_t mismatches = 0;
+		PROF_TIMER queryTimer;
+
+		for (size_t i = 0; i < windows.size(); ++i) {
+			hits.clear();
+			mismatches += aView.Query(windows[i], hits) != static_cast<int>(expected[i]);
+		}
+
+		queryTimer.Stop();
+
+		printf("snapshot %zu items: %-8s Query() %7.2f us%s\n", aCount, aName,
+			queryTimer.msecs() * 1000.0 / QUERIES, mismatches ? ", RESULT MISMATCH" : "");
+	};
+
+	{
+		VIEW view;
+		PROF_TIMER addTimer;
+		view.AddItems(items);
+		addTimer.Stop();
+
+		PROF_TIMER saveTimer;
+		const bool saved = view.SaveIndexSnapshot(path, items, hash);
+		saveTimer.Stop();
+
+		printf("snapshot %zu items: GetContentHash() %7.1f ms, AddItems() %7.1f ms, "
+			"SaveIndexSnapshot() %7.1f ms%s, %.1f MB\n",
+			aCount, hashTimer.msecs(), addTimer.msecs(), saveTimer.msecs(), saved ? "" : " FAILED",
+			std::filesystem::file_size(path) / 1e6);
+
+		queries(view, "rtree");
+		view.Clear();
+	}
+
+	{
+		VIEW view;
+		PROF_TIMER loadTimer;
+		const bool loaded = view.LoadIndexSnapshot(path, items, hash);
+		loadTimer.Stop();
+
+		printf("snapshot %zu items: LoadIndexSnapshot() %7.1f ms%s\n", aCount, loadTimer.msecs(),
+			loaded ? "" : " (NOT USED)");
+
+		queries(view, "packed");
+		view.Clear();
+	}
+
+	// A stale snapshot falls back to AddItems()
+	HASH_128 otherHash = hash;
+	otherHash.Value64[0]++;
+
+	{
+		VIEW view;
+		PROF_TIMER loadTimer;
+		const bool loaded = view.LoadIndexSnapshot(path, items, otherHash);
+		loadTimer.Stop();
+
+		printf("snapshot %zu items: LoadIndexSnapshot(stale) %7.1f ms%s\n", aCount, loadTimer.msecs(),
+			loaded ? " (USED)" : ", rebuilt");
+		view.Clear();
+	}
+
+	std::filesystem::remove(path);
+}
+
+// Cached board of circles and segments generated the way OPENGL_GAL caches them: memory taken
+// by the vertices, and the time to generate them, recolor every item (e.g. a highlight) and
+// upload them
+static void benchVertex(size_t aCount)
+{
+	constexpr int EXTENT = 1000000000;
+
+	static int argc = 1;
+	static char name[] = "BenchView";
+	static char* argv[] = { name, nullptr };
+	QGuiApplication app(argc, argv);
+	QOffscreenSurface surface;
+	QOpenGLContext context;
+
+	surface.create();
+
+	if (!context.create() || !context.makeCurrent(&surface)) {
+		printf("vertex %zu items: no OpenGL context, skipped\n", aCount);
+		return;
+	}
+
+	std::mt19937 gen(7);
+	std::uniform_real_distribution<float> distPos(0, EXTENT);
+	std::uniform_real_distribution<float> distSize(10000, 1000000);
+
+	{
+		VERTEX_MANAGER manager(true);
+		std::vector<std::unique_ptr<VERTEX_ITEM>> items;
+		size_t vertices = 0;
+
+		items.reserve(aCount);
+
+		PROF_TIMER fillTimer;
+		manager.Map();
+
+		for (size_t i = 0; i < aCount; ++i) {
+			const float x = distPos(gen);
+			const float y = distPos(gen);
+			const float size = distSize(gen);
+			const float depth = -static_cast<float>(i % 64);
+
+			items.push_back(std::make_unique<VERTEX_ITEM>(manager));
+			manager.Color(0.2f, 0.6f, 0.8f, 1.0f);
+
+			if (i % 2) {
+				manager.Reserve(3);
+
+				for (int v = 1; v <= 3; ++v) {
+					manager.Shader(SHADER_FILLED_CIRCLE, v, size);
+					manager.Vertex(x, y, depth);
+				}
+
+				vertices += 3;
+			}
+			else {
+				const SHADER_MODE modes[] = { SHADER_LINE_A, SHADER_LINE_B, SHADER_LINE_C,
+					SHADER_LINE_D, SHADER_LINE_E, SHADER_LINE_F };
+				const bool atEnd[] = { false, false, true, true, true, false };
+
+				manager.Reserve(6);
+
+				for (int v = 0; v < 6; ++v) {
+					manager.Shader(modes[v], size / 10, size, size / 2);
+					manager.Vertex(atEnd[v] ? x + size : x, atEnd[v] ? y + size / 2 : y, depth);
+				}
+
+				vertices += 6;
+			}
+
+			manager.FinishItem();
+		}
+
+		fillTimer.Stop();
+		PROF_TIMER uploadTimer;
+		manager.Unmap();
+		uploadTimer.Stop();
+
+		PROF_TIMER colorTimer;
+		manager.Map();
+
+		for (const std::unique_ptr<VERTEX_ITEM>& item : items)
+			manager.ChangeItemColor(*item, COLOR4D(1.0, 1.0, 1.0, 0.5));
+
+		colorTimer.Stop();
+		PROF_TIMER reuploadTimer;
+		manager.Unmap();
+		reuploadTimer.Stop();
+
+		printf("vertex %zu items: %zu vertices x %zu B = %7.1f MB, generate %7.1f ms, "
+			"upload %7.1f ms, ChangeItemColor() %7.1f ms, upload %7.1f ms\n",
+			aCount, vertices, VERTEX_SIZE, vertices * VERTEX_SIZE / 1e6, fillTimer.msecs(),
+			uploadTimer.msecs(), colorTimer.msecs(), reuploadTimer.msecs());
+
+		items.clear();
+	}
+
+	context.doneCurrent();
+}
+
+// Circles, rectangles and lines drawn into a non-cached VERTEX_MANAGER one at a time, the way
+// OPENGL_GAL::DrawCircle() etc. add them, and with the batch functions used by
+// OPENGL_GAL::DrawCircles() etc., as vertices and as instances
+static void benchBatch(size_t aCount)
+{
+	constexpr int EXTENT = 1000000000;
+	constexpr int RUNS = 5;
+	const size_t perType = aCount / 3;
+	const GLfloat depth = -1.0f;
+	const GLfloat width = 20000.0f;
+
+	std::mt19937 gen(11);
+	std::uniform_real_distribution<double> distPos(0, EXTENT);
+	std::uniform_real_distribution<double> distSize(10000, 1000000);
+
+	std::vector<VECTOR2D> centers, corners, points;
+	std::vector<double> radii;
+
+	for (size_t i = 0; i < perType; ++i) {
+		const VECTOR2D pos(distPos(gen), distPos(gen));
+		const double size = distSize(gen);
+
+		centers.push_back(pos);
+		radii.push_back(size);
+		corners.push_back(pos);
+		corners.push_back(pos + VECTOR2D(size, size / 2));
+		points.push_back(pos);
+		points.push_back(pos + VECTOR2D(size / 2, size));
+	}
+
+	VERTEX_MANAGER manager(false);
+
+	auto perItem = [&](bool aInstances) {
+		for (size_t i = 0; i < perType; ++i) {
+			manager.Color(0.2f, 0.6f, 0.8f, 1.0f);
+
+			const GLfloat circle[4] = { (GLfloat) centers[i].x, (GLfloat) centers[i].y,
+				(GLfloat) radii[i], 0.0f };
+
+			if (!aInstances || !manager.Instance(SHADER_INSTANCED_CIRCLE, circle, 0.0f, depth)) {
+				manager.Reserve(3);
+
+				for (int v = 1; v <= 3; ++v) {
+					manager.Shader(SHADER_FILLED_CIRCLE, v, radii[i]);
+					manager.Vertex(centers[i].x, centers[i].y, depth);
+				}
+			}
+		}
+
+		for (size_t i = 0; i < perType; ++i) {
+			const VECTOR2D& a = corners[2 * i];
+			const VECTOR2D& b = corners[2 * i + 1];
+			const GLfloat rect[4] = { (GLfloat) a.x, (GLfloat) a.y, (GLfloat) b.x, (GLfloat) b.y };
+
+			manager.Color(0.2f, 0.6f, 0.8f, 1.0f);
+
+			if (!aInstances || !manager.Instance(SHADER_INSTANCED_RECT, rect, 0.0f, depth)) {
+				manager.Reserve(6);
+				manager.Shader(SHADER_NONE);
+				manager.Vertex(a.x, a.y, depth);
+				manager.Vertex(b.x, a.y, depth);
+				manager.Vertex(b.x, b.y, depth);
+				manager.Vertex(a.x, a.y, depth);
+				manager.Vertex(b.x, b.y, depth);
+				manager.Vertex(a.x, b.y, depth);
+			}
+		}
+
+		const SHADER_MODE modes[] = { SHADER_LINE_A, SHADER_LINE_B, SHADER_LINE_C, SHADER_LINE_D,
+			SHADER_LINE_E, SHADER_LINE_F };
+		const bool atEnd[] = { false, false, true, true, true, false };
+
+		for (size_t i = 0; i < perType; ++i) {
+			const VECTOR2D& a = points[2 * i];
+			const VECTOR2D& b = points[2 * i + 1];
+			const GLfloat line[4] = { (GLfloat) a.x, (GLfloat) a.y, (GLfloat) b.x, (GLfloat) b.y };
+			const VECTOR2D vs = b - a;
+
+			manager.Color(0.2f, 0.6f, 0.8f, 1.0f);
+
+			if (!aInstances || !manager.Instance(SHADER_INSTANCED_SEGMENT, line, width, depth)) {
+				manager.Reserve(6);
+
+				for (int v = 0; v < 6; ++v) {
+					manager.Shader(modes[v], width, vs.x, vs.y);
+					manager.Vertex(atEnd[v] ? b : a, depth);
+				}
+			}
+		}
+	};
+
+	auto batch = [&]() {
+		manager.Color(0.2f, 0.6f, 0.8f, 1.0f);
+		manager.Circles(SHADER_FILLED_CIRCLE, centers.data(), radii.data(), perType, 0.0f, depth);
+		manager.Rectangles(corners.data(), perType, depth);
+		manager.Lines(points.data(), perType, width, depth);
+	};
+
+	for (bool instances : { false, true }) {
+		manager.EnableInstancing(instances);
+
+		for (bool batched : { false, true }) {
+			double best = std::numeric_limits<double>::max();
+			size_t bytes = 0;
+
+			for (int run = 0; run < RUNS; ++run) {
+				manager.Clear();
+				PROF_TIMER timer;
+
+				if (batched)
+					batch();
+				else
+					perItem(instances);
+
+				timer.Stop();
+				best = std::min(best, timer.msecs());
+				bytes = manager.GetPendingDataSize();
+			}
+
+			printf("batch %zu primitives: %-9s %-8s %7.1f ms, %6.1f MB\n", perType * 3,
+				instances ? "instances" : "vertices", batched ? "batch" : "per item", best,
+				bytes / 1e6);
+		}
+	}
+
+	manager.Clear();
+}
+
+// Circles, rectangles and lines of a layer generated by the batch functions of a non-cached
+// VERTEX_MANAGER on 1 to 8 threads, as vertices and as instances. The output has to be the
+// same whatever the number of threads.
+static void benchThreads(size_t aCount)
+{
+	constexpr int EXTENT = 1000000000;
+	constexpr int RUNS = 5;
+	const size_t perType = aCount / 3;
+	const GLfloat depth = -1.0f;
+	const GLfloat width = 20000.0f;
+
+	std::mt19937 gen(13);
+	std::uniform_real_distribution<double> distPos(0, EXTENT);
+	std::uniform_real_distribution<double> distSize(10000, 1000000);
+
+	std::vector<VECTOR2D> centers, corners, points;
+	std::vector<double> radii;
+
+	for (size_t i = 0; i < perType; ++i) {
+		const VECTOR2D pos(distPos(gen), distPos(gen));
+		const double size = distSize(gen);
+
+		centers.push_back(pos);
+		radii.push_back(size);
+		corners.push_back(pos);
+		corners.push_back(pos + VECTOR2D(size, size / 2));
+		points.push_back(pos);
+		points.push_back(pos + VECTOR2D(size / 2, size));
+	}
+
+	// Gives access to the generated vertices and instances
+	struct OUTPUT_MANAGER : VERTEX_MANAGER {
+		OUTPUT_MANAGER() : VERTEX_MANAGER(false) { }
+
+		std::vector<char> Output() const {
+			const char* vertices = reinterpret_cast<const char*>(m_container->GetAllVertices());
+			std::vector<char> output(vertices, vertices + m_container->GetSize() * VERTEX_SIZE);
+
+			for (int type = SHADER_INSTANCED_CIRCLE; type <= SHADER_INSTANCED_SEGMENT; ++type) {
+				const std::vector<INSTANCE>& instances = m_instances->Get(SHADER_MODE(type));
+				const char* data = reinterpret_cast<const char*>(instances.data());
+
+				output.insert(output.end(), data, data + instances.size() * INSTANCE_SIZE);
+			}
+
+			return output;
+		}
+	};
+
+	OUTPUT_MANAGER manager;
+
+	for (bool instances : { false, true }) {
+		manager.EnableInstancing(instances);
+
+		std::vector<char> expected;
+		double single = 0.0;
+
+		for (unsigned int threads : { 1, 2, 4, 8 }) {
+			manager.SetGenerationThreads(threads);
+
+			double best = std::numeric_limits<double>::max();
+
+			for (int run = 0; run < RUNS; ++run) {
+				manager.Clear();
+				PROF_TIMER timer;
+
+				manager.Color(0.2f, 0.6f, 0.8f, 1.0f);
+				manager.Circles(SHADER_FILLED_CIRCLE, centers.data(), radii.data(), perType, 0.0f,
+					depth);
+				manager.Rectangles(corners.data(), perType, depth);
+				manager.Lines(points.data(), perType, width, depth);
+
+				timer.Stop();
+				best = std::min(best, timer.msecs());
+			}
+
+			if (threads == 1) {
+				expected = manager.Output();
+				single = best;
+			}
+
+			printf("threads %zu primitives: %-9s %u thread(s) %7.1f ms, speedup %4.2f%s\n",
+				perType * 3, instances ? "instances" : "vertices", threads, best, single / best,
+				manager.Output() == expected ? "" : " OUTPUT MISMATCH");
+		}
+	}
+
+	printf("threads: %u hardware threads\n", std::thread::hardware_concurrency());
+	manager.SetGenerationThreads(0);
+	manager.Clear();
+}
+
+// Cached groups churned like during editing: random groups deleted, added and re-cached with a
+// different size, each operation timed on its own. The fragmentation of the container and the
+// number of full defragmentations show how well the freed space gets reused.
+static void benchChurn(size_t aCount)
+{
+	static int argc = 1;
+	static char name[] = "BenchView";
+	static char* argv[] = { name, nullptr };
+	QGuiApplication app(argc, argv);
+	QOffscreenSurface surface;
+	QOpenGLContext context;
+
+	surface.create();
+
+	if (!context.create() || !context.makeCurrent(&surface)) {
+		printf("churn %zu groups: no OpenGL context, skipped\n", aCount);
+		return;
+	}
+
+	// Gives access to the fragmentation of the container
+	struct CHURN_MANAGER : VERTEX_MANAGER {
+		CHURN_MANAGER() : VERTEX_MANAGER(true) { }
+
+		CACHED_CONTAINER::FRAGMENTATION Fragmentation() const {
+			return static_cast<CACHED_CONTAINER*>(m_container.get())->GetFragmentation();
+		}
+
+		unsigned int Size() const { return m_container->GetSize(); }
+	};
+
+	std::mt19937 gen(17);
+	std::uniform_real_distribution<double> distKind(0, 1);
+
+	// Mostly pads and segments, some arcs and a few polygons
+	auto groupSize = [&]() {
+		const double kind = distKind(gen);
+
+		if (kind < 0.7)
+			return std::uniform_int_distribution<unsigned int>(3, 18)(gen);
+		else if (kind < 0.95)
+			return std::uniform_int_distribution<unsigned int>(18, 120)(gen);
+		else
+			return std::uniform_int_distribution<unsigned int>(120, 3000)(gen);
+	};
+
+	CHURN_MANAGER manager;
+	std::vector<std::unique_ptr<VERTEX_ITEM>> groups;
+
+	auto addGroup = [&](std::unique_ptr<VERTEX_ITEM>& aGroup, unsigned int aSize) {
+		aGroup = std::make_unique<VERTEX_ITEM>(manager);
+		manager.Color(0.2f, 0.6f, 0.8f, 1.0f);
+
+		// Added in a few steps, like the shapes of an item
+		for (unsigned int added = 0; added < aSize; added += 6) {
+			const unsigned int count = std::min(6u, aSize - added);
+			manager.Reserve(count);
+
+			for (unsigned int v = 0; v < count; ++v)
+				manager.Vertex(added + v, v, 0.0f);
+		}
+
+		manager.FinishItem();
+	};
+
+	manager.Map();
+	groups.resize(aCount);
+
+	for (std::unique_ptr<VERTEX_ITEM>& group : groups)
+		addGroup(group, groupSize());
+
+	const unsigned int initialSize = manager.Size();
+	const unsigned int initialDefragmentations = manager.Fragmentation().defragmentations;
+	const size_t ops = 4 * aCount;
+	std::uniform_int_distribution<size_t> distGroup(0, aCount - 1);
+	std::vector<double> latency;
+
+	latency.reserve(ops);
+
+	PROF_TIMER churnTimer;
+
+	for (size_t i = 0; i < ops; ++i) {
+		std::unique_ptr<VERTEX_ITEM>& group = groups[distGroup(gen)];
+		const double op = distKind(gen);
+		const auto start = std::chrono::steady_clock::now();
+
+		if (op < 0.3) {
+			group.reset();     // deleted
+		}
+		else if (op < 0.6) {
+			if (!group)
+				addGroup(group, groupSize());     // added
+		}
+		else {
+			const unsigned int size = group ? group->GetSize() : groupSize();
+			const double scale = std::uniform_real_distribution<double>(0.5, 2.0)(gen);
+
+			// Re-cached after an edit, growing or shrinking
+			group.reset();
+			addGroup(group, std::max(3.0, size * scale));
+		}
+
+		latency.push_back(std::chrono::duration<double, std::micro>(
+			std::chrono::steady_clock::now() - start).count());
+	}
+
+	churnTimer.Stop();
+	manager.Unmap();
+
+	std::sort(latency.begin(), latency.end());
+
+	const CACHED_CONTAINER::FRAGMENTATION fragmentation = manager.Fragmentation();
+	size_t live = 0;
+
+	for (const std::unique_ptr<VERTEX_ITEM>& group : groups)
+		live += group ? group->GetSize() : 0;
+
+	printf("churn %zu groups, %zu ops: %7.1f ms, latency mean %.2f us, p99 %.2f us, max %.1f us\n",
+		aCount, ops, churnTimer.msecs(), churnTimer.msecs() * 1000.0 / ops,
+		latency[latency.size() * 99 / 100], latency.back());
+	printf("churn: %zu live vertices in %u (initially %u), %u free chunks, largest %u of %u free,"
+		" fragmentation %.3f, %u full defragmentations\n", live, manager.Size(), initialSize,
+		fragmentation.freeChunks, fragmentation.largestFreeChunk, fragmentation.freeSpace,
+		fragmentation.Ratio(), fragmentation.defragmentations - initialDefragmentations);
+
+	manager.Map();
+	groups.clear();
+	manager.Unmap();
+}
+
+// Cached groups churned between frames, with a compaction step run by each Map(). The container
+// is fragmented with the compaction disabled first, then the frames show the time of each step,
+// the bytes it moves and the remaining fragmentation, against copying all the live vertices at
+// once like a full defragmentation does.
+static void benchCompact(size_t aCount)
+{
+	static int argc = 1;
+	static char name[] = "BenchView";
+	static char* argv[] = { name, nullptr };
+	QGuiApplication app(argc, argv);
+	QOffscreenSurface surface;
+	QOpenGLContext context;
+
+	surface.create();
+
+	if (!context.create() || !context.makeCurrent(&surface)) {
+		printf("compact %zu groups: no OpenGL context, skipped\n", aCount);
+		return;
+	}
+
+	// Gives access to the container
+	struct COMPACT_MANAGER : VERTEX_MANAGER {
+		COMPACT_MANAGER() : VERTEX_MANAGER(true) { }
+
+		CACHED_CONTAINER* Container() const {
+			return static_cast<CACHED_CONTAINER*>(m_container.get());
+		}
+	};
+
+	std::mt19937 gen(17);
+	std::uniform_real_distribution<double> distKind(0, 1);
+
+	// Mostly pads and segments, some arcs and a few polygons
+	auto groupSize = [&]() {
+		const double kind = distKind(gen);
+
+		if (kind < 0.7)
+			return std::uniform_int_distribution<unsigned int>(3, 18)(gen);
+		else if (kind < 0.95)
+			return std::uniform_int_distribution<unsigned int>(18, 120)(gen);
+		else
+			return std::uniform_int_distribution<unsigned int>(120, 3000)(gen);
+	};
+
+	COMPACT_MANAGER manager;
+	CACHED_CONTAINER* container = manager.Container();
+	std::vector<std::unique_ptr<VERTEX_ITEM>> groups;
+
+	// The vertex x coordinates count up within a group, to check them after moves
+	auto addGroup = [&](std::unique_ptr<VERTEX_ITEM>& aGroup, unsigned int aSize) {
+		aGroup = std::make_unique<VERTEX_ITEM>(manager);
+		manager.Reserve(aSize);
+
+		for (unsigned int v = 0; v < aSize; ++v)
+			manager.Vertex(v, 0.0f, 0.0f);
+
+		manager.FinishItem();
+	};
+
+	std::uniform_int_distribution<size_t> distGroup(0, aCount - 1);
+
+	auto churn = [&](size_t aOps) {
+		for (size_t i = 0; i < aOps; ++i) {
+			std::unique_ptr<VERTEX_ITEM>& group = groups[distGroup(gen)];
+			const double op = distKind(gen);
+
+			if (op < 0.5)
+				group.reset();
+			else if (!group)
+				addGroup(group, groupSize());
+		}
+	};
+
+	container->SetCompactionBudget(0);
+	manager.Map();
+	groups.resize(aCount);
+
+	for (std::unique_ptr<VERTEX_ITEM>& group : groups)
+		addGroup(group, groupSize());
+
+	churn(2 * aCount);
+	manager.Unmap();
+
+	size_t live = 0;
+
+	for (const std::unique_ptr<VERTEX_ITEM>& group : groups)
+		live += group ? group->GetSize() : 0;
+
+	// What a full defragmentation copies at once
+	std::vector<VERTEX> source(live), target(live);
+	PROF_TIMER copyTimer;
+	memcpy(target.data(), source.data(), live * VERTEX_SIZE);
+	copyTimer.Stop();
+
+	const CACHED_CONTAINER::FRAGMENTATION initial = container->GetFragmentation();
+
+	printf("compact %zu groups: %zu live vertices in %u, %u free chunks, fragmentation %.3f,"
+		" full copy %.2f ms\n", aCount, live, container->GetSize(), initial.freeChunks,
+		initial.Ratio(), copyTimer.msecs());
+
+	// A few edits per frame keep fragmenting the container during the compaction
+	const size_t frames = 400;
+	const size_t opsPerFrame = aCount / 5000 + 1;
+	double maxStep = 0.0, totalStep = 0.0;
+	unsigned int maxBytes = 0;
+	size_t converged = 0;
+
+	container->SetCompactionBudget(CACHED_CONTAINER::DEFAULT_COMPACTION_BUDGET);
+
+	for (size_t frame = 1; frame <= frames; ++frame) {
+		PROF_TIMER stepTimer;
+		manager.Map();
+		stepTimer.Stop();
+
+		const CACHED_CONTAINER::COMPACTION& compaction = container->GetCompaction();
+		const double ratio = container->GetFragmentation().Ratio();
+
+		maxStep = std::max(maxStep, stepTimer.msecs());
+		totalStep += stepTimer.msecs();
+		maxBytes = std::max(maxBytes, compaction.bytesMoved);
+
+		if (!converged && !compaction.active && ratio < CACHED_CONTAINER::COMPACTION_START)
+			converged = frame;
+
+		if (frame <= 5 || frame % 100 == 0) {
+			printf("compact frame %3zu: %6u items, %8u bytes moved in %6.2f ms, fragmentation"
+				" %.3f%s\n", frame, compaction.itemsMoved, compaction.bytesMoved,
+				stepTimer.msecs(), ratio, compaction.active ? "" : " (idle)");
+		}
+
+		churn(opsPerFrame);
+		manager.Unmap();
+	}
+
+	size_t corrupted = 0;
+
+	for (const std::unique_ptr<VERTEX_ITEM>& group : groups) {
+		if (!group)
+			continue;
+
+		const VERTEX* vertices = manager.GetVertices(*group);
+
+		for (unsigned int v = 0; v < group->GetSize(); ++v)
+			corrupted += vertices[v].x != v;
+	}
+
+	printf("compact: %zu frames, step mean %.3f ms, max %.2f ms, max %u bytes per frame, %llu"
+		" bytes moved, fragmentation below %.2f from frame %zu, %u full defragmentations%s\n",
+		frames, totalStep / frames, maxStep, maxBytes,
+		(unsigned long long) container->GetCompaction().totalBytesMoved,
+		CACHED_CONTAINER::COMPACTION_START, converged,
+		container->GetFragmentation().defragmentations - initial.defragmentations,
+		corrupted ? " VERTICES CORRUPTED" : "");
+
+	manager.Map();
+	groups.clear();
+	manager.Unmap();
+}
+
+// Vertices added to a non-cached VERTEX_MANAGER one at a time with Vertex(), and at once with
+// Vertices() in each instruction set, without and with a transformation (like DrawArc())
+static void benchEmit(size_t aCount)
+{
+	constexpr int RUNS = 5;
+	const GLfloat depth = -1.0f;
+	const VERTEX_ISA isas[] = { VERTEX_ISA::SCALAR, VERTEX_ISA::SSE2, VERTEX_ISA::AVX2 };
+	const VERTEX_ISA defaultIsa = GetVertexIsa();
+
+	std::mt19937 gen(5);
+	std::uniform_real_distribution<GLfloat> distPos(-1000000, 1000000);
+	std::vector<GLfloat> xy(2 * aCount);
+
+	for (GLfloat& coord : xy)
+		coord = distPos(gen);
+
+	VERTEX_MANAGER manager(false);
+
+	manager.Color(0.2f, 0.6f, 0.8f, 1.0f);
+	manager.Shader(SHADER_NONE);
+
+	for (bool transform : { false, true }) {
+		if (transform) {
+			manager.PushMatrix();
+			manager.Translate(1000.0f, -2000.0f, 0.0f);
+			manager.Rotate(0.3f, 0.0f, 0.0f, 1.0f);
+		}
+
+		// Every implementation has to give the scalar results, up to the rounding of the
+		// transformation
+		std::vector<VERTEX> expected(aCount), result(aCount);
+		VERTEX base = {};
+		base.r = 51;
+		base.mode = SHADER_NONE;
+		const glm::mat4& matrix = manager.GetTransformation();
+
+		SetVertexIsa(VERTEX_ISA::SCALAR);
+		EmitVertices(expected.data(), xy.data(), aCount, depth, transform ? &matrix : nullptr,
+			base);
+
+		auto run = [&](const char* aName, const std::function<void()>& aFunc) {
+			double best = std::numeric_limits<double>::max();
+
+			for (int i = 0; i < RUNS; ++i) {
+				manager.Clear();
+				PROF_TIMER timer;
+				aFunc();
+				timer.Stop();
+				best = std::min(best, timer.msecs());
+			}
+
+			printf("emit %zu vertices, transform %-3s: %-20s %7.1f ms, %5.2f ns/vertex\n", aCount,
+				transform ? "on" : "off", aName, best, best * 1e6 / aCount);
+		};
+
+		run("Vertex()", [&]() {
+			manager.Reserve(aCount);
+
+			for (size_t i = 0; i < aCount; ++i)
+				manager.Vertex(xy[2 * i], xy[2 * i + 1], depth);
+		});
+
+		for (VERTEX_ISA isa : isas) {
+			if (!SetVertexIsa(isa))
+				continue;
+
+			EmitVertices(result.data(), xy.data(), aCount, depth, transform ? &matrix : nullptr,
+				base);
+
+			double deviation = 0.0;
+			bool same = true;
+
+			for (size_t i = 0; i < aCount; ++i) {
+				deviation = std::max({ deviation, (double) std::abs(result[i].x - expected[i].x),
+					(double) std::abs(result[i].y - expected[i].y),
+					(double) std::abs(result[i].z - expected[i].z) });
+				same = same && !memcmp(&result[i].r, &expected[i].r, VERTEX_SIZE - COLOR_OFFSET);
+			}
+
+			const std::string name = std::string("Vertices() ") + GetVertexIsaName(isa);
+
+			run(name.c_str(), [&]() {
+				manager.Vertices(xy.data(), aCount, depth);
+			});
+
+			if (!same || deviation > 0.5)
+				printf("emit: %s RESULT MISMATCH (max deviation %g)\n", name.c_str(), deviation);
+		}
+
+		if (transform)
+			manager.PopMatrix();
+	}
+
+	SetVertexIsa(defaultIsa);
+	manager.Clear();
+}
+
+static std::vector<DATA_Rectangle> makeDistribution(const char* aName, size_t aCount)
+{
+	constexpr int EXTENT = 1000000000;
+
+	std::mt19937 gen(777);
+	std::vector<DATA_Rectangle> rectangles;
+	rectangles.reserve(aCount);
+
+	if (!strcmp(aName, "clustered")) {
+		// Dense blobs of parts with empty board between them
+		std::uniform_real_distribution<double> distCentre(0.1 * EXTENT, 0.9 * EXTENT);
+		std::normal_distribution<double> distOffset(0.0, 0.01 * EXTENT);
+		std::uniform_int_distribution<int> distSize(1000, 200000);
+		std::vector<VECTOR2D> centres;
+
+		for (int i = 0; i < 20; ++i)
+			centres.emplace_back(distCentre(gen), distCentre(gen));
+
+		for (size_t i = 0; i < aCount; ++i) {
+			const VECTOR2D& centre = centres[i % centres.size()];
+			VECTOR2I start(centre.x + distOffset(gen), centre.y + distOffset(gen));
+			rectangles.emplace_back(start, start + VECTOR2I(distSize(gen), distSize(gen)));
+		}
+	}
+	else if (!strcmp(aName, "mixed")) {
+		// Mostly small items plus a few large ones (zones, board outline segments)
+		std::uniform_int_distribution<int> distPos(0, EXTENT / 2);
+		std::uniform_int_distribution<int> distSmall(1000, 20000);
+		std::uniform_int_distribution<int> distLarge(1000000, EXTENT / 10);
+
+		for (size_t i = 0; i < aCount; ++i) {
+			VECTOR2I start(distPos(gen), distPos(gen));
+			auto& dist = (i % 100 == 0) ? distLarge : distSmall;
+			rectangles.emplace_back(start, start + VECTOR2I(dist(gen), dist(gen)));
+		}
+	}
+	else {
+		return makeRectangles(aCount);
+	}
+
+	return rectangles;
+}
+
+// Layer index backends (VIEW::SetLayerIndex()): bulk load, insertion, removal, move and query
+// cost, for several item distributions
+static void benchIndex(size_t aCount)
+{
+	constexpr int EXTENT = 1000000000;
+	constexpr int QUERIES = 200;
+
+	const std::pair<VIEW_INDEX_TYPE, const char*> backends[] = {
+		{ VIEW_INDEX_TYPE::RTREE_QUADRATIC, "rtree-quadratic" },
+		{ VIEW_INDEX_TYPE::RTREE_LINEAR,    "rtree-linear" },
+		{ VIEW_INDEX_TYPE::RTREE_RSTAR,     "rtree-rstar" },
+		{ VIEW_INDEX_TYPE::HASH_GRID,       "hash-grid" },
+		{ VIEW_INDEX_TYPE::QUADTREE,        "quadtree" },
+		{ VIEW_INDEX_TYPE::LINEAR_SCAN,     "linear-scan" },
+		{ VIEW_INDEX_TYPE::PACKED_RTREE,    "packed-rtree" }
+	};
+
+	const std::pair<const char*, size_t> distributions[] = {
+		{ "uniform", aCount },
+		{ "clustered", aCount },
+		{ "mixed", aCount },
+		{ "overlay", 200 }
+	};
+
+	printf("%-10s %-16s %10s %10s %12s %12s %12s %10s\n", "items", "index", "bulk ms", "insert ms",
+		"remove us/op", "move us/op", "query us", "hits");
+
+	for (const auto& [distribution, count] : distributions) {
+		std::vector<DATA_Rectangle> rectangles = makeDistribution(distribution, count);
+		std::vector<VIEW_INDEX_ENTRY> entries;
+
+		for (DATA_Rectangle& rect : rectangles)
+			entries.emplace_back(rect.GetBoundingBoxD(), &rect);
+
+		// Viewports covering 1% of the board, the same ones for every backend
+		std::mt19937 gen(99);
+		std::uniform_int_distribution<int> distPos(0, EXTENT - EXTENT / 10);
+		std::vector<BOX2D> viewports;
+
+		for (int i = 0; i < QUERIES; ++i)
+			viewports.emplace_back(VECTOR2D(distPos(gen), distPos(gen)), VECTOR2D(EXTENT / 10, EXTENT / 10));
+
+		const size_t ops = std::max<size_t>(1, std::min<size_t>(count / 10, 10000));
+		size_t expectedHits = SIZE_MAX;
+
+		for (const auto& [type, name] : backends) {
+			std::vector<VIEW_INDEX_ENTRY> bulk = entries;
+			VIEW_INDEX index(type);
+
+			PROF_TIMER bulkTimer;
+			index.BulkLoad(bulk);
+			bulkTimer.Stop();
+
+			VIEW_INDEX inserted(type);
+			PROF_TIMER insertTimer;
+
+			for (const auto& [bbox, item] : entries)
+				inserted.Insert(item, bbox);
+
+			insertTimer.Stop();
+
+			size_t hits = 0;
+			auto   visitor = [&](VIEW_ITEM*) { hits++; };
+			PROF_TIMER queryTimer;
+
+			for (const BOX2D& viewport : viewports)
+				index.Query(viewport, visitor);
+
+			queryTimer.Stop();
+
+			// Move a few items (remove + insert at the new place), then remove them
+			PROF_TIMER moveTimer;
+
+			for (size_t i = 0; i < ops; ++i) {
+				const auto& [bbox, item] = entries[i * 7 % count];
+				BOX2D moved = bbox;
+				moved.Move(VECTOR2D(EXTENT / 1000, 0));
+
+				index.Remove(item, &bbox);
+				index.Insert(item, moved);
+			}
+
+			moveTimer.Stop();
+
+			PROF_TIMER removeTimer;
+
+			for (size_t i = 0; i < ops; ++i) {
+				const auto& [bbox, item] = entries[i * 7 % count];
+				BOX2D moved = bbox;
+				moved.Move(VECTOR2D(EXTENT / 1000, 0));
+
+				index.Remove(item, &moved);
+			}
+
+			removeTimer.Stop();
+
+			if (expectedHits == SIZE_MAX)
+				expectedHits = hits;
+			else if (hits != expectedHits)
+				printf("index: %s/%s hit count mismatch\n", distribution, name);
+
+			printf("%-10s %-16s %10.1f %10.1f %12.3f %12.3f %12.1f %10zu\n", distribution, name,
+				bulkTimer.msecs(), insertTimer.msecs(), removeTimer.msecs() * 1000.0 / ops,
+				moveTimer.msecs() * 1000.0 / ops, queryTimer.msecs() * 1000.0 / QUERIES, hits / QUERIES);
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	// usage: BenchView [load|query|move|index|redraw|pan|lod|priority|memory|rebuild|ingest|pick|select|snap|order|snapshot|vertex|batch|emit|threads|churn|compact] [item count]
+	const char* which = argc > 1 ? argv[1] : "all";
+	size_t count = argc > 2 ? strtoull(argv[2], nullptr, 10) : 0;
+
+	auto selected = [&](const char* aName) {
+		return !strcmp(which, "all") || !strcmp(which, aName);
+	};
+
+	if (selected("load")) {
+		if (count)
+			benchLoad(count);
+		else {
+			benchLoad(1000000);
+			benchLoad(10000000);
+		}
+	}
+
+	if (selected("query"))
+		benchQuery(count ? count : 1000000);
+
+	if (selected("move"))
+		benchMove(count ? count : 1000000, 100000);
+
+	if (selected("index"))
+		benchIndex(count ? count : 200000);
+
+	if (selected("redraw"))
+		benchRedraw(count ? count : 1000000);
+
+	if (selected("pan"))
+		benchPan(count ? count : 1000000);
+
+	if (selected("priority"))
+		benchPriority(count ? count : 1000000);
+
+	if (selected("ingest"))
+		benchIngest(count ? count : 1000000);
+
+	if (selected("rebuild"))
+		benchRebuild(count ? count : 1000000);
+
+	if (selected("pick"))
+		benchPick(count ? count : 10000000);
+
+	if (selected("select"))
+		benchSelect(count ? count : 1000000);
+
+	if (selected("snap"))
+		benchSnap(count ? count : 1000000);
+
+	if (selected("order"))
+		benchOrder(count ? count : 1000000);
+
+	if (selected("snapshot"))
+		benchSnapshot(count ? count : 1000000);
+
+	if (selected("vertex"))
+		benchVertex(count ? count : 1000000);
+
+	if (selected("batch"))
+		benchBatch(count ? count : 1000000);
+
+	if (selected("threads"))
+		benchThreads(count ? count : 3000000);
+
+	if (selected("churn"))
+		benchChurn(count ? count : 200000);
+
+	if (selected("compact"))
+		benchCompact(count ? count : 200000);
+
+	if (selected("emit"))
+		benchEmit(count ? count : 2000000);
+
+	if (selected("memory"))
+		benchMemory(count ? count : 5000000);
+
+	if (selected("lod")) {
+		if (count)
+			benchLod(count);
+		else {
+			benchLod(1000000);
+			benchLod(4000000);
+		}
+	}
+
+	return 0;
+}
@@ -6,19 +6,36 @@
 #include <unordered_map>
 #include <memory>
 #include <map>
+#include <span>
+#include <string>
+#include <functional>
+#include <cstdint>
+#include <limits>
+#include <optional>
 
 #include <box2.hxx>
+#include <epoch_reclaimer.hxx>
+#include <mpsc_queue.hxx>
 #include <gal/include/definitions.hxx>
+#include <view_def.hxx>
 
 //#include <view/view_overlay.h>
 
+class SHAPE_LINE_CHAIN;
+struct HASH_128;
+
 namespace KIGFX
 {
     class PAINTER;
     class GAL;
     class VIEW_ITEM;
     //class VIEW_GROUP;
-    class VIEW_RTREE;
+    class VIEW_INDEX;
+    class VIEW_ITEM_DATA_POOL;
+    class VIEW_LOD_CACHE;
+    struct VIEW_LOD_CELL;
+    class VIEW_SNAP_INDEX;
+    struct VIEW_ANCHOR;
     //class VIEW_OVERLAY;
 
     /**
@@ -44,6 +61,7 @@ namespace KIGFX
         friend class VIEW_ITEM;
 
         typedef std::pair<VIEW_ITEM*, int> LAYER_ITEM_PAIR;
+        typedef std::pair<VIEW_ITEM*, double> ITEM_DISTANCE_PAIR;
 
         VIEW();
         virtual ~VIEW();
@@ -72,6 +90,51 @@ namespace KIGFX
          */
         virtual void Add(VIEW_ITEM* aItem, int aDrawPriority = -1);
 
+        /**
+         * Add a batch of #VIEW_ITEMs to the view.
+         *
+         * Equivalent to calling Add() for each item with sequential draw priorities, but the
+         * items are grouped by layer and each layer's R-tree is built in a single packing pass,
+         * which is considerably faster for large item counts (e.g. initial board load).
+         *
+         * @param aItems: items to be added. No ownership is given. The items must not be
+         *                already added to the view.
+         */
+        void AddItems(std::span<VIEW_ITEM* const> aItems);
+
+        /**
+         * Add a batch of #VIEW_ITEMs to an empty view from an index snapshot, instead of computing
+         * their boxes and building the layer indexes.
+         *
+         * The snapshot is memory mapped and its packed R-trees are used in place: the layers it
+         * covers switch to VIEW_INDEX_TYPE::PACKED_RTREE. The items get the order and draw
+         * priorities they had when the snapshot was saved.
+         *
+         * If the snapshot is missing, was written for another content hash or item count, does
+         * not match the boxes of a sample of the items or is not valid, or the view is not empty,
+         * the items are added with AddItems() instead.
+         *
+         * @param aPath is the snapshot file.
+         * @param aItems are the items, listed as when the snapshot was saved.
+         * @param aContentHash identifies the content the items are made from.
+         * @return true if the snapshot was used.
+         */
+        bool LoadIndexSnapshot(const std::string& aPath, std::span<VIEW_ITEM* const> aItems,
+                               const HASH_128& aContentHash);
+
+        /**
+         * Save an index snapshot of the items in the view, for LoadIndexSnapshot().
+         *
+         * @param aPath is the snapshot file, replaced if it exists.
+         * @param aItems are all the items of the view, in the order they will be listed to
+         *               LoadIndexSnapshot().
+         * @param aContentHash identifies the content the items are made from.
+         * @return false if \a aItems are not the items of the view or the file could not be
+         *         written.
+         */
+        bool SaveIndexSnapshot(const std::string& aPath, std::span<VIEW_ITEM* const> aItems,
+                               const HASH_128& aContentHash) const;
+
         /**
          * Remove a #VIEW_ITEM from the view.
          *
@@ -79,16 +142,64 @@ namespace KIGFX
          */
         virtual void Remove(VIEW_ITEM* aItem);
 
+        /**
+         * Queue items to be added to the view by ApplyQueuedChanges().
+         *
+         * Unlike the rest of the view, the Queue*() methods can be called from any thread, e.g.
+         * by a background loader while the view keeps rendering. Queued changes are applied in
+         * order.
+         *
+         * @param aItems: items to be added. No ownership is given.
+         */
+        void QueueAdd(std::vector<VIEW_ITEM*> aItems);
+
+        /**
+         * Queue items to be removed from the view by ApplyQueuedChanges().
+         *
+         * @param aItems: items to be removed.
+         * @param aDisposer: if set, called for each item once it is removed and no reader can see
+         *                   it anymore (see PinItems()), e.g. to delete it.
+         */
+        void QueueRemove(std::vector<VIEW_ITEM*> aItems,
+                         std::function<void(VIEW_ITEM*)> aDisposer = nullptr);
+
+        /**
+         * Queue items to be updated by ApplyQueuedChanges() (see Update()).
+         */
+        void QueueUpdate(std::vector<VIEW_ITEM*> aItems, int aUpdateFlags = ALL);
+
+        /**
+         * Apply the changes queued by QueueAdd(), QueueRemove() and QueueUpdate(). To be called
+         * from the thread owning the view, typically before drawing a frame.
+         *
+         * @param aMaxItems: maximum number of items to add, remove or update, 0 for no limit.
+         *                   Bounds the time spent per frame while a large design streams in.
+         * @return true if changes are still queued.
+         */
+        bool ApplyQueuedChanges(size_t aMaxItems = 0);
+
+        /**
+         * Keep the items removed by ApplyQueuedChanges() from being disposed of while the
+         * returned guard exists. For code holding item pointers outside of the thread owning the
+         * view.
+         */
+        EPOCH_RECLAIMER::GUARD PinItems() const
+        {
+            return EPOCH_RECLAIMER::GUARD(m_reclaimer);
+        }
+
 
         /**
          * Find all visible items that touch or are within the rectangle \a aRect.
          *
          * @param aResult result of the search, containing VIEW_ITEMs associated with their layers.
          *                Sorted according to the rendering order (items that are on top of the
-         *                rendering stack as first).
+         *                rendering stack as first). Results are appended, so the vector may
+         *                be reused between queries to avoid reallocations.
          * @return Number of found items.
          */
         int Query(const BOX2I& aRect, std::vector<LAYER_ITEM_PAIR>& aResult) const;
+        int Query(const BOX2D& aRect, std::vector<LAYER_ITEM_PAIR>& aResult) const;
 
         /**
          * Run a function on all visible items that touch or are within the rectangle \a aRect.
@@ -96,6 +207,94 @@ namespace KIGFX
          * @param aFunc the function to be executed; return true to continue, false to end query.
          */
         void Query(const BOX2I& aRect, const std::function<bool(VIEW_ITEM*)>& aFunc) const;
+        void Query(const BOX2D& aRect, const std::function<bool(VIEW_ITEM*)>& aFunc) const;
+
+        /**
+         * Find all visible items whose shape lies within \a aTolerance of \a aPoint.
+         *
+         * Unlike Query(), the candidates found with their bounding box are tested against their
+         * actual shape (see VIEW_ITEM::ViewHitDistance()): a click in the empty corner of the
+         * bounding box of a diagonal line does not pick it.
+         *
+         * @param aResult result of the search, sorted like Query(). Results are appended.
+         * @return Number of found items.
+         */
+        int HitTest(const VECTOR2D& aPoint, double aTolerance,
+                    std::vector<LAYER_ITEM_PAIR>& aResult) const;
+
+        /**
+         * Find the \a aCount visible items whose shape is the closest to \a aPoint.
+         *
+         * The layer indexes are searched best first (see VIEW_INDEX::Nearest()), and the search
+         * stops as soon as the remaining bounding boxes are farther than the \a aCount closest
+         * shapes found so far, or than \a aMaxDistance. Items on several layers are reported once.
+         *
+         * @param aResult result of the search: the items with the distance to their shape, the
+         *                closest first. Results are appended.
+         * @param aMaxDistance is the largest distance of the items to find, in world units.
+         * @return Number of found items, less than \a aCount if there are not enough items.
+         */
+        int Nearest(const VECTOR2D& aPoint, int aCount, std::vector<ITEM_DISTANCE_PAIR>& aResult,
+                    double aMaxDistance = std::numeric_limits<double>::max()) const;
+
+        /**
+         * Find all visible items inside a lasso or touching it.
+         *
+         * Candidates come from the layer indexes. Those whose bounding box is completely
+         * inside or outside the lasso are decided right away (see VIEW_AREA_MAP), only the
+         * others get an exact test (VIEW_ITEM::ViewHitTest()). The tests run on the thread
+         * pool, so large selections do not stall the caller.
+         *
+         * @param aArea is the lasso outline, taken as closed.
+         * @param aContained is true to select the items completely inside the lasso, false to
+         *                   select the items touching it.
+         * @param aResult result of the search, containing VIEW_ITEMs associated with their layers.
+         *                Items on top of the rendering stack come first: layers are in reverse
+         *                rendering order, and items of a layer by decreasing draw priority if
+         *                the view draws by priority. Results are appended.
+         * @return Number of found items.
+         */
+        int Select(const SHAPE_LINE_CHAIN& aArea, bool aContained,
+                   std::vector<LAYER_ITEM_PAIR>& aResult) const;
+
+        /**
+         * Find all visible items inside a selection window or touching it.
+         *
+         * @see Select(const SHAPE_LINE_CHAIN&, bool, std::vector<LAYER_ITEM_PAIR>&).
+         */
+        int Select(const BOX2I& aArea, bool aContained, std::vector<LAYER_ITEM_PAIR>& aResult) const;
+
+        /**
+         * Enable or disable the index of item anchors used by GetSnapAnchor().
+         *
+         * Enabling builds the index from the items in the view. It is then kept up to date as
+         * items are added, updated and removed, which costs some time on every change, so it is
+         * disabled by default.
+         */
+        void EnableSnapIndex(bool aEnable);
+
+        bool IsSnapIndexEnabled() const
+        {
+            return m_snapIndex != nullptr;
+        }
+
+        /**
+         * Find the point to snap the cursor to: the closest anchor of a visible item (see
+         * VIEW_ITEM::ViewGetAnchors()), or intersection of the edges of the visible items
+         * passing near the cursor.
+         *
+         * Only a bounded number of anchors and items closest to the cursor are considered. When
+         * the visible layers use the dynamic R-trees (the default), the cost does not depend on
+         * the number of items or on the zoom level. The other index types search windows of
+         * growing size, capped at \a aScreenDistance, so their cost still grows with the number
+         * of items near the cursor, and with the layer size for VIEW_INDEX_TYPE::LINEAR_SCAN.
+         *
+         * @param aPoint is the cursor position, in world coordinates.
+         * @param aScreenDistance is the snapping distance, in screen pixels.
+         * @return the anchor, nothing if there is none within \a aScreenDistance or the snap
+         *         index is disabled.
+         */
+        std::optional<VIEW_ANCHOR> GetSnapAnchor(const VECTOR2D& aPoint, double aScreenDistance) const;
 
         /**
          * Set the item visibility.
@@ -140,6 +339,19 @@ namespace KIGFX
         virtual void Update(const VIEW_ITEM* aItem, int aUpdateFlags) const;
         virtual void Update(const VIEW_ITEM* aItem) const;
 
+        /**
+         * Immediately refresh the bounding box of an item in the spatial index, e.g. while it
+         * is being dragged.
+         *
+         * The item is stored in the layer R-trees under a slightly enlarged box, so small moves
+         * only update the cached bbox. The tree entries are replaced only when the item leaves
+         * the enlarged box.  Cached (GAL group) geometry is not refreshed, use Update() with
+         * #GEOMETRY for that.
+         *
+         * @param aItem: the item whose geometry has changed.
+         */
+        void UpdateBBox(VIEW_ITEM* aItem);
+
         /**
          * Mark the \a aRequiredId layer as required for the aLayerId layer. In order to display the
          * layer, all of its required layers have to be enabled.
@@ -301,6 +513,9 @@ namespace KIGFX
          * Set the center point of the VIEW (i.e. the point in world space that will be drawn in
          * the middle of the screen).
          *
+         * With scroll blit enabled (see UseScrollBlit()), moving the center by whole screen
+         * pixels scrolls the previous frame on the next Redraw() instead of redrawing it.
+         *
          * @param aCenter: the new center point, in world space coordinates.
          */
         void SetCenter(const VECTOR2D& aCenter);
@@ -480,6 +695,24 @@ namespace KIGFX
             it->second.target = aTarget;
         }
 
+        /**
+         * Change the spatial index used for a particular layer.
+         *
+         * The default R-tree suits most layers. A hash grid or a quadtree handles densely
+         * populated layers and items that move every frame better, while a linear scan is the
+         * fastest option for layers holding only a few items. The items already on the layer
+         * are moved to the new index.
+         *
+         * @param aLayer is the layer.
+         * @param aType is the type of index to use.
+         */
+        void SetLayerIndex(int aLayer, VIEW_INDEX_TYPE aType);
+
+        /**
+         * Return the type of spatial index used for a particular layer.
+         */
+        VIEW_INDEX_TYPE GetLayerIndex(int aLayer) const;
+
         /**
          * Set rendering order of a particular layer. Lower values are rendered first.
          *
@@ -571,9 +804,33 @@ namespace KIGFX
 
         /**
          * Immediately redraws the whole view.
+         *
+         * Items to draw are culled in parallel, one layer per task on the shared thread pool,
+         * then submitted to the GAL serially in layer order.
          */
         virtual void Redraw();
 
+        /**
+         * Return the time spent by the last redraw culling items, i.e. querying the layers and
+         * evaluating item visibility and LOD.
+         *
+         * @return the time in milliseconds.
+         */
+        double GetLastCullTime() const
+        {
+            return m_lastCullTime;
+        }
+
+        /**
+         * Return the time spent by the last redraw submitting the culled items to the GAL.
+         *
+         * @return the time in milliseconds.
+         */
+        double GetLastSubmitTime() const
+        {
+            return m_lastSubmitTime;
+        }
+
         /**
          * Rebuild GAL display lists.
          */
@@ -618,8 +875,22 @@ namespace KIGFX
             //wxCHECK(aTarget < TARGETS_NUMBER, /* void */);
             if (aTarget >= TARGETS_NUMBER) return;
             m_dirtyTargets[aTarget] = true;
+            m_fullRedrawTargets[aTarget] = true;
         }
 
+        /**
+         * Mark an area of a target as changed, e.g. where an item was drawn before and after
+         * an update.
+         *
+         * With damage redraw enabled (see UseDamageRedraw()), the next Redraw() clears and
+         * redraws only the changed area instead of the whole screen. Otherwise this is the
+         * same as MarkTargetDirty().
+         *
+         * @param aTarget is the target to set.
+         * @param aArea is the changed area, in world coordinates.
+         */
+        void MarkTargetDamaged(int aTarget, const BOX2D& aArea);
+
         /// Return true if the layer is cached.
         inline bool IsCached(int aLayer) const
         {
@@ -637,7 +908,10 @@ namespace KIGFX
         void MarkDirty()
         {
             for (int i = 0; i < TARGETS_NUMBER; ++i)
+            {
                 m_dirtyTargets[i] = true;
+                m_fullRedrawTargets[i] = true;
+            }
         }
 
         /**
@@ -646,7 +920,10 @@ namespace KIGFX
         void MarkClean()
         {
             for (int i = 0; i < TARGETS_NUMBER; ++i)
+            {
                 m_dirtyTargets[i] = false;
+                m_fullRedrawTargets[i] = false;
+            }
         }
 
         /**
@@ -661,6 +938,16 @@ namespace KIGFX
          */
         void UpdateAllItems(int aUpdateFlags);
 
+        /**
+         * Sort the items along a Hilbert curve of their bbox centers, and move their
+         * VIEW_ITEM_DATA to match. Redraw, UpdateItems() and recaching then walk the data
+         * mostly sequentially instead of in insertion order.
+         *
+         * The items themselves stay where they are; see DataManager::SortSpatially() for them.
+         * This is worth it after many items were added, removed or moved.
+         */
+        void SortItemsSpatially();
+
         /**
          * Update items in the view according to the given flags and condition.
          *
@@ -703,6 +990,73 @@ namespace KIGFX
             m_reverseDrawOrder = aFlag;
         }
 
+        /**
+         * @return true if only the damaged areas of the targets are redrawn.
+         */
+        bool IsUsingDamageRedraw() const
+        {
+            return m_useDamageRedraw;
+        }
+
+        /**
+         * Set whether Redraw() repaints only the areas where items changed (see
+         * MarkTargetDamaged()) or always the whole screen.
+         *
+         * Changes of the view transform, layer setup etc. still redraw the whole screen.
+         *
+         * @param aFlag is true to redraw only the damaged areas.
+         */
+        void UseDamageRedraw(bool aFlag)
+        {
+            m_useDamageRedraw = aFlag;
+        }
+
+        /**
+         * @return true if panning scrolls the previous frame.
+         */
+        bool IsUsingScrollBlit() const
+        {
+            return m_useScrollBlit;
+        }
+
+        /**
+         * Set whether panning the view by whole pixels at a constant scale shifts the previous
+         * frame and redraws only the uncovered strips along the screen edges.
+         *
+         * Zooming, sub-pixel panning and GALs that cannot scroll their targets (see
+         * GAL::ScrollTargets()) still redraw the whole screen.
+         *
+         * @param aFlag is true to scroll the previous frame when panning.
+         */
+        void UseScrollBlit(bool aFlag)
+        {
+            m_useScrollBlit = aFlag;
+        }
+
+        /**
+         * @return the screen size below which items are aggregated, in pixels (0 if disabled).
+         */
+        double GetAggregateThreshold() const
+        {
+            return m_aggregateThreshold;
+        }
+
+        /**
+         * Set the screen size below which items are no longer drawn one by one.
+         *
+         * When zoomed out, each layer is divided in cells of about this size on the screen and
+         * the items smaller than a cell are drawn as one quad per cell (see
+         * PAINTER::DrawAggregate()). This keeps the number of draws bounded by the screen size
+         * instead of the number of items. Layers with mostly large items are drawn as usual.
+         *
+         * @param aPixels is the cell size in screen pixels, 0 to always draw every item.
+         */
+        void SetAggregateThreshold(double aPixels)
+        {
+            m_aggregateThreshold = aPixels;
+            MarkDirty();
+        }
+
         //std::shared_ptr<VIEW_OVERLAY> MakeOverlay();
 
         void InitPreview();
@@ -736,7 +1090,8 @@ namespace KIGFX
 
             /// Layer should be drawn separately to not delete lower layers.
             bool                    hasNegatives;
-            std::shared_ptr<VIEW_RTREE> items;       ///< R-tree indexing all items on this layer.
+            std::shared_ptr<VIEW_INDEX> items;       ///< Spatial index of all items on this layer.
+            std::shared_ptr<VIEW_LOD_CACHE> lod;     ///< Aggregated items for zoomed out views.
             int                     renderingOrder;  ///< Rendering order of this layer.
             int                     id;              ///< Layer ID.
             RENDER_TARGET           target;          ///< Where the layer should be rendered.
@@ -750,16 +1105,89 @@ namespace KIGFX
             }
         };
 
+        /// Items of a layer that pass the visibility and LOD tests, in drawing order.
+        struct LAYER_DRAW_LIST
+        {
+            VIEW_LAYER*             layer;
+            std::vector<VIEW_ITEM*> items;
+
+            /// Draw priority keys of the items, when drawing by priority. The items are sorted
+            /// by key and then copied to #items.
+            std::vector<std::pair<uint32_t, VIEW_ITEM*>> sortKeys;
+
+            /// Scratch buffer for sorting #sortKeys, kept to reuse its storage.
+            std::vector<std::pair<uint32_t, VIEW_ITEM*>> sortScratch;
+
+            /// Cells of small items drawn as one quad each, when the layer is aggregated.
+            std::vector<const VIEW_LOD_CELL*> aggregates;
+
+            /// True if some items have forced transparency and need the second drawing pass.
+            bool                    hasForcedTransparent;
+        };
+
+        /// A batch of changes queued by QueueAdd(), QueueRemove() or QueueUpdate().
+        struct QUEUED_CHANGE
+        {
+            enum TYPE
+            {
+                ADD,
+                REMOVE,
+                UPDATE
+            };
+
+            TYPE                            type = ADD;
+            std::vector<VIEW_ITEM*>         items;
+            int                             updateFlags = NONE;
+            std::function<void(VIEW_ITEM*)> disposer;
+        };
+
         /// Redraw contents within rectangle \a aRect.
-        void redrawRect(const BOX2I& aRect);
+        void redrawRect(const BOX2D& aRect);
+
+        /// Fill \a aList with the items of its layer to be drawn within \a aRect.
+        void cullLayer(LAYER_DRAW_LIST& aList, const BOX2D& aRect) const;
+
+        /// @return true if \a aItem may be drawn as part of an aggregate on \a aLayer.
+        bool canAggregate(const VIEW_ITEM* aItem, int aLayer) const;
+
+        /// Bring the aggregated items cache of \a aLayer up to date for cells of \a aCellSize.
+        void updateLayerLOD(VIEW_LAYER& aLayer, double aCellSize) const;
+
+        /// Update the aggregated items cache of \a aLayer after \a aItem has been added, moved
+        /// or removed (see VIEW_LOD_CACHE::Update()).
+        void updateItemLOD(VIEW_ITEM* aItem, int aLayer, const BOX2D* aOldBbox,
+                           const BOX2D* aNewBbox);
 
         inline void markTargetClean(int aTarget)
         {
             //wxCHECK(aTarget < TARGETS_NUMBER, /* void */);
             if (aTarget >= TARGETS_NUMBER) return;
             m_dirtyTargets[aTarget] = false;
+            m_fullRedrawTargets[aTarget] = false;
         }
 
+        /**
+         * Compute the area to redraw when only parts of the dirty targets changed.
+         *
+         * @param aViewport is the visible area, in world coordinates.
+         * @param aArea receives the area to redraw, in world coordinates; it is left invalid if
+         *              the targets were only scrolled.
+         * @return false if the whole screen has to be redrawn.
+         */
+        bool getDamagedArea(const BOX2D& aViewport, BOX2D& aArea) const;
+
+        /// Clear and redraw the dirty targets within \a aArea only, in world coordinates.
+        void redrawArea(const BOX2D& aArea);
+
+        /**
+         * Record that the view content moved by \a aShift screen pixels, to be scrolled by the
+         * next Redraw().
+         *
+         * @return false if the shift cannot be done by scrolling, so everything has to be
+         *         redrawn.
+         */
+        bool markScrolled(const VECTOR2D& aShift);
+
         /**
          * Draw an item, but on a specified layers.
          *
@@ -812,12 +1240,34 @@ namespace KIGFX
         /// Update all information needed to draw an item.
         void updateItemGeometry(VIEW_ITEM* aItem, int aLayer);
 
-        /// Update bounding box of an item.
-        void updateBbox(VIEW_ITEM* aItem);
+        /**
+         * Return true if \a aItem only matched a query on \a aRect because of the slack of its
+         * index box (see UpdateBBox()), i.e. its actual bbox does not touch \a aRect.
+         */
+        bool isOutsideIndexSlack(const VIEW_ITEM* aItem, const BOX2D& aRect) const;
 
         /// Update set of layers that an item occupies.
         void updateLayers(VIEW_ITEM* aItem);
 
+        /// Refresh the bboxes and layers of all the items and pack them into the (empty) layer
+        /// indexes, using the thread pool.
+        void rebuildIndexes();
+
+        /// Remove the empty slots of m_allItems and update the indices cached in the items.
+        void compactItems();
+
+        /// Give the VIEW_ITEM_DATA of \a aItem back to the pool, detaching it from the view.
+        void freeItemData(VIEW_ITEM* aItem);
+
+        /// Insert the anchors of \a aItem into the snap index.
+        void insertAnchors(VIEW_ITEM* aItem);
+
+        /// Fill the (empty) snap index with the anchors of all the items, using the thread pool.
+        void rebuildSnapIndex();
+
+        /// @return true if \a aItem is drawn on a visible layer, so it can be snapped to.
+        bool isSnappable(const VIEW_ITEM* aItem) const;
+
         /// Determine rendering order of layers. Used in display order sorting function.
         static bool compareRenderingOrder(VIEW_LAYER* aI, VIEW_LAYER* aJ)
         {
@@ -830,7 +1280,7 @@ namespace KIGFX
         // Function objects that need to access VIEW/VIEW_ITEM private/protected members
         struct CLEAR_LAYER_CACHE_VISITOR;
         struct RECACHE_ITEM_VISITOR;
-        struct DRAW_ITEM_VISITOR;
+        struct CULL_ITEM_VISITOR;
         struct UPDATE_COLOR_VISITOR;
         struct UPDATE_DEPTH_VISITOR;
 
@@ -849,6 +1299,23 @@ namespace KIGFX
         /// Flat list of all items.
         std::shared_ptr<std::vector<VIEW_ITEM*>> m_allItems;
 
+        /// Storage of the VIEW_ITEM_DATA of the items added to this view.
+        std::unique_ptr<VIEW_ITEM_DATA_POOL> m_itemDataPool;
+
+        /// Anchors of the items for cursor snapping, null unless enabled (see EnableSnapIndex()).
+        std::unique_ptr<VIEW_SNAP_INDEX>   m_snapIndex;
+
+        /// Changes queued from any thread, waiting for ApplyQueuedChanges().
+        MPSC_QUEUE<QUEUED_CHANGE>          m_queuedChanges;
+
+        /// Change ApplyQueuedChanges() stopped in the middle of, and the number of its items
+        /// applied already.
+        std::optional<QUEUED_CHANGE>       m_partialChange;
+        size_t                             m_partialChangeOffset;
+
+        /// Delays disposing of the items removed by ApplyQueuedChanges() for pinned readers.
+        mutable EPOCH_RECLAIMER            m_reclaimer;
+
         /// The set of layers that are displayed on the top.
         std::set<unsigned int>             m_topLayers;
 
@@ -872,6 +1339,27 @@ namespace KIGFX
         /// Flag to mark targets as dirty so they have to be redrawn on the next refresh event.
         bool m_dirtyTargets[TARGETS_NUMBER];
 
+        /// Dirty targets that have to be redrawn whole, as opposed to their damaged area only.
+        bool m_fullRedrawTargets[TARGETS_NUMBER];
+
+        /// Changed area of each target, valid for the dirty targets that are not fully redrawn.
+        BOX2D m_damagedArea[TARGETS_NUMBER];
+
+        /// Flag to redraw only the damaged areas of the targets.
+        bool m_useDamageRedraw;
+
+        /// Flag to scroll the previous frame when the view is panned.
+        bool m_useScrollBlit;
+
+        /// Shift of the view content since the last redraw, in screen pixels.
+        VECTOR2I m_pendingScroll;
+
+        /// Sub-pixel error accumulated by scrolling since the last full redraw.
+        VECTOR2D m_scrollDrift;
+
+        /// Screen size of the cells aggregating small items, in pixels (0 if disabled).
+        double m_aggregateThreshold;
+
         /// Flag to respect draw priority when drawing items.
         bool m_useDrawPriority;
 
@@ -880,6 +1368,19 @@ namespace KIGFX
 
         /// Flag to reverse the draw order when using draw priority.
         bool m_reverseDrawOrder;
+
+        /// Number of items removed since m_allItems was last compacted.
+        int m_gcCounter;
+
+        /// True if some items are indexed with a box larger than their bbox (see UpdateBBox()).
+        bool m_hasIndexSlack;
+
+        /// Per layer draw lists of the last redraw, kept to reuse their storage.
+        std::vector<LAYER_DRAW_LIST> m_drawLists;
+
+        /// Time spent by the last redraw in the cull and GAL submission phases, in milliseconds.
+        double m_lastCullTime;
+        double m_lastSubmitTime;
     };
 } // namespace KIGFX
 
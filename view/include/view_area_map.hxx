@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <box2.hxx>
+#include <shape_line_chain.hxx>
+
+namespace KIGFX
+{
+    /**
+     * Coarse raster of a closed area, to tell in constant time whether a box is inside the
+     * area, outside of it or crosses its outline.
+     *
+     * The bounding box of the area is divided into a grid. Cells crossed by the outline are
+     * boundary cells, the others are inside or outside as a whole. Summed area tables of the
+     * inside and outside cells then tell whether a box only covers cells of one kind. Only the
+     * boxes covering boundary cells need an exact test.
+     */
+    class VIEW_AREA_MAP
+    {
+    public:
+        enum class BOX_CLASS
+        {
+            INSIDE,      ///< The box is completely inside the area.
+            OUTSIDE,     ///< The box does not touch the area.
+            CROSSING     ///< The box may cross the outline, it needs an exact test.
+        };
+
+        /**
+         * @param aArea is the area outline, taken as closed.
+         * @param aResolution is the number of cells along the longer side of the area.
+         */
+        explicit VIEW_AREA_MAP(const SHAPE_LINE_CHAIN& aArea, int aResolution = 256);
+
+        /**
+         * @return the class of the (normalized) box \a aBox.
+         */
+        BOX_CLASS Classify(const BOX2D& aBox) const;
+
+        /**
+         * @return the bounding box of the area.
+         */
+        const BOX2D& GetBBox() const
+        {
+            return m_bbox;
+        }
+
+    private:
+        enum CELL_STATE : uint8_t
+        {
+            OUTSIDE_CELL,
+            INSIDE_CELL,
+            BOUNDARY_CELL
+        };
+
+        int column(double aX) const;
+        int row(double aY) const;
+
+        /// Mark the cells crossed by the segment \a aA - \a aB as boundary cells.
+        void markSegment(const VECTOR2D& aA, const VECTOR2D& aB, std::vector<CELL_STATE>& aCells);
+
+        /// @return the number of cells counted in \a aSums in the given (inclusive) range.
+        uint32_t countCells(const std::vector<uint32_t>& aSums, int aCol0, int aRow0, int aCol1,
+                            int aRow1) const;
+
+        BOX2D  m_bbox;
+        double m_cellSize;
+        int    m_cols;
+        int    m_rows;
+
+        /// Summed area tables of the inside and outside cells, (m_cols + 1) x (m_rows + 1).
+        std::vector<uint32_t> m_insideSums;
+        std::vector<uint32_t> m_outsideSums;
+    };
+} // namespace KIGFX
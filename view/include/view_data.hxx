@@ -1,4 +1,6 @@
 #pragma once
+#include <cstddef>
+#include <memory>
 #include <vector>
 #include <unordered_map>
 #include <spdlog/spdlog.h>
@@ -9,18 +11,24 @@
 namespace KIGFX {
 
 class VIEW;
+class VIEW_ITEM_DATA_POOL;
 
 class VIEW_ITEM_DATA
 {
 public:
-    VIEW_ITEM_DATA() :
+    /**
+     * @param aPool is the pool the data is allocated from, which also stores the group ids that
+     *              do not fit in the data.
+     */
+    explicit VIEW_ITEM_DATA(VIEW_ITEM_DATA_POOL* aPool) :
         m_view(nullptr),
+        m_pool(aPool),
         m_flags(KIGFX::VISIBLE),
         m_requiredUpdate(KIGFX::NONE),
         m_drawPriority(0),
         m_cachedIndex(-1),
-        m_groups(nullptr),
-        m_groupsSize(0) {
+        m_groupsSize(0),
+        m_groupsCapacity(INLINE_GROUPS) {
     }
 
     ~VIEW_ITEM_DATA()
@@ -28,6 +36,9 @@ public:
         deleteGroups();
     }
 
+    VIEW_ITEM_DATA(const VIEW_ITEM_DATA&) = delete;
+    VIEW_ITEM_DATA& operator=(const VIEW_ITEM_DATA&) = delete;
+
     int GetFlags() const
     {
         return m_flags;
@@ -35,6 +46,27 @@ public:
 
 private:
     friend class VIEW;
+    friend class VIEW_ITEM_DATA_POOL;
+
+    /// A layer number and the group id of the item on that layer.
+    struct GROUP
+    {
+        int layer;
+        int group;
+    };
+
+    /// Number of group ids stored in the data itself. Most items lie on a few layers only.
+    static constexpr int INLINE_GROUPS = 4;
+
+    GROUP* groups()
+    {
+        return m_groupsCapacity > INLINE_GROUPS ? m_overflowGroups : m_inlineGroups;
+    }
+
+    const GROUP* groups() const
+    {
+        return m_groupsCapacity > INLINE_GROUPS ? m_overflowGroups : m_inlineGroups;
+    }
 
     /**
         * Return number of the group id for the given layer, or -1 in case it was not cached before.
@@ -44,10 +76,12 @@ private:
         */
     int getGroup(int aLayer) const
     {
+        const GROUP* groupIds = groups();
+
         for (int i = 0; i < m_groupsSize; ++i)
         {
-            if (m_groups[i].first == aLayer)
-                return m_groups[i].second;
+            if (groupIds[i].layer == aLayer)
+                return groupIds[i].group;
         }
 
         return -1;
@@ -61,27 +95,23 @@ private:
         */
     void setGroup(int aLayer, int aGroup)
     {
+        GROUP* groupIds = groups();
+
         // Look if there is already an entry for the layer
         for (int i = 0; i < m_groupsSize; ++i)
         {
-            if (m_groups[i].first == aLayer)
+            if (groupIds[i].layer == aLayer)
             {
-                m_groups[i].second = aGroup;
+                groupIds[i].group = aGroup;
                 return;
             }
         }
 
         // If there was no entry for the given layer - create one
-        std::pair<int, int>* newGroups = new std::pair<int, int>[m_groupsSize + 1];
+        if (m_groupsSize == m_groupsCapacity)
+            growGroups();
 
-        if (m_groupsSize > 0)
-        {
-            std::copy(m_groups, m_groups + m_groupsSize, newGroups);
-            delete[] m_groups;
-        }
-
-        m_groups = newGroups;
-        newGroups[m_groupsSize++] = { aLayer, aGroup };
+        groups()[m_groupsSize++] = { aLayer, aGroup };
     }
 
 
@@ -90,11 +120,25 @@ private:
         */
     void deleteGroups()
     {
-        //delete[] m_groups;
-        m_groups = nullptr;
+        if (m_groupsCapacity > INLINE_GROUPS)
+            freeOverflowGroups();
+
         m_groupsSize = 0;
+        m_groupsCapacity = INLINE_GROUPS;
     }
 
+    /// Double the room for group ids, moving them to the pool when they overflow the data.
+    void growGroups();
+
+    /// Give the group ids stored in the pool back to it.
+    void freeOverflowGroups();
+
+    /**
+     * Take over the state of \a aOther, which may come from another pool (see
+     * VIEW::SortItemsSpatially()). \a aOther keeps its group ids, to be freed with it.
+     */
+    void moveFrom(VIEW_ITEM_DATA& aOther);
+
     /**
         * Return information if the item uses at least one group id (ie. if it is cached at all).
         *
@@ -114,15 +158,17 @@ private:
         */
     void reorderGroups(std::unordered_map<int, int> aReorderMap)
     {
+        GROUP* groupIds = groups();
+
         for (int i = 0; i < m_groupsSize; ++i)
         {
-            int orig_layer = m_groups[i].first;
+            int orig_layer = groupIds[i].layer;
             int new_layer = orig_layer;
 
             if (aReorderMap.count(orig_layer))
                 new_layer = aReorderMap.at(orig_layer);
 
-            m_groups[i].first = new_layer;
+            groupIds[i].layer = new_layer;
         }
     }
 
@@ -138,10 +184,12 @@ private:
 
         for (int layer : aLayers)
         {
-            if (layer >= 0 && layer < 2048) continue;
-            else {
+            if (layer < 0 || layer >= 2048)
+            {
                 spdlog::warn(std::format("Invalid layer number: {}", layer));
+                continue;
             }
+
             m_layers.push_back(layer);
         }
     }
@@ -171,17 +219,105 @@ private:
     }
 
     VIEW* m_view;             ///< Current dynamic view the item is assigned to.
+    VIEW_ITEM_DATA_POOL* m_pool;             ///< Pool the data is allocated from.
     int                  m_flags;            ///< Visibility flags
     int                  m_requiredUpdate;   ///< Flag required for updating
     int                  m_drawPriority;     ///< Order to draw this item in a layer, lowest first
     int                  m_cachedIndex;      ///< Cached index in m_allItems.
 
-    std::pair<int, int>* m_groups;           ///< layer_number:group_id pairs for each layer the
-    ///< item occupies.
+    /// layer_number:group_id pairs for each layer the item occupies. Stored inline up to
+    /// INLINE_GROUPS layers, then in the pool.
+    union
+    {
+        GROUP            m_inlineGroups[INLINE_GROUPS];
+        GROUP*           m_overflowGroups;
+    };
+
     int                  m_groupsSize;
+    int                  m_groupsCapacity;
 
     std::vector<int>     m_layers;           /// Stores layer numbers used by the item.
 
-    BOX2I                m_bbox;             /// Cached inserted Bbox for faster removals.
+    BOX2D                m_bbox;             /// Cached item Bbox (see VIEW_ITEM::ViewBBoxD()).
+
+    /// Box the item is stored under in the layer R-trees. Equal to m_bbox, or enlarged by some
+    /// slack for items moved with VIEW::UpdateBBox(), so they can move a bit without touching
+    /// the trees. Used on removal to descend only the tree nodes covering it instead of scanning
+    /// the whole tree.
+    BOX2D                m_indexBbox;
+};
+
+/**
+ * Storage for the VIEW_ITEM_DATA of the items of a VIEW.
+ *
+ * The data is allocated in slabs and recycled through a free list, instead of one heap block
+ * per item. The group ids of items lying on more layers than VIEW_ITEM_DATA stores inline are
+ * kept here as well, in blocks of power of two sizes.
+ */
+class VIEW_ITEM_DATA_POOL
+{
+public:
+    VIEW_ITEM_DATA_POOL();
+    ~VIEW_ITEM_DATA_POOL();
+
+    VIEW_ITEM_DATA_POOL(const VIEW_ITEM_DATA_POOL&) = delete;
+    VIEW_ITEM_DATA_POOL& operator=(const VIEW_ITEM_DATA_POOL&) = delete;
+
+    /**
+     * @return a new VIEW_ITEM_DATA, to be released with Free().
+     */
+    VIEW_ITEM_DATA* Alloc();
+
+    void Free(VIEW_ITEM_DATA* aData);
+
+    /**
+     * Give the memory back to the system, if no data is in use anymore.
+     */
+    void ReleaseMemory();
+
+    /**
+     * @return the number of VIEW_ITEM_DATA in use.
+     */
+    size_t GetCount() const
+    {
+        return m_count;
+    }
+
+private:
+    friend class VIEW_ITEM_DATA;
+
+    using GROUP = VIEW_ITEM_DATA::GROUP;
+
+    union SLOT
+    {
+        SLOT* next;         ///< Next free slot, when the slot is free.
+        alignas(VIEW_ITEM_DATA) unsigned char data[sizeof(VIEW_ITEM_DATA)];
+    };
+
+    /// A free block of group ids.
+    struct FREE_GROUPS
+    {
+        FREE_GROUPS* next;
+    };
+
+    static constexpr size_t SLAB_SIZE = 1024;           ///< VIEW_ITEM_DATA per slab.
+    static constexpr size_t GROUP_CHUNK_SIZE = 4096;    ///< Group ids per chunk.
+    static constexpr int    MIN_GROUP_BLOCK = 8;        ///< Smallest block of group ids.
+
+    /// @return the index of the free list of blocks of \a aCapacity group ids.
+    static int groupsClass(int aCapacity);
+
+    GROUP* allocGroups(int aCapacity);
+    void freeGroups(GROUP* aGroups, int aCapacity);
+
+    std::vector<std::unique_ptr<SLOT[]>>  m_slabs;
+    size_t                                m_slabUsed;      ///< Slots used in the last slab.
+    SLOT*                                 m_freeSlots;
+    size_t                                m_count;
+
+    std::vector<std::unique_ptr<GROUP[]>> m_groupChunks;
+    size_t                                m_groupChunkUsed;  ///< Group ids used in the last chunk.
+    size_t                                m_groupChunkSize;  ///< Size of the last chunk.
+    std::vector<FREE_GROUPS*>             m_freeGroups;      ///< Free blocks per size class.
 };
 }
\ No newline at end of file
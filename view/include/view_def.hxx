@@ -26,4 +26,18 @@ enum VIEW_VISIBILITY_FLAGS {
     HIDDEN = 0x02,
     OVERLAY_HIDDEN = 0x04   ///< Item is temporarily hidden from being drawn on an overlay.
 };
+
+/**
+    * Define the spatial index used by a VIEW layer (see VIEW::SetLayerIndex()).
+    */
+enum class VIEW_INDEX_TYPE {
+    RTREE_QUADRATIC,     ///< R-tree with quadratic node splits (default).
+    RTREE_LINEAR,        ///< R-tree with linear node splits: cheaper inserts, slower queries.
+    RTREE_RSTAR,         ///< R*-tree: slower inserts, best query performance.
+    HASH_GRID,           ///< Uniform hash grid, for dense layers and frequently moving items.
+    QUADTREE,            ///< Loose quadtree, no rebalancing on insertion or removal.
+    LINEAR_SCAN,         ///< Flat arrays scanned on every query, for small layers.
+    PACKED_RTREE         ///< R-tree packed into flat arrays: fastest to build, can be loaded from
+                         ///< an index snapshot; changes go to a small dynamic R-tree.
+};
 }
\ No newline at end of file
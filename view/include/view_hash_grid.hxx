@@ -0,0 +1,218 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "view_index_base.hxx"
+
+namespace KIGFX
+{
+    /**
+     * Non-owning uniform hash grid indexing VIEW items.
+     *
+     * The plane is divided into square cells, and each item is stored in every cell its box
+     * touches. Only the occupied cells are allocated. Insertion and removal are O(1) for items
+     * spanning a few cells, which makes the grid a good fit for densely populated layers of
+     * similarly sized items, and for layers whose items move every frame. Items spanning many
+     * cells are kept in a separate list that is checked by every query.
+     */
+    class VIEW_HASH_GRID
+    {
+    public:
+        /**
+         * @param aCellSize is the size of the grid cells, in world units. With 0, it is
+         *                  chosen from the size and density of the first items inserted.
+         */
+        explicit VIEW_HASH_GRID(double aCellSize = 0.0);
+
+        /**
+         * Insert an item into the grid.
+         */
+        void Insert(VIEW_ITEM* aItem, const BOX2D& aBbox);
+
+        /**
+         * Insert a batch of items.
+         *
+         * @param aEntries are the box/item pairs to insert. The vector is consumed.
+         */
+        void BulkLoad(std::vector<VIEW_INDEX_ENTRY>& aEntries);
+
+        /**
+         * Remove an item from the grid.
+         *
+         * @param aBbox is the box the item was inserted with, so only the cells it touches have
+         *              to be searched. Without it, the whole grid is scanned.
+         * @return true if the item was found and removed.
+         */
+        bool Remove(VIEW_ITEM* aItem, const BOX2D* aBbox);
+
+        /**
+         * Execute a function object \a aVisitor for each item whose bounding box intersects
+         * with \a aBounds. Each item is visited once, even if it spans several cells.
+         *
+         * @return false if the query was stopped by the visitor, true otherwise.
+         */
+        template <class Visitor>
+        bool Query(const BOX2D& aBounds, Visitor& aVisitor) const;
+
+        /**
+         * Append all items whose bounding box intersects with \a aBounds to \a aResult.
+         *
+         * @return the number of items appended.
+         */
+        size_t Query(const BOX2D& aBounds, std::vector<VIEW_ITEM*>& aResult) const
+        {
+            const size_t prevSize = aResult.size();
+            auto         collect = [&](VIEW_ITEM* aItem) { aResult.push_back(aItem); };
+
+            Query(aBounds, collect);
+
+            return aResult.size() - prevSize;
+        }
+
+        /**
+         * Remove all items. With an automatic cell size, it is chosen again for the next items.
+         */
+        void RemoveAll();
+
+        size_t Size() const
+        {
+            return m_count;
+        }
+
+        double GetCellSize() const
+        {
+            return m_cellSize;
+        }
+
+    private:
+        struct ENTRY
+        {
+            double     minX, minY, maxX, maxY;
+            VIEW_ITEM* item;
+
+            bool Intersects(double aMinX, double aMinY, double aMaxX, double aMaxY) const
+            {
+                return minX <= aMaxX && maxX >= aMinX && minY <= aMaxY && maxY >= aMinY;
+            }
+        };
+
+        /// Range of cells covered by a box, inclusive.
+        struct CELL_RANGE
+        {
+            int32_t x0, y0, x1, y1;
+
+            double Count() const
+            {
+                return (double(x1) - x0 + 1) * (double(y1) - y0 + 1);
+            }
+        };
+
+        /// Items covering more cells than this go to m_oversized.
+        static constexpr double MAX_ITEM_CELLS = 64;
+
+        int32_t cellCoord(double aValue) const;
+
+        CELL_RANGE cellRange(double aMinX, double aMinY, double aMaxX, double aMaxY) const
+        {
+            return { cellCoord(aMinX), cellCoord(aMinY), cellCoord(aMaxX), cellCoord(aMaxY) };
+        }
+
+        static uint64_t cellKey(int32_t aX, int32_t aY)
+        {
+            return (uint64_t(uint32_t(aX)) << 32) | uint32_t(aY);
+        }
+
+        static ENTRY makeEntry(VIEW_ITEM* aItem, const BOX2D& aBbox);
+
+        /// Pick a cell size suiting the size and spread of \a aEntries.
+        void chooseCellSize(const std::vector<VIEW_INDEX_ENTRY>& aEntries);
+
+        void insert(const ENTRY& aEntry);
+
+        /// Visit the entries of one cell that intersect the query, skipping items that will be
+        /// (or were) visited from another cell.
+        template <class Visitor>
+        bool queryCell(const std::vector<ENTRY>& aCell, int32_t aX, int32_t aY,
+                       const ENTRY& aQuery, Visitor& aVisitor) const
+        {
+            for (const ENTRY& entry : aCell)
+            {
+                if (!entry.Intersects(aQuery.minX, aQuery.minY, aQuery.maxX, aQuery.maxY))
+                    continue;
+
+                // An item spanning several cells is only reported from the cell containing the
+                // top-left corner of its intersection with the query box
+                if (cellCoord(std::max(entry.minX, aQuery.minX)) != aX
+                        || cellCoord(std::max(entry.minY, aQuery.minY)) != aY)
+                    continue;
+
+                if (!VisitIndexItem(aVisitor, entry.item))
+                    return false;
+            }
+
+            return true;
+        }
+
+        std::unordered_map<uint64_t, std::vector<ENTRY>> m_cells;
+        std::vector<ENTRY>                               m_oversized;
+        size_t                                           m_count;
+        double                                           m_cellSize;
+        double                                           m_invCellSize;
+        bool                                             m_autoCellSize;
+    };
+
+
+    template <class Visitor>
+    bool VIEW_HASH_GRID::Query(const BOX2D& aBounds, Visitor& aVisitor) const
+    {
+        if (m_count == 0)
+            return true;
+
+        BOX2D bounds = aBounds;
+        bounds.Normalize();
+
+        const ENTRY      query = makeEntry(nullptr, bounds);
+        const CELL_RANGE range = cellRange(query.minX, query.minY, query.maxX, query.maxY);
+
+        if (range.Count() > double(m_cells.size()))
+        {
+            // Large query: cheaper to go through the occupied cells than through the range
+            for (const auto& [key, cell] : m_cells)
+            {
+                const int32_t x = int32_t(uint32_t(key >> 32));
+                const int32_t y = int32_t(uint32_t(key));
+
+                if (x < range.x0 || x > range.x1 || y < range.y0 || y > range.y1)
+                    continue;
+
+                if (!queryCell(cell, x, y, query, aVisitor))
+                    return false;
+            }
+        }
+        else
+        {
+            for (int32_t y = range.y0; y <= range.y1; ++y)
+            {
+                for (int32_t x = range.x0; x <= range.x1; ++x)
+                {
+                    auto it = m_cells.find(cellKey(x, y));
+
+                    if (it != m_cells.end() && !queryCell(it->second, x, y, query, aVisitor))
+                        return false;
+                }
+            }
+        }
+
+        for (const ENTRY& entry : m_oversized)
+        {
+            if (entry.Intersects(query.minX, query.minY, query.maxX, query.maxY)
+                    && !VisitIndexItem(aVisitor, entry.item))
+                return false;
+        }
+
+        return true;
+    }
+} // namespace KIGFX
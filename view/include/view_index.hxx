@@ -0,0 +1,197 @@
+#pragma once
+
+#include <limits>
+#include <unordered_set>
+#include <variant>
+
+#include "view_def.hxx"
+#include "view_rtree.hxx"
+#include "view_hash_grid.hxx"
+#include "view_quadtree.hxx"
+#include "view_linear_index.hxx"
+#include "view_packed_rtree.hxx"
+
+namespace KIGFX
+{
+    /**
+     * Spatial index of the items on a VIEW layer.
+     *
+     * Forwards to one of the index implementations, selected with #VIEW_INDEX_TYPE. All of
+     * them provide the same operations; dispatch happens once per call (not per item), so
+     * query visitors are still inlined into each implementation.
+     */
+    class VIEW_INDEX
+    {
+    public:
+        explicit VIEW_INDEX(VIEW_INDEX_TYPE aType = VIEW_INDEX_TYPE::RTREE_QUADRATIC)
+        {
+            SetType(aType);
+        }
+
+        VIEW_INDEX_TYPE GetType() const
+        {
+            return static_cast<VIEW_INDEX_TYPE>(m_index.index());
+        }
+
+        /**
+         * Switch to another index implementation. The index is emptied; items have to be
+         * inserted again.
+         */
+        void SetType(VIEW_INDEX_TYPE aType)
+        {
+            switch (aType)
+            {
+            case VIEW_INDEX_TYPE::RTREE_QUADRATIC: m_index.emplace<VIEW_RTREE>();        break;
+            case VIEW_INDEX_TYPE::RTREE_LINEAR:    m_index.emplace<VIEW_RTREE_LINEAR>(); break;
+            case VIEW_INDEX_TYPE::RTREE_RSTAR:     m_index.emplace<VIEW_RTREE_RSTAR>();  break;
+            case VIEW_INDEX_TYPE::HASH_GRID:       m_index.emplace<VIEW_HASH_GRID>();    break;
+            case VIEW_INDEX_TYPE::QUADTREE:        m_index.emplace<VIEW_QUADTREE>();     break;
+            case VIEW_INDEX_TYPE::LINEAR_SCAN:     m_index.emplace<VIEW_LINEAR_INDEX>(); break;
+            case VIEW_INDEX_TYPE::PACKED_RTREE:    m_index.emplace<VIEW_PACKED_RTREE>(); break;
+            }
+        }
+
+        /**
+         * Insert an item under the box \a aBbox.
+         */
+        void Insert(VIEW_ITEM* aItem, const BOX2D& aBbox)
+        {
+            std::visit([&](auto& aIndex) { aIndex.Insert(aItem, aBbox); }, m_index);
+        }
+
+        /**
+         * Switch to a packed R-tree using arrays stored elsewhere, typically in a mapped index
+         * snapshot (see VIEW_PACKED_RTREE::Attach()). The items already in the index are dropped.
+         */
+        void AttachPacked(const VIEW_PACKED_RTREE::ARRAYS& aArrays, VIEW_ITEM* const* aItems,
+                          std::shared_ptr<const void> aStorage)
+        {
+            m_index.emplace<VIEW_PACKED_RTREE>().Attach(aArrays, aItems, std::move(aStorage));
+        }
+
+        /**
+         * Insert a batch of items. Depending on the implementation this is much faster than
+         * inserting them one by one (see VIEW_RTREE_BASE::BulkLoad()).
+         *
+         * @param aEntries are the box/item pairs to insert. The vector is consumed.
+         */
+        void BulkLoad(std::vector<VIEW_INDEX_ENTRY>& aEntries)
+        {
+            std::visit([&](auto& aIndex) { aIndex.BulkLoad(aEntries); }, m_index);
+        }
+
+        /**
+         * Remove an item.
+         *
+         * @param aBbox is the box the item was inserted with, if known; it speeds up the lookup.
+         * @return true if the item was found and removed.
+         */
+        bool Remove(VIEW_ITEM* aItem, const BOX2D* aBbox)
+        {
+            return std::visit([&](auto& aIndex) { return aIndex.Remove(aItem, aBbox); }, m_index);
+        }
+
+        /**
+         * Execute a function object \a aVisitor for each item whose bounding box intersects
+         * with \a aBounds. If the visitor returns a bool, returning false stops the query.
+         *
+         * @return false if the query was stopped by the visitor, true otherwise.
+         */
+        template <class Visitor>
+        bool Query(const BOX2D& aBounds, Visitor& aVisitor) const
+        {
+            return std::visit([&](const auto& aIndex) { return aIndex.Query(aBounds, aVisitor); },
+                              m_index);
+        }
+
+        /**
+         * Append all items whose bounding box intersects with \a aBounds to \a aResult.
+         *
+         * @return the number of items appended.
+         */
+        size_t Query(const BOX2D& aBounds, std::vector<VIEW_ITEM*>& aResult) const
+        {
+            return std::visit([&](const auto& aIndex) { return aIndex.Query(aBounds, aResult); },
+                              m_index);
+        }
+
+        /**
+         * Execute a function object \a aVisitor(item, distance) for the items in increasing order
+         * of the distance between \a aPoint and their box, until the visitor returns false.
+         *
+         * The R-trees have a best first search (see VIEW_RTREE_BASE::Nearest()). The other
+         * implementations fall back to window queries of growing size, and report the items
+         * ring by ring with the inner radius of their ring as distance. Either way the distance
+         * is a lower bound of the distance to the box, and never decreases between calls.
+         *
+         * @param aMaxDistance is the distance beyond which items are not needed. The windows stop
+         *                     growing once they cover it; the visitor has to stop the best first
+         *                     search itself. Items farther away may still be reported.
+         * @return false if the search was stopped by the visitor, true otherwise.
+         */
+        template <class Visitor>
+        bool Nearest(const VECTOR2D& aPoint, Visitor& aVisitor,
+                     double aMaxDistance = std::numeric_limits<double>::max()) const
+        {
+            return std::visit(
+                    [&](const auto& aIndex)
+                    {
+                        if constexpr (requires { aIndex.Nearest(aPoint, aVisitor); })
+                            return aIndex.Nearest(aPoint, aVisitor);
+                        else
+                            return nearestByWindows(aIndex, aPoint, aVisitor, aMaxDistance);
+                    }, m_index);
+        }
+
+        void RemoveAll()
+        {
+            std::visit([](auto& aIndex) { aIndex.RemoveAll(); }, m_index);
+        }
+
+        size_t Size() const
+        {
+            return std::visit([](const auto& aIndex) { return aIndex.Size(); }, m_index);
+        }
+
+    private:
+        template <class Index, class Visitor>
+        static bool nearestByWindows(const Index& aIndex, const VECTOR2D& aPoint, Visitor& aVisitor,
+                                     double aMaxDistance)
+        {
+            std::unordered_set<VIEW_ITEM*> visited;
+            std::vector<VIEW_ITEM*>        found;
+            double                         inner = 0.0;
+
+            // Items are in integer coordinates, the last window covers everything
+            for (double radius = 1.0; visited.size() < aIndex.Size(); radius *= 4.0)
+            {
+                BOX2D window(aPoint - VECTOR2D(radius, radius), VECTOR2D(2 * radius, 2 * radius));
+
+                if (radius > std::numeric_limits<int>::max())
+                    window.SetMaximum();
+
+                found.clear();
+                aIndex.Query(window, found);
+
+                // The items met for the first time are outside of the previous window
+                for (VIEW_ITEM* item : found)
+                {
+                    if (visited.insert(item).second && !aVisitor(item, inner))
+                        return false;
+                }
+
+                // The window contains every box within aMaxDistance of the point
+                if (radius > std::numeric_limits<int>::max() || radius >= aMaxDistance)
+                    break;
+
+                inner = radius;
+            }
+
+            return true;
+        }
+
+        /// Alternatives in the same order as VIEW_INDEX_TYPE.
+        std::variant<VIEW_RTREE, VIEW_RTREE_LINEAR, VIEW_RTREE_RSTAR, VIEW_HASH_GRID,
+                     VIEW_QUADTREE, VIEW_LINEAR_INDEX, VIEW_PACKED_RTREE> m_index;
+    };
+} // namespace KIGFX
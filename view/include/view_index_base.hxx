@@ -0,0 +1,35 @@
+#pragma once
+
+#include <type_traits>
+#include <utility>
+
+#include <box2.hxx>
+
+namespace KIGFX
+{
+    class VIEW_ITEM;
+
+    /// An item together with the box it is indexed under, as passed to the layer indices.
+    using VIEW_INDEX_ENTRY = std::pair<BOX2D, VIEW_ITEM*>;
+
+    /**
+     * Call a layer index query visitor for \a aItem.
+     *
+     * Visitors either return void, or a bool where false stops the query.
+     *
+     * @return false if the query has to be stopped.
+     */
+    template <class Visitor>
+    inline bool VisitIndexItem(Visitor& aVisitor, VIEW_ITEM* aItem)
+    {
+        if constexpr (std::is_void_v<std::invoke_result_t<Visitor&, VIEW_ITEM*>>)
+        {
+            aVisitor(aItem);
+            return true;
+        }
+        else
+        {
+            return aVisitor(aItem);
+        }
+    }
+} // namespace KIGFX
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <hash_128.hxx>
+#include "view_packed_rtree.hxx"
+
+namespace KIGFX
+{
+    /**
+     * Binary snapshot of the spatial indexes of a VIEW, to open a design again without building
+     * them (see VIEW::SaveIndexSnapshot() and VIEW::LoadIndexSnapshot()).
+     *
+     * The snapshot stores, for a list of items given by the caller, the order of the items in the
+     * view, their draw priorities, boxes and layers, and a packed R-tree per layer (see
+     * VIEW_PACKED_RTREE). Items are referred to by their number in the list, so the snapshot is
+     * valid as long as the caller lists the same items in the same order, which the content hash
+     * it is keyed with stands for.
+     *
+     * The file is memory mapped and its arrays are used in place; the whole file is checked for
+     * consistency when opened, so a truncated or corrupted file is rejected rather than read out
+     * of bounds.
+     */
+    class VIEW_INDEX_SNAPSHOT
+    {
+    public:
+        /// Content of a snapshot, gathered before writing it.
+        struct CONTENT
+        {
+            std::vector<uint32_t> order;          ///< Item numbers in the order of the view.
+            std::vector<int32_t>  priorities;     ///< Draw priority of each item.
+            std::vector<double>   boxes;          ///< Min x, min y, max x, max y of each item.
+            std::vector<uint32_t> layerOffsets;   ///< Start of the layers of each item, and end.
+            std::vector<int32_t>  layers;         ///< Layers of all the items.
+
+            /// Layer number and packed tree of each layer.
+            std::vector<std::pair<int, VIEW_PACKED_RTREE::PACKED_ARRAYS>> trees;
+        };
+
+        /// Packed tree of a layer in a mapped snapshot.
+        struct LAYER_TREE
+        {
+            int                       layer;
+            VIEW_PACKED_RTREE::ARRAYS tree;
+        };
+
+        /**
+         * Write a snapshot.
+         *
+         * @return false if the file could not be written.
+         */
+        static bool Write(const std::string& aPath, const HASH_128& aContentHash,
+                          const CONTENT& aContent);
+
+        /**
+         * Map a snapshot.
+         *
+         * @param aContentHash is the hash of the content the snapshot must have been written for.
+         * @param aItemCount is the number of items it must describe.
+         * @return the snapshot, or null if the file is missing, stale or not a valid snapshot.
+         */
+        static std::shared_ptr<VIEW_INDEX_SNAPSHOT> Open(const std::string& aPath,
+                                                         const HASH_128& aContentHash,
+                                                         size_t aItemCount);
+
+        size_t GetItemCount() const
+        {
+            return m_itemCount;
+        }
+
+        const uint32_t* Order() const { return m_order; }
+        const int32_t* Priorities() const { return m_priorities; }
+        const double* Boxes() const { return m_boxes; }
+        const uint32_t* LayerOffsets() const { return m_layerOffsets; }
+        const int32_t* Layers() const { return m_layers; }
+
+        const std::vector<LAYER_TREE>& GetTrees() const
+        {
+            return m_trees;
+        }
+
+        /**
+         * Keep the items the snapshot is used for, for the layer trees to refer to.
+         */
+        void SetItems(std::vector<VIEW_ITEM*> aItems)
+        {
+            m_items = std::move(aItems);
+        }
+
+        VIEW_ITEM* const* Items() const
+        {
+            return m_items.data();
+        }
+
+    private:
+        /// Check the layout of the mapped file and set up the pointers to its arrays.
+        bool parse(const HASH_128& aContentHash, size_t aItemCount);
+
+        boost::interprocess::file_mapping  m_file;
+        boost::interprocess::mapped_region m_region;
+
+        size_t                  m_itemCount = 0;
+        const uint32_t*         m_order = nullptr;
+        const int32_t*          m_priorities = nullptr;
+        const double*           m_boxes = nullptr;
+        const uint32_t*         m_layerOffsets = nullptr;
+        const int32_t*          m_layers = nullptr;
+        std::vector<LAYER_TREE> m_trees;
+
+        std::vector<VIEW_ITEM*> m_items;
+    };
+} // namespace KIGFX
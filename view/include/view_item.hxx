@@ -1,20 +1,47 @@
 #pragma once
 
+#include <algorithm>
 #include <bitset>
+#include <cmath>
 #include <vector>
 #include <limits>
 #include <numeric>
 
 #include <gal/include/gal.hxx>
 #include <box2.hxx>
+#include <seg.hxx>
 #include "view_data.hxx"
 
+class SHAPE_LINE_CHAIN;
+
 namespace KIGFX
 {
     // Forward declarations
     class VIEW;
 
 
+    /**
+     * Kind of a point the cursor can snap to. When several anchors are as close to the cursor,
+     * the first kind wins.
+     */
+    enum class VIEW_ANCHOR_TYPE : uint8_t
+    {
+        ENDPOINT,
+        CORNER,
+        CENTER,
+        MIDPOINT,
+        INTERSECTION    ///< Crossing of the edges of two items, found while snapping.
+    };
+
+
+    /// A point the cursor can snap to, see VIEW_ITEM::ViewGetAnchors().
+    struct VIEW_ANCHOR
+    {
+        VECTOR2D         point;
+        VIEW_ANCHOR_TYPE type;
+    };
+
+
     /**
      * An abstract base class for deriving all objects that can be added to a VIEW.
      *
@@ -57,6 +84,80 @@ namespace KIGFX
          */
         virtual const BOX2I ViewBBox() const = 0;
 
+        /**
+         * Return the bounding box of the item covering all its layers, in double precision.
+         *
+         * This is the box the #VIEW indexes the item with. Items with floating point geometry
+         * should override it, so that sub-unit items keep their real extent at high zoom levels.
+         * The default implementation converts ViewBBox().
+         *
+         * VIEW::UpdateItems() calls it from several threads at once when it rebuilds the layer
+         * indexes, so it must not modify shared state. The same goes for ViewGetLayers().
+         *
+         * @return the current bounding box.
+         */
+        virtual const BOX2D ViewBBoxD() const
+        {
+            const BOX2I bbox = ViewBBox();
+
+            return BOX2D(bbox.GetOrigin(), bbox.GetSize());
+        }
+
+        /**
+         * Return the distance between \a aPoint and the shape of the item, 0 if the point lies
+         * on or inside it.
+         *
+         * VIEW::HitTest() and VIEW::Nearest() select candidates with their bounding box and
+         * use this for the exact test, so the result must not be smaller than the distance to
+         * ViewBBoxD(). The default implementation returns the distance to the bounding box;
+         * items that do not fill their box should override it.
+         *
+         * Like ViewBBoxD(), it may be called from several threads at once.
+         */
+        virtual double ViewHitDistance(const VECTOR2D& aPoint) const
+        {
+            BOX2D bbox = ViewBBoxD();
+            bbox.Normalize();
+
+            const double dx = std::max({ bbox.GetLeft() - aPoint.x, 0.0, aPoint.x - bbox.GetRight() });
+            const double dy = std::max({ bbox.GetTop() - aPoint.y, 0.0, aPoint.y - bbox.GetBottom() });
+
+            return std::hypot(dx, dy);
+        }
+
+        /**
+         * Test the shape of the item against a lasso or selection window (see VIEW::Select()).
+         *
+         * Only called for items whose bounding box crosses the outline of the area. The default
+         * implementation tests the bounding box as a filled rectangle.
+         *
+         * Like ViewBBoxD(), it may be called from several threads at once.
+         *
+         * @param aArea is the closed outline of the area.
+         * @param aContained is true to test if the item is completely inside the area, false to
+         *                   test if it touches the area.
+         */
+        virtual bool ViewHitTest(const SHAPE_LINE_CHAIN& aArea, bool aContained) const;
+
+        /**
+         * Append the points the cursor can snap to (see VIEW::GetSnapAnchor()) to \a aAnchors.
+         *
+         * The anchors must lie within ViewBBoxD(): the VIEW looks them up with that box when the
+         * item changes. Like ViewBBoxD(), it may be called from several threads at once. The
+         * default implementation has no anchors.
+         */
+        virtual void ViewGetAnchors(std::vector<VIEW_ANCHOR>& aAnchors) const
+        {
+        }
+
+        /**
+         * Append the straight edges of the item to \a aEdges, to snap to the intersections of
+         * items. The default implementation has no edges.
+         */
+        virtual void ViewGetEdges(std::vector<SEG>& aEdges) const
+        {
+        }
+
         /**
          * Draw the parts of the object belonging to layer aLayer.
          *
@@ -92,6 +193,9 @@ namespace KIGFX
          * Use @ref lodScaleForThreshold() to calculate the LOD scale for when the item
          * passes a certain threshold size on screen.
          *
+         * The VIEW calls it from several threads at once while culling layers, so it must not
+         * modify shared state.
+         *
          * @param aLayer is the current drawing layer.
          * @param aView is a pointer to the #VIEW device we are drawing on.
          * @return the level of detail. 0 always shows the item, because the actual zoom level
@@ -146,6 +250,15 @@ namespace KIGFX
          */
         static double lodScaleForThreshold(const KIGFX::VIEW* aView, int aWhatIu, int aThresholdIu);
 
+        /**
+         * Test a polyline against a closed area, see ViewHitTest().
+         *
+         * @param aPoints are the vertices of the polyline.
+         * @param aFilled is true if the polyline is the (closed) outline of a filled shape.
+         */
+        static bool hitTestPolyline(const SHAPE_LINE_CHAIN& aArea, bool aContained,
+                                    const std::vector<VECTOR2I>& aPoints, bool aFilled);
+
     private:
         friend class VIEW;
 
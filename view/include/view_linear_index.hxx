@@ -0,0 +1,116 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "view_index_base.hxx"
+
+namespace KIGFX
+{
+    /**
+     * Non-owning flat index of VIEW items, queried by scanning every item.
+     *
+     * The boxes are kept as a structure of arrays, so a query is a tight loop over contiguous
+     * coordinates that the compiler turns into SIMD compares. For small layers (overlays,
+     * selection, a few hundred items) this beats walking any tree, and insertion and removal
+     * involve no rebalancing at all.
+     */
+    class VIEW_LINEAR_INDEX
+    {
+    public:
+        /**
+         * Insert an item into the index.
+         */
+        void Insert(VIEW_ITEM* aItem, const BOX2D& aBbox);
+
+        /**
+         * Insert a batch of items.
+         *
+         * @param aEntries are the box/item pairs to insert. The vector is consumed.
+         */
+        void BulkLoad(std::vector<VIEW_INDEX_ENTRY>& aEntries);
+
+        /**
+         * Remove an item from the index. The box is not needed to find it.
+         *
+         * @return true if the item was found and removed.
+         */
+        bool Remove(VIEW_ITEM* aItem, const BOX2D* aBbox);
+
+        /**
+         * Execute a function object \a aVisitor for each item whose bounding box intersects
+         * with \a aBounds.
+         *
+         * @return false if the query was stopped by the visitor, true otherwise.
+         */
+        template <class Visitor>
+        bool Query(const BOX2D& aBounds, Visitor& aVisitor) const
+        {
+            constexpr size_t BLOCK = 256;
+
+            BOX2D bounds = aBounds;
+            bounds.Normalize();
+
+            const double qMinX = bounds.GetLeft();
+            const double qMinY = bounds.GetTop();
+            const double qMaxX = bounds.GetRight();
+            const double qMaxY = bounds.GetBottom();
+            const size_t count = m_items.size();
+            int64_t      hits[BLOCK];
+
+            for (size_t start = 0; start < count; start += BLOCK)
+            {
+                const size_t  n = std::min(BLOCK, count - start);
+                const double* minX = m_minX.data() + start;
+                const double* minY = m_minY.data() + start;
+                const double* maxX = m_maxX.data() + start;
+                const double* maxY = m_maxY.data() + start;
+
+                // Branch-free compare pass, vectorized by the compiler
+                for (size_t i = 0; i < n; ++i)
+                {
+                    hits[i] = (minX[i] <= qMaxX) & (maxX[i] >= qMinX)
+                              & (minY[i] <= qMaxY) & (maxY[i] >= qMinY);
+                }
+
+                for (size_t i = 0; i < n; ++i)
+                {
+                    if (hits[i] && !VisitIndexItem(aVisitor, m_items[start + i]))
+                        return false;
+                }
+            }
+
+            return true;
+        }
+
+        /**
+         * Append all items whose bounding box intersects with \a aBounds to \a aResult.
+         *
+         * @return the number of items appended.
+         */
+        size_t Query(const BOX2D& aBounds, std::vector<VIEW_ITEM*>& aResult) const
+        {
+            const size_t prevSize = aResult.size();
+            auto         collect = [&](VIEW_ITEM* aItem) { aResult.push_back(aItem); };
+
+            Query(aBounds, collect);
+
+            return aResult.size() - prevSize;
+        }
+
+        void RemoveAll();
+
+        size_t Size() const
+        {
+            return m_items.size();
+        }
+
+    private:
+        std::vector<double>     m_minX;
+        std::vector<double>     m_minY;
+        std::vector<double>     m_maxX;
+        std::vector<double>     m_maxY;
+        std::vector<VIEW_ITEM*> m_items;
+    };
+} // namespace KIGFX
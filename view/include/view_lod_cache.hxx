@@ -0,0 +1,204 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+#include "view_rtree.hxx"
+
+namespace KIGFX
+{
+    /// Items of a VIEW_LOD_CACHE cell, drawn as one quad.
+    struct VIEW_LOD_CELL
+    {
+        BOX2D  bbox;        ///< Bounding box of the items.
+        double coverage;    ///< Fraction of the bounding box covered by the items.
+    };
+
+
+    /**
+     * Aggregated level of detail of the items of a VIEW layer, for zoomed out views.
+     *
+     * The layer is divided in square cells. Items smaller than a cell are binned into the cell
+     * holding their center, and each occupied cell is drawn as a single quad instead of its
+     * items. Larger items are kept in an R-tree of their own and drawn one by one. With a cell
+     * size that follows the zoom, the number of draws is bounded by the number of cells on the
+     * screen rather than by the number of items.
+     *
+     * The VIEW fills the cache for a given cell size. Afterwards, item changes only mark the
+     * cells they touch, which are refilled before the next use (see Update() and Refill()).
+     * The cache is filled from scratch when another cell size is needed.
+     */
+    class VIEW_LOD_CACHE
+    {
+    public:
+        VIEW_LOD_CACHE();
+
+        /**
+         * Mark the whole cache as outdated.
+         */
+        void Invalidate()
+        {
+            m_valid = false;
+        }
+
+        /**
+         * @return true if the cache can be used for cells of \a aCellSize, possibly after a
+         * Refill().
+         */
+        bool IsValid(double aCellSize) const
+        {
+            // Smaller cells have even fewer small items, so a layer not worth aggregating
+            // stays that way when zooming in
+            return m_valid && (aCellSize == m_cellSize || (!m_aggregating && aCellSize < m_cellSize));
+        }
+
+        /**
+         * @return true if enough items are smaller than a cell for the aggregation to pay off.
+         * Otherwise the layer has to be drawn as usual.
+         */
+        bool IsAggregating() const
+        {
+            return m_aggregating;
+        }
+
+        /**
+         * Empty the cache, and start filling it for cells of \a aCellSize.
+         *
+         * @param aItemCount is the expected number of items, to reserve memory.
+         */
+        void Begin(double aCellSize, size_t aItemCount = 0);
+
+        /**
+         * Add an item to draw, binned into a cell or kept as a large item depending on its size.
+         * Has to be called between Begin() and End(), or from a Refill() query.
+         *
+         * @param aCanAggregate is false to always keep the item as a large one.
+         */
+        void Add(VIEW_ITEM* aItem, const BOX2D& aBbox, bool aCanAggregate = true);
+
+        /**
+         * Finish filling the cache.
+         */
+        void End();
+
+        /**
+         * Account for an item added, moved or removed since the cache was filled.
+         *
+         * Large items are updated right away, the cells are only marked for the next Refill().
+         *
+         * @param aOldBbox is the previous box of the item, nullptr if it has just been added.
+         * @param aNewBbox is the new box of the item, nullptr if it has been removed.
+         * @param aCanAggregate is false to keep the item as a large one (see Add()).
+         * @return the area where the drawn cells may change, invalid if none.
+         */
+        BOX2D Update(VIEW_ITEM* aItem, const BOX2D* aOldBbox, const BOX2D* aNewBbox,
+                     bool aCanAggregate);
+
+        /**
+         * @return true if cells have been changed by Update() and need a Refill().
+         */
+        bool NeedsRefill() const
+        {
+            return !m_dirtyCells.empty();
+        }
+
+        /**
+         * Rebuild the cells changed by Update().
+         *
+         * @param aQuery is called with the area around each changed cell, and has to call Add()
+         *               for every item intersecting with that area.
+         */
+        void Refill(const std::function<void(const BOX2D&)>& aQuery);
+
+        /**
+         * Append the cells intersecting with \a aBounds to \a aCells, and execute a function
+         * object \a aVisitor for each large item whose bounding box intersects with \a aBounds.
+         *
+         * The cell pointers stay valid until the cache is filled or refilled.
+         */
+        template <class Visitor>
+        void Query(const BOX2D& aBounds, std::vector<const VIEW_LOD_CELL*>& aCells,
+                   Visitor& aVisitor) const
+        {
+            queryCells(aBounds, aCells);
+            m_largeItems.Query(aBounds, aVisitor);
+        }
+
+        size_t GetCellCount() const
+        {
+            return m_cells.size();
+        }
+
+    private:
+        using CELL_KEY = VECTOR2<int64_t>;    ///< Column and row of a cell.
+
+        struct CELL_KEY_HASH
+        {
+            size_t operator()(const CELL_KEY& aKey) const
+            {
+                return std::hash<int64_t>()(aKey.x * 0x9E3779B97F4A7C15LL ^ aKey.y);
+            }
+        };
+
+        /// An item binned into a cell.
+        struct SMALL_ENTRY
+        {
+            CELL_KEY cell;
+            BOX2D    bbox;
+        };
+
+        /// @return true if an item with the (normalized) box \a aBbox goes into a cell.
+        bool isSmall(const BOX2D& aBbox) const
+        {
+            return aBbox.GetWidth() <= m_cellSize && aBbox.GetHeight() <= m_cellSize;
+        }
+
+        /// @return the cell holding \a aPoint. Items go into the cell holding their center.
+        CELL_KEY cellKey(const VECTOR2D& aPoint) const;
+
+        /// @return the area covered by the items of cell \a aKey, at most.
+        BOX2D cellArea(const CELL_KEY& aKey) const;
+
+        void queryCells(const BOX2D& aBounds, std::vector<const VIEW_LOD_CELL*>& aCells) const;
+
+        /// Add the (normalized) box \a aBbox to the cell \a aCell. Coverage holds the summed
+        /// item areas until the cell is complete.
+        static void addToCell(VIEW_LOD_CELL& aCell, const BOX2D& aBbox);
+
+        /// Turn the summed item areas of a complete cell into its coverage.
+        static void finishCell(VIEW_LOD_CELL& aCell);
+
+        /// Items being binned, only used between Begin() and End().
+        std::vector<SMALL_ENTRY> m_smallEntries;
+
+        /// Large items being collected, only used between Begin() and End().
+        std::vector<VIEW_INDEX_ENTRY> m_largeEntries;
+
+        /// Range of the cells holding items, only used between Begin() and End().
+        CELL_KEY m_minCell;
+        CELL_KEY m_maxCell;
+
+        std::vector<VIEW_LOD_CELL> m_cells;
+        std::vector<CELL_KEY>      m_cellKeys;    ///< Key of each cell of m_cells.
+
+        /// Position of the cells in m_cells, built by the first Refill(). Also speeds up the
+        /// queries of small areas, like the damaged areas of a redraw.
+        std::unordered_map<CELL_KEY, size_t, CELL_KEY_HASH> m_cellIndex;
+
+        /// Cells changed by Update() since the last Refill().
+        std::vector<CELL_KEY> m_dirtyCells;
+
+        /// Cell being rebuilt by Refill() and its content.
+        bool          m_refilling;
+        CELL_KEY      m_refillKey;
+        VIEW_LOD_CELL m_refillCell;
+        size_t        m_refillCount;
+
+        VIEW_RTREE m_largeItems;
+        double     m_cellSize;
+        bool       m_valid;
+        bool       m_aggregating;
+    };
+} // namespace KIGFX
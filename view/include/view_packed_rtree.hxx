@@ -0,0 +1,216 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "view_index_base.hxx"
+#include "view_rtree.hxx"
+
+namespace KIGFX
+{
+    /**
+     * Non-owning R-tree packed into flat arrays, which can be stored in a file and used in place
+     * once the file is mapped again (see VIEW::LoadIndexSnapshot()).
+     *
+     * The items are sorted along a Hilbert curve of their box centers and grouped NODE_SIZE at
+     * a time, level after level up to the root. Nodes refer to their children and to the items
+     * by number, never by address. Building the tree is a sort, and queries walk contiguous
+     * arrays.
+     *
+     * The packed arrays never change. Inserted items go to a small dynamic R-tree next to them
+     * and removed items are only marked dead, until a bulk load that is large compared to the
+     * index packs everything again.
+     */
+    class VIEW_PACKED_RTREE
+    {
+    public:
+        /// Children per node.
+        static constexpr uint32_t NODE_SIZE = 16;
+
+        /// Levels supported, enough for NODE_SIZE^16 items.
+        static constexpr uint32_t MAX_LEVELS = 16;
+
+        /**
+         * The arrays of a packed tree. Nodes are numbered level by level, leaves first, the
+         * root last.
+         */
+        struct ARRAYS
+        {
+            const double*   boxes = nullptr;     ///< Min x, min y, max x, max y of each node.
+            const uint32_t* indices = nullptr;   ///< Leaves: item number, others: first child.
+            const uint64_t* levelEnds = nullptr; ///< Number of the node after each level.
+            uint32_t        levelCount = 0;
+            uint64_t        nodeCount = 0;
+
+            uint64_t LeafCount() const
+            {
+                return levelCount ? levelEnds[0] : 0;
+            }
+        };
+
+        /// Storage of the arrays of a tree packed in memory.
+        struct PACKED_ARRAYS
+        {
+            std::vector<double>   boxes;
+            std::vector<uint32_t> indices;
+            std::vector<uint64_t> levelEnds;
+
+            ARRAYS Arrays() const;
+        };
+
+        /// A box with the number of its item, as packed by Pack().
+        using LEAF = std::pair<BOX2D, uint32_t>;
+
+        /**
+         * Pack boxes into a tree.
+         *
+         * @param aLeaves are the boxes and their item numbers. The vector is sorted.
+         * @param aResult receives the arrays of the tree.
+         */
+        static void Pack(std::vector<LEAF>& aLeaves, PACKED_ARRAYS& aResult);
+
+        /**
+         * Insert an item into the index.
+         */
+        void Insert(VIEW_ITEM* aItem, const BOX2D& aBbox);
+
+        /**
+         * Insert a batch of items. If the batch is large compared to the index, everything is
+         * packed again, otherwise the items go to the dynamic part like single insertions.
+         *
+         * @param aEntries are the box/item pairs to insert. The vector is consumed.
+         */
+        void BulkLoad(std::vector<VIEW_INDEX_ENTRY>& aEntries);
+
+        /**
+         * Remove an item from the index.
+         *
+         * @param aBbox is the box the item was inserted with, if known. Without it, all the
+         *              leaves are scanned.
+         * @return true if the item was found and removed.
+         */
+        bool Remove(VIEW_ITEM* aItem, const BOX2D* aBbox);
+
+        /**
+         * Use a tree packed elsewhere, typically in a mapped index snapshot. The items already
+         * in the index are dropped.
+         *
+         * @param aArrays are the arrays of the tree.
+         * @param aItems are the items the leaves refer to by number.
+         * @param aStorage keeps the memory of \a aArrays and \a aItems alive.
+         */
+        void Attach(const ARRAYS& aArrays, VIEW_ITEM* const* aItems,
+                    std::shared_ptr<const void> aStorage);
+
+        /**
+         * Execute a function object \a aVisitor for each item whose bounding box intersects
+         * with \a aBounds.
+         *
+         * @return false if the query was stopped by the visitor, true otherwise.
+         */
+        template <class Visitor>
+        bool Query(const BOX2D& aBounds, Visitor& aVisitor) const
+        {
+            const bool completed = queryLeaves(aBounds,
+                    [&](uint64_t aLeaf)
+                    {
+                        return isDead(aLeaf)
+                               || VisitIndexItem(aVisitor, m_items[m_arrays.indices[aLeaf]]);
+                    });
+
+            return completed && m_dynamic.Query(aBounds, aVisitor);
+        }
+
+        /**
+         * Append all items whose bounding box intersects with \a aBounds to \a aResult.
+         *
+         * @return the number of items appended.
+         */
+        size_t Query(const BOX2D& aBounds, std::vector<VIEW_ITEM*>& aResult) const
+        {
+            const size_t prevSize = aResult.size();
+            auto         collect = [&](VIEW_ITEM* aItem) { aResult.push_back(aItem); };
+
+            Query(aBounds, collect);
+
+            return aResult.size() - prevSize;
+        }
+
+        void RemoveAll();
+
+        size_t Size() const
+        {
+            return m_arrays.LeafCount() - m_deadCount + m_dynamic.Size();
+        }
+
+    private:
+        /**
+         * Call \a aFunc(leaf) for the leaves whose box intersects with \a aBounds, until it
+         * returns false.
+         */
+        template <class Func>
+        bool queryLeaves(const BOX2D& aBounds, Func&& aFunc) const
+        {
+            if (m_arrays.nodeCount == 0)
+                return true;
+
+            BOX2D bounds = aBounds;
+            bounds.Normalize();
+
+            const double qMinX = bounds.GetLeft();
+            const double qMinY = bounds.GetTop();
+            const double qMaxX = bounds.GetRight();
+            const double qMaxY = bounds.GetBottom();
+
+            // Nodes to visit with their level, at most NODE_SIZE per level
+            std::pair<uint64_t, uint32_t> stack[NODE_SIZE * MAX_LEVELS];
+            int                           stackSize = 0;
+
+            stack[stackSize++] = { m_arrays.nodeCount - 1, m_arrays.levelCount - 1 };
+
+            while (stackSize > 0)
+            {
+                const auto [node, level] = stack[--stackSize];
+                const uint64_t first = m_arrays.indices[node];
+                const uint64_t end = std::min<uint64_t>(first + NODE_SIZE,
+                                                        m_arrays.levelEnds[level - 1]);
+
+                for (uint64_t child = first; child < end; ++child)
+                {
+                    const double* box = m_arrays.boxes + 4 * child;
+
+                    if (box[0] > qMaxX || box[1] > qMaxY || box[2] < qMinX || box[3] < qMinY)
+                        continue;
+
+                    if (level > 1)
+                        stack[stackSize++] = { child, level - 1 };
+                    else if (!aFunc(child))
+                        return false;
+                }
+            }
+
+            return true;
+        }
+
+        bool isDead(uint64_t aLeaf) const
+        {
+            return !m_dead.empty() && (m_dead[aLeaf / 64] >> (aLeaf % 64) & 1);
+        }
+
+        ARRAYS                      m_arrays;
+        VIEW_ITEM* const*           m_items = nullptr;
+
+        /// Owner of the memory of m_arrays and m_items.
+        std::shared_ptr<const void> m_storage;
+
+        /// One bit per leaf removed from the packed part, empty until the first removal.
+        std::vector<uint64_t>       m_dead;
+        size_t                      m_deadCount = 0;
+
+        /// Items inserted since the tree was packed.
+        VIEW_RTREE                  m_dynamic;
+    };
+} // namespace KIGFX
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <vector>
+
+#include "view_index_base.hxx"
+
+namespace KIGFX
+{
+    /**
+     * Non-owning loose quadtree indexing VIEW items.
+     *
+     * Each item is stored once, in the deepest node whose square contains the item's centre
+     * and is at least as large as the item. The bounds used for queries are twice the node
+     * square, so items never have to be split or stored in several nodes. Nodes hold up to
+     * NODE_CAPACITY items before their items are pushed down into the children.
+     *
+     * Unlike an R-tree, nodes are never rebalanced, so moving an item is just a removal from
+     * one node vector and an insertion into another one. The root grows as needed to cover
+     * items inserted outside of it.
+     */
+    class VIEW_QUADTREE
+    {
+    public:
+        VIEW_QUADTREE();
+
+        /**
+         * Insert an item into the tree.
+         */
+        void Insert(VIEW_ITEM* aItem, const BOX2D& aBbox);
+
+        /**
+         * Insert a batch of items. The root is sized to cover all of them at once.
+         *
+         * @param aEntries are the box/item pairs to insert. The vector is consumed.
+         */
+        void BulkLoad(std::vector<VIEW_INDEX_ENTRY>& aEntries);
+
+        /**
+         * Remove an item from the tree.
+         *
+         * @param aBbox is the box the item was inserted with, so only the nodes on its path
+         *              from the root have to be searched. Without it, all nodes are scanned.
+         * @return true if the item was found and removed.
+         */
+        bool Remove(VIEW_ITEM* aItem, const BOX2D* aBbox);
+
+        /**
+         * Execute a function object \a aVisitor for each item whose bounding box intersects
+         * with \a aBounds.
+         *
+         * @return false if the query was stopped by the visitor, true otherwise.
+         */
+        template <class Visitor>
+        bool Query(const BOX2D& aBounds, Visitor& aVisitor) const
+        {
+            if (m_root < 0)
+                return true;
+
+            BOX2D bounds = aBounds;
+            bounds.Normalize();
+
+            return queryNode(m_root, makeEntry(nullptr, bounds), aVisitor);
+        }
+
+        /**
+         * Append all items whose bounding box intersects with \a aBounds to \a aResult.
+         *
+         * @return the number of items appended.
+         */
+        size_t Query(const BOX2D& aBounds, std::vector<VIEW_ITEM*>& aResult) const
+        {
+            const size_t prevSize = aResult.size();
+            auto         collect = [&](VIEW_ITEM* aItem) { aResult.push_back(aItem); };
+
+            Query(aBounds, collect);
+
+            return aResult.size() - prevSize;
+        }
+
+        void RemoveAll();
+
+        size_t Size() const
+        {
+            return m_count;
+        }
+
+    private:
+        struct ENTRY
+        {
+            double     minX, minY, maxX, maxY;
+            VIEW_ITEM* item;
+
+            bool Intersects(double aMinX, double aMinY, double aMaxX, double aMaxY) const
+            {
+                return minX <= aMaxX && maxX >= aMinX && minY <= aMaxY && maxY >= aMinY;
+            }
+        };
+
+        struct NODE
+        {
+            double             cx, cy;        ///< Centre of the node square.
+            double             half;          ///< Half of the node square size.
+            int                children[4];   ///< Child node indices (-1 if none), by quadrant.
+            bool               split;         ///< Items go to the children when they fit.
+            std::vector<ENTRY> entries;
+        };
+
+        /// Number of items a node holds before it is split.
+        static constexpr size_t NODE_CAPACITY = 16;
+
+        /// Nodes are not split beyond this depth, to handle many items at the same place.
+        static constexpr int MAX_SPLIT_DEPTH = 48;
+
+        static ENTRY makeEntry(VIEW_ITEM* aItem, const BOX2D& aBbox);
+
+        /// Return true if \a aEntry may be stored in \a aNode (or below).
+        static bool fits(const NODE& aNode, const ENTRY& aEntry);
+
+        /// Return the quadrant of \a aNode containing the centre of \a aEntry.
+        static int quadrant(const NODE& aNode, const ENTRY& aEntry);
+
+        int addNode(double aCx, double aCy, double aHalf);
+
+        /// Return the child of \a aNode in \a aQuadrant, creating it if needed.
+        int child(int aNode, int aQuadrant);
+
+        /// Enlarge the tree until the root can hold \a aEntry.
+        void growRoot(const ENTRY& aEntry);
+
+        void insert(const ENTRY& aEntry);
+
+        /// Push the items of \a aNode that fit in a quadrant down into the children.
+        void splitNode(int aNode, int aDepth);
+
+        template <class Visitor>
+        bool queryNode(int aNode, const ENTRY& aQuery, Visitor& aVisitor) const
+        {
+            const NODE&  node = m_nodes[aNode];
+            const double loose = 2.0 * node.half;
+
+            if (aQuery.minX > node.cx + loose || aQuery.maxX < node.cx - loose
+                    || aQuery.minY > node.cy + loose || aQuery.maxY < node.cy - loose)
+            {
+                return true;
+            }
+
+            for (const ENTRY& entry : node.entries)
+            {
+                if (entry.Intersects(aQuery.minX, aQuery.minY, aQuery.maxX, aQuery.maxY)
+                        && !VisitIndexItem(aVisitor, entry.item))
+                {
+                    return false;
+                }
+            }
+
+            for (int childIdx : node.children)
+            {
+                if (childIdx >= 0 && !queryNode(childIdx, aQuery, aVisitor))
+                    return false;
+            }
+
+            return true;
+        }
+
+        std::vector<NODE> m_nodes;
+        int               m_root;
+        size_t            m_count;
+    };
+} // namespace KIGFX
@@ -1,103 +1,302 @@
 #pragma once
 
+#include <algorithm>
+#include <limits>
+#include <type_traits>
 #include <boost/geometry.hpp>
+#include <boost/iterator/function_output_iterator.hpp>
 
 #include <box2.hxx>
+#include "view_index_base.hxx"
 
 namespace KIGFX
 {
     namespace bg = boost::geometry;
     namespace bgi = boost::geometry::index;
-    using Box = bg::model::box<bg::model::point<double, 2, bg::cs::cartesian>>;
-    using Point2D = bg::model::point<double, 2, bg::cs::cartesian>;
-    using Value = std::pair<Box, VIEW_ITEM*>;
 
     /**
      * Implement an non-owning R-tree for fast spatial indexing of VIEW items.
+     *
+     * @tparam CoordType is the coordinate type of the stored boxes. The VIEW indexes items with
+     *                   their double precision bounding box (VIEW_ITEM::ViewBBoxD()), so tiny
+     *                   items do not collapse when rounded to integer coordinates.
+     * @tparam Params is the Boost node splitting algorithm (quadratic, linear or rstar).
      */
-    class VIEW_RTREE
+    template <typename CoordType, typename Params = bgi::quadratic<16>>
+    class VIEW_RTREE_BASE
     {
     public:
+        using BOX = BOX2<VECTOR2<CoordType>>;
+        using Point2D = bg::model::point<CoordType, 2, bg::cs::cartesian>;
+        using Box = bg::model::box<Point2D>;
+        using Value = std::pair<Box, VIEW_ITEM*>;
+        using Entry = std::pair<BOX, VIEW_ITEM*>;
+
         /**
          * Insert an item into the tree.
          *
          * Item's bounding box is taken via its ViewBBox() method.
          */
-        void Insert(VIEW_ITEM* aItem, const BOX2I& bbox)
+        void Insert(VIEW_ITEM* aItem, const BOX& bbox)
         {
-            const int       mmin[2] = { std::min(bbox.GetX(), bbox.GetRight()),
-                                        std::min(bbox.GetY(), bbox.GetBottom()) };
-            const int       mmax[2] = { std::max(bbox.GetX(), bbox.GetRight()),
-                                        std::max(bbox.GetY(), bbox.GetBottom()) };
-
-            rtree.insert(Value({ Box(Point2D(mmin[0], mmin[1]), Point2D(mmax[0], mmax[1])), aItem }));
+            rtree.insert(Value({ ToBox(bbox), aItem }));
         }
 
         /**
-         * Remove an item from the tree.
+         * Insert a batch of items in one pass.
          *
-         * Removal is done by comparing pointers, attempting to remove a copy of the item will fail.
+         * When the tree is empty it is built with the packing (STR) algorithm, which is much
+         * faster than inserting the items one by one and also gives a better balanced tree.
+         * Items that are already in the tree are repacked together with the new ones, unless
+         * the batch is small compared to the tree: inserting it is cheaper then.
+         *
+         * @param aEntries are the box/item pairs to insert. The vector is consumed.
          */
-        void Remove(VIEW_ITEM* aItem, const BOX2I* aBbox)
+        void BulkLoad(std::vector<Entry>& aEntries)
         {
-            // const BOX2I&    bbox    = aItem->ViewBBox();
+            if (aEntries.empty())
+                return;
 
-            if (aBbox)
+            // An insertion costs about as much as repacking 8 items
+            if (aEntries.size() * 8 < rtree.size())
             {
-                const int mmin[2] = { std::min(aBbox->GetX(), aBbox->GetRight()),
-                                      std::min(aBbox->GetY(), aBbox->GetBottom()) };
-                const int mmax[2] = { std::max(aBbox->GetX(), aBbox->GetRight()),
-                                      std::max(aBbox->GetY(), aBbox->GetBottom()) };
-                rtree.remove(Value({ Box(Point2D(mmin[0], mmin[1]), Point2D(mmax[0], mmax[1])), aItem }));
+                for (const Entry& entry : aEntries)
+                    rtree.insert(Value(ToBox(entry.first), entry.second));
+
+                aEntries.clear();
+                aEntries.shrink_to_fit();
                 return;
             }
 
-            // FIXME: use cached bbox or ptr_map to speed up pointer <-> node lookups.
-            const int       mmin[2] = { INT_MIN, INT_MIN };
-            const int       mmax[2] = { INT_MAX, INT_MAX };
+            std::vector<Value> values;
+            values.reserve(aEntries.size() + rtree.size());
+
+            for (const Entry& entry : aEntries)
+                values.emplace_back(ToBox(entry.first), entry.second);
+
+            if (!rtree.empty())
+                values.insert(values.end(), rtree.begin(), rtree.end());
+
+            RTREE packed(values.begin(), values.end());
+            rtree = std::move(packed);
+            aEntries.clear();
+            aEntries.shrink_to_fit();
+        }
+
+        /**
+         * Convert a BOX2 into the (normalized) box type stored in the tree.
+         */
+        static Box ToBox(const BOX& aBbox)
+        {
+            const CoordType mmin[2] = { std::min(aBbox.GetX(), aBbox.GetRight()),
+                                        std::min(aBbox.GetY(), aBbox.GetBottom()) };
+            const CoordType mmax[2] = { std::max(aBbox.GetX(), aBbox.GetRight()),
+                                        std::max(aBbox.GetY(), aBbox.GetBottom()) };
 
-            rtree.remove(Value({ Box(Point2D(mmin[0], mmin[1]), Point2D(mmax[0], mmax[1])), aItem }));
+            return Box(Point2D(mmin[0], mmin[1]), Point2D(mmax[0], mmax[1]));
+        }
+
+        /**
+         * Remove an item from the tree.
+         *
+         * Removal is done by comparing pointers, attempting to remove a copy of the item will fail.
+         *
+         * @param aBbox is the box the item was inserted with. The lookup then only descends into
+         *              the nodes covering that box, which is O(log n) plus the overlap between
+         *              nodes, not constant time. Without it, the whole tree is scanned.
+         * @return true if the item was found and removed.
+         */
+        bool Remove(VIEW_ITEM* aItem, const BOX* aBbox)
+        {
+            if (aBbox)
+                return rtree.remove(Value({ ToBox(*aBbox), aItem })) > 0;
+
+            std::vector<Value> found;
+
+            rtree.query(bgi::satisfies(
+                    [aItem](const Value& aValue)
+                    {
+                        return aValue.second == aItem;
+                    }), std::back_inserter(found));
+
+            for (const Value& value : found)
+                rtree.remove(value);
+
+            return !found.empty();
         }
 
         /**
          * Execute a function object \a aVisitor for each item whose bounding box intersects
          * with \a aBounds.
+         *
+         * Hits are streamed straight to the visitor, nothing is copied. If the visitor returns
+         * a bool, returning false stops the query immediately.
+         *
+         * @return false if the query was stopped by the visitor, true otherwise.
          */
         template <class Visitor>
-        void Query(const BOX2I& aBounds, Visitor& aVisitor) const
+        bool Query(const BOX& aBounds, Visitor& aVisitor) const
         {
-            int   mmin[2] = { std::min(aBounds.GetX(), aBounds.GetRight()),
-                              std::min(aBounds.GetY(), aBounds.GetBottom()) };
-            int   mmax[2] = { std::max(aBounds.GetX(), aBounds.GetRight()),
-                              std::max(aBounds.GetY(), aBounds.GetBottom()) };
+            const auto predicate = bgi::intersects(queryBox(aBounds));
 
-            // We frequently use the maximum bounding box to recache all items
-            // or for any item that overflows the integer width limits of BBOX2I
-            // in this case, we search the full rtree whose bounds are absolute
-            // coordinates rather than relative
-            BOX2I max_box;
-            max_box.SetMaximum();
+            if constexpr (std::is_void_v<std::invoke_result_t<Visitor&, VIEW_ITEM*>>)
+            {
+                // The visitor cannot stop the query, so use the (faster) output iterator path
+                rtree.query(predicate, boost::make_function_output_iterator(
+                        [&](const Value& aValue)
+                        {
+                            aVisitor(aValue.second);
+                        }));
+            }
+            else
+            {
+                for (auto it = rtree.qbegin(predicate); it != rtree.qend(); ++it)
+                {
+                    if (!aVisitor(it->second))
+                        return false;
+                }
+            }
 
-            if (aBounds == max_box)
+            return true;
+        }
+
+        /**
+         * Execute a function object \a aVisitor(item, distance) for the items in increasing order
+         * of the distance between \a aPoint and their bounding box (0 if the box contains the
+         * point), until the visitor returns false.
+         *
+         * The items are fetched with k-nearest queries of growing k, so stopping after a few
+         * items costs a few node visits, whatever the size of the tree. (The incremental Boost
+         * query with an unbounded k is much slower: it keeps sorting every value it met.)
+         *
+         * @return false if the search was stopped by the visitor, true otherwise.
+         */
+        template <class Visitor>
+        bool Nearest(const VECTOR2<CoordType>& aPoint, Visitor& aVisitor) const
+        {
+            if (rtree.empty())
+                return true;
+
+            const Point2D point(aPoint.x, aPoint.y);
+
+            std::vector<std::pair<double, VIEW_ITEM*>> found;
+            std::vector<VIEW_ITEM*> lastVisited;    // visited items at the last distance
+            double lastDistance = -1.0;
+
+            for (size_t count = 8; ; count *= 4)
             {
-                mmin[0] = mmin[1] = INT_MIN;
-                mmax[0] = mmax[1] = INT_MAX;
+                found.clear();
+                rtree.query(bgi::nearest(point, count), boost::make_function_output_iterator(
+                        [&](const Value& aValue)
+                        {
+                            found.emplace_back(bg::distance(point, aValue.first), aValue.second);
+                        }));
+
+                std::sort(found.begin(), found.end());
+
+                // The previous queries returned a prefix of these, except for the items tied at
+                // the farthest distance
+                for (const auto& [distance, item] : found)
+                {
+                    if (distance < lastDistance)
+                        continue;
+
+                    if (distance == lastDistance)
+                    {
+                        if (std::find(lastVisited.begin(), lastVisited.end(), item) != lastVisited.end())
+                            continue;
+                    }
+                    else
+                    {
+                        lastDistance = distance;
+                        lastVisited.clear();
+                    }
+
+                    lastVisited.push_back(item);
+
+                    if (!aVisitor(item, distance))
+                        return false;
+                }
+
+                if (found.size() < count)
+                    return true;
             }
-            std::vector<Value> val;
-            rtree.query(bgi::intersects(Box(Point2D(mmin[0], mmin[1]), Point2D(mmax[0], mmax[1]))), std::back_inserter(val));
-            for (auto [box, item] : val) {
-                aVisitor(item);
+        }
+
+        /**
+         * Append all items whose bounding box intersects with \a aBounds to \a aResult.
+         *
+         * Meant for callers that need the results materialized: the vector is not cleared, so
+         * it can be reused as a scratch buffer and will not allocate once it has grown enough.
+         *
+         * @return the number of items appended.
+         */
+        size_t Query(const BOX& aBounds, std::vector<VIEW_ITEM*>& aResult) const
+        {
+            const size_t prevSize = aResult.size();
+
+            rtree.query(bgi::intersects(queryBox(aBounds)), boost::make_function_output_iterator(
+                    [&](const Value& aValue)
+                    {
+                        aResult.push_back(aValue.second);
+                    }));
+
+            return aResult.size() - prevSize;
+        }
+
+        /**
+         * Execute a function object \a aFunc(bbox, item) for every item in the tree.
+         */
+        template <class Func>
+        void ForEach(Func&& aFunc) const
+        {
+            for (const Value& value : rtree)
+            {
+                const Point2D& min = value.first.min_corner();
+                const Point2D& max = value.first.max_corner();
+                const VECTOR2<CoordType> origin(bg::get<0>(min), bg::get<1>(min));
+
+                aFunc(BOX(origin, VECTOR2<CoordType>(bg::get<0>(max), bg::get<1>(max)) - origin),
+                      value.second);
             }
-            //rtree.query(
-            //    bgi::intersects(query_box),
-            //    boost::make_function_output_iterator([&](auto const& v) { aVisitor(v.second); })
-            //);
         }
+
         void RemoveAll() {
             rtree.clear();
         }
+
+        size_t Size() const
+        {
+            return rtree.size();
+        }
+
     private:
-        bgi::rtree<Value, bgi::quadratic<16>> rtree;
+        static Box queryBox(const BOX& aBounds)
+        {
+            // We frequently use the maximum bounding box to recache all items
+            // or for any item that overflows the width limits of the box type
+            // in this case, we search the full rtree whose bounds are absolute
+            // coordinates rather than relative
+            BOX max_box;
+            max_box.SetMaximum();
+
+            if (aBounds == max_box)
+            {
+                using limits = std::numeric_limits<CoordType>;
+                return Box(Point2D(limits::lowest(), limits::lowest()),
+                           Point2D(limits::max(), limits::max()));
+            }
+
+            return ToBox(aBounds);
+        }
+
+        using RTREE = bgi::rtree<Value, Params>;
+
+        RTREE rtree;
     };
+
+    using VIEW_RTREE = VIEW_RTREE_BASE<double>;
+    using VIEW_RTREE_LINEAR = VIEW_RTREE_BASE<double, bgi::linear<16>>;
+    using VIEW_RTREE_RSTAR = VIEW_RTREE_BASE<double, bgi::rstar<16>>;
 } // namespace KIGFX
 
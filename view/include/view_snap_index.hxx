@@ -0,0 +1,150 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "view_item.hxx"
+#include "view_rtree.hxx"
+
+namespace KIGFX
+{
+    /**
+     * Spatial index of the anchor points of the VIEW items, for cursor snapping.
+     *
+     * The anchors are stored in an R-tree of points, so the anchors closest to the cursor are
+     * found in logarithmic time whatever the zoom level, unlike with a fixed grid. Items are
+     * updated one by one as they change; only a full rebuild packs the tree again.
+     */
+    class VIEW_SNAP_INDEX
+    {
+    public:
+        /// An anchor together with the item it belongs to.
+        struct ENTRY
+        {
+            VECTOR2D         point;
+            VIEW_ITEM*       item;
+            VIEW_ANCHOR_TYPE type;
+        };
+
+        /**
+         * Insert the anchors of \a aItem.
+         */
+        void Insert(VIEW_ITEM* aItem, const std::vector<VIEW_ANCHOR>& aAnchors)
+        {
+            for (const VIEW_ANCHOR& anchor : aAnchors)
+                m_tree.insert(toValue({ anchor.point, aItem, anchor.type }));
+        }
+
+        /**
+         * Insert a batch of anchors. The tree is packed again unless the batch is small compared
+         * to it (see VIEW_RTREE_BASE::BulkLoad()).
+         *
+         * @param aEntries are the anchors to insert. The vector is consumed.
+         */
+        void BulkLoad(std::vector<ENTRY>& aEntries)
+        {
+            if (aEntries.size() * 8 < m_tree.size())
+            {
+                for (const ENTRY& entry : aEntries)
+                    m_tree.insert(toValue(entry));
+            }
+            else
+            {
+                std::vector<VALUE> values;
+                values.reserve(aEntries.size() + m_tree.size());
+
+                for (const ENTRY& entry : aEntries)
+                    values.push_back(toValue(entry));
+
+                values.insert(values.end(), m_tree.begin(), m_tree.end());
+                m_tree = TREE(values.begin(), values.end());
+            }
+
+            aEntries.clear();
+            aEntries.shrink_to_fit();
+        }
+
+        /**
+         * Remove the anchors of \a aItem.
+         *
+         * @param aBbox is the bounding box of the item when its anchors were inserted.
+         */
+        void Remove(VIEW_ITEM* aItem, const BOX2D& aBbox)
+        {
+            BOX2D bbox = aBbox;
+            bbox.Normalize();
+
+            const BOX box(POINT(bbox.GetLeft(), bbox.GetTop()), POINT(bbox.GetRight(), bbox.GetBottom()));
+            std::vector<VALUE> found;
+
+            m_tree.query(bgi::intersects(box) && bgi::satisfies(
+                    [aItem](const VALUE& aValue)
+                    {
+                        return aValue.second.item == aItem;
+                    }), std::back_inserter(found));
+
+            for (const VALUE& value : found)
+                m_tree.remove(value);
+        }
+
+        /**
+         * Execute a function object \a aVisitor(entry) for the \a aCount anchors closest to
+         * \a aPoint, the closest first.
+         */
+        template <class Visitor>
+        void Nearest(const VECTOR2D& aPoint, size_t aCount, Visitor& aVisitor) const
+        {
+            if (m_tree.empty() || aCount == 0)
+                return;
+
+            const POINT        point(aPoint.x, aPoint.y);
+            std::vector<VALUE> found;
+
+            m_tree.query(bgi::nearest(point, aCount), std::back_inserter(found));
+
+            std::sort(found.begin(), found.end(),
+                [&](const VALUE& aA, const VALUE& aB)
+                {
+                    return bg::comparable_distance(point, aA.first)
+                           < bg::comparable_distance(point, aB.first);
+                });
+
+            for (const VALUE& value : found)
+            {
+                aVisitor(ENTRY{ VECTOR2D(bg::get<0>(value.first), bg::get<1>(value.first)),
+                                value.second.item, value.second.type });
+            }
+        }
+
+        void RemoveAll()
+        {
+            m_tree.clear();
+        }
+
+        size_t Size() const
+        {
+            return m_tree.size();
+        }
+
+    private:
+        struct ANCHOR_REF
+        {
+            VIEW_ITEM*       item;
+            VIEW_ANCHOR_TYPE type;
+
+            bool operator==(const ANCHOR_REF& aOther) const = default;
+        };
+
+        using POINT = bg::model::point<double, 2, bg::cs::cartesian>;
+        using BOX = bg::model::box<POINT>;
+        using VALUE = std::pair<POINT, ANCHOR_REF>;
+        using TREE = bgi::rtree<VALUE, bgi::quadratic<16>>;
+
+        static VALUE toValue(const ENTRY& aEntry)
+        {
+            return VALUE(POINT(aEntry.point.x, aEntry.point.y), { aEntry.item, aEntry.type });
+        }
+
+        TREE m_tree;
+    };
+} // namespace KIGFX
@@ -5,45 +5,67 @@
 //#include <view/view_group.h>
 #include <view_item.hxx>
 #include <view_data.hxx>
-#include <view_rtree.hxx>
+#include <view_index.hxx>
+#include <view_lod_cache.hxx>
+#include <view_area_map.hxx>
+#include <view_snap_index.hxx>
+#include <view_index_snapshot.hxx>
 //#include <view/view_overlay.h>
 
 #include <gal/include/painter.hxx>
 #include <shape_poly_set.hxx>
+#include <hilbert_curve.hxx>
 #include <gal/include/definitions.hxx>
 #include <gal/include/graphics_abstraction_layer.hxx>
 #include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
 
+#include <kicad_algo.hxx>
 #include <profile.hxx>
+#include <thread_pool.hxx>
 
 namespace KIGFX {
 
     class VIEW;
 
+    /// Margin around partially redrawn areas in pixels, for antialiasing and strokes that
+    /// exceed item bboxes.
+    static constexpr double REDRAW_AREA_MARGIN = 2.0;
+
+    /// Above this fraction of the screen, a partial redraw costs about the same as a full one.
+    static constexpr double MAX_PARTIAL_REDRAW_RATIO = 0.5;
+
 
     void VIEW::OnDestroy(VIEW_ITEM* aItem)
     {
-        if (aItem->m_viewPrivData)
-        {
-            if (aItem->m_viewPrivData->m_view)
-                aItem->m_viewPrivData->m_view->VIEW::Remove(aItem);
-
-            delete aItem->m_viewPrivData;
-            aItem->m_viewPrivData = nullptr;
-        }
+        // The data belongs to the view, removing the item gives it back
+        if (aItem->m_viewPrivData && aItem->m_viewPrivData->m_view)
+            aItem->m_viewPrivData->m_view->VIEW::Remove(aItem);
     }
 
 
     VIEW::VIEW() :
         m_enableOrderModifier(true),
+        m_partialChangeOffset(0),
         m_scale(4.0),
         m_minScale(0.2), m_maxScale(50000.0),
         m_mirrorX(false), m_mirrorY(false),
         m_painter(nullptr),
         m_gal(nullptr),
+        m_useDamageRedraw(false),
+        m_useScrollBlit(false),
+        m_pendingScroll(0, 0),
+        m_scrollDrift(0.0, 0.0),
+        m_aggregateThreshold(0.0),
         m_useDrawPriority(false),
         m_nextDrawPriority(0),
-        m_reverseDrawOrder(false)
+        m_reverseDrawOrder(false),
+        m_gcCounter(0),
+        m_hasIndexSlack(false),
+        m_lastCullTime(0.0),
+        m_lastSubmitTime(0.0)
     {
         // Set m_boundary to define the max area size. The default area size
         // is defined here as the max value of a int.
@@ -57,6 +79,7 @@ namespace KIGFX {
 
         m_allItems.reset(new std::vector<VIEW_ITEM*>);
         m_allItems->reserve(32768);
+        m_itemDataPool = std::make_unique<VIEW_ITEM_DATA_POOL>();
 
         // Redraw everything at the beginning
         MarkDirty();
@@ -70,7 +93,8 @@ namespace KIGFX {
             auto [it, _] = m_layers.emplace(ii, VIEW_LAYER());
             VIEW_LAYER& l = it->second;
 
-            l.items = std::make_shared<VIEW_RTREE>();
+            l.items = std::make_shared<VIEW_INDEX>();
+            l.lod = std::make_shared<VIEW_LOD_CACHE>();
             l.id = ii;
             l.renderingOrder = ii;
             l.visible = true;
@@ -90,25 +114,121 @@ namespace KIGFX {
     VIEW::~VIEW()
     {
         //Remove(m_preview.get());
+
+        // Detach the items, their data goes away with the pool
+        for (VIEW_ITEM* item : *m_allItems)
+        {
+            if (item && item->m_viewPrivData && item->m_viewPrivData->m_view == this)
+                freeItemData(item);
+        }
+
+        // The items of removals still queued are handed over all the same
+        if (m_partialChange && m_partialChange->type == QUEUED_CHANGE::REMOVE
+            && m_partialChange->disposer)
+        {
+            for (size_t i = m_partialChangeOffset; i < m_partialChange->items.size(); ++i)
+                m_partialChange->disposer(m_partialChange->items[i]);
+        }
+
+        QUEUED_CHANGE change;
+
+        while (m_queuedChanges.Pop(change))
+        {
+            if (change.type == QUEUED_CHANGE::REMOVE && change.disposer)
+            {
+                for (VIEW_ITEM* item : change.items)
+                    change.disposer(item);
+            }
+        }
     }
 
 
-    void VIEW::Add(VIEW_ITEM* aItem, int aDrawPriority)
+    void VIEW::compactItems()
     {
-        if (aDrawPriority < 0)
-            aDrawPriority = m_nextDrawPriority++;
+        // Perform defragmentation
+        std::erase_if(*m_allItems,
+            [](VIEW_ITEM* it)
+            {
+                return it == nullptr;
+            });
 
-        if (!aItem->m_viewPrivData)
-            aItem->m_viewPrivData = new VIEW_ITEM_DATA;
+        // Update cached indices
+        for (size_t idx = 0; idx < m_allItems->size(); idx++)
+            (*m_allItems)[idx]->m_viewPrivData->m_cachedIndex = idx;
 
-        //wxASSERT_MSG(aItem->m_viewPrivData->m_view == nullptr || aItem->m_viewPrivData->m_view == this,
-        //    wxS("Already in a different view!"));
+        m_gcCounter = 0;
+    }
 
-        aItem->m_viewPrivData->m_view = this;
-        aItem->m_viewPrivData->m_drawPriority = aDrawPriority;
-        const BOX2I bbox = aItem->ViewBBox();
-        aItem->m_viewPrivData->m_bbox = bbox;
-        aItem->m_viewPrivData->m_cachedIndex = m_allItems->size();
+
+    void VIEW::SortItemsSpatially()
+    {
+        std::vector<VIEW_ITEM*>& allItems = *m_allItems;
+
+        compactItems();
+
+        if (allItems.empty())
+            return;
+
+        BOX2D extents;
+
+        for (size_t i = 0; i < allItems.size(); ++i)
+        {
+            BOX2D bbox = allItems[i]->m_viewPrivData->m_bbox;
+            bbox.Normalize();
+
+            if (i == 0)
+                extents = bbox;
+            else
+                extents.Merge(bbox);
+        }
+
+        std::vector<std::pair<uint64_t, VIEW_ITEM*>> keys;
+        keys.reserve(allItems.size());
+
+        for (VIEW_ITEM* item : allItems)
+            keys.emplace_back(HilbertIndex(item->m_viewPrivData->m_bbox.Centre(), extents), item);
+
+        // Stable, so that items at the same place keep their relative order
+        std::stable_sort(keys.begin(), keys.end(),
+            [](const auto& aA, const auto& aB)
+            {
+                return aA.first < aB.first;
+            });
+
+        // The data is moved to a new pool in the new order, the old pool goes away with the
+        // holes left by removed items
+        auto pool = std::make_unique<VIEW_ITEM_DATA_POOL>();
+
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            VIEW_ITEM*      item = keys[i].second;
+            VIEW_ITEM_DATA* viewData = pool->Alloc();
+
+            viewData->moveFrom(*item->m_viewPrivData);
+            viewData->m_cachedIndex = i;
+
+            freeItemData(item);
+            item->m_viewPrivData = viewData;
+            allItems[i] = item;
+        }
+
+        m_itemDataPool = std::move(pool);
+    }
+
+
+    void VIEW::freeItemData(VIEW_ITEM* aItem)
+    {
+        VIEW_ITEM_DATA* viewData = aItem->m_viewPrivData;
+
+        aItem->m_viewPrivData = nullptr;
+        viewData->m_pool->Free(viewData);
+    }
+
+
+    void VIEW::Add(VIEW_ITEM* aItem, int aDrawPriority)
+    {
+        if (aDrawPriority < 0)
+            aDrawPriority = m_nextDrawPriority++;
 
         std::vector<int> layers = aItem->ViewGetLayers();
 
@@ -117,9 +237,23 @@ namespace KIGFX {
                 return layer < 0 || layer >= VIEW_MAX_LAYERS;
             });
 
+        // Items without layers are not added, so they get no data to free later
         if (layers.empty())
             return;
 
+        if (!aItem->m_viewPrivData)
+            aItem->m_viewPrivData = m_itemDataPool->Alloc();
+
+        //wxASSERT_MSG(aItem->m_viewPrivData->m_view == nullptr || aItem->m_viewPrivData->m_view == this,
+        //    wxS("Already in a different view!"));
+
+        aItem->m_viewPrivData->m_view = this;
+        aItem->m_viewPrivData->m_drawPriority = aDrawPriority;
+        const BOX2D bbox = aItem->ViewBBoxD();
+        aItem->m_viewPrivData->m_bbox = bbox;
+        aItem->m_viewPrivData->m_indexBbox = bbox;
+        aItem->m_viewPrivData->m_cachedIndex = m_allItems->size();
+
         aItem->viewPrivData()->saveLayers(layers);
 
         m_allItems->push_back(aItem);
@@ -128,79 +262,452 @@ namespace KIGFX {
         {
             VIEW_LAYER& l = m_layers[layer];
             l.items->Insert(aItem, bbox);
-            MarkTargetDirty(l.target);
+            MarkTargetDamaged(l.target, bbox);
         }
 
         SetVisible(aItem, true);
+
+        for (int layer : layers)
+            updateItemLOD(aItem, layer, nullptr, &bbox);
+
+        if (m_snapIndex)
+            insertAnchors(aItem);
+
         Update(aItem, KIGFX::INITIAL_ADD);
     }
 
 
-    void VIEW::Remove(VIEW_ITEM* aItem)
+    void VIEW::AddItems(std::span<VIEW_ITEM* const> aItems)
     {
-        static int s_gcCounter = 0;
+        // Entries for each layer are collected first and then packed into the R-trees at once
+        std::map<int, std::vector<VIEW_INDEX_ENTRY>> layerValues;
+        std::vector<VIEW_SNAP_INDEX::ENTRY>          snapEntries;
+        std::vector<VIEW_ANCHOR>                     anchors;
+
+        m_allItems->reserve(m_allItems->size() + aItems.size());
 
-        if (aItem && aItem->m_viewPrivData)
+        for (VIEW_ITEM* item : aItems)
         {
-            if (aItem->m_viewPrivData->m_view == this) return;
-            else aItem->GetClass();
+            if (!item)
+                continue;
+
+            std::vector<int> layers = item->ViewGetLayers();
+
+            std::erase_if(layers, [](int layer)
+                {
+                    return layer < 0 || layer >= VIEW_MAX_LAYERS;
+                });
+
+            if (layers.empty())
+                continue;
+
+            if (!item->m_viewPrivData)
+                item->m_viewPrivData = m_itemDataPool->Alloc();
 
-            std::vector<VIEW_ITEM*>::iterator item = m_allItems->end();
-            int                               cachedIndex = aItem->m_viewPrivData->m_cachedIndex;
+            VIEW_ITEM_DATA* viewData = item->m_viewPrivData;
+            const BOX2D bbox = item->ViewBBoxD();
 
-            if (cachedIndex >= 0
-                && cachedIndex < static_cast<size_t>(m_allItems->size())
-                && (*m_allItems)[cachedIndex] == aItem)
+            viewData->m_view = this;
+            viewData->m_drawPriority = m_nextDrawPriority++;
+            viewData->m_bbox = bbox;
+            viewData->m_indexBbox = bbox;
+            viewData->m_cachedIndex = m_allItems->size();
+            viewData->saveLayers(layers);
+
+            // Same as SetVisible( item, true ) followed by Update( item, INITIAL_ADD )
+            if (!(viewData->m_flags & VISIBLE))
             {
-                item = m_allItems->begin() + cachedIndex;
+                viewData->m_flags |= VISIBLE;
+                viewData->m_requiredUpdate |= APPEARANCE | COLOR;
             }
-            else
+
+            viewData->m_requiredUpdate |= INITIAL_ADD;
+
+            m_allItems->push_back(item);
+
+            for (int layer : layers)
+                layerValues[layer].emplace_back(bbox, item);
+
+            if (m_snapIndex)
             {
-                item = std::find(m_allItems->begin(), m_allItems->end(), aItem);
+                anchors.clear();
+                item->ViewGetAnchors(anchors);
+
+                for (const VIEW_ANCHOR& anchor : anchors)
+                    snapEntries.push_back({ anchor.point, item, anchor.type });
             }
+        }
+
+        if (m_snapIndex)
+            m_snapIndex->BulkLoad(snapEntries);
 
-            if (item != m_allItems->end())
+        for (auto& [layer, values] : layerValues)
+        {
+            VIEW_LAYER& l = m_layers[layer];
+            l.items->BulkLoad(values);
+            l.lod->Invalidate();
+            MarkTargetDirty(l.target);
+        }
+    }
+
+
+    bool VIEW::LoadIndexSnapshot(const std::string& aPath, std::span<VIEW_ITEM* const> aItems,
+                                 const HASH_128& aContentHash)
+    {
+        // Items whose box changed since the snapshot was saved mean a stale content hash
+        constexpr size_t SAMPLES = 64;
+
+        auto isEmpty =
+            [&]()
             {
-                *item = nullptr;
-                aItem->m_viewPrivData->clearUpdateFlags();
+                return std::all_of(m_allItems->begin(), m_allItems->end(),
+                                   [](VIEW_ITEM* aItem)
+                                   {
+                                       return aItem == nullptr;
+                                   });
+            };
 
-                s_gcCounter++;
+        auto matches =
+            [&](const VIEW_INDEX_SNAPSHOT& aSnapshot)
+            {
+                const size_t count = aItems.size();
+                const size_t samples = std::min(SAMPLES, count);
 
-                if (s_gcCounter > 4096)
+                for (size_t s = 0; s < samples; ++s)
                 {
-                    // Perform defragmentation
-                    std::erase_if(*m_allItems,
-                        [](VIEW_ITEM* it)
-                        {
-                            return it == nullptr;
-                        });
+                    const size_t  i = s * count / samples;
+                    const double* box = aSnapshot.Boxes() + 4 * i;
+
+                    if (!aItems[i])
+                        return false;
 
-                    // Update cached indices
-                    for (size_t idx = 0; idx < m_allItems->size(); idx++)
-                        (*m_allItems)[idx]->m_viewPrivData->m_cachedIndex = idx;
+                    BOX2D bbox = aItems[i]->ViewBBoxD();
+                    bbox.Normalize();
 
-                    s_gcCounter = 0;
+                    if (bbox.GetLeft() != box[0] || bbox.GetTop() != box[1]
+                        || bbox.GetRight() != box[2] || bbox.GetBottom() != box[3])
+                    {
+                        return false;
+                    }
                 }
+
+                auto isValidLayer =
+                    [](int aLayer)
+                    {
+                        return aLayer >= 0 && aLayer < VIEW_MAX_LAYERS;
+                    };
+
+                const int32_t* layers = aSnapshot.Layers();
+
+                if (!std::all_of(layers, layers + aSnapshot.LayerOffsets()[count], isValidLayer))
+                    return false;
+
+                return std::all_of(aSnapshot.GetTrees().begin(), aSnapshot.GetTrees().end(),
+                                   [&](const VIEW_INDEX_SNAPSHOT::LAYER_TREE& aTree)
+                                   {
+                                       return isValidLayer(aTree.layer);
+                                   })
+                       && std::none_of(aItems.begin(), aItems.end(),
+                                       [](VIEW_ITEM* aItem)
+                                       {
+                                           return aItem == nullptr;
+                                       });
+            };
+
+        std::shared_ptr<VIEW_INDEX_SNAPSHOT> snapshot;
+
+        if (isEmpty())
+            snapshot = VIEW_INDEX_SNAPSHOT::Open(aPath, aContentHash, aItems.size());
+
+        if (!snapshot || !matches(*snapshot))
+        {
+            AddItems(aItems);
+            return false;
+        }
+
+        snapshot->SetItems(std::vector<VIEW_ITEM*>(aItems.begin(), aItems.end()));
+
+        const uint32_t* order = snapshot->Order();
+        const int32_t*  priorities = snapshot->Priorities();
+        const double*   boxes = snapshot->Boxes();
+        const uint32_t* layerOffsets = snapshot->LayerOffsets();
+        const int32_t*  layers = snapshot->Layers();
+        int             maxPriority = -1;
+
+        m_allItems->clear();
+        m_allItems->reserve(aItems.size());
+        m_gcCounter = 0;
+
+        for (size_t i = 0; i < aItems.size(); ++i)
+        {
+            const uint32_t number = order[i];
+            VIEW_ITEM*     item = aItems[number];
+            const double*  box = boxes + 4 * number;
+            const BOX2D    bbox(VECTOR2D(box[0], box[1]), VECTOR2D(box[2] - box[0], box[3] - box[1]));
+
+            if (!item->m_viewPrivData)
+                item->m_viewPrivData = m_itemDataPool->Alloc();
+
+            VIEW_ITEM_DATA* viewData = item->m_viewPrivData;
+
+            viewData->m_view = this;
+            viewData->m_drawPriority = priorities[number];
+            viewData->m_bbox = bbox;
+            viewData->m_indexBbox = bbox;
+            viewData->m_cachedIndex = i;
+            viewData->m_layers.assign(layers + layerOffsets[number], layers + layerOffsets[number + 1]);
+
+            // Same as in AddItems()
+            if (!(viewData->m_flags & VISIBLE))
+            {
+                viewData->m_flags |= VISIBLE;
+                viewData->m_requiredUpdate |= APPEARANCE | COLOR;
             }
 
-            const BOX2I* bbox = &aItem->m_viewPrivData->m_bbox;
+            viewData->m_requiredUpdate |= INITIAL_ADD;
+            maxPriority = std::max(maxPriority, viewData->m_drawPriority);
+
+            m_allItems->push_back(item);
+        }
+
+        m_nextDrawPriority = std::max(m_nextDrawPriority, maxPriority + 1);
+
+        for (const VIEW_INDEX_SNAPSHOT::LAYER_TREE& tree : snapshot->GetTrees())
+        {
+            VIEW_LAYER& l = m_layers[tree.layer];
+            l.items->AttachPacked(tree.tree, snapshot->Items(), snapshot);
+            l.lod->Invalidate();
+            MarkTargetDirty(l.target);
+        }
+
+        if (m_snapIndex)
+            rebuildSnapIndex();
+
+        return true;
+    }
 
-            for (int layer : aItem->m_viewPrivData->m_layers)
+
+    bool VIEW::SaveIndexSnapshot(const std::string& aPath, std::span<VIEW_ITEM* const> aItems,
+                                 const HASH_128& aContentHash) const
+    {
+        constexpr uint32_t UNLISTED = std::numeric_limits<uint32_t>::max();
+
+        const std::vector<VIEW_ITEM*>& allItems = *m_allItems;
+        std::vector<uint32_t>          numbers(allItems.size(), UNLISTED);
+        VIEW_INDEX_SNAPSHOT::CONTENT   content;
+
+        std::map<int, std::vector<VIEW_PACKED_RTREE::LEAF>> layerLeaves;
+
+        content.priorities.reserve(aItems.size());
+        content.boxes.reserve(4 * aItems.size());
+        content.layerOffsets.reserve(aItems.size() + 1);
+        content.layerOffsets.push_back(0);
+
+        for (size_t i = 0; i < aItems.size(); ++i)
+        {
+            const VIEW_ITEM_DATA* viewData = aItems[i] ? aItems[i]->viewPrivData() : nullptr;
+
+            // Every item must be in the view, listed once
+            if (!viewData || viewData->m_view != this || viewData->m_cachedIndex < 0
+                || allItems[viewData->m_cachedIndex] != aItems[i]
+                || numbers[viewData->m_cachedIndex] != UNLISTED)
             {
-                VIEW_LAYER& l = m_layers[layer];
-                l.items->Remove(aItem, bbox);
-                MarkTargetDirty(l.target);
+                return false;
+            }
 
-                // Clear the GAL cache
-                int prevGroup = aItem->m_viewPrivData->getGroup(layer);
+            numbers[viewData->m_cachedIndex] = i;
 
-                if (prevGroup >= 0)
-                    m_gal->DeleteGroup(prevGroup);
+            BOX2D bbox = viewData->m_bbox;
+            bbox.Normalize();
+
+            content.priorities.push_back(viewData->m_drawPriority);
+            content.boxes.insert(content.boxes.end(), { bbox.GetLeft(), bbox.GetTop(),
+                                                        bbox.GetRight(), bbox.GetBottom() });
+
+            for (int layer : viewData->m_layers)
+            {
+                content.layers.push_back(layer);
+                layerLeaves[layer].emplace_back(bbox, i);
+            }
+
+            content.layerOffsets.push_back(content.layers.size());
+        }
+
+        content.order.reserve(aItems.size());
+
+        for (size_t idx = 0; idx < allItems.size(); ++idx)
+        {
+            if (!allItems[idx])
+                continue;
+
+            // An item of the view missing from the list
+            if (numbers[idx] == UNLISTED)
+                return false;
+
+            content.order.push_back(numbers[idx]);
+        }
+
+        for (auto& [layer, leaves] : layerLeaves)
+        {
+            content.trees.emplace_back(layer, VIEW_PACKED_RTREE::PACKED_ARRAYS());
+            VIEW_PACKED_RTREE::Pack(leaves, content.trees.back().second);
+        }
+
+        return VIEW_INDEX_SNAPSHOT::Write(aPath, aContentHash, content);
+    }
+
+
+    void VIEW::Remove(VIEW_ITEM* aItem)
+    {
+        if (!aItem || !aItem->m_viewPrivData)
+            return;
+
+        VIEW_ITEM_DATA* viewData = aItem->m_viewPrivData;
+
+        if (viewData->m_view != this)
+            return;
+
+        int cachedIndex = viewData->m_cachedIndex;
+
+        if (cachedIndex >= 0
+            && cachedIndex < static_cast<int>(m_allItems->size())
+            && (*m_allItems)[cachedIndex] == aItem)
+        {
+            (*m_allItems)[cachedIndex] = nullptr;
+            viewData->m_cachedIndex = -1;
+            viewData->clearUpdateFlags();
+
+            if (++m_gcCounter > 4096)
+                compactItems();
+        }
+
+        // The index bbox locates the R-tree entries directly, no search needed
+        const BOX2D* bbox = &viewData->m_indexBbox;
+
+        for (int layer : viewData->m_layers)
+        {
+            VIEW_LAYER& l = m_layers[layer];
+            l.items->Remove(aItem, bbox);
+            updateItemLOD(aItem, layer, &viewData->m_bbox, nullptr);
+            MarkTargetDamaged(l.target, viewData->m_bbox);
+
+            // Clear the GAL cache
+            int prevGroup = viewData->getGroup(layer);
+
+            if (prevGroup >= 0 && m_gal)
+                m_gal->DeleteGroup(prevGroup);
+        }
+
+        if (m_snapIndex)
+            m_snapIndex->Remove(aItem, viewData->m_bbox);
+
+        freeItemData(aItem);
+    }
+
+
+    void VIEW::QueueAdd(std::vector<VIEW_ITEM*> aItems)
+    {
+        m_queuedChanges.Push({ QUEUED_CHANGE::ADD, std::move(aItems), NONE, nullptr });
+    }
+
+
+    void VIEW::QueueRemove(std::vector<VIEW_ITEM*> aItems,
+                           std::function<void(VIEW_ITEM*)> aDisposer)
+    {
+        m_queuedChanges.Push({ QUEUED_CHANGE::REMOVE, std::move(aItems), NONE,
+                               std::move(aDisposer) });
+    }
+
+
+    void VIEW::QueueUpdate(std::vector<VIEW_ITEM*> aItems, int aUpdateFlags)
+    {
+        m_queuedChanges.Push({ QUEUED_CHANGE::UPDATE, std::move(aItems), aUpdateFlags, nullptr });
+    }
+
+
+    bool VIEW::ApplyQueuedChanges(size_t aMaxItems)
+    {
+        size_t budget = aMaxItems > 0 ? aMaxItems : std::numeric_limits<size_t>::max();
+        bool   applied = false;
+
+        std::vector<VIEW_ITEM*> added;
+
+        auto flushAdded =
+            [&]()
+            {
+                AddItems(added);
+                added.clear();
+            };
+
+        while (budget > 0)
+        {
+            if (!m_partialChange)
+            {
+                QUEUED_CHANGE next;
+
+                if (!m_queuedChanges.Pop(next))
+                    break;
+
+                m_partialChange = std::move(next);
+                m_partialChangeOffset = 0;
+            }
+
+            QUEUED_CHANGE& change = *m_partialChange;
+            const size_t   count = std::min(budget, change.items.size() - m_partialChangeOffset);
+            std::span<VIEW_ITEM* const> items(change.items.data() + m_partialChangeOffset, count);
+
+            switch (change.type)
+            {
+            case QUEUED_CHANGE::ADD:
+                // Consecutive additions are loaded into the indexes together
+                added.insert(added.end(), items.begin(), items.end());
+                break;
+
+            case QUEUED_CHANGE::REMOVE:
+                flushAdded();
+
+                for (VIEW_ITEM* item : items)
+                    Remove(item);
+
+                if (change.disposer && count > 0)
+                {
+                    m_reclaimer.Retire(
+                        [disposer = change.disposer,
+                         removed = std::vector<VIEW_ITEM*>(items.begin(), items.end())]()
+                        {
+                            for (VIEW_ITEM* item : removed)
+                                disposer(item);
+                        });
+                }
+
+                break;
+
+            case QUEUED_CHANGE::UPDATE:
+                flushAdded();
+
+                for (VIEW_ITEM* item : items)
+                    Update(item, change.updateFlags);
+
+                break;
             }
 
-            aItem->m_viewPrivData->deleteGroups();
-            aItem->m_viewPrivData->m_view = nullptr;
+            applied |= count > 0;
+            budget -= count;
+            m_partialChangeOffset += count;
+
+            if (m_partialChangeOffset == change.items.size())
+                m_partialChange.reset();
         }
+
+        flushAdded();
+
+        // Cache and damage the changed items, as the owner of the view does after direct changes
+        if (applied && m_gal)
+            UpdateItems();
+
+        m_reclaimer.Collect();
+
+        return m_partialChange.has_value() || !m_queuedChanges.IsEmpty();
     }
 
 
@@ -217,6 +724,12 @@ namespace KIGFX {
 
 
     int VIEW::Query(const BOX2I& aRect, std::vector<LAYER_ITEM_PAIR>& aResult) const
+    {
+        return Query(BOX2D(aRect.GetOrigin(), aRect.GetSize()), aResult);
+    }
+
+
+    int VIEW::Query(const BOX2D& aRect, std::vector<LAYER_ITEM_PAIR>& aResult) const
     {
         if (m_orderedLayers.empty())
             return 0;
@@ -225,41 +738,257 @@ namespace KIGFX {
         auto visitor =
             [&](VIEW_ITEM* item) -> bool
             {
+                if (isOutsideIndexSlack(item, aRect))
+                    return true;
+
                 aResult.push_back(VIEW::LAYER_ITEM_PAIR(item, layer));
                 return true;
             };
 
-        std::vector<VIEW_LAYER*>::const_reverse_iterator i;
+        std::vector<VIEW_LAYER*>::const_reverse_iterator i;
+
+        // execute queries in reverse direction, so that items that are on the top of
+        // the rendering stack are returned first.
+        for (i = m_orderedLayers.rbegin(); i != m_orderedLayers.rend(); ++i)
+        {
+            // ignore layers that do not contain actual items (i.e. the selection box, menus, floats)
+            if ((*i)->displayOnly || !(*i)->visible)
+                continue;
+
+            layer = (*i)->id;
+            (*i)->items->Query(aRect, visitor);
+        }
+
+        return aResult.size();
+    }
+
+
+    void VIEW::Query(const BOX2I& aRect, const std::function<bool(VIEW_ITEM*)>& aFunc) const
+    {
+        Query(BOX2D(aRect.GetOrigin(), aRect.GetSize()), aFunc);
+    }
+
+
+    void VIEW::Query(const BOX2D& aRect, const std::function<bool(VIEW_ITEM*)>& aFunc) const
+    {
+        if (m_orderedLayers.empty())
+            return;
+
+        auto visitor =
+            [&](VIEW_ITEM* item) -> bool
+            {
+                if (isOutsideIndexSlack(item, aRect))
+                    return true;
+
+                return aFunc(item);
+            };
+
+        for (const auto& i : m_orderedLayers)
+        {
+            // ignore layers that do not contain actual items (i.e. the selection box, menus, floats)
+            if (i->displayOnly || !i->visible)
+                continue;
+
+            if (!i->items->Query(aRect, visitor))
+                return;
+        }
+    }
+
+
+    int VIEW::HitTest(const VECTOR2D& aPoint, double aTolerance,
+                      std::vector<LAYER_ITEM_PAIR>& aResult) const
+    {
+        const BOX2D area(aPoint - VECTOR2D(aTolerance, aTolerance),
+                         VECTOR2D(2 * aTolerance, 2 * aTolerance));
+        const size_t prevSize = aResult.size();
+        int layer = UNDEFINED_LAYER;
+
+        auto visitor =
+            [&](VIEW_ITEM* item)
+            {
+                if (item->viewPrivData()->isRenderable() && item->ViewHitDistance(aPoint) <= aTolerance)
+                    aResult.push_back(VIEW::LAYER_ITEM_PAIR(item, layer));
+            };
+
+        // top of the rendering stack first, like Query()
+        for (auto i = m_orderedLayers.rbegin(); i != m_orderedLayers.rend(); ++i)
+        {
+            if ((*i)->displayOnly || !(*i)->visible)
+                continue;
+
+            layer = (*i)->id;
+            (*i)->items->Query(area, visitor);
+        }
+
+        return aResult.size() - prevSize;
+    }
+
+
+    int VIEW::Nearest(const VECTOR2D& aPoint, int aCount, std::vector<ITEM_DISTANCE_PAIR>& aResult,
+                      double aMaxDistance) const
+    {
+        if (aCount <= 0)
+            return 0;
+
+        // Max-heap of the closest items so far, the farthest on top
+        std::vector<ITEM_DISTANCE_PAIR> best;
+        best.reserve(aCount);
+
+        auto farther =
+            [](const ITEM_DISTANCE_PAIR& aA, const ITEM_DISTANCE_PAIR& aB)
+            {
+                return aA.second < aB.second;
+            };
+
+        auto visitor =
+            [&](VIEW_ITEM* item, double boxDistance) -> bool
+            {
+                const bool full = best.size() == static_cast<size_t>(aCount);
+
+                // All the other items of the layer are at least that far
+                if (boxDistance > aMaxDistance || (full && boxDistance >= best.front().second))
+                    return false;
+
+                if (!item->viewPrivData()->isRenderable())
+                    return true;
+
+                const double distance = item->ViewHitDistance(aPoint);
+
+                if (distance > aMaxDistance || (full && distance >= best.front().second))
+                    return true;
+
+                // Already found on another layer, at the same distance
+                for (const ITEM_DISTANCE_PAIR& entry : best)
+                {
+                    if (entry.first == item)
+                        return true;
+                }
+
+                if (full)
+                {
+                    std::pop_heap(best.begin(), best.end(), farther);
+                    best.pop_back();
+                }
+
+                best.emplace_back(item, distance);
+                std::push_heap(best.begin(), best.end(), farther);
+                return true;
+            };
+
+        for (const VIEW_LAYER* layer : m_orderedLayers)
+        {
+            if (layer->displayOnly || !layer->visible)
+                continue;
+
+            layer->items->Nearest(aPoint, visitor, aMaxDistance);
+        }
+
+        std::sort_heap(best.begin(), best.end(), farther);
+        aResult.insert(aResult.end(), best.begin(), best.end());
+
+        return best.size();
+    }
+
+
+    int VIEW::Select(const SHAPE_LINE_CHAIN& aArea, bool aContained,
+                     std::vector<LAYER_ITEM_PAIR>& aResult) const
+    {
+        if (aArea.PointCount() == 0)
+            return 0;
+
+        SHAPE_LINE_CHAIN area(aArea);
+        area.SetClosed(true);
+
+        const VIEW_AREA_MAP map(area);
+        const size_t        prevSize = aResult.size();
+        THREAD_POOL&        pool = GetKiCadThreadPool();
+
+        std::vector<VIEW_ITEM*> candidates;
+        std::vector<uint8_t>    selected;
+
+        for (auto i = m_orderedLayers.rbegin(); i != m_orderedLayers.rend(); ++i)
+        {
+            const VIEW_LAYER* layer = *i;
+
+            if (layer->displayOnly || !layer->visible)
+                continue;
+
+            candidates.clear();
+            layer->items->Query(map.GetBBox(), candidates);
+            selected.assign(candidates.size(), 0);
+
+            pool.ParallelFor(candidates.size(),
+                [&](size_t aIndex)
+                {
+                    const VIEW_ITEM*      item = candidates[aIndex];
+                    const VIEW_ITEM_DATA* viewData = item->viewPrivData();
+
+                    if (!viewData->isRenderable())
+                        return;
+
+                    switch (map.Classify(viewData->m_bbox))
+                    {
+                    case VIEW_AREA_MAP::BOX_CLASS::INSIDE:   selected[aIndex] = 1; break;
+                    case VIEW_AREA_MAP::BOX_CLASS::OUTSIDE:  break;
+                    case VIEW_AREA_MAP::BOX_CLASS::CROSSING:
+                        selected[aIndex] = item->ViewHitTest(area, aContained);
+                        break;
+                    }
+                },
+                4096);
+
+            const size_t layerBegin = aResult.size();
+
+            for (size_t j = 0; j < candidates.size(); ++j)
+            {
+                if (selected[j])
+                    aResult.emplace_back(candidates[j], layer->id);
+            }
+
+            // Items drawn last are on top
+            if (m_useDrawPriority)
+            {
+                std::stable_sort(aResult.begin() + layerBegin, aResult.end(),
+                    [&](const LAYER_ITEM_PAIR& aA, const LAYER_ITEM_PAIR& aB)
+                    {
+                        const int a = aA.first->viewPrivData()->m_drawPriority;
+                        const int b = aB.first->viewPrivData()->m_drawPriority;
+
+                        return m_reverseDrawOrder ? a < b : a > b;
+                    });
+            }
+        }
+
+        return aResult.size() - prevSize;
+    }
 
-        // execute queries in reverse direction, so that items that are on the top of
-        // the rendering stack are returned first.
-        for (i = m_orderedLayers.rbegin(); i != m_orderedLayers.rend(); ++i)
-        {
-            // ignore layers that do not contain actual items (i.e. the selection box, menus, floats)
-            if ((*i)->displayOnly || !(*i)->visible)
-                continue;
 
-            layer = (*i)->id;
-            (*i)->items->Query(aRect, visitor);
-        }
+    int VIEW::Select(const BOX2I& aArea, bool aContained,
+                     std::vector<LAYER_ITEM_PAIR>& aResult) const
+    {
+        BOX2I box(aArea);
+        box.Normalize();
 
-        return aResult.size();
+        const SHAPE_LINE_CHAIN area({ box.GetOrigin(), VECTOR2I(box.GetRight(), box.GetTop()),
+                                      box.GetEnd(), VECTOR2I(box.GetLeft(), box.GetBottom()) },
+                                    true);
+
+        return Select(area, aContained, aResult);
     }
 
 
-    void VIEW::Query(const BOX2I& aRect, const std::function<bool(VIEW_ITEM*)>& aFunc) const
+    bool VIEW::isOutsideIndexSlack(const VIEW_ITEM* aItem, const BOX2D& aRect) const
     {
-        if (m_orderedLayers.empty())
-            return;
+        if (!m_hasIndexSlack)
+            return false;
 
-        for (const auto& i : m_orderedLayers)
-        {
-            // ignore layers that do not contain actual items (i.e. the selection box, menus, floats)
-            if (i->displayOnly || !i->visible)
-                continue;
+        const VIEW_ITEM_DATA* viewData = aItem->viewPrivData();
 
-            i->items->Query(aRect, aFunc);
-        }
+        // Items indexed with their exact bbox always match the R-tree query
+        if (!viewData || viewData->m_indexBbox == viewData->m_bbox)
+            return false;
+
+        return !viewData->m_bbox.Intersects(aRect);
     }
 
 
@@ -395,6 +1124,8 @@ namespace KIGFX {
 
     void VIEW::SetCenter(const VECTOR2D& aCenter)
     {
+        const VECTOR2D oldCenter = m_center;
+
         m_center = aCenter;
 
         if (!m_boundary.Contains(aCenter))
@@ -413,6 +1144,10 @@ namespace KIGFX {
         m_gal->SetLookAtPoint(m_center);
         m_gal->ComputeWorldScreenMatrix();
 
+        // The content moves on the screen opposite to the center
+        if (markScrolled(ToScreen(oldCenter) - ToScreen(m_center)))
+            return;
+
         // Redraw everything after the viewport has changed
         MarkDirty();
     }
@@ -453,6 +1188,42 @@ namespace KIGFX {
     }
 
 
+    void VIEW::SetLayerIndex(int aLayer, VIEW_INDEX_TYPE aType)
+    {
+        auto it = m_layers.find(aLayer);
+
+        if (it == m_layers.end() || it->second.items->GetType() == aType)
+            return;
+
+        // Re-index the items under the exact boxes they are stored with, so that the removal
+        // lookups (which use VIEW_ITEM_DATA::m_indexBbox) keep working
+        std::vector<VIEW_INDEX_ENTRY> entries;
+        entries.reserve(it->second.items->Size());
+
+        for (VIEW_ITEM* item : *m_allItems)
+        {
+            if (!item)
+                continue;
+
+            const VIEW_ITEM_DATA* viewData = item->viewPrivData();
+            const std::vector<int>& layers = viewData->m_layers;
+
+            if (std::find(layers.begin(), layers.end(), aLayer) != layers.end())
+                entries.emplace_back(viewData->m_indexBbox, item);
+        }
+
+        it->second.items->SetType(aType);
+        it->second.items->BulkLoad(entries);
+        MarkTargetDirty(it->second.target);
+    }
+
+
+    VIEW_INDEX_TYPE VIEW::GetLayerIndex(int aLayer) const
+    {
+        return m_layers.at(aLayer).items->GetType();
+    }
+
+
     void VIEW::SetLayerOrder(int aLayer, int aRenderingOrder)
     {
         m_layers[aLayer].renderingOrder = aRenderingOrder;
@@ -557,7 +1328,7 @@ namespace KIGFX {
         if (!IsCached(aLayer))
             return;
 
-        BOX2I r;
+        BOX2D r;
 
         r.SetMaximum();
 
@@ -735,27 +1506,21 @@ namespace KIGFX {
     }
 
 
-    struct VIEW::DRAW_ITEM_VISITOR
+    struct VIEW::CULL_ITEM_VISITOR
     {
-        DRAW_ITEM_VISITOR(VIEW* aView, int aLayer, bool aUseDrawPriority, bool aReverseDrawOrder) :
+        CULL_ITEM_VISITOR(const VIEW* aView, LAYER_DRAW_LIST& aList) :
             view(aView),
-            layer(aLayer),
-            useDrawPriority(aUseDrawPriority),
-            reverseDrawOrder(aReverseDrawOrder),
-            drawForcedTransparent(false),
-            foundForcedTransparent(false)
+            layer(aList.layer->id),
+            list(aList)
         {
         }
 
         bool operator()(VIEW_ITEM* aItem)
         {
-            if (!aItem->viewPrivData()) return false;
+            if (!aItem->viewPrivData()) return true;
 
-            if (aItem->m_forcedTransparency > 0 && !drawForcedTransparent)
-            {
-                foundForcedTransparent = true;
-                return true;
-            }
+            if (aItem->m_forcedTransparency > 0)
+                list.hasForcedTransparent = true;
 
             const double itemLOD = aItem->ViewGetLOD(layer, view);
 
@@ -765,88 +1530,222 @@ namespace KIGFX {
             if (!drawCondition)
                 return true;
 
-            if (useDrawPriority)
-                drawItems.push_back(aItem);
+            if (view->m_useDrawPriority)
+            {
+                // The priority is read while the item data is at hand, so sorting does not
+                // have to chase the item pointers. Flipping the sign bit orders negative
+                // priorities first when compared unsigned.
+                uint32_t key = static_cast<uint32_t>(aItem->viewPrivData()->m_drawPriority)
+                               ^ 0x80000000u;
+
+                list.sortKeys.emplace_back(view->m_reverseDrawOrder ? ~key : key, aItem);
+            }
             else
-                view->draw(aItem, layer);
+            {
+                list.items.push_back(aItem);
+            }
 
             return true;
         }
 
-        void deferredDraw()
-        {
-            if (reverseDrawOrder)
+        const VIEW* view;
+        int layer;
+        LAYER_DRAW_LIST& list;
+    };
+
+
+    bool VIEW::canAggregate(const VIEW_ITEM* aItem, int aLayer) const
+    {
+        // Items hidden by their LOD and items needing the transparent pass are left to the
+        // usual culling. The LOD of aggregated items is only checked when they are binned.
+        return aItem->viewPrivData()->isRenderable() && aItem->m_forcedTransparency <= 0
+               && aItem->ViewGetLOD(aLayer, this) < m_scale;
+    }
+
+
+    void VIEW::updateLayerLOD(VIEW_LAYER& aLayer, double aCellSize) const
+    {
+        VIEW_LOD_CACHE& lod = *aLayer.lod;
+
+        auto addItem =
+            [&](VIEW_ITEM* aItem)
             {
-                std::sort(drawItems.begin(), drawItems.end(),
-                    [](VIEW_ITEM* a, VIEW_ITEM* b) -> bool
-                    {
-                        return b->viewPrivData()->m_drawPriority
-                            < a->viewPrivData()->m_drawPriority;
-                    });
-            }
-            else
+                const VIEW_ITEM_DATA* viewData = aItem->viewPrivData();
+
+                if (viewData && viewData->isRenderable())
+                    lod.Add(aItem, viewData->m_bbox, canAggregate(aItem, aLayer.id));
+            };
+
+        if (lod.IsValid(aCellSize))
+        {
+            if (lod.NeedsRefill())
             {
-                std::sort(drawItems.begin(), drawItems.end(),
-                    [](VIEW_ITEM* a, VIEW_ITEM* b) -> bool
+                lod.Refill(
+                    [&](const BOX2D& aArea)
                     {
-                        return a->viewPrivData()->m_drawPriority
-                            < b->viewPrivData()->m_drawPriority;
+                        aLayer.items->Query(aArea, addItem);
                     });
             }
 
-            for (VIEW_ITEM* item : drawItems)
-                view->draw(item, layer);
+            return;
         }
 
-        VIEW* view;
-        int layer, layers[VIEW_MAX_LAYERS];
-        bool useDrawPriority, reverseDrawOrder;
-        std::vector<VIEW_ITEM*> drawItems;
-        bool drawForcedTransparent;
-        bool foundForcedTransparent;
-    };
+        BOX2D all;
+        all.SetMaximum();
+
+        lod.Begin(aCellSize, aLayer.items->Size());
+        aLayer.items->Query(all, addItem);
+        lod.End();
+    }
+
+
+    void VIEW::updateItemLOD(VIEW_ITEM* aItem, int aLayer, const BOX2D* aOldBbox,
+                             const BOX2D* aNewBbox)
+    {
+        auto it = m_layers.find(aLayer);
+
+        if (it == m_layers.end())
+            return;
+
+        // The quads of the cells span more than the item itself
+        const BOX2D changed = it->second.lod->Update(aItem, aOldBbox, aNewBbox,
+                                                     aNewBbox && canAggregate(aItem, aLayer));
 
+        if (changed.IsValid())
+            MarkTargetDamaged(it->second.target, changed);
+    }
+
+
+    void VIEW::cullLayer(LAYER_DRAW_LIST& aList, const BOX2D& aRect) const
+    {
+        CULL_ITEM_VISITOR cullFunc(this, aList);
+
+        aList.items.clear();
+        aList.sortKeys.clear();
+        aList.aggregates.clear();
+        aList.hasForcedTransparent = false;
+
+        if (m_aggregateThreshold > 0.0)
+        {
+            // Power of two cell sizes, so the cache is only refilled when the zoom has doubled
+            // or halved
+            const double cellSize = std::exp2(std::ceil(std::log2(ToWorld(m_aggregateThreshold))));
+            VIEW_LOD_CACHE& lod = *aList.layer->lod;
+
+            // Each layer is culled by a single thread, so its cache can be filled here
+            updateLayerLOD(*aList.layer, cellSize);
+
+            if (lod.IsAggregating())
+                lod.Query(aRect, aList.aggregates, cullFunc);
+            else
+                aList.layer->items->Query(aRect, cullFunc);
+        }
+        else
+        {
+            aList.layer->items->Query(aRect, cullFunc);
+        }
+
+        if (!m_useDrawPriority)
+            return;
 
-    void VIEW::redrawRect(const BOX2I& aRect)
+        alg::radix_sort_by_key(aList.sortKeys, aList.sortScratch);
+
+        aList.items.reserve(aList.sortKeys.size());
+
+        for (const auto& [key, item] : aList.sortKeys)
+            aList.items.push_back(item);
+    }
+
+
+    void VIEW::redrawRect(const BOX2D& aRect)
     {
+        PROF_TIMER cullTimer;
+        size_t     count = 0;
+
         for (VIEW_LAYER* l : m_orderedLayers)
         {
             if (l->visible && IsTargetDirty(l->target) && areRequiredLayersEnabled(l->id))
             {
-                DRAW_ITEM_VISITOR drawFunc(this, l->id, m_useDrawPriority, m_reverseDrawOrder);
+                if (count == m_drawLists.size())
+                    m_drawLists.emplace_back();
 
-                m_gal->SetTarget(l->target);
-                m_gal->SetLayerDepth(l->renderingOrder);
+                m_drawLists[count++].layer = l;
+            }
+        }
+
+        // Culling only reads the items and the index, so layers are processed concurrently.
+        // Anything touching the GAL has to stay on this thread.
+        GetKiCadThreadPool().ParallelFor(count,
+            [&](size_t aIndex)
+            {
+                cullLayer(m_drawLists[aIndex], aRect);
+            });
 
-                // Differential layer also work for the negatives, since both special layer types
-                // will composite on separate layers (at least in Cairo)
-                if (l->diffLayer)
-                    m_gal->StartDiffLayer();
-                else if (l->hasNegatives)
-                    m_gal->StartNegativesLayer();
+        cullTimer.Stop();
+        PROF_TIMER submitTimer;
 
-                l->items->Query(aRect, drawFunc);
+        for (size_t i = 0; i < count; ++i)
+        {
+            const LAYER_DRAW_LIST& list = m_drawLists[i];
+            const VIEW_LAYER*      l = list.layer;
 
-                if (m_useDrawPriority)
-                    drawFunc.deferredDraw();
+            m_gal->SetTarget(l->target);
+            m_gal->SetLayerDepth(l->renderingOrder);
 
-                if (l->diffLayer)
-                    m_gal->EndDiffLayer();
-                else if (l->hasNegatives)
-                    m_gal->EndNegativesLayer();
+            if (!list.aggregates.empty())
+            {
+                // Aggregates change with the zoom, there is no point in caching them
+                m_gal->SetTarget(TARGET_NONCACHED);
 
-                if (drawFunc.foundForcedTransparent)
-                {
-                    drawFunc.drawForcedTransparent = true;
+                for (const VIEW_LOD_CELL* cell : list.aggregates)
+                    m_painter->DrawAggregate(cell->bbox, cell->coverage, l->id);
 
-                    m_gal->SetTarget(TARGET_NONCACHED);
-                    m_gal->EnableDepthTest(true);
-                    m_gal->SetLayerDepth(l->renderingOrder);
+                m_gal->SetTarget(l->target);
+            }
+
+            // Differential layer also work for the negatives, since both special layer types
+            // will composite on separate layers (at least in Cairo)
+            if (l->diffLayer)
+                m_gal->StartDiffLayer();
+            else if (l->hasNegatives)
+                m_gal->StartNegativesLayer();
+
+            // Items drawn in immediate mode may be batched by the painter, unless they have to
+            // keep their priority order or some of them are drawn later
+            const bool batched = !IsCached(l->id) && !m_useDrawPriority
+                                 && !list.hasForcedTransparent
+                                 && m_painter->DrawItems(list.items, l->id);
 
-                    l->items->Query(aRect, drawFunc);
+            if (!batched)
+            {
+                for (VIEW_ITEM* item : list.items)
+                {
+                    if (item->m_forcedTransparency <= 0)
+                        draw(item, l->id);
                 }
             }
+
+            if (l->diffLayer)
+                m_gal->EndDiffLayer();
+            else if (l->hasNegatives)
+                m_gal->EndNegativesLayer();
+
+            if (list.hasForcedTransparent)
+            {
+                m_gal->SetTarget(TARGET_NONCACHED);
+                m_gal->EnableDepthTest(true);
+                m_gal->SetLayerDepth(l->renderingOrder);
+
+                for (VIEW_ITEM* item : list.items)
+                    draw(item, l->id);
+            }
         }
+
+        submitTimer.Stop();
+
+        // A redraw of several areas calls this more than once
+        m_lastCullTime += cullTimer.msecs();
+        m_lastSubmitTime += submitTimer.msecs();
     }
 
 
@@ -894,83 +1793,237 @@ namespace KIGFX {
             if (m_gal)
                 m_gal->SetLayerDepth(it->second.renderingOrder);
 
-            draw(aItem, layer, aImmediate);
-        }
+            draw(aItem, layer, aImmediate);
+        }
+    }
+
+
+    //void VIEW::draw(VIEW_GROUP* aGroup, bool aImmediate)
+    //{
+        //for (unsigned int i = 0; i < aGroup->GetSize(); i++)
+        //    draw(aGroup->GetItem(i), aImmediate);
+    //}
+
+
+    struct VIEW::RECACHE_ITEM_VISITOR
+    {
+        RECACHE_ITEM_VISITOR(VIEW* aView, GAL* aGal, int aLayer) :
+            view(aView),
+            gal(aGal),
+            layer(aLayer)
+        {
+        }
+
+        bool operator()(VIEW_ITEM* aItem)
+        {
+            VIEW_ITEM_DATA* viewData = aItem->viewPrivData();
+
+            if (!viewData)
+                return true;
+
+            // Remove previously cached group
+            int group = viewData->getGroup(layer);
+
+            if (group >= 0)
+                gal->DeleteGroup(group);
+
+            viewData->setGroup(layer, -1);
+            view->Update(aItem);
+
+            return true;
+        }
+
+        VIEW* view;
+        GAL* gal;
+        int layer;
+    };
+
+
+    void VIEW::Clear()
+    {
+        // Detach the items, so they do not try to remove themselves from this view later
+        for (VIEW_ITEM* item : *m_allItems)
+        {
+            if (item && item->m_viewPrivData && item->m_viewPrivData->m_view == this)
+                freeItemData(item);
+        }
+
+        m_allItems->clear();
+        m_itemDataPool->ReleaseMemory();
+
+        for (auto& [_, layer] : m_layers)
+        {
+            layer.items->RemoveAll();
+            layer.lod->Invalidate();
+        }
+
+        if (m_snapIndex)
+            m_snapIndex->RemoveAll();
+
+        m_nextDrawPriority = 0;
+        m_hasIndexSlack = false;
+
+        if (m_gal)
+            m_gal->ClearCache();
+    }
+
+
+    void VIEW::ClearTargets()
+    {
+        if (IsTargetDirty(TARGET_CACHED) || IsTargetDirty(TARGET_NONCACHED))
+        {
+            // TARGET_CACHED and TARGET_NONCACHED have to be redrawn together, as they contain
+            // layers that rely on each other (eg. netnames are noncached, but tracks - are cached)
+            m_gal->ClearTarget(TARGET_NONCACHED);
+            m_gal->ClearTarget(TARGET_CACHED);
+
+            MarkDirty();
+        }
+
+        if (IsTargetDirty(TARGET_OVERLAY))
+        {
+            m_gal->ClearTarget(TARGET_OVERLAY);
+        }
+    }
+
+
+    void VIEW::MarkTargetDamaged(int aTarget, const BOX2D& aArea)
+    {
+        if (aTarget >= TARGETS_NUMBER)
+            return;
+
+        if (!m_useDamageRedraw)
+        {
+            MarkTargetDirty(aTarget);
+            return;
+        }
+
+        // Nothing to add if the whole target is going to be redrawn anyway
+        if (m_fullRedrawTargets[aTarget])
+            return;
+
+        BOX2D area = aArea;
+        area.Normalize();
+
+        if (m_dirtyTargets[aTarget])
+        {
+            m_damagedArea[aTarget].Merge(area);
+        }
+        else
+        {
+            m_damagedArea[aTarget] = area;
+            m_dirtyTargets[aTarget] = true;
+        }
+    }
+
+
+    bool VIEW::getDamagedArea(const BOX2D& aViewport, BOX2D& aArea) const
+    {
+        aArea = BOX2D();
+
+        for (int i = 0; i < TARGETS_NUMBER; ++i)
+        {
+            if (!m_dirtyTargets[i])
+                continue;
+
+            if (m_fullRedrawTargets[i])
+                return false;
+
+            aArea.Merge(m_damagedArea[i]);
+        }
+
+        if (!aArea.IsValid())
+            return true;
+
+        aArea = aArea.Intersect(aViewport);
+
+        return aArea.GetWidth() * aArea.GetHeight()
+               < aViewport.GetWidth() * aViewport.GetHeight() * MAX_PARTIAL_REDRAW_RATIO;
     }
 
 
-    //void VIEW::draw(VIEW_GROUP* aGroup, bool aImmediate)
-    //{
-        //for (unsigned int i = 0; i < aGroup->GetSize(); i++)
-        //    draw(aGroup->GetItem(i), aImmediate);
-    //}
+    bool VIEW::markScrolled(const VECTOR2D& aShift)
+    {
+        // Largest error of a single shift and accumulated error of the reused image, in pixels
+        constexpr double MAX_SHIFT_ERROR = 0.01;
+        constexpr double MAX_DRIFT = 0.1;
 
+        if (!m_useScrollBlit)
+            return false;
 
-    struct VIEW::RECACHE_ITEM_VISITOR
-    {
-        RECACHE_ITEM_VISITOR(VIEW* aView, GAL* aGal, int aLayer) :
-            view(aView),
-            gal(aGal),
-            layer(aLayer)
+        for (int i = 0; i < TARGETS_NUMBER; ++i)
         {
+            if (m_fullRedrawTargets[i])
+                return false;
         }
 
-        bool operator()(VIEW_ITEM* aItem)
-        {
-            VIEW_ITEM_DATA* viewData = aItem->viewPrivData();
+        const VECTOR2D pixels(std::round(aShift.x), std::round(aShift.y));
+        const VECTOR2D error = aShift - pixels;
+        const VECTOR2D drift = m_scrollDrift + error;
 
-            if (!viewData)
-                return false;
+        if (std::abs(error.x) > MAX_SHIFT_ERROR || std::abs(error.y) > MAX_SHIFT_ERROR
+            || std::abs(drift.x) > MAX_DRIFT || std::abs(drift.y) > MAX_DRIFT)
+        {
+            return false;
+        }
 
-            // Remove previously cached group
-            int group = viewData->getGroup(layer);
+        const VECTOR2I scroll = m_pendingScroll
+                                + VECTOR2I(static_cast<int>(pixels.x), static_cast<int>(pixels.y));
+        const VECTOR2D screen = m_gal->GetScreenPixelSize();
+        const double   exposed = std::abs(scroll.x) * screen.y + std::abs(scroll.y) * screen.x
+                                 - std::abs(double(scroll.x) * scroll.y);
 
-            if (group >= 0)
-                gal->DeleteGroup(group);
+        if (std::abs(scroll.x) >= screen.x || std::abs(scroll.y) >= screen.y
+            || exposed > screen.x * screen.y * MAX_PARTIAL_REDRAW_RATIO)
+        {
+            return false;
+        }
 
-            viewData->setGroup(layer, -1);
-            view->Update(aItem);
+        m_pendingScroll = scroll;
+        m_scrollDrift = drift;
 
-            return true;
+        // The scrolled targets are dirty, but only along the exposed edges
+        for (int target : { TARGET_CACHED, TARGET_NONCACHED, TARGET_OVERLAY })
+        {
+            if (!m_dirtyTargets[target])
+            {
+                m_dirtyTargets[target] = true;
+                m_damagedArea[target] = BOX2D();
+            }
         }
 
-        VIEW* view;
-        GAL* gal;
-        int layer;
-    };
+        return true;
+    }
 
 
-    void VIEW::Clear()
+    void VIEW::redrawArea(const BOX2D& aArea)
     {
-        BOX2I r;
-        r.SetMaximum();
-        m_allItems->clear();
-
-        for (auto& [_, layer] : m_layers)
-            layer.items->RemoveAll();
-
-        m_nextDrawPriority = 0;
+        BOX2D area = aArea;
+        area.Normalize();
+        area.Inflate(ToWorld(REDRAW_AREA_MARGIN));
 
-        m_gal->ClearCache();
-    }
+        const VECTOR2D corner0 = ToScreen(area.GetOrigin());
+        const VECTOR2D corner1 = ToScreen(area.GetEnd());
+        const VECTOR2I origin(static_cast<int>(std::floor(std::min(corner0.x, corner1.x))),
+                              static_cast<int>(std::floor(std::min(corner0.y, corner1.y))));
+        const VECTOR2I end(static_cast<int>(std::ceil(std::max(corner0.x, corner1.x))),
+                           static_cast<int>(std::ceil(std::max(corner0.y, corner1.y))));
 
+        // Everything outside of the area is kept from the previous frame
+        m_gal->SetClipArea(BOX2I(origin, end - origin));
 
-    void VIEW::ClearTargets()
-    {
+        // Cached and noncached layers share a buffer, so clearing it erases both of them
         if (IsTargetDirty(TARGET_CACHED) || IsTargetDirty(TARGET_NONCACHED))
         {
-            // TARGET_CACHED and TARGET_NONCACHED have to be redrawn together, as they contain
-            // layers that rely on each other (eg. netnames are noncached, but tracks - are cached)
+            m_dirtyTargets[TARGET_CACHED] = true;
+            m_dirtyTargets[TARGET_NONCACHED] = true;
             m_gal->ClearTarget(TARGET_NONCACHED);
-            m_gal->ClearTarget(TARGET_CACHED);
-
-            MarkDirty();
         }
 
         if (IsTargetDirty(TARGET_OVERLAY))
-        {
             m_gal->ClearTarget(TARGET_OVERLAY);
-        }
+
+        redrawRect(area);
     }
 
 
@@ -985,16 +2038,65 @@ namespace KIGFX {
             ToWorld(screenSize) - ToWorld(VECTOR2D(0, 0)));
 
         rect.Normalize();
-        BOX2I recti = BOX2ISafe(rect);
 
-        redrawRect(recti);
+        m_lastCullTime = 0.0;
+        m_lastSubmitTime = 0.0;
+
+        const VECTOR2I scroll = m_pendingScroll;
+        BOX2D          damage;
+        bool           partial = getDamagedArea(rect, damage);
+
+        // Reuse the previous frame, shifted, for the parts that are still visible
+        if (partial && (scroll.x != 0 || scroll.y != 0) && !m_gal->ScrollTargets(scroll))
+        {
+            MarkDirty();
+            partial = false;
+        }
+
+        if (!partial)
+        {
+            redrawRect(rect);
+            m_scrollDrift = VECTOR2D(0.0, 0.0);
+        }
+        else
+        {
+            const VECTOR2D size = screenSize;
+
+            // Redraw the edges uncovered by scrolling: a full height strip on the left or right
+            // and the rest of the top or bottom rows
+            if (scroll.x != 0)
+            {
+                const double left = scroll.x > 0 ? 0.0 : size.x + scroll.x;
+
+                redrawArea(BOX2D(ToWorld(VECTOR2D(left, 0.0)),
+                                 ToWorld(VECTOR2D(left + std::abs(scroll.x), size.y))
+                                     - ToWorld(VECTOR2D(left, 0.0))));
+            }
+
+            if (scroll.y != 0)
+            {
+                const double top = scroll.y > 0 ? 0.0 : size.y + scroll.y;
+                const double left = scroll.x > 0 ? scroll.x : 0.0;
+                const double right = scroll.x < 0 ? size.x + scroll.x : size.x;
+
+                redrawArea(BOX2D(ToWorld(VECTOR2D(left, top)),
+                                 ToWorld(VECTOR2D(right, top + std::abs(scroll.y)))
+                                     - ToWorld(VECTOR2D(left, top))));
+            }
+
+            if (damage.GetWidth() > 0 && damage.GetHeight() > 0)
+                redrawArea(damage);
+        }
 
         // All targets were redrawn, so nothing is dirty
+        m_pendingScroll = VECTOR2I(0, 0);
         MarkClean();
 
 #ifdef KICAD_GAL_PROFILE
         totalRealTime.Stop();
-        wxLogTrace(traceGalProfile, wxS("VIEW::Redraw(): %.1f ms"), totalRealTime.msecs());
+        spdlog::trace(std::format("[{}] VIEW::Redraw(): {:.1f} ms (cull {:.1f} ms, submit {:.1f} ms)",
+                                  traceGalProfile, totalRealTime.msecs(), m_lastCullTime,
+                                  m_lastSubmitTime));
 #endif /* KICAD_GAL_PROFILE */
     }
 
@@ -1025,7 +2127,7 @@ namespace KIGFX {
 
     void VIEW::clearGroupCache()
     {
-        BOX2I r;
+        BOX2D r;
 
         r.SetMaximum();
         CLEAR_LAYER_CACHE_VISITOR visitor(this);
@@ -1037,6 +2139,10 @@ namespace KIGFX {
 
     void VIEW::invalidateItem(VIEW_ITEM* aItem, int aUpdateFlags)
     {
+        // Visibility changes add or remove the item from the aggregates. Add() took care of
+        // new items already.
+        const bool visibilityChanged = (aUpdateFlags & APPEARANCE) && !(aUpdateFlags & INITIAL_ADD);
+
         if (aUpdateFlags & INITIAL_ADD)
         {
             // Don't update layers or bbox, since it was done in VIEW::Add()
@@ -1050,7 +2156,7 @@ namespace KIGFX {
             if (aUpdateFlags & LAYERS)
                 updateLayers(aItem);
             else if (aUpdateFlags & GEOMETRY)
-                updateBbox(aItem);
+                UpdateBBox(aItem);
         }
 
         std::vector<int> layers = aItem->ViewGetLayers();
@@ -1066,8 +2172,11 @@ namespace KIGFX {
                     updateItemColor(aItem, layer);
             }
 
+            if (visibilityChanged)
+                m_layers[layer].lod->Invalidate();
+
             // Mark those layers as dirty, so the VIEW will be refreshed
-            MarkTargetDirty(m_layers[layer].target);
+            MarkTargetDamaged(m_layers[layer].target, aItem->viewPrivData()->m_bbox);
         }
 
         aItem->viewPrivData()->clearUpdateFlags();
@@ -1144,28 +2253,58 @@ namespace KIGFX {
     }
 
 
-    void VIEW::updateBbox(VIEW_ITEM* aItem)
+    void VIEW::UpdateBBox(VIEW_ITEM* aItem)
     {
-        std::vector<int> layers = aItem->ViewGetLayers();
+        VIEW_ITEM_DATA* viewData = aItem->viewPrivData();
 
-        Q_ASSERT(aItem->m_viewPrivData); //must have a viewPrivData
+        if (!viewData || viewData->m_view != this)
+            return;
 
-        const BOX2I  new_bbox = aItem->ViewBBox();
-        const BOX2I* old_bbox = &aItem->m_viewPrivData->m_bbox;
-        aItem->m_viewPrivData->m_bbox = new_bbox;
+        const BOX2D old_bbox = viewData->m_bbox;
+        const BOX2D new_bbox = aItem->ViewBBoxD();
+        viewData->m_bbox = new_bbox;
 
-        for (int layer : layers)
+        if (m_snapIndex)
         {
-            auto it = m_layers.find(layer);
+            m_snapIndex->Remove(aItem, old_bbox);
+            insertAnchors(aItem);
+        }
 
-            if (it == m_layers.end())
-                continue;
+        // The item has to be erased where it was and drawn where it is now
+        BOX2D damage = old_bbox;
+        damage.Merge(new_bbox);
 
-            VIEW_LAYER& l = it->second;
-            l.items->Remove(aItem, old_bbox);
-            l.items->Insert(aItem, new_bbox);
-            MarkTargetDirty(l.target);
+        for (int layer : viewData->m_layers)
+        {
+            updateItemLOD(aItem, layer, &old_bbox, &new_bbox);
+            MarkTargetDamaged(m_layers[layer].target, damage);
+        }
+
+        BOX2D newBox = new_bbox;
+        BOX2D indexBox = viewData->m_indexBbox;
+        newBox.Normalize();
+        indexBox.Normalize();
+
+        // Still inside the box it is indexed with, so the R-tree entries remain valid
+        if (indexBox.Contains(newBox))
+            return;
+
+        // Re-insert with some slack: a fraction of the item size, plus twice the last move so
+        // an item that keeps being dragged the same way stays inside for the next updates
+        const VECTOR2D motion = newBox.Centre() - old_bbox.Centre();
+
+        newBox.Inflate(std::max(newBox.GetWidth(), newBox.GetHeight()) / 8
+                       + 2 * std::max(std::abs(motion.x), std::abs(motion.y)));
+
+        for (int layer : viewData->m_layers)
+        {
+            VIEW_LAYER& l = m_layers[layer];
+            l.items->Remove(aItem, &viewData->m_indexBbox);
+            l.items->Insert(aItem, newBox);
         }
+
+        viewData->m_indexBbox = newBox;
+        m_hasIndexSlack = true;
     }
 
 
@@ -1177,7 +2316,7 @@ namespace KIGFX {
             return;
 
         // Remove the item from previous layer set
-        const BOX2I* old_bbox = &aItem->m_viewPrivData->m_bbox;
+        const BOX2D* old_bbox = &aItem->m_viewPrivData->m_indexBbox;
 
         for (int layer : aItem->m_viewPrivData->m_layers)
         {
@@ -1188,7 +2327,8 @@ namespace KIGFX {
 
             VIEW_LAYER& l = it->second;
             l.items->Remove(aItem, old_bbox);
-            MarkTargetDirty(l.target);
+            updateItemLOD(aItem, layer, &viewData->m_bbox, nullptr);
+            MarkTargetDamaged(l.target, viewData->m_bbox);
 
             if (IsCached(l.id))
             {
@@ -1203,8 +2343,15 @@ namespace KIGFX {
             }
         }
 
-        const BOX2I new_bbox = aItem->ViewBBox();
+        if (m_snapIndex)
+            m_snapIndex->Remove(aItem, viewData->m_bbox);
+
+        const BOX2D new_bbox = aItem->ViewBBoxD();
         aItem->m_viewPrivData->m_bbox = new_bbox;
+        aItem->m_viewPrivData->m_indexBbox = new_bbox;
+
+        if (m_snapIndex)
+            insertAnchors(aItem);
 
         // Add the item to new layer set
         std::vector<int> layers = aItem->ViewGetLayers();
@@ -1219,7 +2366,8 @@ namespace KIGFX {
 
             VIEW_LAYER& l = it->second;
             l.items->Insert(aItem, new_bbox);
-            MarkTargetDirty(l.target);
+            updateItemLOD(aItem, layer, nullptr, &new_bbox);
+            MarkTargetDamaged(l.target, new_bbox);
         }
     }
 
@@ -1250,7 +2398,7 @@ namespace KIGFX {
 
     void VIEW::RecacheAllItems()
     {
-        BOX2I r;
+        BOX2D r;
 
         r.SetMaximum();
 
@@ -1265,6 +2413,275 @@ namespace KIGFX {
     }
 
 
+    void VIEW::rebuildIndexes()
+    {
+        const std::vector<VIEW_ITEM*>& allItems = *m_allItems;
+        THREAD_POOL&                   pool = GetKiCadThreadPool();
+
+        // The items are split in one slice per thread. Small slices are not worth a thread.
+        constexpr size_t MIN_SLICE_SIZE = 4096;
+        const size_t     sliceCount = std::clamp<size_t>(allItems.size() / MIN_SLICE_SIZE, 1,
+                                                         pool.GetThreadCount() + 1);
+        const size_t     sliceSize = (allItems.size() + sliceCount - 1) / sliceCount;
+
+        // Entries of each layer per slice, to find where each slice writes its entries
+        std::vector<std::vector<size_t>> sliceCounts(sliceCount,
+                                                     std::vector<size_t>(VIEW_MAX_LAYERS, 0));
+
+        // Bboxes and layers come from the items themselves, which is the expensive part
+        pool.ParallelFor(sliceCount,
+            [&](size_t aSlice)
+            {
+                std::vector<size_t>& counts = sliceCounts[aSlice];
+                const size_t         end = std::min(allItems.size(), (aSlice + 1) * sliceSize);
+
+                for (size_t i = aSlice * sliceSize; i < end; ++i)
+                {
+                    VIEW_ITEM* item = allItems[i];
+
+                    if (!item)
+                        continue;
+
+                    VIEW_ITEM_DATA* viewData = item->m_viewPrivData;
+                    const BOX2D     bbox = item->ViewBBoxD();
+
+                    viewData->m_bbox = bbox;
+                    viewData->m_indexBbox = bbox;
+                    viewData->saveLayers(item->ViewGetLayers());
+                    viewData->m_requiredUpdate &= ~(LAYERS | GEOMETRY);
+
+                    for (int layer : viewData->m_layers)
+                        counts[layer]++;
+                }
+            });
+
+        std::vector<std::vector<VIEW_INDEX_ENTRY>> layerEntries(VIEW_MAX_LAYERS);
+
+        for (int layer = 0; layer < VIEW_MAX_LAYERS; ++layer)
+        {
+            size_t total = 0;
+
+            // Turn the counts into the offsets of the slices
+            for (std::vector<size_t>& counts : sliceCounts)
+                total += std::exchange(counts[layer], total);
+
+            layerEntries[layer].resize(total);
+        }
+
+        // Entries keep the order of m_allItems, so the indexes do not depend on the thread count
+        pool.ParallelFor(sliceCount,
+            [&](size_t aSlice)
+            {
+                std::vector<size_t>& offsets = sliceCounts[aSlice];
+                const size_t         end = std::min(allItems.size(), (aSlice + 1) * sliceSize);
+
+                for (size_t i = aSlice * sliceSize; i < end; ++i)
+                {
+                    VIEW_ITEM* item = allItems[i];
+
+                    if (!item)
+                        continue;
+
+                    const VIEW_ITEM_DATA* viewData = item->m_viewPrivData;
+
+                    for (int layer : viewData->m_layers)
+                        layerEntries[layer][offsets[layer]++] = { viewData->m_bbox, item };
+                }
+            });
+
+        std::vector<int> layers;
+
+        for (auto& [id, l] : m_layers)
+        {
+            if (id >= 0 && id < VIEW_MAX_LAYERS && !layerEntries[id].empty())
+            {
+                layers.push_back(id);
+                MarkTargetDirty(l.target);
+            }
+        }
+
+        // Each layer has its own index, they are packed concurrently
+        pool.ParallelFor(layers.size(),
+            [&](size_t aIndex)
+            {
+                const int layer = layers[aIndex];
+                m_layers.at(layer).items->BulkLoad(layerEntries[layer]);
+            });
+
+        // The anchors moved with the items
+        if (m_snapIndex)
+        {
+            m_snapIndex->RemoveAll();
+            rebuildSnapIndex();
+        }
+    }
+
+
+    void VIEW::insertAnchors(VIEW_ITEM* aItem)
+    {
+        std::vector<VIEW_ANCHOR> anchors;
+
+        aItem->ViewGetAnchors(anchors);
+        m_snapIndex->Insert(aItem, anchors);
+    }
+
+
+    void VIEW::rebuildSnapIndex()
+    {
+        const std::vector<VIEW_ITEM*>& allItems = *m_allItems;
+        THREAD_POOL&                   pool = GetKiCadThreadPool();
+
+        // Same slicing as rebuildIndexes()
+        constexpr size_t MIN_SLICE_SIZE = 4096;
+        const size_t     sliceCount = std::clamp<size_t>(allItems.size() / MIN_SLICE_SIZE, 1,
+                                                         pool.GetThreadCount() + 1);
+        const size_t     sliceSize = (allItems.size() + sliceCount - 1) / sliceCount;
+
+        std::vector<std::vector<VIEW_SNAP_INDEX::ENTRY>> sliceEntries(sliceCount);
+
+        pool.ParallelFor(sliceCount,
+            [&](size_t aSlice)
+            {
+                std::vector<VIEW_ANCHOR> anchors;
+                const size_t             end = std::min(allItems.size(), (aSlice + 1) * sliceSize);
+
+                for (size_t i = aSlice * sliceSize; i < end; ++i)
+                {
+                    VIEW_ITEM* item = allItems[i];
+
+                    if (!item)
+                        continue;
+
+                    anchors.clear();
+                    item->ViewGetAnchors(anchors);
+
+                    for (const VIEW_ANCHOR& anchor : anchors)
+                        sliceEntries[aSlice].push_back({ anchor.point, item, anchor.type });
+                }
+            });
+
+        std::vector<VIEW_SNAP_INDEX::ENTRY> entries;
+        size_t                              total = 0;
+
+        for (const std::vector<VIEW_SNAP_INDEX::ENTRY>& slice : sliceEntries)
+            total += slice.size();
+
+        entries.reserve(total);
+
+        for (std::vector<VIEW_SNAP_INDEX::ENTRY>& slice : sliceEntries)
+        {
+            entries.insert(entries.end(), slice.begin(), slice.end());
+            slice = {};
+        }
+
+        m_snapIndex->BulkLoad(entries);
+    }
+
+
+    void VIEW::EnableSnapIndex(bool aEnable)
+    {
+        if (aEnable == IsSnapIndexEnabled())
+            return;
+
+        if (aEnable)
+        {
+            m_snapIndex = std::make_unique<VIEW_SNAP_INDEX>();
+            rebuildSnapIndex();
+        }
+        else
+        {
+            m_snapIndex.reset();
+        }
+    }
+
+
+    bool VIEW::isSnappable(const VIEW_ITEM* aItem) const
+    {
+        const VIEW_ITEM_DATA* viewData = aItem->viewPrivData();
+
+        if (!viewData || !viewData->isRenderable())
+            return false;
+
+        for (int layer : viewData->m_layers)
+        {
+            auto it = m_layers.find(layer);
+
+            if (it != m_layers.end() && it->second.visible && !it->second.displayOnly)
+                return true;
+        }
+
+        return false;
+    }
+
+
+    std::optional<VIEW_ANCHOR> VIEW::GetSnapAnchor(const VECTOR2D& aPoint,
+                                                   double aScreenDistance) const
+    {
+        // Enough to skip a few hidden items, and to find the intersections of a few edges
+        constexpr size_t ANCHOR_CANDIDATES = 16;
+        constexpr int    EDGE_ITEMS = 8;
+
+        if (!m_snapIndex)
+            return std::nullopt;
+
+        const double               maxDistance = ToWorld(aScreenDistance);
+        std::optional<VIEW_ANCHOR> best;
+        double                     bestDistance = 0.0;
+
+        auto consider =
+            [&](const VECTOR2D& aAnchor, VIEW_ANCHOR_TYPE aType)
+            {
+                const double distance = (aAnchor - aPoint).EuclideanNorm();
+
+                if (distance > maxDistance)
+                    return;
+
+                if (!best || distance < bestDistance
+                    || (distance == bestDistance && aType < best->type))
+                {
+                    best = VIEW_ANCHOR{ aAnchor, aType };
+                    bestDistance = distance;
+                }
+            };
+
+        auto anchorVisitor =
+            [&](const VIEW_SNAP_INDEX::ENTRY& aEntry)
+            {
+                if (isSnappable(aEntry.item))
+                    consider(aEntry.point, aEntry.type);
+            };
+
+        m_snapIndex->Nearest(aPoint, ANCHOR_CANDIDATES, anchorVisitor);
+
+        // Intersections are not indexed, they are computed for the items passing near the cursor
+        std::vector<ITEM_DISTANCE_PAIR> nearItems;
+        std::vector<SEG>                edges;
+        std::vector<size_t>             edgeOwners;
+
+        Nearest(aPoint, EDGE_ITEMS, nearItems, maxDistance);
+
+        for (size_t i = 0; i < nearItems.size(); ++i)
+        {
+            nearItems[i].first->ViewGetEdges(edges);
+            edgeOwners.resize(edges.size(), i);
+        }
+
+        for (size_t i = 0; i < edges.size(); ++i)
+        {
+            for (size_t j = i + 1; j < edges.size(); ++j)
+            {
+                if (edgeOwners[i] == edgeOwners[j])
+                    continue;
+
+                if (OPT_VECTOR2I crossing = edges[i].Intersect(edges[j]))
+                    consider(*crossing, VIEW_ANCHOR_TYPE::INTERSECTION);
+            }
+        }
+
+        return best;
+    }
+
+
     void VIEW::UpdateItems()
     {
         if (!m_gal->IsVisible() || !m_gal->IsInitialized())
@@ -1306,38 +2723,17 @@ namespace KIGFX {
 
         if (ratio > 0.3)
         {
-            auto allItems = *m_allItems;
-
             // kill all Rtrees
             for (auto& [_, layer] : m_layers)
-                layer.items->RemoveAll();
-
-            // and re-insert items from scratch
-            for (VIEW_ITEM* item : allItems)
             {
-                if (!item)
-                    continue;
-
-                const BOX2I bbox = item->ViewBBox();
-                item->m_viewPrivData->m_bbox = bbox;
-
-                std::vector<int> layers = item->ViewGetLayers();
-                item->viewPrivData()->saveLayers(layers);
-
-                for (int layer : layers)
-                {
-                    auto it = m_layers.find(layer);
-
-                    if (it == m_layers.end()) continue;
-
+                layer.items->RemoveAll();
+                layer.lod->Invalidate();
+            }
 
-                    VIEW_LAYER& l = it->second;
-                    l.items->Insert(item, bbox);
-                    MarkTargetDirty(l.target);
-                }
+            m_hasIndexSlack = false;
 
-                item->viewPrivData()->m_requiredUpdate &= ~(LAYERS | GEOMETRY);
-            }
+            // and re-insert items from scratch
+            rebuildIndexes();
         }
 
         if (anyUpdated)
@@ -1354,7 +2750,8 @@ namespace KIGFX {
             }
         }
 
-        spdlog::trace(std::format("[{}] View update: total items %u, geom %u anyUpdated %u\n", traceGalProfile, cntTotal, cntGeomUpdate, (unsigned)anyUpdated));
+        spdlog::trace("[{}] View update: total items {}, geom {} anyUpdated {}", traceGalProfile,
+                      cntTotal, cntGeomUpdate, anyUpdated);
     }
 
 
@@ -0,0 +1,167 @@
+#include <view_area_map.hxx>
+
+#include <algorithm>
+#include <cmath>
+
+namespace KIGFX {
+
+    VIEW_AREA_MAP::VIEW_AREA_MAP(const SHAPE_LINE_CHAIN& aArea, int aResolution)
+    {
+        const BOX2I bbox = aArea.BBox();
+
+        m_bbox = BOX2D(bbox.GetOrigin(), bbox.GetSize());
+        m_cellSize = std::max(m_bbox.GetWidth(), m_bbox.GetHeight()) / aResolution;
+
+        if (m_cellSize <= 0.0)
+            m_cellSize = 1.0;
+
+        m_cols = std::clamp(static_cast<int>(std::ceil(m_bbox.GetWidth() / m_cellSize)), 1, aResolution);
+        m_rows = std::clamp(static_cast<int>(std::ceil(m_bbox.GetHeight() / m_cellSize)), 1, aResolution);
+
+        std::vector<VECTOR2D> points(aArea.CPoints().begin(), aArea.CPoints().end());
+        std::vector<CELL_STATE> cells(static_cast<size_t>(m_cols) * m_rows, OUTSIDE_CELL);
+
+        for (size_t i = 0; i < points.size(); ++i)
+            markSegment(points[i], points[(i + 1) % points.size()], cells);
+
+        // The other cells are inside or outside as a whole: test their center with a scanline
+        // through the middle of the row
+        std::vector<double> crossings;
+
+        for (int r = 0; r < m_rows; ++r)
+        {
+            const double y = m_bbox.GetY() + (r + 0.5) * m_cellSize;
+
+            crossings.clear();
+
+            for (size_t i = 0; i < points.size(); ++i)
+            {
+                const VECTOR2D& a = points[i];
+                const VECTOR2D& b = points[(i + 1) % points.size()];
+
+                if ((a.y > y) != (b.y > y))
+                    crossings.push_back(a.x + (y - a.y) * (b.x - a.x) / (b.y - a.y));
+            }
+
+            std::sort(crossings.begin(), crossings.end());
+
+            size_t crossed = 0;
+
+            for (int c = 0; c < m_cols; ++c)
+            {
+                const double x = m_bbox.GetX() + (c + 0.5) * m_cellSize;
+
+                while (crossed < crossings.size() && crossings[crossed] < x)
+                    crossed++;
+
+                CELL_STATE& cell = cells[static_cast<size_t>(r) * m_cols + c];
+
+                if (cell != BOUNDARY_CELL)
+                    cell = (crossed % 2) ? INSIDE_CELL : OUTSIDE_CELL;
+            }
+        }
+
+        const size_t stride = m_cols + 1;
+
+        m_insideSums.assign(stride * (m_rows + 1), 0);
+        m_outsideSums.assign(stride * (m_rows + 1), 0);
+
+        for (int r = 0; r < m_rows; ++r)
+        {
+            for (int c = 0; c < m_cols; ++c)
+            {
+                const CELL_STATE cell = cells[static_cast<size_t>(r) * m_cols + c];
+                const size_t     idx = (r + 1) * stride + c + 1;
+
+                m_insideSums[idx] = (cell == INSIDE_CELL) + m_insideSums[idx - 1]
+                                    + m_insideSums[idx - stride] - m_insideSums[idx - stride - 1];
+                m_outsideSums[idx] = (cell == OUTSIDE_CELL) + m_outsideSums[idx - 1]
+                                     + m_outsideSums[idx - stride] - m_outsideSums[idx - stride - 1];
+            }
+        }
+    }
+
+
+    VIEW_AREA_MAP::BOX_CLASS VIEW_AREA_MAP::Classify(const BOX2D& aBox) const
+    {
+        if (aBox.GetRight() < m_bbox.GetLeft() || aBox.GetLeft() > m_bbox.GetRight()
+            || aBox.GetBottom() < m_bbox.GetTop() || aBox.GetTop() > m_bbox.GetBottom())
+        {
+            return BOX_CLASS::OUTSIDE;
+        }
+
+        const int col0 = column(aBox.GetLeft());
+        const int col1 = column(aBox.GetRight());
+        const int row0 = row(aBox.GetTop());
+        const int row1 = row(aBox.GetBottom());
+        const uint32_t cellCount = (col1 - col0 + 1) * (row1 - row0 + 1);
+
+        // The area is inside its bbox, so the part of a box sticking out of it is outside
+        const bool inBBox = aBox.GetLeft() >= m_bbox.GetLeft() && aBox.GetRight() <= m_bbox.GetRight()
+                            && aBox.GetTop() >= m_bbox.GetTop() && aBox.GetBottom() <= m_bbox.GetBottom();
+
+        if (inBBox && countCells(m_insideSums, col0, row0, col1, row1) == cellCount)
+            return BOX_CLASS::INSIDE;
+
+        if (countCells(m_outsideSums, col0, row0, col1, row1) == cellCount)
+            return BOX_CLASS::OUTSIDE;
+
+        return BOX_CLASS::CROSSING;
+    }
+
+
+    int VIEW_AREA_MAP::column(double aX) const
+    {
+        return std::clamp(static_cast<int>(std::floor((aX - m_bbox.GetX()) / m_cellSize)), 0,
+                          m_cols - 1);
+    }
+
+
+    int VIEW_AREA_MAP::row(double aY) const
+    {
+        return std::clamp(static_cast<int>(std::floor((aY - m_bbox.GetY()) / m_cellSize)), 0,
+                          m_rows - 1);
+    }
+
+
+    void VIEW_AREA_MAP::markSegment(const VECTOR2D& aA, const VECTOR2D& aB,
+                                    std::vector<CELL_STATE>& aCells)
+    {
+        // A small margin keeps the marking conservative against rounding: a box touching the
+        // outline must never land on cells classified as inside or outside
+        const double margin = m_cellSize * 1e-6;
+        const double minY = std::min(aA.y, aB.y);
+        const double maxY = std::max(aA.y, aB.y);
+
+        for (int r = row(minY - margin); r <= row(maxY + margin); ++r)
+        {
+            // Part of the segment within the row
+            const double y0 = std::clamp(m_bbox.GetY() + r * m_cellSize, minY, maxY);
+            const double y1 = std::clamp(m_bbox.GetY() + (r + 1) * m_cellSize, minY, maxY);
+            double       x0 = std::min(aA.x, aB.x);
+            double       x1 = std::max(aA.x, aB.x);
+
+            if (aA.y != aB.y)
+            {
+                const double xa = aA.x + (y0 - aA.y) * (aB.x - aA.x) / (aB.y - aA.y);
+                const double xb = aA.x + (y1 - aA.y) * (aB.x - aA.x) / (aB.y - aA.y);
+
+                x0 = std::min(xa, xb);
+                x1 = std::max(xa, xb);
+            }
+
+            for (int c = column(x0 - margin); c <= column(x1 + margin); ++c)
+                aCells[static_cast<size_t>(r) * m_cols + c] = BOUNDARY_CELL;
+        }
+    }
+
+
+    uint32_t VIEW_AREA_MAP::countCells(const std::vector<uint32_t>& aSums, int aCol0, int aRow0,
+                                       int aCol1, int aRow1) const
+    {
+        const size_t stride = m_cols + 1;
+
+        return aSums[(aRow1 + 1) * stride + aCol1 + 1] - aSums[aRow0 * stride + aCol1 + 1]
+               - aSums[(aRow1 + 1) * stride + aCol0] + aSums[aRow0 * stride + aCol0];
+    }
+} // namespace KIGFX
@@ -50,7 +50,9 @@ void ViewControler::onWheel(QWheelEvent* aEvent)
 		else
 			scrollY = -scrollVec.y;
 
-		VECTOR2D delta(scrollX, scrollY);
+		// Pan by whole pixels, so the view can reuse the previous frame instead of redrawing it
+		VECTOR2D delta = m_view->ToScreen(VECTOR2D(scrollX, scrollY), false);
+		delta = m_view->ToWorld(VECTOR2D(std::round(delta.x), std::round(delta.y)), false);
 
 		m_view->SetCenter(m_view->GetCenter() + delta);
 	}
@@ -0,0 +1,166 @@
+#include <view_data.hxx>
+
+#include <algorithm>
+#include <bit>
+#include <new>
+
+namespace KIGFX {
+
+    void VIEW_ITEM_DATA::growGroups()
+    {
+        const int capacity = m_groupsCapacity * 2;
+        GROUP* newGroups = m_pool->allocGroups(capacity);
+
+        std::copy(groups(), groups() + m_groupsSize, newGroups);
+
+        if (m_groupsCapacity > INLINE_GROUPS)
+            freeOverflowGroups();
+
+        m_overflowGroups = newGroups;
+        m_groupsCapacity = capacity;
+    }
+
+
+    void VIEW_ITEM_DATA::freeOverflowGroups()
+    {
+        m_pool->freeGroups(m_overflowGroups, m_groupsCapacity);
+    }
+
+
+    void VIEW_ITEM_DATA::moveFrom(VIEW_ITEM_DATA& aOther)
+    {
+        m_view = aOther.m_view;
+        m_flags = aOther.m_flags;
+        m_requiredUpdate = aOther.m_requiredUpdate;
+        m_drawPriority = aOther.m_drawPriority;
+        m_cachedIndex = aOther.m_cachedIndex;
+
+        deleteGroups();
+
+        const GROUP* otherGroups = aOther.groups();
+
+        for (int i = 0; i < aOther.m_groupsSize; ++i)
+            setGroup(otherGroups[i].layer, otherGroups[i].group);
+
+        m_layers = std::move(aOther.m_layers);
+        m_bbox = aOther.m_bbox;
+        m_indexBbox = aOther.m_indexBbox;
+    }
+
+
+    VIEW_ITEM_DATA_POOL::VIEW_ITEM_DATA_POOL() :
+        m_slabUsed(0),
+        m_freeSlots(nullptr),
+        m_count(0),
+        m_groupChunkUsed(0),
+        m_groupChunkSize(0)
+    {
+    }
+
+
+    VIEW_ITEM_DATA_POOL::~VIEW_ITEM_DATA_POOL()
+    {
+        // The owner frees the data in use first, the slabs just go away
+    }
+
+
+    VIEW_ITEM_DATA* VIEW_ITEM_DATA_POOL::Alloc()
+    {
+        SLOT* slot;
+
+        if (m_freeSlots)
+        {
+            slot = m_freeSlots;
+            m_freeSlots = slot->next;
+        }
+        else
+        {
+            if (m_slabs.empty() || m_slabUsed == SLAB_SIZE)
+            {
+                m_slabs.emplace_back(new SLOT[SLAB_SIZE]);
+                m_slabUsed = 0;
+            }
+
+            slot = &m_slabs.back()[m_slabUsed++];
+        }
+
+        ++m_count;
+        return new (slot->data) VIEW_ITEM_DATA(this);
+    }
+
+
+    void VIEW_ITEM_DATA_POOL::Free(VIEW_ITEM_DATA* aData)
+    {
+        aData->~VIEW_ITEM_DATA();
+
+        SLOT* slot = reinterpret_cast<SLOT*>(aData);
+        slot->next = m_freeSlots;
+        m_freeSlots = slot;
+        --m_count;
+    }
+
+
+    void VIEW_ITEM_DATA_POOL::ReleaseMemory()
+    {
+        if (m_count > 0)
+            return;
+
+        m_slabs.clear();
+        m_slabs.shrink_to_fit();
+        m_slabUsed = 0;
+        m_freeSlots = nullptr;
+
+        m_groupChunks.clear();
+        m_groupChunks.shrink_to_fit();
+        m_groupChunkUsed = 0;
+        m_groupChunkSize = 0;
+        m_freeGroups.clear();
+    }
+
+
+    int VIEW_ITEM_DATA_POOL::groupsClass(int aCapacity)
+    {
+        return std::countr_zero(static_cast<unsigned>(aCapacity / MIN_GROUP_BLOCK));
+    }
+
+
+    VIEW_ITEM_DATA_POOL::GROUP* VIEW_ITEM_DATA_POOL::allocGroups(int aCapacity)
+    {
+        const size_t sizeClass = groupsClass(aCapacity);
+
+        if (sizeClass < m_freeGroups.size() && m_freeGroups[sizeClass])
+        {
+            FREE_GROUPS* block = m_freeGroups[sizeClass];
+            m_freeGroups[sizeClass] = block->next;
+            return reinterpret_cast<GROUP*>(block);
+        }
+
+        if (m_groupChunkUsed + aCapacity > m_groupChunkSize)
+        {
+            // The rest of the previous chunk is lost, blocks are small compared to the chunks
+            m_groupChunkSize = std::max<size_t>(GROUP_CHUNK_SIZE, aCapacity);
+            m_groupChunks.emplace_back(new GROUP[m_groupChunkSize]);
+            m_groupChunkUsed = 0;
+        }
+
+        GROUP* groups = &m_groupChunks.back()[m_groupChunkUsed];
+        m_groupChunkUsed += aCapacity;
+
+        return groups;
+    }
+
+
+    void VIEW_ITEM_DATA_POOL::freeGroups(GROUP* aGroups, int aCapacity)
+    {
+        static_assert(sizeof(FREE_GROUPS) <= MIN_GROUP_BLOCK * sizeof(GROUP));
+
+        const size_t sizeClass = groupsClass(aCapacity);
+
+        if (sizeClass >= m_freeGroups.size())
+            m_freeGroups.resize(sizeClass + 1, nullptr);
+
+        FREE_GROUPS* block = reinterpret_cast<FREE_GROUPS*>(aGroups);
+        block->next = m_freeGroups[sizeClass];
+        m_freeGroups[sizeClass] = block;
+    }
+} // namespace KIGFX
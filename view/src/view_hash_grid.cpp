@@ -0,0 +1,208 @@
+#include <view_hash_grid.hxx>
+
+#include <cmath>
+#include <limits>
+
+namespace KIGFX {
+
+    VIEW_HASH_GRID::VIEW_HASH_GRID(double aCellSize) :
+        m_count(0),
+        m_cellSize(aCellSize),
+        m_invCellSize(aCellSize > 0.0 ? 1.0 / aCellSize : 0.0),
+        m_autoCellSize(aCellSize <= 0.0)
+    {
+    }
+
+
+    int32_t VIEW_HASH_GRID::cellCoord(double aValue) const
+    {
+        constexpr double low = std::numeric_limits<int32_t>::min();
+        constexpr double high = std::numeric_limits<int32_t>::max();
+
+        return int32_t(std::clamp(std::floor(aValue * m_invCellSize), low, high));
+    }
+
+
+    VIEW_HASH_GRID::ENTRY VIEW_HASH_GRID::makeEntry(VIEW_ITEM* aItem, const BOX2D& aBbox)
+    {
+        return { std::min(aBbox.GetLeft(), aBbox.GetRight()), std::min(aBbox.GetTop(), aBbox.GetBottom()),
+                 std::max(aBbox.GetLeft(), aBbox.GetRight()), std::max(aBbox.GetTop(), aBbox.GetBottom()),
+                 aItem };
+    }
+
+
+    void VIEW_HASH_GRID::chooseCellSize(const std::vector<VIEW_INDEX_ENTRY>& aEntries)
+    {
+        // Aim at cells about twice the typical item size, but no smaller than needed to hold a
+        // few items each on average, so sparse layers do not end up with one cell per item
+        constexpr double ITEMS_PER_CELL = 16.0;
+
+        double sumSize = 0.0;
+        size_t count = 0;
+        BOX2D  extents;
+
+        for (const auto& [bbox, item] : aEntries)
+        {
+            const double size = std::max(std::abs(bbox.GetWidth()), std::abs(bbox.GetHeight()));
+
+            // Skip items that cover everything (e.g. with a maximum bounding box)
+            if (!std::isfinite(size) || size > 1e100)
+                continue;
+
+            BOX2D normalized = bbox;
+            normalized.Normalize();
+
+            if (count)
+                extents.Merge(normalized);
+            else
+                extents = normalized;
+
+            sumSize += size;
+            count++;
+        }
+
+        double cellSize = 0.0;
+
+        if (count)
+        {
+            const double densitySize = std::sqrt(extents.GetArea() * ITEMS_PER_CELL / count);
+            cellSize = std::max(2.0 * sumSize / count, densitySize);
+        }
+
+        if (!std::isfinite(cellSize) || cellSize <= 0.0)
+            cellSize = 1.0;
+
+        m_cellSize = cellSize;
+        m_invCellSize = 1.0 / cellSize;
+    }
+
+
+    void VIEW_HASH_GRID::insert(const ENTRY& aEntry)
+    {
+        const CELL_RANGE range = cellRange(aEntry.minX, aEntry.minY, aEntry.maxX, aEntry.maxY);
+
+        if (range.Count() > MAX_ITEM_CELLS)
+        {
+            m_oversized.push_back(aEntry);
+        }
+        else
+        {
+            for (int32_t y = range.y0; y <= range.y1; ++y)
+            {
+                for (int32_t x = range.x0; x <= range.x1; ++x)
+                    m_cells[cellKey(x, y)].push_back(aEntry);
+            }
+        }
+
+        m_count++;
+    }
+
+
+    void VIEW_HASH_GRID::Insert(VIEW_ITEM* aItem, const BOX2D& aBbox)
+    {
+        if (m_count == 0 && m_autoCellSize)
+            chooseCellSize({ VIEW_INDEX_ENTRY(aBbox, aItem) });
+
+        insert(makeEntry(aItem, aBbox));
+    }
+
+
+    void VIEW_HASH_GRID::BulkLoad(std::vector<VIEW_INDEX_ENTRY>& aEntries)
+    {
+        if (aEntries.empty())
+            return;
+
+        if (m_count == 0 && m_autoCellSize)
+            chooseCellSize(aEntries);
+
+        for (const auto& [bbox, item] : aEntries)
+            insert(makeEntry(item, bbox));
+
+        aEntries.clear();
+        aEntries.shrink_to_fit();
+    }
+
+
+    bool VIEW_HASH_GRID::Remove(VIEW_ITEM* aItem, const BOX2D* aBbox)
+    {
+        if (m_count == 0)
+            return false;
+
+        auto eraseFrom =
+            [aItem](std::vector<ENTRY>& aEntries) -> bool
+            {
+                auto it = std::find_if(aEntries.begin(), aEntries.end(),
+                                       [aItem](const ENTRY& aEntry)
+                                       {
+                                           return aEntry.item == aItem;
+                                       });
+
+                if (it == aEntries.end())
+                    return false;
+
+                // Order within a cell does not matter
+                *it = aEntries.back();
+                aEntries.pop_back();
+                return true;
+            };
+
+        bool found = false;
+
+        if (aBbox)
+        {
+            const ENTRY      entry = makeEntry(aItem, *aBbox);
+            const CELL_RANGE range = cellRange(entry.minX, entry.minY, entry.maxX, entry.maxY);
+
+            if (range.Count() > MAX_ITEM_CELLS)
+            {
+                found = eraseFrom(m_oversized);
+            }
+            else
+            {
+                for (int32_t y = range.y0; y <= range.y1; ++y)
+                {
+                    for (int32_t x = range.x0; x <= range.x1; ++x)
+                    {
+                        auto it = m_cells.find(cellKey(x, y));
+
+                        if (it == m_cells.end() || !eraseFrom(it->second))
+                            continue;
+
+                        found = true;
+
+                        if (it->second.empty())
+                            m_cells.erase(it);
+                    }
+                }
+            }
+        }
+        else
+        {
+            for (auto it = m_cells.begin(); it != m_cells.end();)
+            {
+                found |= eraseFrom(it->second);
+
+                if (it->second.empty())
+                    it = m_cells.erase(it);
+                else
+                    ++it;
+            }
+
+            found |= eraseFrom(m_oversized);
+        }
+
+        if (found)
+            m_count--;
+
+        return found;
+    }
+
+
+    void VIEW_HASH_GRID::RemoveAll()
+    {
+        m_cells.clear();
+        m_oversized.clear();
+        m_count = 0;
+    }
+
+} // namespace KIGFX
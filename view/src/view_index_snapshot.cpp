@@ -0,0 +1,309 @@
+#include <view_index_snapshot.hxx>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace KIGFX {
+
+    namespace
+    {
+        constexpr char     SNAPSHOT_MAGIC[8] = { 'M', 'I', 'N', 'I', 'V', 'I', 'D', 'X' };
+        constexpr uint32_t SNAPSHOT_VERSION = 1;
+        constexpr uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+
+        /// Start of the file. Every section that follows starts on a multiple of 8 bytes.
+        struct HEADER
+        {
+            char     magic[8];
+            uint32_t version;
+            uint32_t byteOrder;
+            uint64_t contentHash[2];
+            uint64_t fileSize;
+            uint64_t itemCount;
+            uint64_t layerEntryCount;
+            uint64_t treeCount;
+        };
+
+        /// Start of the packed tree of a layer, followed by its level ends, boxes and indices.
+        struct TREE_HEADER
+        {
+            int32_t  layer;
+            uint32_t levelCount;
+            uint64_t nodeCount;
+        };
+
+        size_t padded(size_t aBytes)
+        {
+            return (aBytes + 7) & ~size_t(7);
+        }
+
+        /// Hands out the arrays of a mapped file one after the other, within its bounds.
+        class READER
+        {
+        public:
+            READER(const void* aData, size_t aSize) :
+                m_data(static_cast<const uint8_t*>(aData)),
+                m_size(aSize),
+                m_offset(0)
+            {
+            }
+
+            /**
+             * @return the next \a aCount values, null if the file is too short.
+             */
+            template <class T>
+            const T* Take(size_t aCount)
+            {
+                if (aCount > (m_size - m_offset) / sizeof(T))
+                    return nullptr;
+
+                const T* values = reinterpret_cast<const T*>(m_data + m_offset);
+                m_offset = std::min(m_size, m_offset + padded(aCount * sizeof(T)));
+
+                return values;
+            }
+
+            bool AtEnd() const
+            {
+                return m_offset == m_size;
+            }
+
+        private:
+            const uint8_t* m_data;
+            size_t         m_size;
+            size_t         m_offset;
+        };
+
+        /// Writes arrays one after the other, each padded to 8 bytes.
+        class WRITER
+        {
+        public:
+            explicit WRITER(std::ofstream& aStream) :
+                m_stream(aStream),
+                m_offset(0)
+            {
+            }
+
+            template <class T>
+            void Put(const T* aValues, size_t aCount)
+            {
+                static const char zeros[8] = {};
+                const size_t      bytes = aCount * sizeof(T);
+
+                m_stream.write(reinterpret_cast<const char*>(aValues), bytes);
+                m_stream.write(zeros, padded(bytes) - bytes);
+                m_offset += padded(bytes);
+            }
+
+            template <class T>
+            void Put(const std::vector<T>& aValues)
+            {
+                Put(aValues.data(), aValues.size());
+            }
+
+            size_t GetOffset() const
+            {
+                return m_offset;
+            }
+
+        private:
+            std::ofstream& m_stream;
+            size_t         m_offset;
+        };
+    }
+
+
+    bool VIEW_INDEX_SNAPSHOT::Write(const std::string& aPath, const HASH_128& aContentHash,
+                                    const CONTENT& aContent)
+    {
+        // Written aside and renamed, so that a snapshot is never seen half written
+        const std::string tmpPath = aPath + ".tmp";
+        HEADER            header = {};
+
+        std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+        header.version = SNAPSHOT_VERSION;
+        header.byteOrder = SNAPSHOT_BYTE_ORDER;
+        header.contentHash[0] = aContentHash.Value64[0];
+        header.contentHash[1] = aContentHash.Value64[1];
+        header.itemCount = aContent.priorities.size();
+        header.layerEntryCount = aContent.layers.size();
+        header.treeCount = aContent.trees.size();
+
+        {
+            std::ofstream stream(tmpPath, std::ios::binary | std::ios::trunc);
+            WRITER        writer(stream);
+
+            writer.Put(&header, 1);
+            writer.Put(aContent.order);
+            writer.Put(aContent.priorities);
+            writer.Put(aContent.boxes);
+            writer.Put(aContent.layerOffsets);
+            writer.Put(aContent.layers);
+
+            for (const auto& [layer, tree] : aContent.trees)
+            {
+                const TREE_HEADER treeHeader = { layer, static_cast<uint32_t>(tree.levelEnds.size()),
+                                                 tree.indices.size() };
+
+                writer.Put(&treeHeader, 1);
+                writer.Put(tree.levelEnds);
+                writer.Put(tree.boxes);
+                writer.Put(tree.indices);
+            }
+
+            // The size goes last, a truncated file never matches it
+            header.fileSize = writer.GetOffset();
+            stream.seekp(0);
+            stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            stream.close();
+
+            if (!stream)
+            {
+                std::error_code ec;
+                std::filesystem::remove(tmpPath, ec);
+                return false;
+            }
+        }
+
+        std::error_code ec;
+        std::filesystem::rename(tmpPath, aPath, ec);
+
+        if (ec)
+        {
+            std::filesystem::remove(tmpPath, ec);
+            return false;
+        }
+
+        return true;
+    }
+
+
+    std::shared_ptr<VIEW_INDEX_SNAPSHOT> VIEW_INDEX_SNAPSHOT::Open(const std::string& aPath,
+                                                                   const HASH_128& aContentHash,
+                                                                   size_t aItemCount)
+    {
+        namespace bip = boost::interprocess;
+
+        std::error_code ec;
+
+        if (!std::filesystem::is_regular_file(aPath, ec))
+            return nullptr;
+
+        auto snapshot = std::make_shared<VIEW_INDEX_SNAPSHOT>();
+
+        try
+        {
+            snapshot->m_file = bip::file_mapping(aPath.c_str(), bip::read_only);
+            snapshot->m_region = bip::mapped_region(snapshot->m_file, bip::read_only);
+        }
+        catch (const bip::interprocess_exception&)
+        {
+            return nullptr;
+        }
+
+        if (!snapshot->parse(aContentHash, aItemCount))
+            return nullptr;
+
+        return snapshot;
+    }
+
+
+    bool VIEW_INDEX_SNAPSHOT::parse(const HASH_128& aContentHash, size_t aItemCount)
+    {
+        READER        reader(m_region.get_address(), m_region.get_size());
+        const HEADER* header = reader.Take<HEADER>(1);
+
+        if (!header || std::memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0
+            || header->version != SNAPSHOT_VERSION || header->byteOrder != SNAPSHOT_BYTE_ORDER
+            || header->contentHash[0] != aContentHash.Value64[0]
+            || header->contentHash[1] != aContentHash.Value64[1]
+            || header->fileSize != m_region.get_size() || header->itemCount != aItemCount)
+        {
+            return false;
+        }
+
+        m_itemCount = header->itemCount;
+        m_order = reader.Take<uint32_t>(m_itemCount);
+        m_priorities = reader.Take<int32_t>(m_itemCount);
+        m_boxes = reader.Take<double>(4 * m_itemCount);
+        m_layerOffsets = reader.Take<uint32_t>(m_itemCount + 1);
+        m_layers = reader.Take<int32_t>(header->layerEntryCount);
+
+        if (!m_order || !m_priorities || !m_boxes || !m_layerOffsets || !m_layers)
+            return false;
+
+        // The order lists every item once
+        std::vector<bool> listed(m_itemCount, false);
+
+        for (size_t i = 0; i < m_itemCount; ++i)
+        {
+            if (m_order[i] >= m_itemCount || listed[m_order[i]])
+                return false;
+
+            listed[m_order[i]] = true;
+
+            if (m_layerOffsets[i] > m_layerOffsets[i + 1])
+                return false;
+        }
+
+        if (m_layerOffsets[0] != 0 || m_layerOffsets[m_itemCount] != header->layerEntryCount)
+            return false;
+
+        for (uint64_t t = 0; t < header->treeCount; ++t)
+        {
+            const TREE_HEADER* treeHeader = reader.Take<TREE_HEADER>(1);
+
+            if (!treeHeader || treeHeader->levelCount < 2
+                || treeHeader->levelCount > VIEW_PACKED_RTREE::MAX_LEVELS)
+            {
+                return false;
+            }
+
+            VIEW_PACKED_RTREE::ARRAYS tree;
+
+            tree.levelCount = treeHeader->levelCount;
+            tree.nodeCount = treeHeader->nodeCount;
+            tree.levelEnds = reader.Take<uint64_t>(tree.levelCount);
+            tree.boxes = reader.Take<double>(4 * tree.nodeCount);
+            tree.indices = reader.Take<uint32_t>(tree.nodeCount);
+
+            if (!tree.levelEnds || !tree.boxes || !tree.indices
+                || tree.levelEnds[tree.levelCount - 1] != tree.nodeCount
+                || tree.levelEnds[tree.levelCount - 2] + 1 != tree.nodeCount)
+            {
+                return false;
+            }
+
+            // Leaves refer to items, other nodes to children on the level below
+            uint64_t levelStart = 0;
+
+            for (uint32_t level = 0; level < tree.levelCount; ++level)
+            {
+                const uint64_t levelEnd = tree.levelEnds[level];
+
+                if (levelEnd <= levelStart)
+                    return false;
+
+                for (uint64_t node = levelStart; node < levelEnd; ++node)
+                {
+                    const uint32_t index = tree.indices[node];
+
+                    if (level == 0 ? index >= m_itemCount
+                                   : (index >= levelStart
+                                      || (level > 1 && index < tree.levelEnds[level - 2])))
+                    {
+                        return false;
+                    }
+                }
+
+                levelStart = levelEnd;
+            }
+
+            m_trees.push_back({ treeHeader->layer, tree });
+        }
+
+        return reader.AtEnd();
+    }
+} // namespace KIGFX
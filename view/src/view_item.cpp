@@ -1,6 +1,8 @@
 #include "view_item.hxx"
 #include "view.hxx"
 
+#include <shape_line_chain.hxx>
+
 using namespace KIGFX;
 
 VIEW_ITEM::~VIEW_ITEM()
@@ -21,3 +23,67 @@ double VIEW_ITEM::lodScaleForThreshold(const VIEW* aView, int aWhatIu, int aThre
     //return double(aThresholdIu) / aWhatIu;
     return LOD_SHOW;
 }
+
+
+bool VIEW_ITEM::ViewHitTest(const SHAPE_LINE_CHAIN& aArea, bool aContained) const
+{
+    const BOX2I bbox = BOX2ISafe(ViewBBoxD());
+
+    return hitTestPolyline(aArea, aContained,
+                           { bbox.GetOrigin(), VECTOR2I(bbox.GetRight(), bbox.GetTop()),
+                             bbox.GetEnd(), VECTOR2I(bbox.GetLeft(), bbox.GetBottom()) },
+                           true);
+}
+
+
+bool VIEW_ITEM::hitTestPolyline(const SHAPE_LINE_CHAIN& aArea, bool aContained,
+                                const std::vector<VECTOR2I>& aPoints, bool aFilled)
+{
+    if (aPoints.empty())
+        return false;
+
+    const size_t segCount = aFilled && aPoints.size() > 2 ? aPoints.size() : aPoints.size() - 1;
+
+    auto segment =
+        [&](size_t aIndex)
+        {
+            return SEG(aPoints[aIndex], aPoints[(aIndex + 1) % aPoints.size()]);
+        };
+
+    if (aContained)
+    {
+        for (const VECTOR2I& point : aPoints)
+        {
+            if (!aArea.PointInside(point))
+                return false;
+        }
+
+        // All the vertices are inside, the polyline is unless it crosses the outline
+        for (size_t i = 0; i < segCount; ++i)
+        {
+            const SEG seg = segment(i);
+
+            for (int j = 0; j < aArea.SegmentCount(); ++j)
+            {
+                if (aArea.CSegment(j).Intersects(seg))
+                    return false;
+            }
+        }
+
+        return true;
+    }
+
+    if (segCount == 0)
+        return aArea.PointInside(aPoints[0]);
+
+    // The area is closed, so this also finds segments lying inside of it
+    for (size_t i = 0; i < segCount; ++i)
+    {
+        if (aArea.Collide(segment(i)))
+            return true;
+    }
+
+    // The area may lie inside the shape
+    return aFilled && aPoints.size() > 2
+           && SHAPE_LINE_CHAIN(aPoints, true).PointInside(aArea.CPoint(0));
+}
@@ -0,0 +1,70 @@
+#include <view_linear_index.hxx>
+
+#include <algorithm>
+
+namespace KIGFX {
+
+    void VIEW_LINEAR_INDEX::Insert(VIEW_ITEM* aItem, const BOX2D& aBbox)
+    {
+        m_minX.push_back(std::min(aBbox.GetLeft(), aBbox.GetRight()));
+        m_minY.push_back(std::min(aBbox.GetTop(), aBbox.GetBottom()));
+        m_maxX.push_back(std::max(aBbox.GetLeft(), aBbox.GetRight()));
+        m_maxY.push_back(std::max(aBbox.GetTop(), aBbox.GetBottom()));
+        m_items.push_back(aItem);
+    }
+
+
+    void VIEW_LINEAR_INDEX::BulkLoad(std::vector<VIEW_INDEX_ENTRY>& aEntries)
+    {
+        const size_t size = m_items.size() + aEntries.size();
+
+        m_minX.reserve(size);
+        m_minY.reserve(size);
+        m_maxX.reserve(size);
+        m_maxY.reserve(size);
+        m_items.reserve(size);
+
+        for (const auto& [bbox, item] : aEntries)
+            Insert(item, bbox);
+
+        aEntries.clear();
+        aEntries.shrink_to_fit();
+    }
+
+
+    bool VIEW_LINEAR_INDEX::Remove(VIEW_ITEM* aItem, const BOX2D* aBbox)
+    {
+        auto it = std::find(m_items.begin(), m_items.end(), aItem);
+
+        if (it == m_items.end())
+            return false;
+
+        // Move the last item into the hole, the order of the items does not matter
+        const size_t index = it - m_items.begin();
+
+        m_minX[index] = m_minX.back();
+        m_minY[index] = m_minY.back();
+        m_maxX[index] = m_maxX.back();
+        m_maxY[index] = m_maxY.back();
+        m_items[index] = m_items.back();
+
+        m_minX.pop_back();
+        m_minY.pop_back();
+        m_maxX.pop_back();
+        m_maxY.pop_back();
+        m_items.pop_back();
+
+        return true;
+    }
+
+
+    void VIEW_LINEAR_INDEX::RemoveAll()
+    {
+        m_minX.clear();
+        m_minY.clear();
+        m_maxX.clear();
+        m_maxY.clear();
+        m_items.clear();
+    }
+
+} // namespace KIGFX
@@ -0,0 +1,324 @@
+#include <view_lod_cache.hxx>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace KIGFX {
+
+    VIEW_LOD_CACHE::VIEW_LOD_CACHE() :
+        m_refilling(false),
+        m_refillCount(0),
+        m_cellSize(0.0),
+        m_valid(false),
+        m_aggregating(false)
+    {
+    }
+
+
+    VIEW_LOD_CACHE::CELL_KEY VIEW_LOD_CACHE::cellKey(const VECTOR2D& aPoint) const
+    {
+        return CELL_KEY(static_cast<int64_t>(std::floor(aPoint.x / m_cellSize)),
+                        static_cast<int64_t>(std::floor(aPoint.y / m_cellSize)));
+    }
+
+
+    BOX2D VIEW_LOD_CACHE::cellArea(const CELL_KEY& aKey) const
+    {
+        // Items binned into the cell have their center in it and are at most one cell large
+        BOX2D area(VECTOR2D(aKey.x * m_cellSize, aKey.y * m_cellSize),
+                   VECTOR2D(m_cellSize, m_cellSize));
+        area.Inflate(m_cellSize / 2);
+
+        return area;
+    }
+
+
+    void VIEW_LOD_CACHE::queryCells(const BOX2D& aBounds,
+                                    std::vector<const VIEW_LOD_CELL*>& aCells) const
+    {
+        BOX2D bounds = aBounds;
+        bounds.Normalize();
+
+        // Cells reach up to half a cell beyond their own area
+        const double cols = bounds.GetWidth() / m_cellSize + 2;
+        const double rows = bounds.GetHeight() / m_cellSize + 2;
+
+        if (!m_cellIndex.empty() && cols * rows < m_cells.size() / 8)
+        {
+            const VECTOR2D margin(m_cellSize / 2, m_cellSize / 2);
+            const CELL_KEY first = cellKey(bounds.GetOrigin() - margin);
+            const CELL_KEY last = cellKey(bounds.GetEnd() + margin);
+
+            for (int64_t y = first.y; y <= last.y; ++y)
+            {
+                for (int64_t x = first.x; x <= last.x; ++x)
+                {
+                    auto it = m_cellIndex.find(CELL_KEY(x, y));
+
+                    if (it != m_cellIndex.end() && m_cells[it->second].bbox.Intersects(bounds))
+                        aCells.push_back(&m_cells[it->second]);
+                }
+            }
+
+            return;
+        }
+
+        for (const VIEW_LOD_CELL& cell : m_cells)
+        {
+            if (cell.bbox.Intersects(bounds))
+                aCells.push_back(&cell);
+        }
+    }
+
+
+    void VIEW_LOD_CACHE::addToCell(VIEW_LOD_CELL& aCell, const BOX2D& aBbox)
+    {
+        aCell.bbox.Merge(aBbox);
+        aCell.coverage += aBbox.GetWidth() * aBbox.GetHeight();
+    }
+
+
+    void VIEW_LOD_CACHE::finishCell(VIEW_LOD_CELL& aCell)
+    {
+        const double area = aCell.bbox.GetWidth() * aCell.bbox.GetHeight();
+
+        aCell.coverage = area > 0.0 ? std::min(aCell.coverage / area, 1.0) : 1.0;
+    }
+
+
+    void VIEW_LOD_CACHE::Begin(double aCellSize, size_t aItemCount)
+    {
+        m_smallEntries.clear();
+        m_smallEntries.reserve(aItemCount);
+        m_largeEntries.clear();
+        m_cells.clear();
+        m_cellKeys.clear();
+        m_cellIndex.clear();
+        m_dirtyCells.clear();
+        m_largeItems.RemoveAll();
+        m_minCell = CELL_KEY(std::numeric_limits<int64_t>::max(),
+                             std::numeric_limits<int64_t>::max());
+        m_maxCell = CELL_KEY(std::numeric_limits<int64_t>::min(),
+                             std::numeric_limits<int64_t>::min());
+        m_cellSize = aCellSize;
+        m_valid = false;
+        m_aggregating = false;
+    }
+
+
+    void VIEW_LOD_CACHE::Add(VIEW_ITEM* aItem, const BOX2D& aBbox, bool aCanAggregate)
+    {
+        BOX2D bbox = aBbox;
+        bbox.Normalize();
+
+        const bool small = aCanAggregate && isSmall(bbox);
+
+        if (m_refilling)
+        {
+            // Large items are kept up to date by Update(), only the refilled cell matters
+            if (small && cellKey(bbox.Centre()) == m_refillKey)
+            {
+                if (m_refillCount++ == 0)
+                    m_refillCell = { bbox, 0.0 };
+
+                addToCell(m_refillCell, bbox);
+            }
+
+            return;
+        }
+
+        if (!small)
+        {
+            m_largeEntries.emplace_back(aBbox, aItem);
+            return;
+        }
+
+        const CELL_KEY cell = cellKey(bbox.Centre());
+
+        m_minCell.x = std::min(m_minCell.x, cell.x);
+        m_minCell.y = std::min(m_minCell.y, cell.y);
+        m_maxCell.x = std::max(m_maxCell.x, cell.x);
+        m_maxCell.y = std::max(m_maxCell.y, cell.y);
+        m_smallEntries.push_back({ cell, bbox });
+    }
+
+
+    void VIEW_LOD_CACHE::End()
+    {
+        m_aggregating = !m_smallEntries.empty() && m_smallEntries.size() >= m_largeEntries.size();
+        m_valid = true;
+
+        if (!m_aggregating)
+        {
+            m_smallEntries.clear();
+            m_smallEntries.shrink_to_fit();
+            m_largeEntries.clear();
+            m_largeEntries.shrink_to_fit();
+            return;
+        }
+
+        const uint64_t cols = m_maxCell.x - m_minCell.x + 1;
+        const uint64_t rows = m_maxCell.y - m_minCell.y + 1;
+        const uint64_t maxGridSize = std::max<uint64_t>(4 * m_smallEntries.size(), 1 << 20);
+
+        if (cols <= maxGridSize && rows <= maxGridSize / cols)
+        {
+            // Zoomed out, the cells span a small grid: look them up directly
+            std::vector<int32_t> cellIndex(cols * rows, -1);
+
+            for (const SMALL_ENTRY& entry : m_smallEntries)
+            {
+                int32_t& index = cellIndex[(entry.cell.y - m_minCell.y) * cols
+                                           + entry.cell.x - m_minCell.x];
+
+                if (index < 0)
+                {
+                    index = static_cast<int32_t>(m_cells.size());
+                    m_cells.push_back({ entry.bbox, 0.0 });
+                    m_cellKeys.push_back(entry.cell);
+                }
+
+                addToCell(m_cells[index], entry.bbox);
+            }
+        }
+        else
+        {
+            // Otherwise sorting brings the items of each cell together
+            std::sort(m_smallEntries.begin(), m_smallEntries.end(),
+                [](const SMALL_ENTRY& a, const SMALL_ENTRY& b)
+                {
+                    return a.cell.y < b.cell.y || (a.cell.y == b.cell.y && a.cell.x < b.cell.x);
+                });
+
+            for (size_t i = 0; i < m_smallEntries.size(); ++i)
+            {
+                const SMALL_ENTRY& entry = m_smallEntries[i];
+
+                if (i == 0 || entry.cell != m_smallEntries[i - 1].cell)
+                {
+                    m_cells.push_back({ entry.bbox, 0.0 });
+                    m_cellKeys.push_back(entry.cell);
+                }
+
+                addToCell(m_cells.back(), entry.bbox);
+            }
+        }
+
+        for (VIEW_LOD_CELL& cell : m_cells)
+            finishCell(cell);
+
+        m_smallEntries.clear();
+        m_smallEntries.shrink_to_fit();
+        m_largeItems.BulkLoad(m_largeEntries);
+    }
+
+
+    BOX2D VIEW_LOD_CACHE::Update(VIEW_ITEM* aItem, const BOX2D* aOldBbox, const BOX2D* aNewBbox,
+                                 bool aCanAggregate)
+    {
+        BOX2D changed;
+
+        if (!m_valid || !m_aggregating)
+            return changed;
+
+        if (aOldBbox)
+        {
+            BOX2D bbox = *aOldBbox;
+            bbox.Normalize();
+
+            // Whether the item could be aggregated may have changed since, so try both
+            if (isSmall(bbox))
+            {
+                m_dirtyCells.push_back(cellKey(bbox.Centre()));
+                changed.Merge(cellArea(m_dirtyCells.back()));
+            }
+
+            m_largeItems.Remove(aItem, aOldBbox);
+        }
+
+        if (aNewBbox)
+        {
+            BOX2D bbox = *aNewBbox;
+            bbox.Normalize();
+
+            if (aCanAggregate && isSmall(bbox))
+            {
+                m_dirtyCells.push_back(cellKey(bbox.Centre()));
+                changed.Merge(cellArea(m_dirtyCells.back()));
+            }
+            else
+            {
+                m_largeItems.Insert(aItem, *aNewBbox);
+            }
+        }
+
+        return changed;
+    }
+
+
+    void VIEW_LOD_CACHE::Refill(const std::function<void(const BOX2D&)>& aQuery)
+    {
+        if (m_cellIndex.empty())
+        {
+            for (size_t i = 0; i < m_cellKeys.size(); ++i)
+                m_cellIndex.emplace(m_cellKeys[i], i);
+        }
+
+        std::sort(m_dirtyCells.begin(), m_dirtyCells.end(),
+            [](const CELL_KEY& a, const CELL_KEY& b)
+            {
+                return a.y < b.y || (a.y == b.y && a.x < b.x);
+            });
+
+        m_dirtyCells.erase(std::unique(m_dirtyCells.begin(), m_dirtyCells.end()),
+                           m_dirtyCells.end());
+
+        m_refilling = true;
+
+        for (const CELL_KEY& key : m_dirtyCells)
+        {
+            m_refillKey = key;
+            m_refillCount = 0;
+            aQuery(cellArea(key));
+
+            auto it = m_cellIndex.find(key);
+
+            if (m_refillCount > 0)
+            {
+                finishCell(m_refillCell);
+
+                if (it != m_cellIndex.end())
+                {
+                    m_cells[it->second] = m_refillCell;
+                }
+                else
+                {
+                    m_cellIndex.emplace(key, m_cells.size());
+                    m_cells.push_back(m_refillCell);
+                    m_cellKeys.push_back(key);
+                }
+            }
+            else if (it != m_cellIndex.end())
+            {
+                // The cell is empty now, move the last one into its place
+                const size_t index = it->second;
+
+                m_cellIndex.erase(it);
+
+                if (index + 1 < m_cells.size())
+                {
+                    m_cells[index] = m_cells.back();
+                    m_cellKeys[index] = m_cellKeys.back();
+                    m_cellIndex[m_cellKeys[index]] = index;
+                }
+
+                m_cells.pop_back();
+                m_cellKeys.pop_back();
+            }
+        }
+
+        m_refilling = false;
+        m_dirtyCells.clear();
+    }
+} // namespace KIGFX
@@ -0,0 +1,237 @@
+#include <view_packed_rtree.hxx>
+
+#include <limits>
+
+#include <hilbert_curve.hxx>
+
+namespace KIGFX {
+
+    namespace
+    {
+        /// A tree packed in memory, with the items its leaves refer to.
+        struct OWNED_TREE
+        {
+            VIEW_PACKED_RTREE::PACKED_ARRAYS arrays;
+            std::vector<VIEW_ITEM*>          items;
+        };
+    }
+
+
+    VIEW_PACKED_RTREE::ARRAYS VIEW_PACKED_RTREE::PACKED_ARRAYS::Arrays() const
+    {
+        ARRAYS arrays;
+
+        arrays.boxes = boxes.data();
+        arrays.indices = indices.data();
+        arrays.levelEnds = levelEnds.data();
+        arrays.levelCount = levelEnds.size();
+        arrays.nodeCount = indices.size();
+
+        return arrays;
+    }
+
+
+    void VIEW_PACKED_RTREE::Pack(std::vector<LEAF>& aLeaves, PACKED_ARRAYS& aResult)
+    {
+        aResult.boxes.clear();
+        aResult.indices.clear();
+        aResult.levelEnds.clear();
+
+        if (aLeaves.empty())
+            return;
+
+        BOX2D extents;
+
+        for (size_t i = 0; i < aLeaves.size(); ++i)
+        {
+            aLeaves[i].first.Normalize();
+
+            if (i == 0)
+                extents = aLeaves[i].first;
+            else
+                extents.Merge(aLeaves[i].first);
+        }
+
+        std::vector<std::pair<uint64_t, uint32_t>> order;
+        order.reserve(aLeaves.size());
+
+        for (uint32_t i = 0; i < aLeaves.size(); ++i)
+            order.emplace_back(HilbertIndex(aLeaves[i].first.Centre(), extents), i);
+
+        std::sort(order.begin(), order.end());
+
+        // Each level has about NODE_SIZE times fewer nodes than the one below
+        const size_t nodeEstimate = aLeaves.size() + aLeaves.size() / (NODE_SIZE - 1) + MAX_LEVELS;
+
+        aResult.boxes.reserve(4 * nodeEstimate);
+        aResult.indices.reserve(nodeEstimate);
+
+        for (const auto& [key, index] : order)
+        {
+            const BOX2D& box = aLeaves[index].first;
+
+            aResult.boxes.insert(aResult.boxes.end(),
+                                 { box.GetLeft(), box.GetTop(), box.GetRight(), box.GetBottom() });
+            aResult.indices.push_back(aLeaves[index].second);
+        }
+
+        uint64_t levelStart = 0;
+        uint64_t levelEnd = aResult.indices.size();
+
+        aResult.levelEnds.push_back(levelEnd);
+
+        // Group the nodes of each level under parents, with at least one level above the leaves
+        do
+        {
+            for (uint64_t first = levelStart; first < levelEnd; first += NODE_SIZE)
+            {
+                const uint64_t last = std::min<uint64_t>(first + NODE_SIZE, levelEnd);
+                double         box[4] = { std::numeric_limits<double>::max(),
+                                          std::numeric_limits<double>::max(),
+                                          std::numeric_limits<double>::lowest(),
+                                          std::numeric_limits<double>::lowest() };
+
+                for (uint64_t child = first; child < last; ++child)
+                {
+                    const double* childBox = &aResult.boxes[4 * child];
+
+                    box[0] = std::min(box[0], childBox[0]);
+                    box[1] = std::min(box[1], childBox[1]);
+                    box[2] = std::max(box[2], childBox[2]);
+                    box[3] = std::max(box[3], childBox[3]);
+                }
+
+                aResult.boxes.insert(aResult.boxes.end(), std::begin(box), std::end(box));
+                aResult.indices.push_back(static_cast<uint32_t>(first));
+            }
+
+            levelStart = levelEnd;
+            levelEnd = aResult.indices.size();
+            aResult.levelEnds.push_back(levelEnd);
+        } while (levelEnd - levelStart > 1);
+    }
+
+
+    void VIEW_PACKED_RTREE::Insert(VIEW_ITEM* aItem, const BOX2D& aBbox)
+    {
+        m_dynamic.Insert(aItem, aBbox);
+    }
+
+
+    void VIEW_PACKED_RTREE::BulkLoad(std::vector<VIEW_INDEX_ENTRY>& aEntries)
+    {
+        if (aEntries.empty())
+            return;
+
+        // Same trade-off as VIEW_RTREE_BASE::BulkLoad()
+        if (aEntries.size() * 8 < Size())
+        {
+            m_dynamic.BulkLoad(aEntries);
+            return;
+        }
+
+        auto              tree = std::make_shared<OWNED_TREE>();
+        std::vector<LEAF> leaves;
+
+        leaves.reserve(Size() + aEntries.size());
+        tree->items.reserve(Size() + aEntries.size());
+
+        auto add = [&](const BOX2D& aBbox, VIEW_ITEM* aItem)
+                   {
+                       leaves.emplace_back(aBbox, tree->items.size());
+                       tree->items.push_back(aItem);
+                   };
+
+        for (uint64_t leaf = 0; leaf < m_arrays.LeafCount(); ++leaf)
+        {
+            if (isDead(leaf))
+                continue;
+
+            const double* box = m_arrays.boxes + 4 * leaf;
+
+            add(BOX2D(VECTOR2D(box[0], box[1]), VECTOR2D(box[2] - box[0], box[3] - box[1])),
+                m_items[m_arrays.indices[leaf]]);
+        }
+
+        m_dynamic.ForEach(add);
+
+        for (const auto& [bbox, item] : aEntries)
+            add(bbox, item);
+
+        Pack(leaves, tree->arrays);
+
+        m_arrays = tree->arrays.Arrays();
+        m_items = tree->items.data();
+        m_storage = tree;
+        m_dead.clear();
+        m_deadCount = 0;
+        m_dynamic.RemoveAll();
+
+        aEntries.clear();
+        aEntries.shrink_to_fit();
+    }
+
+
+    bool VIEW_PACKED_RTREE::Remove(VIEW_ITEM* aItem, const BOX2D* aBbox)
+    {
+        if (m_dynamic.Size() > 0 && m_dynamic.Remove(aItem, aBbox))
+            return true;
+
+        uint64_t found = std::numeric_limits<uint64_t>::max();
+
+        auto match = [&](uint64_t aLeaf)
+                     {
+                         if (isDead(aLeaf) || m_items[m_arrays.indices[aLeaf]] != aItem)
+                             return true;
+
+                         found = aLeaf;
+                         return false;
+                     };
+
+        if (aBbox)
+        {
+            queryLeaves(*aBbox, match);
+        }
+        else
+        {
+            for (uint64_t leaf = 0; leaf < m_arrays.LeafCount(); ++leaf)
+            {
+                if (!match(leaf))
+                    break;
+            }
+        }
+
+        if (found == std::numeric_limits<uint64_t>::max())
+            return false;
+
+        if (m_dead.empty())
+            m_dead.resize((m_arrays.LeafCount() + 63) / 64, 0);
+
+        m_dead[found / 64] |= uint64_t(1) << (found % 64);
+        m_deadCount++;
+
+        return true;
+    }
+
+
+    void VIEW_PACKED_RTREE::Attach(const ARRAYS& aArrays, VIEW_ITEM* const* aItems,
+                                   std::shared_ptr<const void> aStorage)
+    {
+        RemoveAll();
+
+        m_arrays = aArrays;
+        m_items = aItems;
+        m_storage = std::move(aStorage);
+    }
+
+
+    void VIEW_PACKED_RTREE::RemoveAll()
+    {
+        m_arrays = ARRAYS();
+        m_items = nullptr;
+        m_storage.reset();
+        m_dead.clear();
+        m_deadCount = 0;
+        m_dynamic.RemoveAll();
+    }
+} // namespace KIGFX
@@ -0,0 +1,289 @@
+#include <view_quadtree.hxx>
+
+#include <algorithm>
+#include <cmath>
+
+namespace KIGFX {
+
+    VIEW_QUADTREE::VIEW_QUADTREE() :
+        m_root(-1),
+        m_count(0)
+    {
+    }
+
+
+    VIEW_QUADTREE::ENTRY VIEW_QUADTREE::makeEntry(VIEW_ITEM* aItem, const BOX2D& aBbox)
+    {
+        return { std::min(aBbox.GetLeft(), aBbox.GetRight()), std::min(aBbox.GetTop(), aBbox.GetBottom()),
+                 std::max(aBbox.GetLeft(), aBbox.GetRight()), std::max(aBbox.GetTop(), aBbox.GetBottom()),
+                 aItem };
+    }
+
+
+    bool VIEW_QUADTREE::fits(const NODE& aNode, const ENTRY& aEntry)
+    {
+        const double cx = (aEntry.minX + aEntry.maxX) / 2;
+        const double cy = (aEntry.minY + aEntry.maxY) / 2;
+        const double ext = std::max(aEntry.maxX - aEntry.minX, aEntry.maxY - aEntry.minY) / 2;
+
+        // Centre inside the node square and not larger than it: the item lies within the loose
+        // bounds (twice the square)
+        return std::abs(cx - aNode.cx) <= aNode.half && std::abs(cy - aNode.cy) <= aNode.half
+               && ext <= aNode.half;
+    }
+
+
+    int VIEW_QUADTREE::quadrant(const NODE& aNode, const ENTRY& aEntry)
+    {
+        const double cx = (aEntry.minX + aEntry.maxX) / 2;
+        const double cy = (aEntry.minY + aEntry.maxY) / 2;
+
+        return (cx >= aNode.cx ? 1 : 0) | (cy >= aNode.cy ? 2 : 0);
+    }
+
+
+    int VIEW_QUADTREE::addNode(double aCx, double aCy, double aHalf)
+    {
+        NODE node;
+        node.cx = aCx;
+        node.cy = aCy;
+        node.half = aHalf;
+        std::fill(std::begin(node.children), std::end(node.children), -1);
+        node.split = false;
+
+        m_nodes.push_back(std::move(node));
+        return int(m_nodes.size()) - 1;
+    }
+
+
+    int VIEW_QUADTREE::child(int aNode, int aQuadrant)
+    {
+        if (m_nodes[aNode].children[aQuadrant] < 0)
+        {
+            const NODE&  node = m_nodes[aNode];
+            const double half = node.half / 2;
+            const double cx = node.cx + ((aQuadrant & 1) ? half : -half);
+            const double cy = node.cy + ((aQuadrant & 2) ? half : -half);
+
+            // addNode() may reallocate m_nodes, do not keep references across it
+            const int childIdx = addNode(cx, cy, half);
+            m_nodes[aNode].children[aQuadrant] = childIdx;
+        }
+
+        return m_nodes[aNode].children[aQuadrant];
+    }
+
+
+    void VIEW_QUADTREE::growRoot(const ENTRY& aEntry)
+    {
+        const double cx = (aEntry.minX + aEntry.maxX) / 2;
+        const double cy = (aEntry.minY + aEntry.maxY) / 2;
+
+        if (m_root < 0)
+        {
+            const double ext = std::max(aEntry.maxX - aEntry.minX, aEntry.maxY - aEntry.minY) / 2;
+            m_root = addNode(cx, cy, std::max(ext, 1.0));
+        }
+
+        // Double the root towards the item until it fits. Items that are not finite or cover
+        // (almost) everything stay in the root once it cannot grow any further.
+        while (!fits(m_nodes[m_root], aEntry) && m_nodes[m_root].half < 1e300)
+        {
+            const NODE&  root = m_nodes[m_root];
+            const double half = root.half;
+            const double newCx = root.cx + (cx >= root.cx ? half : -half);
+            const double newCy = root.cy + (cy >= root.cy ? half : -half);
+            const int    oldRoot = m_root;
+
+            m_root = addNode(newCx, newCy, 2 * half);
+
+            NODE& newRoot = m_nodes[m_root];
+            const ENTRY oldCentre = { m_nodes[oldRoot].cx, m_nodes[oldRoot].cy,
+                                      m_nodes[oldRoot].cx, m_nodes[oldRoot].cy, nullptr };
+
+            newRoot.children[quadrant(newRoot, oldCentre)] = oldRoot;
+            newRoot.split = true;
+        }
+    }
+
+
+    void VIEW_QUADTREE::insert(const ENTRY& aEntry)
+    {
+        if (m_root < 0 || !fits(m_nodes[m_root], aEntry))
+            growRoot(aEntry);
+
+        int nodeIdx = m_root;
+        int depth = 0;
+
+        while (m_nodes[nodeIdx].split)
+        {
+            const NODE&  node = m_nodes[nodeIdx];
+            const double ext = std::max(aEntry.maxX - aEntry.minX, aEntry.maxY - aEntry.minY) / 2;
+
+            if (ext > node.half / 2)
+                break;
+
+            nodeIdx = child(nodeIdx, quadrant(node, aEntry));
+            depth++;
+        }
+
+        m_nodes[nodeIdx].entries.push_back(aEntry);
+        m_count++;
+
+        if (!m_nodes[nodeIdx].split && m_nodes[nodeIdx].entries.size() > NODE_CAPACITY
+                && depth < MAX_SPLIT_DEPTH)
+        {
+            splitNode(nodeIdx, depth);
+        }
+    }
+
+
+    void VIEW_QUADTREE::splitNode(int aNode, int aDepth)
+    {
+        std::vector<ENTRY> entries = std::move(m_nodes[aNode].entries);
+        m_nodes[aNode].entries.clear();
+        m_nodes[aNode].split = true;
+
+        const double childHalf = m_nodes[aNode].half / 2;
+
+        for (const ENTRY& entry : entries)
+        {
+            const double ext = std::max(entry.maxX - entry.minX, entry.maxY - entry.minY) / 2;
+
+            if (ext > childHalf)
+            {
+                m_nodes[aNode].entries.push_back(entry);
+                continue;
+            }
+
+            const int childIdx = child(aNode, quadrant(m_nodes[aNode], entry));
+            m_nodes[childIdx].entries.push_back(entry);
+        }
+
+        for (int q = 0; q < 4; ++q)
+        {
+            const int childIdx = m_nodes[aNode].children[q];
+
+            if (childIdx >= 0 && m_nodes[childIdx].entries.size() > NODE_CAPACITY
+                    && aDepth + 1 < MAX_SPLIT_DEPTH)
+            {
+                splitNode(childIdx, aDepth + 1);
+            }
+        }
+    }
+
+
+    void VIEW_QUADTREE::Insert(VIEW_ITEM* aItem, const BOX2D& aBbox)
+    {
+        insert(makeEntry(aItem, aBbox));
+    }
+
+
+    void VIEW_QUADTREE::BulkLoad(std::vector<VIEW_INDEX_ENTRY>& aEntries)
+    {
+        if (aEntries.empty())
+            return;
+
+        if (m_root < 0)
+        {
+            // Size the root for all the items, so it does not have to grow while inserting
+            double minX = HUGE_VAL, minY = HUGE_VAL, maxX = -HUGE_VAL, maxY = -HUGE_VAL;
+
+            for (const auto& [bbox, item] : aEntries)
+            {
+                const ENTRY e = makeEntry(item, bbox);
+
+                if (!std::isfinite(e.minX) || !std::isfinite(e.maxX) || !std::isfinite(e.minY)
+                        || !std::isfinite(e.maxY))
+                    continue;
+
+                minX = std::min(minX, e.minX);
+                minY = std::min(minY, e.minY);
+                maxX = std::max(maxX, e.maxX);
+                maxY = std::max(maxY, e.maxY);
+            }
+
+            if (minX <= maxX && minY <= maxY)
+                growRoot({ minX, minY, maxX, maxY, nullptr });
+        }
+
+        for (const auto& [bbox, item] : aEntries)
+            insert(makeEntry(item, bbox));
+
+        aEntries.clear();
+        aEntries.shrink_to_fit();
+    }
+
+
+    bool VIEW_QUADTREE::Remove(VIEW_ITEM* aItem, const BOX2D* aBbox)
+    {
+        auto eraseFrom =
+            [aItem](std::vector<ENTRY>& aEntries) -> bool
+            {
+                auto it = std::find_if(aEntries.begin(), aEntries.end(),
+                                       [aItem](const ENTRY& aEntry)
+                                       {
+                                           return aEntry.item == aItem;
+                                       });
+
+                if (it == aEntries.end())
+                    return false;
+
+                *it = aEntries.back();
+                aEntries.pop_back();
+                return true;
+            };
+
+        if (m_root < 0)
+            return false;
+
+        bool found = false;
+
+        if (aBbox)
+        {
+            // Follow the path the item took on insertion; it is stored in one of the nodes on it
+            const ENTRY entry = makeEntry(aItem, *aBbox);
+            const double ext = std::max(entry.maxX - entry.minX, entry.maxY - entry.minY) / 2;
+            int nodeIdx = m_root;
+
+            while (nodeIdx >= 0 && !found)
+            {
+                NODE& node = m_nodes[nodeIdx];
+                found = eraseFrom(node.entries);
+
+                if (!node.split || ext > node.half / 2)
+                    break;
+
+                nodeIdx = node.children[quadrant(node, entry)];
+            }
+        }
+
+        // Without a box, or for an item whose centre lies exactly on the edge of a former root
+        // (the quadrant of its new parent may then differ), look everywhere
+        if (!found)
+        {
+            for (NODE& node : m_nodes)
+            {
+                if (eraseFrom(node.entries))
+                {
+                    found = true;
+                    break;
+                }
+            }
+        }
+
+        if (found)
+            m_count--;
+
+        return found;
+    }
+
+
+    void VIEW_QUADTREE::RemoveAll()
+    {
+        m_nodes.clear();
+        m_root = -1;
+        m_count = 0;
+    }
+
+} // namespace KIGFX
@@ -3,11 +3,24 @@
 #include "data_painter.hxx"
 #include "data_manager.hxx"
 #include "gal/include/utils.hxx"
+#include "view_item.hxx"
+
+#include <QDir>
+#include <QStandardPaths>
 
 // Scale limits for zoom (especially mouse wheel) for Data
 #define ZOOM_MAX_LIMIT_DATA 50000
 #define ZOOM_MIN_LIMIT_DATA 0.1
 
+// Items queued by background loaders applied per frame, so the panel keeps repainting
+#define INGEST_ITEMS_PER_FRAME 50000
+
+// Distance in pixels within which the cursor snaps to item anchors rather than to the grid
+#define SNAP_DISTANCE_PIXELS 8
+
+// Designs with this many items are opened again from an index snapshot rather than indexed again
+#define INDEX_SNAPSHOT_MIN_ITEMS 100000
+
 DrawPanelGal::DrawPanelGal(QWidget* parent, QSize aSize, GAL_TYPE aGalType)
 	: QAbstractScrollArea(parent),
 	  m_gal(nullptr),
@@ -28,6 +41,16 @@ DrawPanelGal::DrawPanelGal(QWidget* parent, QSize aSize, GAL_TYPE aGalType)
 	for (int i = 0; i < KIGFX::VIEW::VIEW_MAX_LAYERS; i++)
 		m_view->SetLayerTarget(i, KIGFX::TARGET_NONCACHED);
 
+	// Item updates repaint only the area they touch, the rest of the frame is kept
+	m_view->UseDamageRedraw(true);
+	m_view->UseScrollBlit(true);
+
+	// At full board zoom, items below a couple of pixels are drawn as density quads
+	m_view->SetAggregateThreshold(2.0);
+
+	// The cursor snaps to item endpoints, centers, midpoints and intersections
+	m_view->EnableSnapIndex(true);
+
 	qreal dpi = QGuiApplication::primaryScreen()->logicalDotsPerInch();
 	m_gal->show();
 	m_gal->SetScreenDPI(dpi);
@@ -52,6 +75,8 @@ void DrawPanelGal::Paint(QPaintEvent* event)
 
 
 	m_gal->SetCursorEnabled(true);
+	m_view->ApplyQueuedChanges(INGEST_ITEMS_PER_FRAME);
+
 	if (m_view->IsDirty()) {
 		m_view->Redraw();
 	}
@@ -59,7 +84,13 @@ void DrawPanelGal::Paint(QPaintEvent* event)
 	
 	QPoint widgetPos = m_gal->mapFromGlobal(QCursor::pos());
 	VECTOR2D cursor = { (double)widgetPos.x(), (double)widgetPos.y() };
-	cursor = GetClampedCoords(m_gal->GetGridPoint(m_view->ToWorld(cursor)));
+	cursor = m_view->ToWorld(cursor);
+
+	if (std::optional<KIGFX::VIEW_ANCHOR> anchor = m_view->GetSnapAnchor(cursor, SNAP_DISTANCE_PIXELS))
+		cursor = GetClampedCoords(anchor->point);
+	else
+		cursor = GetClampedCoords(m_gal->GetGridPoint(cursor));
+
 	m_gal->DrawCursor(cursor);
 
 	m_gal->update();
@@ -128,16 +159,36 @@ void DrawPanelGal::InitialViewData(DataManager* data)
 	m_gal->SetLineWidth(m_view->ToWorld(1));
 	//m_gal->SetIsFill(true);
 	//m_gal->SetFillColor(KIGFX::COLOR4D(1, 1, 1, 1));
+
+	// Items close on the board are drawn one after the other, keep them close in memory too
+	data->SortSpatially();
+
+	std::vector<KIGFX::VIEW_ITEM*> items;
+	items.reserve(data->m_circles.size() + data->m_rectangles.size());
+
 	for (auto &circle : data->m_circles) {
 		circle.m_centerPoint = m_view->ToWorld(circle.m_centerPoint);
 		circle.m_radius = m_view->ToWorld(circle.m_radius);
-		m_view->Add(&circle);
+		items.push_back(&circle);
 	}
 
 	for (auto& rectangle : data->m_rectangles) {
 		rectangle.m_startPoint = m_view->ToWorld(rectangle.m_startPoint);
 		rectangle.m_endPoint = m_view->ToWorld(rectangle.m_endPoint);
-		m_view->Add(&rectangle);
+		items.push_back(&rectangle);
+	}
+
+	if (items.size() >= INDEX_SNAPSHOT_MIN_ITEMS) {
+		// Snapshots are kept in the cache directory, named after the hash of the design
+		const HASH_128 hash = data->GetContentHash();
+		const QString dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+		const std::string path = (dir + "/" + QString::fromStdString(hash.ToString()) + ".vidx").toStdString();
+
+		if (!m_view->LoadIndexSnapshot(path, items, hash) && QDir().mkpath(dir))
+			m_view->SaveIndexSnapshot(path, items, hash);
+	} else {
+		// Bulk load: builds every layer's R-tree in one pass instead of item by item
+		m_view->AddItems(items);
 	}
 
 	m_view->MarkDirty();